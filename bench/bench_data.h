@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "mbo_parser.h"
+
+// Synthetic MBO flow for the benchmarks. Everything is generated from a
+// fixed seed, so runs compare like with like.
+namespace bench_data {
+
+constexpr uint32_t INSTRUMENT_ID = 1108;
+constexpr Price MID_PRICE = 100 * PRICE_SCALE;
+constexpr Price TICK = PRICE_SCALE / 100;
+
+// Point to a different MBO file with MBO_BENCH_FILE
+inline std::string mboFile() {
+    const char* path = std::getenv("MBO_BENCH_FILE");
+    return path ? path : "quant_dev_trial/mbo.csv";
+}
+
+class Random {
+public:
+    explicit Random(uint64_t seed = 12345) : state_(seed) {}
+    
+    uint64_t next() {
+        state_ = state_ * 6364136223846793005ULL + 1442695040888963407ULL;
+        return state_ >> 33;
+    }
+    
+    uint64_t below(uint64_t bound) { return next() % bound; }
+
+private:
+    uint64_t state_;
+};
+
+inline MboEvent makeEvent(char action, char side, Price price, uint64_t size, uint64_t order_id, uint64_t sequence) {
+    MboEvent event(std::chrono::nanoseconds(1752739509035627674LL + static_cast<int64_t>(sequence) * 1000), action, side,
+                   price, size, order_id);
+    event.instrument_id = INSTRUMENT_ID;
+    event.publisher_id = 2;
+    event.sequence = sequence;
+    event.flags = 130;
+    return event;
+}
+
+inline Price levelPrice(char side, size_t level) {
+    Price offset = static_cast<Price>(level + 1) * TICK;
+    return side == 'B' ? MID_PRICE - offset : MID_PRICE + offset;
+}
+
+// Adds that build a book of levels_per_side levels on each side, with
+// orders_per_level resting orders each; order ids start at 1
+inline std::vector<MboEvent> deepBook(size_t levels_per_side, size_t orders_per_level) {
+    std::vector<MboEvent> events;
+    events.reserve(levels_per_side * orders_per_level * 2);
+    uint64_t order_id = 1;
+    for (size_t order = 0; order < orders_per_level; ++order) {
+        for (size_t level = 0; level < levels_per_side; ++level) {
+            for (char side : {'B', 'A'}) {
+                events.push_back(makeEvent('A', side, levelPrice(side, level), 100 + order, order_id, order_id));
+                ++order_id;
+            }
+        }
+    }
+    return events;
+}
+
+// Add/cancel churn concentrated near the top of the book, as quoting
+// algorithms produce: cancel_percent of events after warm-up cancel a live
+// order, the rest add one within the top ten levels
+inline std::vector<MboEvent> highCancelFlow(size_t event_count, unsigned cancel_percent, uint64_t first_order_id = 1) {
+    Random random;
+    std::vector<MboEvent> events;
+    std::vector<MboEvent> live;
+    events.reserve(event_count);
+    uint64_t order_id = first_order_id;
+    
+    for (uint64_t sequence = 1; events.size() < event_count; ++sequence) {
+        if (live.size() > 100 && random.below(100) < cancel_percent) {
+            size_t pick = random.below(live.size());
+            MboEvent cancel = live[pick];
+            cancel.action = 'C';
+            cancel.sequence = sequence;
+            events.push_back(cancel);
+            live[pick] = live.back();
+            live.pop_back();
+        } else {
+            char side = random.below(2) ? 'B' : 'A';
+            events.push_back(makeEvent('A', side, levelPrice(side, random.below(10)), 1 + random.below(500), order_id++, sequence));
+            live.push_back(events.back());
+        }
+    }
+    return events;
+}
+
+// Events rendered as rows of the Databento MBO CSV schema
+inline std::vector<std::string> csvLines(const std::vector<MboEvent>& events) {
+    std::vector<std::string> lines;
+    lines.reserve(events.size());
+    char line[256];
+    for (const MboEvent& event : events) {
+        int64_t ns = event.ts_event.count() % 1000000000LL;
+        std::snprintf(line, sizeof(line), "2025-07-17T08:05:03.%09lldZ,2025-07-17T08:05:03.%09lldZ,160,%u,%u,%c,%c,%lld.%09lld,%llu,0,%llu,%u,0,%llu,ARL",
+                      static_cast<long long>(ns), static_cast<long long>(ns), static_cast<unsigned>(event.publisher_id),
+                      static_cast<unsigned>(event.instrument_id), event.action, event.side,
+                      static_cast<long long>(event.price / PRICE_SCALE), static_cast<long long>(event.price % PRICE_SCALE),
+                      static_cast<unsigned long long>(event.size), static_cast<unsigned long long>(event.order_id),
+                      static_cast<unsigned>(event.flags), static_cast<unsigned long long>(event.sequence));
+        lines.emplace_back(line);
+    }
+    return lines;
+}
+
+} // namespace bench_data
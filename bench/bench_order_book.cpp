@@ -0,0 +1,183 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include "order_book.h"
+#include "bench_data.h"
+
+// Per-action book costs. Each timed batch starts from a freshly built book
+// of state.range(0) levels per side; building it is not timed.
+
+static constexpr size_t BATCH = 10000;
+static constexpr size_t ORDERS_PER_LEVEL = 4;
+
+template <typename Book>
+static void rebuild(Book& book, const std::vector<MboEvent>& resting) {
+    book.clear();
+    for (const MboEvent& event : resting) {
+        book.processEvent(event);
+    }
+}
+
+template <typename Book>
+static void BM_ProcessAdd(benchmark::State& state) {
+    auto resting = bench_data::deepBook(static_cast<size_t>(state.range(0)), ORDERS_PER_LEVEL);
+    auto adds = bench_data::highCancelFlow(BATCH, 0, resting.size() + 1);
+    Book book;
+    
+    for (auto _ : state) {
+        state.PauseTiming();
+        rebuild(book, resting);
+        state.ResumeTiming();
+        for (const MboEvent& event : adds) {
+            benchmark::DoNotOptimize(book.processEvent(event));
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * adds.size()));
+}
+
+// Cancels every resting order, in random order
+template <typename Book>
+static void BM_ProcessCancel(benchmark::State& state) {
+    auto resting = bench_data::deepBook(static_cast<size_t>(state.range(0)), ORDERS_PER_LEVEL);
+    std::vector<MboEvent> cancels = resting;
+    bench_data::Random random;
+    for (size_t i = cancels.size(); i > 1; --i) {
+        std::swap(cancels[i - 1], cancels[random.below(i)]);
+    }
+    for (MboEvent& cancel : cancels) {
+        cancel.action = 'C';
+    }
+    Book book;
+    
+    for (auto _ : state) {
+        state.PauseTiming();
+        rebuild(book, resting);
+        state.ResumeTiming();
+        for (const MboEvent& event : cancels) {
+            benchmark::DoNotOptimize(book.processEvent(event));
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * cancels.size()));
+}
+
+// T->F->C sequences, each filling the front bid order in full, walking
+// down the bid side level by level
+template <typename Book>
+static void BM_ProcessTradeFillCancel(benchmark::State& state) {
+    const size_t levels = static_cast<size_t>(state.range(0));
+    auto resting = bench_data::deepBook(levels, ORDERS_PER_LEVEL);
+    
+    std::vector<MboEvent> sequences;
+    for (size_t level = 0; level < levels; ++level) {
+        for (size_t order = 0; order < ORDERS_PER_LEVEL; ++order) {
+            const MboEvent& bid = resting[(order * levels + level) * 2];
+            sequences.push_back(bench_data::makeEvent('T', 'A', bid.price, bid.size, 0, bid.sequence));
+            sequences.push_back(bench_data::makeEvent('F', 'B', bid.price, bid.size, bid.order_id, bid.sequence));
+            sequences.push_back(bench_data::makeEvent('C', 'B', bid.price, bid.size, bid.order_id, bid.sequence));
+        }
+    }
+    Book book;
+    
+    for (auto _ : state) {
+        state.PauseTiming();
+        rebuild(book, resting);
+        state.ResumeTiming();
+        for (const MboEvent& event : sequences) {
+            benchmark::DoNotOptimize(book.processEvent(event));
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * sequences.size() / 3));
+    state.SetLabel("T->F->C sequences");
+}
+
+// Mixed flow where most events cancel a recent add near the top
+template <typename Book>
+static void BM_HighCancelFlow(benchmark::State& state) {
+    auto resting = bench_data::deepBook(100, ORDERS_PER_LEVEL);
+    auto flow = bench_data::highCancelFlow(BATCH * 10, static_cast<unsigned>(state.range(0)), resting.size() + 1);
+    Book book;
+    
+    for (auto _ : state) {
+        state.PauseTiming();
+        rebuild(book, resting);
+        state.ResumeTiming();
+        for (const MboEvent& event : flow) {
+            benchmark::DoNotOptimize(book.processEvent(event));
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * flow.size()));
+}
+
+// The same flow with a snapshot after every update inside the top ten, as
+// the replay emits them
+template <typename Book>
+static void BM_HighCancelFlowSnapshots(benchmark::State& state) {
+    auto resting = bench_data::deepBook(100, ORDERS_PER_LEVEL);
+    auto flow = bench_data::highCancelFlow(BATCH * 10, static_cast<unsigned>(state.range(0)), resting.size() + 1);
+    Book book;
+    
+    for (auto _ : state) {
+        state.PauseTiming();
+        rebuild(book, resting);
+        state.ResumeTiming();
+        for (const MboEvent& event : flow) {
+            if (book.processEvent(event).top_changed) {
+                benchmark::DoNotOptimize(book.generateSnapshot(event));
+            }
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * flow.size()));
+}
+
+template <typename Book>
+static void BM_GenerateSnapshot(benchmark::State& state) {
+    Book book;
+    rebuild(book, bench_data::deepBook(static_cast<size_t>(state.range(0)), ORDERS_PER_LEVEL));
+    MboEvent event = bench_data::makeEvent('A', 'B', bench_data::levelPrice('B', 0), 100, 1, 1);
+    
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(book.generateSnapshot(event));
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+template <typename Book, size_t Depth>
+static void BM_GenerateDepthSnapshot(benchmark::State& state) {
+    Book book;
+    rebuild(book, bench_data::deepBook(200, ORDERS_PER_LEVEL));
+    MboEvent event = bench_data::makeEvent('A', 'B', bench_data::levelPrice('B', 0), 100, 1, 1);
+    
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(book.template generateDepthSnapshot<Depth>(event));
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+template <typename Book>
+static void BM_CaptureTop10State(benchmark::State& state) {
+    Book book;
+    rebuild(book, bench_data::deepBook(static_cast<size_t>(state.range(0)), ORDERS_PER_LEVEL));
+    
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(book.captureTop10State());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+BENCHMARK_TEMPLATE(BM_ProcessAdd, OrderBook)->Arg(10)->Arg(1000);
+BENCHMARK_TEMPLATE(BM_ProcessAdd, LadderOrderBook)->Arg(10)->Arg(1000);
+BENCHMARK_TEMPLATE(BM_ProcessCancel, OrderBook)->Arg(10)->Arg(1000);
+BENCHMARK_TEMPLATE(BM_ProcessCancel, LadderOrderBook)->Arg(10)->Arg(1000);
+BENCHMARK_TEMPLATE(BM_ProcessTradeFillCancel, OrderBook)->Arg(10)->Arg(1000);
+BENCHMARK_TEMPLATE(BM_ProcessTradeFillCancel, LadderOrderBook)->Arg(10)->Arg(1000);
+BENCHMARK_TEMPLATE(BM_HighCancelFlow, OrderBook)->Arg(50)->Arg(90);
+BENCHMARK_TEMPLATE(BM_HighCancelFlow, LadderOrderBook)->Arg(50)->Arg(90);
+BENCHMARK_TEMPLATE(BM_HighCancelFlowSnapshots, OrderBook)->Arg(50)->Arg(90);
+BENCHMARK_TEMPLATE(BM_HighCancelFlowSnapshots, LadderOrderBook)->Arg(50)->Arg(90);
+BENCHMARK_TEMPLATE(BM_GenerateSnapshot, OrderBook)->Arg(10)->Arg(1000);
+BENCHMARK_TEMPLATE(BM_GenerateSnapshot, LadderOrderBook)->Arg(10)->Arg(1000);
+BENCHMARK_TEMPLATE(BM_GenerateDepthSnapshot, OrderBook, 1);
+BENCHMARK_TEMPLATE(BM_GenerateDepthSnapshot, OrderBook, 50);
+BENCHMARK_TEMPLATE(BM_GenerateDepthSnapshot, LadderOrderBook, 1);
+BENCHMARK_TEMPLATE(BM_GenerateDepthSnapshot, LadderOrderBook, 50);
+BENCHMARK_TEMPLATE(BM_CaptureTop10State, OrderBook)->Arg(10)->Arg(1000);
+BENCHMARK_TEMPLATE(BM_CaptureTop10State, LadderOrderBook)->Arg(10)->Arg(1000);
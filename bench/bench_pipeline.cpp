@@ -0,0 +1,181 @@
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include "mbo_parser.h"
+#include "mbo_file_reader.h"
+#include "dbn_mbo.h"
+#include "mbp_csv_writer.h"
+#include "mbp_binary_writer.h"
+#include "event_buffer.h"
+#include "replay_engine.h"
+#include "symbology.h"
+#include "bench_data.h"
+
+// Parsing, snapshot output, window consolidation and the end-to-end replay
+
+static constexpr size_t BATCH = 10000;
+static const char* WRITER_OUTPUT = "bench_writer_output.tmp";
+static const char* REPLAY_OUTPUT = "bench_replay_output.tmp";
+
+// The engine reports filtered events on stdout; keep that out of the
+// benchmark's own output while timing
+class SilenceStdout {
+public:
+    SilenceStdout() : saved_(std::cout.rdbuf(sink_.rdbuf())) {}
+    ~SilenceStdout() { std::cout.rdbuf(saved_); }
+
+private:
+    std::ostringstream sink_;
+    std::streambuf* saved_;
+};
+
+static void BM_ParseLine(benchmark::State& state) {
+    auto lines = bench_data::csvLines(bench_data::highCancelFlow(BATCH, 50));
+    size_t bytes = 0;
+    for (const std::string& line : lines) {
+        bytes += line.size() + 1;
+    }
+    MboEvent event;
+    
+    for (auto _ : state) {
+        for (const std::string& line : lines) {
+            benchmark::DoNotOptimize(MboParser::parseLine(line.data(), line.data() + line.size(), event));
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * lines.size()));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+}
+
+// The same events as BM_ParseLine, as fixed-width DBN records
+static void BM_DecodeDbnRecord(benchmark::State& state) {
+    std::vector<dbn_mbo::Record> records;
+    for (const MboEvent& event : bench_data::highCancelFlow(BATCH, 50)) {
+        records.emplace_back();
+        dbn_mbo::encode(event, records.back());
+    }
+    MboEvent event;
+    
+    for (auto _ : state) {
+        for (const dbn_mbo::Record& record : records) {
+            benchmark::DoNotOptimize(dbn_mbo::decode(reinterpret_cast<const char*>(&record), sizeof(record), event));
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * records.size()));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * records.size() * sizeof(dbn_mbo::Record)));
+}
+
+// Rows from a full ten-level book, one timestamp per snapshot so the
+// per-second timestamp cache is exercised the way a replay does
+template <typename Writer>
+static void BM_WriteSnapshot(benchmark::State& state) {
+    OrderBook book;
+    for (const MboEvent& event : bench_data::deepBook(10, 4)) {
+        book.processEvent(event);
+    }
+    std::vector<MbpSnapshot> snapshots;
+    for (const MboEvent& event : bench_data::highCancelFlow(BATCH, 50)) {
+        snapshots.push_back(book.generateSnapshot(event));
+    }
+    
+    SymbologyTable symbology;
+    symbology.add(bench_data::INSTRUMENT_ID, 2, "ARL");
+    Writer writer(WRITER_OUTPUT);
+    writer.setSymbology(&symbology);
+    if (!writer.initialize()) {
+        state.SkipWithError("cannot create writer output");
+        return;
+    }
+    
+    uint64_t row_index = 0;
+    for (auto _ : state) {
+        for (const MbpSnapshot& snapshot : snapshots) {
+            writer.writeSnapshot(snapshot, row_index++);
+        }
+    }
+    writer.close();
+    std::remove(WRITER_OUTPUT);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * snapshots.size()));
+}
+
+// Fills 1 ms windows from a churny flow and runs both consolidation passes
+static void BM_EventBufferPasses(benchmark::State& state) {
+    auto flow = bench_data::highCancelFlow(BATCH, static_cast<unsigned>(state.range(0)));
+    EventBuffer window;
+    size_t removed = 0;
+    
+    for (auto _ : state) {
+        for (const MboEvent& event : flow) {
+            if (!window.addEvent(event)) {
+                removed += window.applyOrderAnnihilation();
+                removed += window.applySameLevelBatching();
+                window.clear();
+                window.addEvent(event);
+            }
+        }
+        removed += window.applyOrderAnnihilation();
+        removed += window.applySameLevelBatching();
+        window.clear();
+    }
+    benchmark::DoNotOptimize(removed);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * flow.size()));
+}
+
+static void BM_ReadMboFile(benchmark::State& state) {
+    const std::string input = bench_data::mboFile();
+    size_t events = 0;
+    size_t bytes = 0;
+    
+    for (auto _ : state) {
+        MboFileReader reader(input);
+        if (!reader.open()) {
+            state.SkipWithError("cannot open MBO input; set MBO_BENCH_FILE");
+            return;
+        }
+        events += reader.forEach([](const MboEvent& event) { benchmark::DoNotOptimize(event); });
+        bytes += reader.getFileSize();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(events));
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+}
+
+// quant_dev_trial/mbo.csv (or MBO_BENCH_FILE) through reader, engine and
+// CSV writer, as the command-line replay runs it
+template <typename Book>
+static void BM_ReplayFile(benchmark::State& state) {
+    const std::string input = bench_data::mboFile();
+    size_t events = 0;
+    SilenceStdout silence;
+    
+    for (auto _ : state) {
+        SymbologyTable symbology;
+        MboFileReader reader(input);
+        reader.setSymbology(&symbology);
+        MbpCsvWriter writer(REPLAY_OUTPUT);
+        writer.setSymbology(&symbology);
+        if (!reader.open() || !writer.initialize()) {
+            state.SkipWithError("cannot open MBO input; set MBO_BENCH_FILE");
+            return;
+        }
+        
+        ReplayEngine<Book, MbpCsvWriter> engine(writer);
+        events += reader.forEach([&](const MboEvent& event) { engine.push(event); });
+        engine.finish();
+        writer.close();
+    }
+    std::remove(REPLAY_OUTPUT);
+    state.SetItemsProcessed(static_cast<int64_t>(events));
+}
+
+BENCHMARK(BM_ParseLine);
+BENCHMARK(BM_DecodeDbnRecord);
+BENCHMARK_TEMPLATE(BM_WriteSnapshot, MbpCsvWriter);
+BENCHMARK_TEMPLATE(BM_WriteSnapshot, MbpBinaryWriter);
+BENCHMARK(BM_EventBufferPasses)->Arg(50)->Arg(90);
+BENCHMARK(BM_ReadMboFile)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_ReplayFile, OrderBook)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_ReplayFile, LadderOrderBook)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Double-buffered file output. write() hands a filled buffer to a background
+// I/O thread in exchange for the one it finished with, so formatting the next
+// buffer overlaps the disk write of the previous one. The caller only waits
+// if it fills a buffer before the previous write has completed.
+class AsyncFileWriter {
+public:
+    AsyncFileWriter();
+    ~AsyncFileWriter();
+    
+    AsyncFileWriter(const AsyncFileWriter&) = delete;
+    AsyncFileWriter& operator=(const AsyncFileWriter&) = delete;
+    
+    bool open(const std::string& filename, std::ios::openmode mode = std::ios::out | std::ios::trunc);
+    bool isOpen() const { return file_stream_.is_open(); }
+    
+    // Queues the first used bytes of buffer for writing and swaps in the
+    // idle buffer, resized to match
+    void write(std::vector<char>& buffer, size_t used);
+    
+    // Waits for the queued write and flushes the stream
+    void flush();
+    void close();
+
+private:
+    std::ofstream file_stream_;
+    std::vector<char> back_buffer_;
+    size_t back_used_;
+    bool write_pending_;
+    bool stopping_;
+    
+    std::thread io_thread_;
+    std::mutex mutex_;
+    std::condition_variable work_ready_;
+    std::condition_variable work_done_;
+    
+    void waitIdle(std::unique_lock<std::mutex>& lock);
+    void run();
+};
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <thread>
+#include "mpsc_ring.h"
+
+// Deferred logging for the replay hot path. A call site pushes a fixed-size
+// binary record (message id plus two integer arguments) into a lock-free
+// ring and carries on; a background thread formats the text and writes it.
+// Nothing on the calling thread touches iostreams or flushes.
+
+enum class LogSeverity : uint8_t {
+    INFO,
+    WARNING,
+    OFF
+};
+
+// Every message the hot path can log. Text and severity live in the
+// logger's message table; the enum only names them.
+enum class LogMessage : uint16_t {
+    RESET_EVENT,
+    FILTERED_CANCEL,
+    FILTERED_ADD,
+    FILTERED_C_EVENT,
+    FILTERED_A_EVENT,
+    UNKNOWN_ACTION,
+    DUPLICATE_ORDER,
+    UNEXPECTED_FILL,
+    COUNT
+};
+
+struct LogRecord {
+    uint64_t args[2];
+    LogMessage message;
+};
+
+bool parseLogSeverity(const char* name, LogSeverity& severity);
+
+// Process-wide logger, started on first use and drained at exit.
+// Messages below the minimum severity are dropped at the call site. Each
+// message type is also rate limited: past rate_limit records of one type in
+// a second the rest are only counted, and the background thread reports
+// how many were suppressed. A full ring drops records rather than blocking.
+class AsyncLogger {
+public:
+    static constexpr size_t RING_CAPACITY = 16 * 1024;
+    static constexpr uint32_t DEFAULT_RATE_LIMIT = 1000;
+    
+    static AsyncLogger& instance();
+    
+    AsyncLogger(std::ostream& info_out, std::ostream& warning_out);
+    ~AsyncLogger();
+    
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+    
+    void log(LogMessage message, uint64_t arg0 = 0, uint64_t arg1 = 0) {
+        if (severityOf(message) < min_severity_.load(std::memory_order_relaxed) || !admit(message)) {
+            return;
+        }
+        LogRecord record = {{arg0, arg1}, message};
+        if (!ring_.tryPush(record)) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    
+    void setMinSeverity(LogSeverity severity) { min_severity_.store(severity, std::memory_order_relaxed); }
+    LogSeverity getMinSeverity() const { return min_severity_.load(std::memory_order_relaxed); }
+    
+    // Records a second per message type; 0 disables the limit
+    void setRateLimit(uint32_t per_second) { rate_limit_.store(per_second, std::memory_order_relaxed); }
+    
+    // Waits until everything logged so far is written, reports suppressed
+    // and dropped counts, and flushes both streams
+    void flush();
+    
+    uint64_t getCount(LogMessage message) const {
+        return counters_[static_cast<size_t>(message)].total.load(std::memory_order_relaxed);
+    }
+    
+    static LogSeverity severityOf(LogMessage message) {
+        switch (message) {
+            case LogMessage::UNKNOWN_ACTION:
+            case LogMessage::DUPLICATE_ORDER:
+            case LogMessage::UNEXPECTED_FILL:
+                return LogSeverity::WARNING;
+            default:
+                return LogSeverity::INFO;
+        }
+    }
+    
+    // The text of a record, as the replay used to print it
+    static void format(std::ostream& out, const LogRecord& record);
+
+private:
+    static constexpr size_t MESSAGE_COUNT = static_cast<size_t>(LogMessage::COUNT);
+    
+    struct MessageCounter {
+        std::atomic<uint64_t> total;
+        std::atomic<uint64_t> window;
+        std::atomic<uint32_t> in_window;
+        std::atomic<uint64_t> suppressed;
+        
+        MessageCounter() : total(0), window(0), in_window(0), suppressed(0) {}
+    };
+    
+    std::ostream& info_out_;
+    std::ostream& warning_out_;
+    MpscRing<LogRecord> ring_;
+    std::atomic<LogSeverity> min_severity_;
+    std::atomic<uint32_t> rate_limit_;
+    MessageCounter counters_[MESSAGE_COUNT];
+    std::atomic<uint64_t> dropped_;
+    
+    // flush() takes a ticket and waits for the background thread, which
+    // does all the writing, to complete it
+    std::atomic<uint64_t> flush_requests_;
+    std::atomic<uint64_t> flushes_done_;
+    
+    // Rate-limit window, advanced once a second by the background thread;
+    // call sites only compare against it
+    std::atomic<uint64_t> window_;
+    
+    std::atomic<bool> stopping_;
+    std::thread worker_;
+    
+    bool admit(LogMessage message) {
+        MessageCounter& counter = counters_[static_cast<size_t>(message)];
+        counter.total.fetch_add(1, std::memory_order_relaxed);
+        uint32_t limit = rate_limit_.load(std::memory_order_relaxed);
+        if (limit == 0) {
+            return true;
+        }
+        // Racing resets between threads only blur the count at a window edge
+        uint64_t window = window_.load(std::memory_order_relaxed);
+        if (counter.window.load(std::memory_order_relaxed) != window) {
+            counter.window.store(window, std::memory_order_relaxed);
+            counter.in_window.store(0, std::memory_order_relaxed);
+        }
+        if (counter.in_window.fetch_add(1, std::memory_order_relaxed) < limit) {
+            return true;
+        }
+        counter.suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    
+    std::ostream& streamFor(LogMessage message) {
+        return severityOf(message) >= LogSeverity::WARNING ? warning_out_ : info_out_;
+    }
+    
+    size_t drain();
+    void completeFlush(uint64_t request);
+    void reportSuppressed();
+    void run();
+};
+
+inline void logMessage(LogMessage message, uint64_t arg0 = 0, uint64_t arg1 = 0) {
+    AsyncLogger::instance().log(message, arg0, arg1);
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include <unordered_map>
+#include "order_book.h"
+#include "mbo_parser.h"
+
+// Routes MBO events to one order book per instrument. Books are created the
+// first time an instrument is seen and live in a stable pool; clear() hands
+// them back to the pool so a new session reuses their storage. Instrument
+// ids below DENSE_ID_LIMIT resolve through a flat id->slot table, larger
+// ids through a hash map.
+template <typename Book>
+class BookManager {
+public:
+    static constexpr uint32_t DENSE_ID_LIMIT = 1u << 20;
+    
+    BookManager();
+    
+    ProcessResult processEvent(const MboEvent& event) { return getBook(event.instrument_id).processEvent(event); }
+    
+    // Returns the book for instrument_id, creating it if absent
+    Book& getBook(uint32_t instrument_id) {
+        uint32_t slot = slotOf(instrument_id);
+        return slot != NO_SLOT ? books_[slot] : createBook(instrument_id);
+    }
+    
+    Book* findBook(uint32_t instrument_id) {
+        uint32_t slot = slotOf(instrument_id);
+        return slot != NO_SLOT ? &books_[slot] : nullptr;
+    }
+    
+    const Book* findBook(uint32_t instrument_id) const {
+        uint32_t slot = slotOf(instrument_id);
+        return slot != NO_SLOT ? &books_[slot] : nullptr;
+    }
+    
+    // Visits fn(instrument_id, book) for every active book in creation order
+    template <typename Fn>
+    void forEachBook(Fn&& fn) const {
+        for (uint32_t slot : active_slots_) {
+            fn(instrument_ids_[slot], books_[slot]);
+        }
+    }
+    
+    // Order table size for books created from now on, overridden per
+    // instrument by setOrderCapacity(); an existing book is grown in place
+    void setDefaultOrderCapacity(size_t order_capacity) { default_order_capacity_ = order_capacity; }
+    void setOrderCapacity(uint32_t instrument_id, size_t order_capacity);
+    
+    size_t size() const { return active_slots_.size(); }
+    bool empty() const { return active_slots_.empty(); }
+    
+    // Aggregates across all books
+    size_t getOrderCount() const;
+    size_t getBidLevelCount() const;
+    size_t getAskLevelCount() const;
+    
+    void clear();
+
+private:
+    static constexpr uint32_t NO_SLOT = UINT32_MAX;
+    
+    std::deque<Book> books_;
+    std::vector<uint32_t> instrument_ids_;
+    std::vector<uint32_t> active_slots_;
+    std::vector<uint32_t> free_slots_;
+    std::vector<uint32_t> dense_slots_;
+    std::unordered_map<uint32_t, uint32_t> sparse_slots_;
+    std::unordered_map<uint32_t, size_t> order_capacities_;
+    size_t default_order_capacity_;
+    
+    uint32_t slotOf(uint32_t instrument_id) const {
+        if (instrument_id < DENSE_ID_LIMIT) {
+            return instrument_id < dense_slots_.size() ? dense_slots_[instrument_id] : NO_SLOT;
+        }
+        auto it = sparse_slots_.find(instrument_id);
+        return it != sparse_slots_.end() ? it->second : NO_SLOT;
+    }
+    
+    Book& createBook(uint32_t instrument_id);
+};
+
+extern template class BookManager<OrderBook>;
+extern template class BookManager<LadderOrderBook>;
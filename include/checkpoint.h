@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <type_traits>
+
+// Binary checkpoint streams. Values go out field by field in native byte
+// order, so a checkpoint is read back by the same build that wrote it; the
+// file header's magic and version reject anything else.
+namespace checkpoint {
+
+constexpr char MAGIC[8] = {'M', 'B', 'O', 'C', 'K', 'P', 'T', '1'};
+constexpr uint32_t VERSION = 1;
+
+class Writer {
+public:
+    explicit Writer(std::ostream& out) : out_(out) {}
+    
+    template <typename T>
+    void put(const T& value) {
+        static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "checkpoint fields are scalars");
+        out_.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+    
+    void putBytes(const void* data, size_t size) { out_.write(static_cast<const char*>(data), static_cast<std::streamsize>(size)); }
+    
+    bool ok() const { return static_cast<bool>(out_); }
+
+private:
+    std::ostream& out_;
+};
+
+// Every get fails once the stream has failed, so callers check ok() once
+// after reading a whole record
+class Reader {
+public:
+    explicit Reader(std::istream& in) : in_(in) {}
+    
+    template <typename T>
+    bool get(T& value) {
+        static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "checkpoint fields are scalars");
+        return getBytes(&value, sizeof(T));
+    }
+    
+    bool getBytes(void* data, size_t size) {
+        in_.read(static_cast<char*>(data), static_cast<std::streamsize>(size));
+        return ok();
+    }
+    
+    bool ok() const { return static_cast<bool>(in_); }
+    
+    // Bytes left before the end of the stream, or UNKNOWN_SIZE when the
+    // stream cannot seek. Lets readers bound a count before trusting it.
+    static constexpr uint64_t UNKNOWN_SIZE = UINT64_MAX;
+    
+    uint64_t remaining() {
+        std::istream::pos_type here = in_.tellg();
+        if (here == std::istream::pos_type(-1)) {
+            return UNKNOWN_SIZE;
+        }
+        in_.seekg(0, std::ios::end);
+        std::istream::pos_type end = in_.tellg();
+        in_.seekg(here);
+        if (end == std::istream::pos_type(-1) || !in_) {
+            in_.clear();
+            in_.seekg(here);
+            return UNKNOWN_SIZE;
+        }
+        return static_cast<uint64_t>(end - here);
+    }
+
+private:
+    std::istream& in_;
+};
+
+} // namespace checkpoint
+
+// Where in the input a checkpoint was taken. Resuming continues from
+// input_offset, the first byte after the last event the checkpoint covers.
+struct CheckpointPosition {
+    uint64_t events_consumed;
+    uint64_t input_offset;
+    uint64_t last_sequence;
+    int64_t last_ts_event;
+    
+    CheckpointPosition() : events_consumed(0), input_offset(0), last_sequence(0), last_ts_event(0) {}
+};
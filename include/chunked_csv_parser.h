@@ -0,0 +1,84 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "mbo_parser.h"
+#include "packed_event.h"
+
+// Symbol column of an instrument's first row within a chunk
+struct ChunkSymbol {
+    uint32_t instrument_id;
+    uint16_t publisher_id;
+    std::string symbol;
+};
+
+// Rows [begin, end) of the input, parsed and packed
+struct ParsedChunk {
+    size_t begin;
+    size_t end;
+    PackedEventBatch events;
+    std::vector<ChunkSymbol> symbols;
+    size_t skipped_lines;
+    
+    ParsedChunk() : begin(0), end(0), skipped_lines(0) {}
+};
+
+// Parses an in-memory MBO CSV body on several threads. The input is cut
+// into chunks of about chunk_bytes, each ending on a newline, and worker
+// threads parse them concurrently into per-chunk event arrays, which
+// nextChunk() then hands out strictly in file order. Workers stay at most
+// a few chunks ahead of the consumer, so memory use is bounded by the
+// window rather than by the input size.
+class ChunkedCsvParser {
+public:
+    static constexpr size_t DEFAULT_CHUNK_BYTES = 4 * 1024 * 1024;
+    
+    // data must stay valid for the parser's lifetime; offsets in the
+    // chunks are relative to it. Symbols are only collected if asked for.
+    // Worker i is pinned to cores[i % cores.size()] when cores are given.
+    ChunkedCsvParser(const char* data, size_t begin, size_t end, size_t threads, size_t chunk_bytes = DEFAULT_CHUNK_BYTES,
+                     bool collect_symbols = false, const std::vector<int>& cores = std::vector<int>());
+    ~ChunkedCsvParser();
+    
+    ChunkedCsvParser(const ChunkedCsvParser&) = delete;
+    ChunkedCsvParser& operator=(const ChunkedCsvParser&) = delete;
+    
+    // Waits for and returns the next chunk in order, or nullptr after the
+    // last one. The chunk stays valid until the next call.
+    const ParsedChunk* nextChunk();
+
+private:
+    struct Slot {
+        ParsedChunk chunk;
+        bool ready;
+        
+        Slot() : ready(false) {}
+    };
+    
+    const char* data_;
+    size_t end_;
+    size_t chunk_bytes_;
+    bool collect_symbols_;
+    
+    // Chunk i is parsed into slots_[i % slots_.size()]; a slot is reused
+    // once its chunk has been handed out and released
+    std::vector<Slot> slots_;
+    size_t next_begin_;
+    size_t claimed_;
+    size_t served_;
+    bool holding_;
+    bool stopping_;
+    
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable work_ready_;
+    std::condition_variable chunk_ready_;
+    
+    void run();
+    void parse(ParsedChunk& chunk) const;
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <unordered_map>
+#include "order_book.h"
+
+// Writer stand-in for conflated output: keeps only the latest snapshot of
+// each instrument until flushTo() passes the window's snapshots on to the
+// real writer, in the order the instruments first changed in the window.
+// Slots are reused across windows, so steady state does not allocate.
+class ConflatingWriter {
+public:
+    ConflatingWriter() : rows_written_(0) {}
+    
+    bool writeSnapshot(const MbpSnapshot& snapshot, uint64_t row_index = 0) {
+        (void)row_index;
+        
+        auto it = slot_of_.find(snapshot.instrument_id);
+        if (it == slot_of_.end()) {
+            it = slot_of_.emplace(snapshot.instrument_id, slots_.size()).first;
+            slots_.push_back(snapshot);
+            pending_flags_.push_back(false);
+        }
+        
+        size_t slot = it->second;
+        slots_[slot] = snapshot;
+        if (!pending_flags_[slot]) {
+            pending_flags_[slot] = true;
+            pending_.push_back(slot);
+        }
+        return true;
+    }
+    
+    // Writes one row per instrument that changed since the last flush and
+    // returns how many were written
+    template <typename Writer>
+    size_t flushTo(Writer& writer) {
+        size_t written = 0;
+        for (size_t slot : pending_) {
+            pending_flags_[slot] = false;
+            if (writer.writeSnapshot(slots_[slot], rows_written_)) {
+                rows_written_++;
+                written++;
+            }
+        }
+        pending_.clear();
+        return written;
+    }
+    
+    uint64_t getRowsWritten() const { return rows_written_; }
+
+private:
+    std::unordered_map<uint32_t, size_t> slot_of_;
+    std::vector<MbpSnapshot> slots_;
+    std::vector<bool> pending_flags_;
+    std::vector<size_t> pending_;
+    uint64_t rows_written_;
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "mbo_event_source.h"
+#include "symbology.h"
+
+// Databento DBN MBO file reader, for plain .dbn files and zstd-compressed
+// ones (the latter needs a build with ZSTD=1). A helper thread reads and
+// decompresses the next buffer while records are decoded from the current
+// one, and cuts every buffer on a record boundary, so next() decodes the
+// fixed-width records in place without any text parsing.
+//
+// Symbols come from the symbol mappings in the metadata header and are
+// recorded the same way the CSV reader records its symbol column.
+class DbnFileReader final : public MboEventSource {
+public:
+    explicit DbnFileReader(const std::string& filename);
+    ~DbnFileReader() override;
+    
+    DbnFileReader(const DbnFileReader&) = delete;
+    DbnFileReader& operator=(const DbnFileReader&) = delete;
+    
+    // Reads the metadata header and starts the helper thread
+    bool open();
+    void close();
+    
+    // When set, the symbol of each newly seen instrument is recorded here
+    void setSymbology(SymbologyTable* symbology) { symbology_ = symbology; }
+    
+    // Pull the next MBO event; returns false at end of file
+    bool next(MboEvent& event) override;
+    
+    uint8_t getVersion() const { return version_; }
+    
+    // Records of other types (status, definitions, ...) passed over
+    size_t getSkippedRecords() const { return skipped_records_; }
+    
+    // Names ending in .dbn or .dbn.zst
+    static bool isDbnFile(const std::string& filename);
+
+private:
+    std::string filename_;
+    std::FILE* file_;
+    bool compressed_;
+    void* zstd_stream_;
+    bool zstd_frame_done_;
+    
+    // Raw bytes from the file: compressed input, or for a plain file the
+    // few bytes read to tell the two apart
+    std::vector<char> raw_buffer_;
+    size_t raw_pos_;
+    size_t raw_used_;
+    bool raw_eof_;
+    
+    uint8_t version_;
+    SymbologyTable* symbology_;
+    std::unordered_map<uint32_t, std::string> mapped_symbols_;
+    uint32_t last_instrument_id_;
+    bool has_last_instrument_;
+    size_t skipped_records_;
+    
+    // Records are decoded from front_[front_pos_, front_used_)
+    std::vector<char> front_;
+    size_t front_pos_;
+    size_t front_used_;
+    
+    // Owned by the helper thread while a fill is pending: back_ receives
+    // whole records, carry_ the partial record cut off at the end of a read
+    std::vector<char> back_;
+    size_t back_used_;
+    std::vector<char> carry_;
+    bool fill_pending_;
+    bool input_done_;
+    bool stopping_;
+    std::string error_;
+    
+    std::thread io_thread_;
+    std::mutex mutex_;
+    std::condition_variable work_ready_;
+    std::condition_variable work_done_;
+    
+    static constexpr size_t BUFFER_SIZE = 1024 * 1024;
+    
+    // Swaps in the buffer the helper thread filled and starts the next fill
+    bool nextBuffer();
+    
+    // Reads up to size bytes of the decompressed stream
+    size_t readInput(char* out, size_t size);
+    bool readMetadata();
+    void fill();
+    void run();
+};
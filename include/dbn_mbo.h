@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include "mbo_parser.h"
+
+// Databento DBN MBO records (RecordHeader + MboMsg, 56 bytes, little
+// endian). Records are decoded field by field straight from the buffer they
+// arrived in into an MboEvent; nothing is staged in between.
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "DBN records are decoded in host byte order and require a little-endian target"
+#endif
+
+namespace dbn_mbo {
+
+// DBN rtype for MBO records
+constexpr uint8_t RTYPE_MBO = 0xA0;
+
+// DBN sentinel for a missing price; MboEvent uses 0
+constexpr Price UNDEF_PRICE = INT64_MAX;
+
+struct Record {
+    // DBN RecordHeader; length is in 4-byte units
+    uint8_t length;
+    uint8_t rtype;
+    uint16_t publisher_id;
+    uint32_t instrument_id;
+    uint64_t ts_event;
+    
+    // DBN MboMsg
+    uint64_t order_id;
+    int64_t price;
+    uint32_t size;
+    uint8_t flags;
+    uint8_t channel_id;
+    char action;
+    char side;
+    uint64_t ts_recv;
+    int32_t ts_in_delta;
+    uint32_t sequence;
+};
+
+static_assert(sizeof(Record) == 56, "DBN MBO record must be 56 bytes");
+
+constexpr size_t HEADER_SIZE = 16;
+constexpr size_t RECORD_SIZE = sizeof(Record);
+
+// Size of the record starting at data as its header states it, or 0 if
+// fewer than a header's bytes are available or the length is zero
+inline size_t recordSize(const char* data, size_t available) {
+    if (available < HEADER_SIZE) {
+        return 0;
+    }
+    return static_cast<size_t>(static_cast<uint8_t>(data[0])) * 4;
+}
+
+inline uint8_t recordType(const char* data) {
+    return static_cast<uint8_t>(data[1]);
+}
+
+template <typename T>
+inline T load(const char* data, size_t offset) {
+    T value;
+    std::memcpy(&value, data + offset, sizeof(T));
+    return value;
+}
+
+// Decodes the MBO record at data, which must hold size bytes as returned by
+// recordSize(); returns false if it is not a complete MBO record
+inline bool decode(const char* data, size_t size, MboEvent& event) {
+    if (size < RECORD_SIZE || recordType(data) != RTYPE_MBO) {
+        return false;
+    }
+    event.publisher_id = load<uint16_t>(data, offsetof(Record, publisher_id));
+    event.instrument_id = load<uint32_t>(data, offsetof(Record, instrument_id));
+    event.ts_event = std::chrono::nanoseconds(static_cast<int64_t>(load<uint64_t>(data, offsetof(Record, ts_event))));
+    event.order_id = load<uint64_t>(data, offsetof(Record, order_id));
+    Price price = load<int64_t>(data, offsetof(Record, price));
+    event.price = price == UNDEF_PRICE ? 0 : price;
+    event.size = load<uint32_t>(data, offsetof(Record, size));
+    event.flags = load<uint8_t>(data, offsetof(Record, flags));
+    event.channel_id = load<uint8_t>(data, offsetof(Record, channel_id));
+    event.action = load<char>(data, offsetof(Record, action));
+    event.side = load<char>(data, offsetof(Record, side));
+    event.ts_recv = std::chrono::nanoseconds(static_cast<int64_t>(load<uint64_t>(data, offsetof(Record, ts_recv))));
+    event.ts_in_delta = load<int32_t>(data, offsetof(Record, ts_in_delta));
+    event.sequence = load<uint32_t>(data, offsetof(Record, sequence));
+    return true;
+}
+
+// The inverse of decode(), for producing feeds and test input. Events
+// parsed from CSV have no ts_recv, so ts_event stands in for it.
+inline void encode(const MboEvent& event, Record& record) {
+    std::memset(&record, 0, sizeof(record));
+    record.length = static_cast<uint8_t>(RECORD_SIZE / 4);
+    record.rtype = RTYPE_MBO;
+    record.publisher_id = event.publisher_id;
+    record.instrument_id = event.instrument_id;
+    record.ts_event = static_cast<uint64_t>(event.ts_event.count());
+    record.order_id = event.order_id;
+    record.price = event.action == 'R' && event.price == 0 ? UNDEF_PRICE : event.price;
+    record.size = static_cast<uint32_t>(event.size);
+    record.flags = event.flags;
+    record.channel_id = event.channel_id;
+    record.action = event.action;
+    record.side = event.side;
+    record.ts_recv = event.ts_recv.count() != 0 ? static_cast<uint64_t>(event.ts_recv.count()) : record.ts_event;
+    record.ts_in_delta = event.ts_in_delta;
+    record.sequence = static_cast<uint32_t>(event.sequence);
+}
+
+} // namespace dbn_mbo
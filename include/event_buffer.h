@@ -1,12 +1,13 @@
 #pragma once
 
 #include "mbo_parser.h"
+#include "packed_event.h"
 #include <vector>
 #include <chrono>
-#include <unordered_map>
-#include <unordered_set>
+#include <cstdint>
 
-// Event buffer for consolidating high-frequency trading events
+// Event buffer for consolidating high-frequency trading events. The window
+// is held packed, so both passes stream through 32 bytes an event.
 class EventBuffer {
 public:
     EventBuffer();
@@ -16,10 +17,27 @@ public:
     bool isEmpty() const;
     size_t size() const;
     
+    // Drops add/cancel pairs of the same order within the window. An order
+    // that is also filled or modified in the window is left alone, since
+    // those events still need it in the book.
     size_t applyOrderAnnihilation();
+    
+    // Merges adds (and cancels) at the same instrument, side and price into
+    // the first of them, summing sizes and keeping the lowest sequence
     size_t applySameLevelBatching();
     
-    const std::vector<MboEvent>& getConsolidatedEvents() const;
+    // Calls fn(const MboEvent&) for each surviving event, in order
+    template <typename Fn>
+    void forEachEvent(Fn&& fn) const {
+        MboEvent event;
+        for (size_t i = 0; i < events_.size(); ++i) {
+            events_.unpack(i, event);
+            fn(event);
+        }
+    }
+    
+    // The surviving events unpacked into a vector, for inspection
+    std::vector<MboEvent> getConsolidatedEvents() const;
     void clear();
     
     struct ConsolidationStats {
@@ -34,12 +52,32 @@ public:
 private:
     static constexpr std::chrono::nanoseconds WINDOW_THRESHOLD = std::chrono::milliseconds(1);
     
-    std::vector<MboEvent> events_;
+    // Open-addressing table shared by both passes and kept across windows.
+    // A slot is live only if its generation matches the current pass, so
+    // starting a pass does not touch the slots.
+    struct Slot {
+        uint64_t key;
+        uint64_t tag;
+        uint32_t generation;
+        bool touched;
+        uint32_t adds;
+        uint32_t cancels;
+        uint32_t adds_removed;
+        uint32_t cancels_removed;
+        uint32_t leader;
+    };
+    
+    PackedEventBatch events_;
     std::chrono::nanoseconds window_timestamp_;
     ConsolidationStats last_stats_;
     
+    std::vector<Slot> slots_;
+    size_t slot_mask_;
+    uint32_t generation_;
+    
     bool belongsToCurrentWindow(const MboEvent& event) const;
-    void consolidateAtPriceLevel(const std::string& key, 
-                                std::vector<MboEvent>& group_events,
-                                std::vector<MboEvent>& consolidated_result);
+    void beginPass();
+    Slot& findSlot(uint64_t key, uint64_t tag, bool& inserted);
+    
+    static uint64_t makeTag(const PackedMboEvent& event, bool with_level);
 };
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Opt-in latency instrumentation. Building with -DORDERBOOK_LATENCY (make
+// LATENCY=1) times event processing, snapshot generation and row emission
+// with the TSC; without it LatencyTimer is empty and every timing point
+// compiles away.
+#ifdef ORDERBOOK_LATENCY
+constexpr bool LATENCY_ENABLED = true;
+#else
+constexpr bool LATENCY_ENABLED = false;
+#endif
+
+// Cycle counter where there is one, steady_clock nanoseconds elsewhere
+inline uint64_t readCycles() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// Counter ticks per nanosecond, measured once against steady_clock
+double cyclesPerNanosecond();
+
+// Log-linear histogram in the style of HdrHistogram: values below
+// SUB_BUCKETS are counted exactly, larger ones in SUB_BUCKETS buckets per
+// power of two, so a recorded value is off by at most 1/SUB_BUCKETS.
+// Recording is a few instructions and never allocates.
+class LatencyHistogram {
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 5;
+    static constexpr size_t SUB_BUCKETS = size_t(1) << SUB_BUCKET_BITS;
+    static constexpr size_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+    
+    LatencyHistogram() : counts_(), count_(0), max_(0) {}
+    
+    void record(uint64_t value) {
+        ++counts_[bucketOf(value)];
+        ++count_;
+        if (value > max_) {
+            max_ = value;
+        }
+    }
+    
+    // Smallest value v such that a fraction q of the samples is <= v, as
+    // the top of v's bucket and never above the largest sample
+    uint64_t percentile(double q) const;
+    
+    uint64_t getCount() const { return count_; }
+    uint64_t getMax() const { return max_; }
+    
+    void merge(const LatencyHistogram& other);
+    void clear();
+    
+    static size_t bucketOf(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return static_cast<size_t>(value);
+        }
+        unsigned shift = highestBit(value) - SUB_BUCKET_BITS;
+        return (shift + 1) * SUB_BUCKETS + static_cast<size_t>((value >> shift) - SUB_BUCKETS);
+    }
+    
+    // Largest value that falls into bucket
+    static uint64_t bucketTop(size_t bucket);
+
+private:
+    static unsigned highestBit(uint64_t value) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        return static_cast<unsigned>(index);
+#else
+        return static_cast<unsigned>(63 - __builtin_clzll(value));
+#endif
+    }
+    
+    std::array<uint64_t, BUCKET_COUNT> counts_;
+    uint64_t count_;
+    uint64_t max_;
+};
+
+// What a latency sample timed: processEvent per action type, then
+// snapshot generation and handing the snapshot to the writer
+enum class LatencyStage : size_t {
+    ADD,
+    CANCEL,
+    TRADE,
+    FILL,
+    RESET,
+    OTHER,
+    SNAPSHOT,
+    EMIT,
+    COUNT
+};
+
+inline LatencyStage latencyStageOf(char action) {
+    switch (action) {
+        case 'A': return LatencyStage::ADD;
+        case 'C': return LatencyStage::CANCEL;
+        case 'T': return LatencyStage::TRADE;
+        case 'F': return LatencyStage::FILL;
+        case 'R': return LatencyStage::RESET;
+        default: return LatencyStage::OTHER;
+    }
+}
+
+const char* latencyStageName(LatencyStage stage);
+
+// One histogram per stage, in counter ticks. A recorder that is not
+// enabled holds no histograms and ignores merges.
+class LatencyRecorder {
+public:
+    explicit LatencyRecorder(bool enabled = LATENCY_ENABLED);
+    
+    bool isEnabled() const { return !histograms_.empty(); }
+    
+    void record(LatencyStage stage, uint64_t cycles) { histograms_[static_cast<size_t>(stage)].record(cycles); }
+    
+    const LatencyHistogram& getHistogram(LatencyStage stage) const { return histograms_[static_cast<size_t>(stage)]; }
+    
+    void merge(const LatencyRecorder& other);
+    
+    // p50/p99/p99.9/max per stage in nanoseconds, for stages with samples
+    void report(std::ostream& out) const;
+    
+    // The same figures as CSV rows tagged with events, for a metrics file
+    // appended to periodically; writeMetricsHeader() starts the file
+    static void writeMetricsHeader(std::ostream& out);
+    void writeMetrics(std::ostream& out, uint64_t events) const;
+
+private:
+    std::vector<LatencyHistogram> histograms_;
+};
+
+// Times its own scope into recorder under stage
+class LatencyTimer {
+public:
+#ifdef ORDERBOOK_LATENCY
+    LatencyTimer(LatencyRecorder& recorder, LatencyStage stage)
+        : recorder_(recorder), stage_(stage), start_(readCycles()) {}
+    ~LatencyTimer() { recorder_.record(stage_, readCycles() - start_); }
+#else
+    LatencyTimer(LatencyRecorder&, LatencyStage) {}
+#endif
+
+    LatencyTimer(const LatencyTimer&) = delete;
+    LatencyTimer& operator=(const LatencyTimer&) = delete;
+
+#ifdef ORDERBOOK_LATENCY
+private:
+    LatencyRecorder& recorder_;
+    LatencyStage stage_;
+    uint64_t start_;
+#endif
+};
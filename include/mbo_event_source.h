@@ -0,0 +1,14 @@
+#pragma once
+
+#include "mbo_parser.h"
+
+// Anything that hands out MBO events one at a time: the CSV file reader
+// for replay, the network feed for live ingest. The replay loops pull from
+// this, so a live session runs exactly the code a replay does.
+class MboEventSource {
+public:
+    virtual ~MboEventSource() {}
+    
+    // Pull the next event; returns false once the source is exhausted
+    virtual bool next(MboEvent& event) = 0;
+};
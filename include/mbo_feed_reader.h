@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "mbo_event_source.h"
+#include "packet_receiver.h"
+
+// Datagram framing for the live feed: a packet sequence number and record
+// count, then that many DBN MBO records back to back. Consecutive packets
+// carry consecutive sequence numbers, which is how loss is detected.
+namespace mbo_feed {
+
+struct PacketHeader {
+    uint64_t sequence;
+    uint16_t record_count;
+    uint16_t reserved;
+    uint32_t reserved2;
+};
+
+static_assert(sizeof(PacketHeader) == 16, "feed packet header must be 16 bytes");
+
+} // namespace mbo_feed
+
+struct FeedStats {
+    uint64_t packets;
+    uint64_t records;
+    uint64_t gaps;
+    uint64_t packets_lost;
+    uint64_t stale_packets;
+    uint64_t malformed_packets;
+    uint64_t resets_issued;
+    
+    FeedStats() : packets(0), records(0), gaps(0), packets_lost(0), stale_packets(0), malformed_packets(0), resets_issued(0) {}
+};
+
+// Live MBO events from a PacketReceiver, decoded in place from the receive
+// buffers. next() busy-polls the receiver while nothing has arrived.
+//
+// When a packet sequence gap shows that packets were lost, every book seen
+// so far can no longer be trusted: before the first event after the gap,
+// next() hands out an 'R' event for each of those instruments, so the
+// engine clears them through the ordinary reset path and rebuilds them from
+// the adds that follow. Late or duplicate packets are dropped.
+class MboFeedReader final : public MboEventSource {
+public:
+    explicit MboFeedReader(PacketReceiver& receiver);
+    
+    bool next(MboEvent& event) override;
+    
+    // Ends the feed once the packet being decoded is done; safe to call from
+    // another thread or a signal handler
+    void stop() { stopped_.store(true, std::memory_order_relaxed); }
+    
+    // Ends the feed after this long without a packet; zero waits forever
+    void setIdleTimeout(std::chrono::milliseconds timeout) { idle_timeout_ = timeout; }
+    
+    const FeedStats& getStats() const { return stats_; }
+
+private:
+    PacketReceiver& receiver_;
+    PacketBatch batch_;
+    size_t packet_index_;
+    
+    // The packet being decoded
+    const char* cursor_;
+    const char* packet_end_;
+    size_t records_left_;
+    
+    uint64_t expected_sequence_;
+    bool has_sequence_;
+    
+    std::vector<uint32_t> instruments_;
+    uint32_t last_instrument_id_;
+    std::chrono::nanoseconds last_ts_event_;
+    std::vector<MboEvent> pending_resets_;
+    
+    std::atomic<bool> stopped_;
+    std::chrono::milliseconds idle_timeout_;
+    FeedStats stats_;
+    
+    bool nextPacket();
+    bool acceptPacket(const char* data, size_t length);
+    void noteInstrument(uint32_t instrument_id);
+};
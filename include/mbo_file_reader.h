@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include "mbo_parser.h"
+#include "chunked_csv_parser.h"
+#include "mbo_event_source.h"
+#include "symbology.h"
+
+// MBO CSV reader. Regular files are memory-mapped and rows are parsed in
+// place from the mapped bytes; "-" (stdin), pipes and other unmappable
+// inputs are read through a chunk buffer instead. Rows are handed out one
+// at a time, so memory use stays flat regardless of input size.
+//
+// With more than one parse thread, a mapped file is parsed ahead in chunks
+// by a ChunkedCsvParser and its events are still handed out in file order.
+class MboFileReader final : public MboEventSource {
+public:
+    explicit MboFileReader(const std::string& filename);
+    ~MboFileReader() override;
+    
+    MboFileReader(const MboFileReader&) = delete;
+    MboFileReader& operator=(const MboFileReader&) = delete;
+    
+    bool open();
+    
+    // Reads from an already open stream, which stays owned by the caller
+    bool open(std::FILE* stream);
+    void close();
+    
+    bool isStreaming() const { return stream_ != nullptr; }
+    
+    // When set, the symbol of each newly seen instrument is recorded here
+    void setSymbology(SymbologyTable* symbology) { symbology_ = symbology; }
+    
+    // Set before open(). Streamed input is always parsed on the calling
+    // thread, and getBytesConsumed() only advances chunk by chunk.
+    void setParseThreads(size_t threads, size_t chunk_bytes = ChunkedCsvParser::DEFAULT_CHUNK_BYTES) {
+        parse_threads_ = threads;
+        chunk_bytes_ = chunk_bytes;
+    }
+    
+    // Set before open(); cores the parse threads are pinned to, round-robin
+    void setParseCores(const std::vector<int>& cores) { parse_cores_ = cores; }
+    
+    // Pull the next event; returns false at end of file
+    bool next(MboEvent& event) override;
+    
+    // Continues reading at byte offset of the input, as returned earlier by
+    // getBytesConsumed(). Mapped files jump there directly; streams read and
+    // drop the bytes in between, so they can only move forward.
+    bool seek(size_t offset);
+    
+    // Push every remaining event to fn(const MboEvent&); returns the count
+    template <typename Fn>
+    size_t forEach(Fn&& fn) {
+        size_t count = 0;
+        MboEvent event;
+        while (next(event)) {
+            fn(event);
+            ++count;
+        }
+        return count;
+    }
+    
+    // Zero for streamed input, whose size is not known up front
+    size_t getFileSize() const { return file_size_; }
+    size_t getBytesConsumed() const { return stream_offset_ + (cursor_ ? static_cast<size_t>(cursor_ - data_) : 0); }
+    size_t getSkippedLines() const { return skipped_lines_; }
+
+private:
+    std::string filename_;
+    const char* data_;
+    const char* cursor_;
+    const char* end_;
+    size_t file_size_;
+    size_t released_bytes_;
+    size_t skipped_lines_;
+    SymbologyTable* symbology_;
+    uint32_t last_instrument_id_;
+    bool has_last_instrument_;
+    
+    // Streamed input: data_..end_ is the unparsed tail of stream_buffer_, and
+    // stream_offset_ counts the bytes already dropped from its front
+    std::FILE* stream_;
+    bool owns_stream_;
+    bool stream_eof_;
+    size_t stream_offset_;
+    std::vector<char> stream_buffer_;
+    
+    // Parallel parsing: events are handed out from chunk_ in order
+    size_t parse_threads_;
+    size_t chunk_bytes_;
+    std::vector<int> parse_cores_;
+    std::unique_ptr<ChunkedCsvParser> chunk_parser_;
+    const ParsedChunk* chunk_;
+    size_t chunk_pos_;
+
+#ifdef _WIN32
+    void* file_handle_;
+    void* mapping_handle_;
+#else
+    int fd_;
+#endif
+
+    // Consumed pages are handed back to the kernel in steps of this size
+    static constexpr size_t RELEASE_STEP = 16 * 1024 * 1024;
+    static constexpr size_t STREAM_CHUNK = 1024 * 1024;
+    
+    void releaseConsumed();
+    bool nextParsed(MboEvent& event);
+    
+    // Returns the end of the line starting at cursor_, reading more input if
+    // needed; may move the buffered bytes, so cursor_ is only valid after it
+    const char* findLineEnd();
+    bool refill();
+    bool openStream();
+    void skipHeader();
+};
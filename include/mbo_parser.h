@@ -4,34 +4,72 @@
 #include <string>
 #include <vector>
 #include <chrono>
+#include "price.h"
 
 // MBO event structure
 struct MboEvent {
     std::chrono::nanoseconds ts_event;
     char action;
     char side;
-    double price;
+    Price price;
     uint64_t size;
     uint64_t order_id;
     uint8_t flags;
     int32_t ts_in_delta;
     uint64_t sequence;
+    uint32_t instrument_id;
+    uint16_t publisher_id;
     
-    MboEvent() : ts_event(0), action('\0'), side('\0'), price(0.0), size(0), order_id(0), flags(0), ts_in_delta(0), sequence(0) {}
+    // Carried by DBN input only; the CSV parser leaves them zero
+    std::chrono::nanoseconds ts_recv;
+    uint8_t channel_id;
     
-    MboEvent(std::chrono::nanoseconds ts, char act, char sd, double pr, uint64_t sz, uint64_t oid)
-        : ts_event(ts), action(act), side(sd), price(pr), size(sz), order_id(oid), flags(0), ts_in_delta(0), sequence(0) {}
+    MboEvent() : ts_event(0), action('\0'), side('\0'), price(0), size(0), order_id(0), flags(0), ts_in_delta(0), sequence(0),
+                 instrument_id(0), publisher_id(0), ts_recv(0), channel_id(0) {}
+    
+    MboEvent(std::chrono::nanoseconds ts, char act, char sd, Price pr, uint64_t sz, uint64_t oid)
+        : ts_event(ts), action(act), side(sd), price(pr), size(sz), order_id(oid), flags(0), ts_in_delta(0), sequence(0),
+          instrument_id(0), publisher_id(0), ts_recv(0), channel_id(0) {}
 };
 
 // High-performance MBO CSV parser
 class MboParser {
 public:
-    static std::vector<MboEvent> parseFile(const std::string& filename);
+    // With parse_threads > 1 the file is parsed in chunks concurrently
+    static std::vector<MboEvent> parseFile(const std::string& filename, size_t parse_threads = 1);
     static bool parseLine(const char* line, MboEvent& event);
+    static bool parseLine(const char* line, const char* end, MboEvent& event);
+    
+    // Low-level pieces of parseLine, exposed for testing
+    static size_t findFieldStarts(const char* line, const char* end, const char** starts, size_t max_fields);
+    static bool parseTimestamp(const char* begin, const char* end, std::chrono::nanoseconds& timestamp);
+    
+    // Locates the symbol column of a row; returns false if the row has none
+    static bool findSymbol(const char* line, const char* end, const char** symbol_begin, const char** symbol_end);
     
 private:
-    static std::chrono::nanoseconds parseTimestamp(const char* timestamp_str);
-    static double fastParseDouble(const char* str, char** endptr);
-    static uint64_t fastParseUInt64(const char* str, char** endptr);
-    static const char* skipToNextField(const char* ptr);
+    // Column positions in the Databento MBO CSV layout
+    enum Field : size_t {
+        FIELD_TS_RECV = 0,
+        FIELD_TS_EVENT,
+        FIELD_RTYPE,
+        FIELD_PUBLISHER_ID,
+        FIELD_INSTRUMENT_ID,
+        FIELD_ACTION,
+        FIELD_SIDE,
+        FIELD_PRICE,
+        FIELD_SIZE,
+        FIELD_CHANNEL_ID,
+        FIELD_ORDER_ID,
+        FIELD_FLAGS,
+        FIELD_TS_IN_DELTA,
+        FIELD_SEQUENCE,
+        FIELD_SYMBOL,
+        FIELD_COUNT
+    };
+    
+    static std::chrono::nanoseconds parseTimestampSlow(const char* timestamp_str);
+    static Price fastParsePrice(const char* str, const char* end, const char** endptr);
+    static uint64_t fastParseUInt64(const char* str, const char* end, const char** endptr);
+    static int64_t fastParseInt64(const char* str, const char* end, const char** endptr);
 };
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "price.h"
+
+// Fixed-size little-endian MBP-10 records. The record body follows the
+// Databento DBN MBP-10 layout (RecordHeader + Mbp10Msg, 368 bytes), so a DBN
+// file body can be read with the same struct. The native layout appends the
+// triggering order id, which DBN MBP-10 does not carry but output.csv does.
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "MBP binary records are written in host byte order and require a little-endian target"
+#endif
+
+namespace mbp_binary {
+
+constexpr char MAGIC[8] = {'M', 'B', 'P', '1', '0', 'B', 'I', 'N'};
+constexpr uint16_t SCHEMA_VERSION = 1;
+
+// DBN rtype for MBP-10 records
+constexpr uint8_t RTYPE_MBP10 = 0x0A;
+
+// DBN sentinel for a missing price; an empty level is 0 in MbpSnapshot
+constexpr Price UNDEF_PRICE = INT64_MAX;
+
+constexpr size_t DEPTH = 10;
+constexpr size_t SYMBOL_LENGTH = 16;
+
+enum Layout : uint16_t {
+    LAYOUT_NATIVE = 0,  // DBN MBP-10 record followed by uint64 order_id
+    LAYOUT_DBN = 1      // Plain DBN MBP-10 record
+};
+
+struct BidAskPair {
+    int64_t bid_px;
+    int64_t ask_px;
+    uint32_t bid_sz;
+    uint32_t ask_sz;
+    uint32_t bid_ct;
+    uint32_t ask_ct;
+};
+
+struct Record {
+    // DBN RecordHeader; length is in 4-byte units
+    uint8_t length;
+    uint8_t rtype;
+    uint16_t publisher_id;
+    uint32_t instrument_id;
+    uint64_t ts_event;
+    
+    // DBN Mbp10Msg
+    int64_t price;
+    uint32_t size;
+    char action;
+    char side;
+    uint8_t flags;
+    uint8_t depth;
+    uint64_t ts_recv;
+    int32_t ts_in_delta;
+    uint32_t sequence;
+    BidAskPair levels[DEPTH];
+};
+
+struct NativeRecord {
+    Record record;
+    uint64_t order_id;
+};
+
+// 64-byte file header; record_count is filled in when the writer closes
+struct FileHeader {
+    char magic[8];
+    uint16_t version;
+    uint16_t layout;
+    uint32_t record_size;
+    uint64_t record_count;
+    uint16_t publisher_id;
+    uint16_t reserved;
+    uint32_t instrument_id;
+    int64_t price_scale;
+    char symbol[SYMBOL_LENGTH];
+    uint8_t padding[8];
+};
+
+static_assert(sizeof(BidAskPair) == 32, "BidAskPair must match DBN");
+static_assert(sizeof(Record) == 368, "Record must match DBN MBP-10");
+static_assert(sizeof(NativeRecord) == 376, "NativeRecord must be tightly packed");
+static_assert(sizeof(FileHeader) == 64, "FileHeader must be 64 bytes");
+
+inline size_t recordSize(Layout layout) {
+    return layout == LAYOUT_DBN ? sizeof(Record) : sizeof(NativeRecord);
+}
+
+} // namespace mbp_binary
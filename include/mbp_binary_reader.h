@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include "order_book.h"
+#include "mbp_binary_format.h"
+
+// Memory-mapped reader for files written by MbpBinaryWriter. Records are
+// returned as typed views into the mapping, and row N is found by offset.
+class MbpBinaryReader {
+public:
+    explicit MbpBinaryReader(const std::string& filename);
+    ~MbpBinaryReader();
+    
+    MbpBinaryReader(const MbpBinaryReader&) = delete;
+    MbpBinaryReader& operator=(const MbpBinaryReader&) = delete;
+    
+    bool open();
+    void close();
+    
+    size_t size() const { return record_count_; }
+    const mbp_binary::FileHeader& header() const { return *header_; }
+    
+    // View of row n; valid until close()
+    const mbp_binary::Record& record(size_t n) const {
+        return *reinterpret_cast<const mbp_binary::Record*>(records_ + n * record_size_);
+    }
+    
+    // Order id of row n, or 0 when the file uses the plain DBN layout
+    uint64_t orderId(size_t n) const;
+    
+    // Row n decoded back into an MbpSnapshot
+    MbpSnapshot snapshot(size_t n) const;
+
+private:
+    std::string filename_;
+    const char* data_;
+    const char* records_;
+    const mbp_binary::FileHeader* header_;
+    size_t file_size_;
+    size_t record_size_;
+    size_t record_count_;
+
+#ifdef _WIN32
+    void* file_handle_;
+    void* mapping_handle_;
+#else
+    int fd_;
+#endif
+
+    bool validateHeader();
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include "order_book.h"
+#include "mbp_binary_format.h"
+#include "symbology.h"
+
+// Writes MBP-10 snapshots as fixed-size binary records (see
+// mbp_binary_format.h). Row N sits at a fixed offset, so readers can seek
+// without scanning.
+class MbpBinaryWriter {
+public:
+    explicit MbpBinaryWriter(const std::string& filename = "output.bin",
+                             mbp_binary::Layout layout = mbp_binary::LAYOUT_NATIVE);
+    ~MbpBinaryWriter();
+    
+    // Instrument metadata stored in the file header. Records always carry
+    // their own publisher and instrument ids.
+    void setInstrument(uint16_t publisher_id, uint32_t instrument_id, const std::string& symbol);
+    
+    // If no instrument was set explicitly and the table holds exactly one
+    // instrument when the file is closed, the header describes it
+    void setSymbology(const SymbologyTable* symbology) { symbology_ = symbology; }
+    
+    bool initialize();
+    bool writeSnapshot(const MbpSnapshot& snapshot, uint64_t row_index = 0);
+    void flush();
+    void close();
+    
+    size_t getSnapshotCount() const { return snapshot_count_; }
+
+private:
+    std::string filename_;
+    std::ofstream file_stream_;
+    std::vector<char> write_buffer_;
+    size_t buffer_used_;
+    size_t record_size_;
+    size_t snapshot_count_;
+    bool is_initialized_;
+    bool instrument_set_;
+    const SymbologyTable* symbology_;
+    mbp_binary::FileHeader header_;
+    
+    static constexpr size_t BUFFER_SIZE = 64 * 1024;
+    
+    void flushBuffer();
+    void encodeRecord(const MbpSnapshot& snapshot, mbp_binary::Record& record) const;
+};
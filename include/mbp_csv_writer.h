@@ -4,7 +4,11 @@
 #include <vector>
 #include <fstream>
 #include <chrono>
+#include <cstdint>
+#include <unordered_map>
 #include "order_book.h"
+#include "symbology.h"
+#include "async_file_writer.h"
 
 // High-performance CSV writer for MBP-10 snapshots
 class MbpCsvWriter {
@@ -12,31 +16,60 @@ public:
     explicit MbpCsvWriter(const std::string& filename = "output.csv");
     ~MbpCsvWriter();
     
+    // Symbols for the symbol column; rows for unknown instruments get none
+    void setSymbology(const SymbologyTable* symbology) { symbology_ = symbology; }
+    
+    // Hand full buffers to a background I/O thread instead of writing them
+    // inline; takes effect at the next initialize()
+    void setAsyncIo(bool enabled) { async_io_ = enabled; }
+    
     bool initialize();
     bool writeSnapshot(const MbpSnapshot& snapshot, uint64_t row_index = 0);
     void flush();
     void close();
     
     size_t getSnapshotCount() const { return snapshot_count_; }
+    
+    static constexpr size_t TIMESTAMP_PREFIX_LENGTH = 19;
 
 private:
     std::string filename_;
     std::ofstream file_stream_;
+    AsyncFileWriter async_file_;
+    bool async_io_;
     std::vector<char> write_buffer_;
+    size_t buffer_used_;
     size_t snapshot_count_;
     bool is_initialized_;
+    const SymbologyTable* symbology_;
+    
+    // Symbols already resolved by this writer, so rows only consult the
+    // shared table once per instrument; the last one is kept at hand
+    std::unordered_map<uint32_t, const std::string*> symbol_cache_;
+    uint32_t cached_instrument_id_;
+    const std::string* cached_symbol_;
+    
+    // "YYYY-MM-DDTHH:MM:SS" of the last formatted second
+    int64_t cached_second_;
+    char cached_prefix_[TIMESTAMP_PREFIX_LENGTH];
     
     static constexpr size_t BUFFER_SIZE = 64 * 1024;
     
+    // Upper bound on one formatted row, so a row can be written without
+    // bounds checks once this much space is free
+    static constexpr size_t MAX_ROW_LENGTH = 4096;
+    static constexpr size_t MAX_SYMBOL_LENGTH = 64;
+    
     void flushBuffer();
-    void appendToBuffer(const std::string& data);
     void appendToBuffer(const char* data, size_t length);
     
-    std::string formatTimestamp(const std::chrono::nanoseconds& timestamp) const;
-    std::string formatPrice(double price) const;
-    std::string formatSize(uint64_t size) const;
-    std::string formatCount(uint32_t count) const;
-    std::string buildCsvRow(const MbpSnapshot& snapshot, uint64_t row_index) const;
+    char* writeTimestamp(char* out, const std::chrono::nanoseconds& timestamp);
+    char* writeRow(char* out, const MbpSnapshot& snapshot, uint64_t row_index);
+    const std::string& lookupSymbol(uint32_t instrument_id);
+    
+    static char* writeUInt(char* out, uint64_t value);
+    static char* writeInt(char* out, int64_t value);
+    static char* writePrice(char* out, Price price);
     
     static const char* CSV_HEADER;
 };
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "mbp_snapshot.h"
+
+// Shared-memory layout published by MbpShmPublisher and read by
+// MbpShmReader: a header, one seqlock-protected slot per instrument holding
+// its latest MBP-10 snapshot, and a journal ring naming each update in
+// order. There is one writer; any number of readers map the region
+// read-only and never write to it, so they cannot slow the writer down.
+//
+// The region holds MbpSnapshot as laid out by this build, so readers must
+// be built from the same headers; snapshot_size guards against mismatches.
+
+namespace mbp_shm {
+
+constexpr char MAGIC[8] = {'M', 'B', 'P', '1', '0', 'S', 'H', 'M'};
+constexpr uint32_t VERSION = 1;
+
+constexpr size_t DEFAULT_SLOT_COUNT = 1024;
+constexpr size_t DEFAULT_JOURNAL_CAPACITY = 64 * 1024;
+constexpr size_t SYMBOL_LENGTH = 16;
+
+// The snapshot is stored as 64-bit words so that readers racing the writer
+// copy it through relaxed atomics rather than plain loads
+constexpr size_t SNAPSHOT_WORDS = (sizeof(MbpSnapshot) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared-memory slots need lock-free 64-bit atomics");
+
+enum WriterState : uint32_t {
+    STATE_LIVE = 1,    // The writer is publishing
+    STATE_CLOSED = 2   // The writer has finished; slots hold the final books
+};
+
+struct alignas(64) RegionHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t snapshot_size;
+    uint32_t slot_count;
+    uint32_t journal_capacity;
+    int64_t price_scale;
+    
+    // Stored last when the region is set up, so a reader seeing STATE_LIVE
+    // sees the fields above
+    std::atomic<uint32_t> state;
+    std::atomic<uint32_t> instrument_count;
+    
+    // Updates published so far; update n is in journal entry n % capacity
+    alignas(64) std::atomic<uint64_t> journal_head;
+};
+
+// Latest snapshot of one instrument. sequence is odd while the writer is
+// copying a snapshot in, and rises by two per snapshot.
+struct alignas(64) Slot {
+    std::atomic<uint64_t> sequence;
+    
+    // instrument_id + 1 once the slot is claimed, set after the symbol
+    std::atomic<uint64_t> instrument_key;
+    char symbol[SYMBOL_LENGTH];
+    
+    std::atomic<uint64_t> row_index;
+    std::atomic<uint64_t> words[SNAPSHOT_WORDS];
+};
+
+// position is 0 while the entry is rewritten and n + 1 once it describes
+// update n
+struct JournalEntry {
+    std::atomic<uint64_t> position;
+    std::atomic<uint64_t> row_index;
+    std::atomic<uint64_t> slot_sequence;
+    std::atomic<uint32_t> instrument_id;
+    std::atomic<uint32_t> slot;
+};
+
+// Slot counts and journal capacities are powers of two
+inline size_t regionSize(size_t slot_count, size_t journal_capacity) {
+    return sizeof(RegionHeader) + slot_count * sizeof(Slot) + journal_capacity * sizeof(JournalEntry);
+}
+
+inline Slot* slots(void* region) {
+    return reinterpret_cast<Slot*>(static_cast<char*>(region) + sizeof(RegionHeader));
+}
+
+inline JournalEntry* journal(void* region, size_t slot_count) {
+    return reinterpret_cast<JournalEntry*>(static_cast<char*>(region) + sizeof(RegionHeader) + slot_count * sizeof(Slot));
+}
+
+// First slot probed for an instrument; later probes step linearly
+inline size_t homeSlot(uint32_t instrument_id, size_t slot_count) {
+    return static_cast<size_t>((instrument_id * 0x9E3779B1u) >> 7) & (slot_count - 1);
+}
+
+} // namespace mbp_shm
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include "order_book.h"
+#include "mbp_shm_format.h"
+#include "symbology.h"
+
+// Publishes MBP-10 snapshots into a POSIX shared-memory region (see
+// mbp_shm_format.h), for consumers on the same host to read with
+// MbpShmReader. Each instrument's slot holds its latest snapshot behind a
+// seqlock, and a journal entry is appended per snapshot. Publishing is a
+// copy into the mapping and a few release stores, with no system calls.
+//
+// The region is replaced when the publisher initialises and left in place
+// when it closes, so consumers can still read the final books afterwards.
+class MbpShmPublisher {
+public:
+    static constexpr const char* DEFAULT_NAME = "/orderbook_mbp10";
+    
+    explicit MbpShmPublisher(const std::string& name = DEFAULT_NAME, size_t slot_count = mbp_shm::DEFAULT_SLOT_COUNT,
+                             size_t journal_capacity = mbp_shm::DEFAULT_JOURNAL_CAPACITY);
+    ~MbpShmPublisher();
+    
+    MbpShmPublisher(const MbpShmPublisher&) = delete;
+    MbpShmPublisher& operator=(const MbpShmPublisher&) = delete;
+    
+    // Symbols are copied into an instrument's slot when it is first published
+    void setSymbology(const SymbologyTable* symbology) { symbology_ = symbology; }
+    
+    // Set before initialize(). slot_count bounds the instruments published;
+    // a reader falling more than journal_capacity updates behind the
+    // writer is lapped and loses the entries in between. Both are rounded
+    // up to powers of two.
+    void setCapacity(size_t slot_count, size_t journal_capacity);
+    
+    bool initialize();
+    
+    // Returns false once every slot is taken by other instruments
+    bool writeSnapshot(const MbpSnapshot& snapshot, uint64_t row_index = 0);
+    
+    // Snapshots are visible as soon as they are written
+    void flush() {}
+    
+    // Marks the region closed and unmaps it
+    void close();
+    
+    size_t getSnapshotCount() const { return snapshot_count_; }
+    
+    // Removes the named region, e.g. once no consumer needs it any more
+    static bool removeRegion(const std::string& name);
+
+private:
+    std::string name_;
+    size_t slot_count_;
+    size_t journal_capacity_;
+    const SymbologyTable* symbology_;
+    
+    void* region_;
+    size_t region_size_;
+    mbp_shm::RegionHeader* header_;
+    mbp_shm::Slot* slots_;
+    mbp_shm::JournalEntry* journal_;
+    
+    size_t snapshot_count_;
+    bool table_full_reported_;
+    
+    mbp_shm::Slot* slotFor(uint32_t instrument_id, uint32_t& slot_index);
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "order_book.h"
+#include "mbp_shm_format.h"
+
+// One journal entry: the update's row index and the instrument whose slot
+// it went to
+struct MbpShmUpdate {
+    uint64_t row_index;
+    uint32_t instrument_id;
+    uint64_t slot_sequence;
+};
+
+// Read-only view of a region published by MbpShmPublisher, typically in
+// another process. Reads retry while the writer is mid-update and never
+// block it; the region stays mapped, so the reads themselves make no
+// system calls.
+class MbpShmReader {
+public:
+    explicit MbpShmReader(const std::string& name);
+    ~MbpShmReader();
+    
+    MbpShmReader(const MbpShmReader&) = delete;
+    MbpShmReader& operator=(const MbpShmReader&) = delete;
+    
+    bool open();
+    void close();
+    
+    // False once the publisher has closed the region
+    bool isLive() const;
+    
+    size_t getInstrumentCount() const;
+    
+    // Copies out the latest snapshot of instrument_id; false if it has not
+    // been published
+    bool readLatest(uint32_t instrument_id, MbpSnapshot& snapshot, uint64_t* row_index = nullptr) const;
+    
+    // Symbol stored with instrument_id's slot, or an empty string
+    std::string getSymbol(uint32_t instrument_id) const;
+    
+    // Number of updates published; the journal holds the most recent
+    // getJournalCapacity() of them
+    uint64_t getJournalHead() const;
+    size_t getJournalCapacity() const { return journal_capacity_; }
+    
+    // Update number position (counting from 0), or false if it has not been
+    // published yet or has already been overwritten
+    bool readUpdate(uint64_t position, MbpShmUpdate& update) const;
+
+private:
+    std::string name_;
+    void* region_;
+    size_t region_size_;
+    const mbp_shm::RegionHeader* header_;
+    mbp_shm::Slot* slots_;
+    mbp_shm::JournalEntry* journal_;
+    size_t slot_count_;
+    size_t journal_capacity_;
+    
+    const mbp_shm::Slot* findSlot(uint32_t instrument_id) const;
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "price.h"
+
+// Side index into the level arrays
+constexpr size_t BID = 0;
+constexpr size_t ASK = 1;
+
+// Top-N price levels of both sides as parallel fixed arrays, best level
+// first. An empty level is all zeros. The arrays hold no padding, so
+// equality is a straight memory compare the compiler turns into vector ops.
+template <size_t N>
+struct DepthLevels {
+    static constexpr size_t DEPTH = N;
+    
+    Price px[2][N];
+    uint64_t sz[2][N];
+    uint32_t ct[2][N];
+    
+    DepthLevels() { clearLevels(); }
+    
+    void clearLevels() {
+        std::memset(px, 0, sizeof(px));
+        std::memset(sz, 0, sizeof(sz));
+        std::memset(ct, 0, sizeof(ct));
+    }
+    
+    bool operator==(const DepthLevels& other) const {
+        return std::memcmp(px, other.px, sizeof(px)) == 0 &&
+               std::memcmp(sz, other.sz, sizeof(sz)) == 0 &&
+               std::memcmp(ct, other.ct, sizeof(ct)) == 0;
+    }
+    
+    bool operator!=(const DepthLevels& other) const {
+        return !(*this == other);
+    }
+    
+    // Alternative market-relevant change detection
+    bool hasMarketRelevantChange(const DepthLevels& other) const {
+        for (size_t s = 0; s < 2; ++s) {
+            // Best levels changed
+            if (px[s][0] != other.px[s][0] || sz[s][0] != other.sz[s][0]) {
+                return true;
+            }
+            
+            for (size_t i = 0; i < N; ++i) {
+                // Level appeared/disappeared
+                if ((px[s][i] > 0) != (other.px[s][i] > 0)) {
+                    return true;
+                }
+                // Existing level size/count changed
+                if (px[s][i] > 0 && (sz[s][i] != other.sz[s][i] || ct[s][i] != other.ct[s][i])) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+};
+
+// Top-10 orderbook state for snapshot filtering
+using Top10State = DepthLevels<10>;
+
+// MBP-N snapshot: the triggering event plus the top N levels per side
+template <size_t N>
+struct BasicMbpSnapshot : DepthLevels<N> {
+    std::chrono::nanoseconds timestamp;
+    uint64_t sequence_number;
+    char action;
+    char side;
+    int32_t depth;
+    uint16_t publisher_id;
+    uint32_t instrument_id;
+    
+    Price event_price;
+    uint64_t event_size;
+    uint64_t event_order_id;
+    uint8_t event_flags;
+    int32_t event_ts_in_delta;
+    
+    BasicMbpSnapshot() : timestamp(0), sequence_number(0), action('S'), side('N'), depth(0), publisher_id(0), instrument_id(0),
+                         event_price(0), event_size(0), event_order_id(0), event_flags(0), event_ts_in_delta(0) {}
+    
+    DepthLevels<N>& levels() { return *this; }
+    const DepthLevels<N>& levels() const { return *this; }
+};
+
+using Mbp1Snapshot = BasicMbpSnapshot<1>;
+using MbpSnapshot = BasicMbpSnapshot<10>;
+using Mbp50Snapshot = BasicMbpSnapshot<50>;
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Bounded multi-producer/single-consumer ring (Vyukov's bounded queue).
+// Each slot carries a sequence number that says whose turn it is, so
+// producers only contend on the tail index and never wait on each other
+// to finish writing. Capacity is rounded up to a power of two.
+template <typename T>
+class MpscRing {
+public:
+    explicit MpscRing(size_t capacity) : head_(0), tail_(0) {
+        size_t rounded = 1;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+        slots_ = std::vector<Slot>(rounded);
+        for (size_t i = 0; i < rounded; ++i) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        mask_ = rounded - 1;
+    }
+    
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+    
+    // Any thread; returns false if the ring is full
+    bool tryPush(const T& item) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots_[tail & mask_];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t lag = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(tail);
+            if (lag == 0) {
+                if (tail_.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (lag < 0) {
+                return false;
+            } else {
+                tail = tail_.load(std::memory_order_relaxed);
+            }
+        }
+        slot->item = item;
+        slot->sequence.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // Consumer side; returns false if the ring is empty or the next slot
+    // has been claimed but not yet written
+    bool tryPop(T& item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        Slot& slot = slots_[head & mask_];
+        if (slot.sequence.load(std::memory_order_acquire) != head + 1) {
+            return false;
+        }
+        item = slot.item;
+        slot.sequence.store(head + slots_.size(), std::memory_order_release);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // Items claimed by producers so far, and items popped so far
+    size_t pushed() const { return tail_.load(std::memory_order_acquire); }
+    size_t popped() const { return head_.load(std::memory_order_acquire); }
+    
+    size_t capacity() const { return slots_.size(); }
+
+private:
+    static constexpr size_t CACHE_LINE = 64;
+    
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T item;
+        
+        Slot() : sequence(0), item() {}
+    };
+    
+    std::vector<Slot> slots_;
+    size_t mask_;
+    
+    // Consumer-owned
+    alignas(CACHE_LINE) std::atomic<size_t> head_;
+    
+    // Shared by producers
+    alignas(CACHE_LINE) std::atomic<size_t> tail_;
+};
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+#include "page_allocator.h"
+
+// Allocation counters of one arena. Everything the arena has to get from the
+// global allocator is counted in chunk_allocations or large_allocations, so
+// a replay whose counters stop moving is running without malloc.
+struct AllocationStats {
+    size_t node_allocations;
+    size_t chunk_allocations;
+    size_t large_allocations;
+    
+    AllocationStats() : node_allocations(0), chunk_allocations(0), large_allocations(0) {}
+    
+    size_t heapAllocations() const { return chunk_allocations + large_allocations; }
+};
+
+// Slab arena for container nodes. Small requests are rounded up to a size
+// class and served from per-class free lists, falling back to bumping
+// through 64 KiB chunks. Chunks are never returned before destruction, and
+// reset() rewinds the arena in O(1) once every node has been released.
+// Requests above MAX_NODE_SIZE (hash buckets, deque blocks) go straight to
+// the global allocator. An arena created on a thread pinned to a NUMA node
+// maps its chunks on that node.
+class NodeArena {
+public:
+    static constexpr size_t GRANULE = 16;
+    static constexpr size_t MAX_NODE_SIZE = 256;
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;
+    
+    NodeArena() : chunk_index_(0), chunk_used_(0), free_lists_(), numa_node_(currentNumaNode()) {}
+    
+    NodeArena(const NodeArena&) = delete;
+    NodeArena& operator=(const NodeArena&) = delete;
+    
+    void* allocate(size_t bytes) {
+        if (bytes > MAX_NODE_SIZE) {
+            stats_.large_allocations++;
+            return ::operator new(bytes);
+        }
+        
+        stats_.node_allocations++;
+        size_t size_class = (bytes + GRANULE - 1) / GRANULE;
+        FreeNode* node = free_lists_[size_class];
+        if (node) {
+            free_lists_[size_class] = node->next;
+            return node;
+        }
+        return bump(size_class * GRANULE);
+    }
+    
+    void deallocate(void* pointer, size_t bytes) {
+        if (bytes > MAX_NODE_SIZE) {
+            ::operator delete(pointer);
+            return;
+        }
+        
+        size_t size_class = (bytes + GRANULE - 1) / GRANULE;
+        FreeNode* node = static_cast<FreeNode*>(pointer);
+        node->next = free_lists_[size_class];
+        free_lists_[size_class] = node;
+    }
+    
+    // Heap memory counted as a large allocation whatever its size, for
+    // containers that keep their storage across reset()
+    void* allocateUnpooled(size_t bytes) {
+        stats_.large_allocations++;
+        return ::operator new(bytes);
+    }
+    
+    void deallocateUnpooled(void* pointer) { ::operator delete(pointer); }
+    
+    // Only valid once every node handed out has been deallocated
+    void reset() {
+        chunk_index_ = 0;
+        chunk_used_ = 0;
+        for (FreeNode*& list : free_lists_) {
+            list = nullptr;
+        }
+    }
+    
+    const AllocationStats& getStats() const { return stats_; }
+
+private:
+    struct FreeNode {
+        FreeNode* next;
+    };
+    
+    // Chunks are arrays of max_align_t so every granule is suitably aligned
+    using Block = std::max_align_t;
+    static constexpr size_t BLOCKS_PER_CHUNK = CHUNK_SIZE / sizeof(Block);
+    
+    // Node-bound chunks are mapped pages, the rest come from operator new
+    struct ChunkDeleter {
+        bool pages;
+        
+        void operator()(Block* chunk) const {
+            if (pages) {
+                releasePages(chunk, CHUNK_SIZE);
+            } else {
+                delete[] chunk;
+            }
+        }
+    };
+    
+    std::vector<std::unique_ptr<Block[], ChunkDeleter>> chunks_;
+    size_t chunk_index_;
+    size_t chunk_used_;
+    FreeNode* free_lists_[MAX_NODE_SIZE / GRANULE + 1];
+    AllocationStats stats_;
+    int numa_node_;
+    
+    void* bump(size_t bytes) {
+        if (chunk_index_ == chunks_.size() || chunk_used_ + bytes > CHUNK_SIZE) {
+            if (chunk_index_ < chunks_.size()) {
+                ++chunk_index_;
+            }
+            if (chunk_index_ == chunks_.size()) {
+                if (numa_node_ != NO_NUMA_NODE) {
+                    chunks_.emplace_back(static_cast<Block*>(allocatePages(CHUNK_SIZE, numa_node_)), ChunkDeleter{true});
+                } else {
+                    chunks_.emplace_back(new Block[BLOCKS_PER_CHUNK], ChunkDeleter{false});
+                }
+                stats_.chunk_allocations++;
+            }
+            chunk_used_ = 0;
+        }
+        
+        void* pointer = reinterpret_cast<unsigned char*>(chunks_[chunk_index_].get()) + chunk_used_;
+        chunk_used_ += bytes;
+        return pointer;
+    }
+};
+
+// Standard allocator over a NodeArena, so std containers draw their nodes
+// from it. A null arena falls back to the global allocator.
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+    
+    ArenaAllocator() : arena_(nullptr) {}
+    explicit ArenaAllocator(NodeArena* arena) : arena_(arena) {}
+    
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.arena()) {}
+    
+    T* allocate(size_t count) {
+        if (!arena_) {
+            return static_cast<T*>(::operator new(count * sizeof(T)));
+        }
+        return static_cast<T*>(arena_->allocate(count * sizeof(T)));
+    }
+    
+    void deallocate(T* pointer, size_t count) {
+        if (!arena_) {
+            ::operator delete(pointer);
+            return;
+        }
+        arena_->deallocate(pointer, count * sizeof(T));
+    }
+    
+    NodeArena* arena() const { return arena_; }
+    
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena_ == other.arena(); }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena_ != other.arena(); }
+
+private:
+    NodeArena* arena_;
+};
+
+// Standard allocator that takes every request from the global allocator but
+// counts it in the arena's stats, for storage a container keeps while the
+// arena is reset. A null arena leaves it uncounted.
+template <typename T>
+class UnpooledAllocator {
+public:
+    using value_type = T;
+    
+    UnpooledAllocator() : arena_(nullptr) {}
+    explicit UnpooledAllocator(NodeArena* arena) : arena_(arena) {}
+    
+    template <typename U>
+    UnpooledAllocator(const UnpooledAllocator<U>& other) : arena_(other.arena()) {}
+    
+    T* allocate(size_t count) {
+        if (!arena_) {
+            return static_cast<T*>(::operator new(count * sizeof(T)));
+        }
+        return static_cast<T*>(arena_->allocateUnpooled(count * sizeof(T)));
+    }
+    
+    void deallocate(T* pointer, size_t) {
+        if (!arena_) {
+            ::operator delete(pointer);
+            return;
+        }
+        arena_->deallocateUnpooled(pointer);
+    }
+    
+    NodeArena* arena() const { return arena_; }
+    
+    template <typename U>
+    bool operator==(const UnpooledAllocator<U>& other) const { return arena_ == other.arena(); }
+    template <typename U>
+    bool operator!=(const UnpooledAllocator<U>& other) const { return arena_ != other.arena(); }
+
+private:
+    NodeArena* arena_;
+};
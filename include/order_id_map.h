@@ -0,0 +1,219 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <utility>
+#include "page_allocator.h"
+
+// Open-addressing map from order id to Value, using Robin Hood probing with
+// backward-shift deletion, so erase leaves no tombstones and probe lengths
+// stay short under heavy add/cancel churn. Keys are spread by Fibonacci
+// hashing, which scatters the monotonically increasing ids exchanges assign
+// across the table. Probe metadata and values live in separate arrays, so a
+// lookup walks 16-byte entries and touches only the one value it returns.
+//
+// Both arrays come from PageAllocator, so a large table sits on huge pages
+// of the NUMA node of the thread that created the map.
+//
+// Pointers returned by find() and insert() are invalidated by the next
+// insert or erase.
+template <typename Value>
+class OrderIdMap {
+public:
+    explicit OrderIdMap(size_t expected_orders = 0)
+        : size_(0), shift_(64), allocation_count_(0) {
+        reserve(expected_orders);
+    }
+    
+    Value* find(uint64_t key) {
+        return const_cast<Value*>(static_cast<const OrderIdMap*>(this)->find(key));
+    }
+    
+    const Value* find(uint64_t key) const {
+        if (size_ == 0) {
+            return nullptr;
+        }
+        
+        size_t index = home(key);
+        for (uint32_t distance = 1;; ++distance) {
+            const Meta& meta = meta_[index];
+            // Robin Hood order: once an entry sits closer to its home than we
+            // are to ours, the key cannot be further along
+            if (meta.distance < distance) {
+                return nullptr;
+            }
+            if (meta.key == key) {
+                return &values_[index];
+            }
+            index = (index + 1) & mask();
+        }
+    }
+    
+    bool contains(uint64_t key) const { return find(key) != nullptr; }
+    
+    // Returns the value for key, value-initialising it if absent; inserted
+    // reports which happened. A single probe does both: the walk that would
+    // find key stops, when key is absent, at the slot Robin Hood order gives
+    // it, and placement carries on from there. The table grows before the
+    // walk, so a duplicate arriving at the load limit triggers the rehash
+    // the next new key would have.
+    Value& insert(uint64_t key, bool& inserted) {
+        if ((size_ + 1) * 8 > capacity() * 7) {
+            rehash(capacity() == 0 ? MIN_CAPACITY : capacity() * 2);
+        }
+        
+        size_t index = home(key);
+        for (uint32_t distance = 1;; ++distance) {
+            const Meta& meta = meta_[index];
+            if (meta.distance < distance) {
+                inserted = true;
+                return values_[placeFrom(index, distance, key, Value())];
+            }
+            if (meta.key == key) {
+                inserted = false;
+                return values_[index];
+            }
+            index = (index + 1) & mask();
+        }
+    }
+    
+    bool erase(uint64_t key) {
+        Value* value = find(key);
+        if (!value) {
+            return false;
+        }
+        eraseFound(value);
+        return true;
+    }
+    
+    // Erases the entry behind a pointer from find() without probing again
+    void eraseFound(Value* value) {
+        size_t index = static_cast<size_t>(value - values_.data());
+        
+        // Pull the following displaced entries one slot back
+        size_t next = (index + 1) & mask();
+        while (meta_[next].distance > 1) {
+            meta_[index].key = meta_[next].key;
+            meta_[index].distance = meta_[next].distance - 1;
+            values_[index] = std::move(values_[next]);
+            index = next;
+            next = (next + 1) & mask();
+        }
+        meta_[index].distance = 0;
+        values_[index] = Value();
+        --size_;
+    }
+    
+    // Grows the table so expected_orders fit without rehashing
+    void reserve(size_t expected_orders) {
+        size_t needed = MIN_CAPACITY;
+        while (needed * 7 < expected_orders * 8) {
+            needed <<= 1;
+        }
+        if (needed > capacity()) {
+            rehash(needed);
+        }
+    }
+    
+    // Empties the table but keeps its capacity
+    void clear() {
+        if (size_ == 0) {
+            return;
+        }
+        for (size_t i = 0; i < meta_.size(); ++i) {
+            if (meta_[i].distance != 0) {
+                meta_[i].distance = 0;
+                values_[i] = Value();
+            }
+        }
+        size_ = 0;
+    }
+    
+    // Visits fn(key, value) for every entry in table order
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (size_t i = 0; i < meta_.size(); ++i) {
+            if (meta_[i].distance != 0) {
+                fn(meta_[i].key, values_[i]);
+            }
+        }
+    }
+    
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t capacity() const { return meta_.size(); }
+    
+    // Table allocations so far; each rehash allocates the two arrays
+    size_t getAllocationCount() const { return allocation_count_; }
+    
+    static constexpr size_t MIN_CAPACITY = 16;
+
+private:
+    struct Meta {
+        uint64_t key;
+        // Probe distance from the key's home slot plus one; zero when empty
+        uint32_t distance;
+    };
+    
+    std::vector<Meta, PageAllocator<Meta>> meta_;
+    std::vector<Value, PageAllocator<Value>> values_;
+    size_t size_;
+    unsigned shift_;
+    size_t allocation_count_;
+    
+    size_t mask() const { return meta_.size() - 1; }
+    size_t home(uint64_t key) const { return static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> shift_); }
+    
+    // Inserts a key known to be absent and returns the slot it ended up in.
+    // Entries closer to home than the one being placed give up their slot
+    // and continue probing in its place.
+    size_t place(uint64_t key, Value value) { return placeFrom(home(key), 1, key, std::move(value)); }
+    
+    // place() resumed at index, distance - 1 slots past key's home, with
+    // every slot before it known not to be key's
+    size_t placeFrom(size_t index, uint32_t distance, uint64_t key, Value value) {
+        size_t result = static_cast<size_t>(-1);
+        
+        for (;;) {
+            Meta& meta = meta_[index];
+            if (meta.distance == 0) {
+                meta.key = key;
+                meta.distance = distance;
+                values_[index] = std::move(value);
+                ++size_;
+                return result == static_cast<size_t>(-1) ? index : result;
+            }
+            if (meta.distance < distance) {
+                std::swap(meta.key, key);
+                std::swap(meta.distance, distance);
+                std::swap(values_[index], value);
+                if (result == static_cast<size_t>(-1)) {
+                    result = index;
+                }
+            }
+            index = (index + 1) & mask();
+            ++distance;
+        }
+    }
+    
+    void rehash(size_t new_capacity) {
+        std::vector<Meta, PageAllocator<Meta>> old_meta(new_capacity, Meta{0, 0}, meta_.get_allocator());
+        std::vector<Value, PageAllocator<Value>> old_values(new_capacity, Value(), values_.get_allocator());
+        old_meta.swap(meta_);
+        old_values.swap(values_);
+        allocation_count_ += 2;
+        
+        shift_ = 64;
+        for (size_t c = new_capacity; c > 1; c >>= 1) {
+            --shift_;
+        }
+        
+        size_ = 0;
+        for (size_t i = 0; i < old_meta.size(); ++i) {
+            if (old_meta[i].distance != 0) {
+                place(old_meta[i].key, std::move(old_values[i]));
+            }
+        }
+    }
+};
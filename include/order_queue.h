@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Resting order, linked into the FIFO of its price level
+struct OrderNode {
+    uint64_t order_id;
+    uint64_t size;
+    OrderNode* prev;
+    OrderNode* next;
+};
+
+// Intrusive doubly-linked FIFO of the orders resting at one price level.
+// The queue does not own its nodes; they come from an OrderNodePool.
+struct OrderQueue {
+    OrderNode* head;
+    OrderNode* tail;
+    
+    OrderQueue() : head(nullptr), tail(nullptr) {}
+    
+    bool empty() const { return head == nullptr; }
+    OrderNode* front() const { return head; }
+    
+    // A linked node is either the head or has a predecessor
+    bool contains(const OrderNode* node) const { return node->prev != nullptr || head == node; }
+    
+    void pushBack(OrderNode* node) {
+        node->prev = tail;
+        node->next = nullptr;
+        if (tail) {
+            tail->next = node;
+        } else {
+            head = node;
+        }
+        tail = node;
+    }
+    
+    void unlink(OrderNode* node) {
+        if (node->prev) {
+            node->prev->next = node->next;
+        } else {
+            head = node->next;
+        }
+        if (node->next) {
+            node->next->prev = node->prev;
+        } else {
+            tail = node->prev;
+        }
+        node->prev = nullptr;
+        node->next = nullptr;
+    }
+    
+    // Unlinks every remaining node so none of them still claims membership
+    // once the level is erased
+    void detachAll() {
+        while (head) {
+            unlink(head);
+        }
+    }
+};
+
+// Chunked free-list allocator for order nodes. Node addresses are stable for
+// the pool's lifetime, and clear() recycles every chunk without freeing it.
+class OrderNodePool {
+public:
+    OrderNodePool() : chunk_index_(0), chunk_used_(0), free_list_(nullptr) {}
+    
+    OrderNode* acquire(uint64_t order_id, uint64_t size) {
+        OrderNode* node = free_list_;
+        if (node) {
+            free_list_ = node->next;
+        } else {
+            if (chunk_index_ == chunks_.size() || chunk_used_ == CHUNK_SIZE) {
+                if (chunk_index_ < chunks_.size()) {
+                    ++chunk_index_;
+                }
+                if (chunk_index_ == chunks_.size()) {
+                    chunks_.emplace_back(new OrderNode[CHUNK_SIZE]);
+                }
+                chunk_used_ = 0;
+            }
+            node = &chunks_[chunk_index_][chunk_used_++];
+        }
+        
+        node->order_id = order_id;
+        node->size = size;
+        node->prev = nullptr;
+        node->next = nullptr;
+        return node;
+    }
+    
+    void release(OrderNode* node) {
+        node->next = free_list_;
+        free_list_ = node;
+    }
+    
+    size_t getChunkCount() const { return chunks_.size(); }
+    
+    void clear() {
+        chunk_index_ = 0;
+        chunk_used_ = 0;
+        free_list_ = nullptr;
+    }
+
+private:
+    static constexpr size_t CHUNK_SIZE = 4096;
+    
+    std::vector<std::unique_ptr<OrderNode[]>> chunks_;
+    size_t chunk_index_;
+    size_t chunk_used_;
+    OrderNode* free_list_;
+};
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "mbo_parser.h"
+
+// The fields every pass over a batch of events reads, in 32 bytes: price
+// ticks, a 32-bit size (as in DBN) and ts_event as a signed offset from the
+// base timestamp of the batch segment the event falls in
+struct PackedMboEvent {
+    Price price;
+    uint64_t order_id;
+    uint32_t size;
+    int32_t ts_offset;
+    uint32_t instrument_id;
+    char action;
+    char side;
+    uint16_t reserved;
+};
+
+static_assert(sizeof(PackedMboEvent) == 32, "packed MBO event must stay 32 bytes");
+
+// The fields only needed once an event is unpacked for output
+struct MboEventCold {
+    uint64_t sequence;
+    int64_t ts_recv;
+    int32_t ts_in_delta;
+    uint16_t publisher_id;
+    uint8_t flags;
+    uint8_t channel_id;
+};
+
+// A run of MboEvents stored as parallel hot and cold arrays, about 56 bytes
+// an event instead of 80, with the hot array alone touched by passes that
+// only look at orders and levels. Timestamps share a base per segment; a
+// new segment starts whenever an event lies more than ~2 s from the current
+// base, so any sequence of events can be stored. Sizes must fit in 32 bits,
+// which the parsers guarantee.
+class PackedEventBatch {
+public:
+    void push(const MboEvent& event) {
+        int64_t ts = event.ts_event.count();
+        if (segments_.empty() || ts - segments_.back().base > MAX_OFFSET || ts - segments_.back().base < -MAX_OFFSET) {
+            segments_.push_back(Segment{hot_.size(), ts});
+        }
+        
+        PackedMboEvent hot;
+        hot.price = event.price;
+        hot.order_id = event.order_id;
+        hot.size = static_cast<uint32_t>(event.size);
+        hot.ts_offset = static_cast<int32_t>(ts - segments_.back().base);
+        hot.instrument_id = event.instrument_id;
+        hot.action = event.action;
+        hot.side = event.side;
+        hot.reserved = 0;
+        hot_.push_back(hot);
+        
+        MboEventCold cold;
+        cold.sequence = event.sequence;
+        cold.ts_recv = event.ts_recv.count();
+        cold.ts_in_delta = event.ts_in_delta;
+        cold.publisher_id = event.publisher_id;
+        cold.flags = event.flags;
+        cold.channel_id = event.channel_id;
+        cold_.push_back(cold);
+    }
+    
+    void unpack(size_t index, MboEvent& event) const {
+        const PackedMboEvent& hot = hot_[index];
+        const MboEventCold& cold = cold_[index];
+        event.ts_event = std::chrono::nanoseconds(baseOf(index) + hot.ts_offset);
+        event.action = hot.action;
+        event.side = hot.side;
+        event.price = hot.price;
+        event.size = hot.size;
+        event.order_id = hot.order_id;
+        event.flags = cold.flags;
+        event.ts_in_delta = cold.ts_in_delta;
+        event.sequence = cold.sequence;
+        event.instrument_id = hot.instrument_id;
+        event.publisher_id = cold.publisher_id;
+        event.ts_recv = std::chrono::nanoseconds(cold.ts_recv);
+        event.channel_id = cold.channel_id;
+    }
+    
+    MboEvent get(size_t index) const {
+        MboEvent event;
+        unpack(index, event);
+        return event;
+    }
+    
+    PackedMboEvent& hot(size_t index) { return hot_[index]; }
+    const PackedMboEvent& hot(size_t index) const { return hot_[index]; }
+    MboEventCold& cold(size_t index) { return cold_[index]; }
+    const MboEventCold& cold(size_t index) const { return cold_[index]; }
+    
+    // Copies event from over event to, for compacting in place. Only for
+    // batches spanning less than ~2 s, such as a conflation window, where
+    // the offset is valid against either position's base.
+    void move(size_t from, size_t to) {
+        int64_t ts = baseOf(from) + hot_[from].ts_offset;
+        hot_[to] = hot_[from];
+        cold_[to] = cold_[from];
+        hot_[to].ts_offset = static_cast<int32_t>(ts - baseOf(to));
+    }
+    
+    // Drops the events from count on
+    void truncate(size_t count) {
+        hot_.resize(count);
+        cold_.resize(count);
+        while (!segments_.empty() && segments_.back().first >= count && count > 0) {
+            segments_.pop_back();
+        }
+        if (count == 0) {
+            segments_.clear();
+        }
+    }
+    
+    void reserve(size_t count) {
+        hot_.reserve(count);
+        cold_.reserve(count);
+    }
+    
+    void clear() {
+        hot_.clear();
+        cold_.clear();
+        segments_.clear();
+    }
+    
+    size_t size() const { return hot_.size(); }
+    bool empty() const { return hot_.empty(); }
+    size_t getSegmentCount() const { return segments_.size(); }
+
+private:
+    struct Segment {
+        size_t first;
+        int64_t base;
+    };
+    
+    static constexpr int64_t MAX_OFFSET = std::numeric_limits<int32_t>::max();
+    
+    std::vector<PackedMboEvent> hot_;
+    std::vector<MboEventCold> cold_;
+    std::vector<Segment> segments_;
+    
+    int64_t baseOf(size_t index) const {
+        if (segments_.size() == 1 || index >= segments_.back().first) {
+            return segments_.back().base;
+        }
+        auto segment = std::upper_bound(segments_.begin(), segments_.end(), index,
+                                        [](size_t value, const Segment& s) { return value < s.first; });
+        return (segment - 1)->base;
+    }
+};
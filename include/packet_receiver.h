@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Datagrams handed out by a receive call. Each entry points at memory owned
+// by the receiver and stays valid until its next receive(), so a backend
+// that exposes the NIC's own buffers never has to copy.
+struct PacketBatch {
+    static constexpr size_t MAX_PACKETS = 64;
+    
+    const char* data[MAX_PACKETS];
+    size_t length[MAX_PACKETS];
+    size_t count;
+    
+    PacketBatch() : data(), length(), count(0) {}
+};
+
+// Where the live feed's datagrams come from. UdpMulticastReceiver is the
+// kernel socket backend; a kernel-bypass backend (ef_vi, DPDK) implements
+// the same two calls on top of its own receive ring.
+class PacketReceiver {
+public:
+    virtual ~PacketReceiver() {}
+    
+    virtual bool open() = 0;
+    
+    // Fills batch with whatever has arrived, without blocking; an empty
+    // batch means nothing yet. Returns false on an unrecoverable error.
+    virtual bool receive(PacketBatch& batch) = 0;
+};
+
+struct MulticastConfig {
+    std::string group;
+    uint16_t port;
+    
+    // Local address of the interface to join on; empty lets the kernel pick
+    std::string interface_address;
+    
+    size_t receive_buffer_bytes;
+    
+    // SO_BUSY_POLL budget in microseconds (Linux); 0 leaves it off
+    int busy_poll_us;
+    
+    MulticastConfig() : port(0), receive_buffer_bytes(DEFAULT_RECEIVE_BUFFER), busy_poll_us(DEFAULT_BUSY_POLL_US) {}
+    
+    static constexpr size_t DEFAULT_RECEIVE_BUFFER = 8 * 1024 * 1024;
+    static constexpr int DEFAULT_BUSY_POLL_US = 50;
+};
+
+// Non-blocking UDP socket joined to a multicast group, drained with
+// recvmmsg on Linux (one system call per batch) and recvfrom elsewhere. A
+// unicast group address is bound as is, which is handy for testing over
+// loopback.
+class UdpMulticastReceiver : public PacketReceiver {
+public:
+    static constexpr size_t MAX_DATAGRAM = 9216;
+    
+    explicit UdpMulticastReceiver(const MulticastConfig& config);
+    ~UdpMulticastReceiver() override;
+    
+    UdpMulticastReceiver(const UdpMulticastReceiver&) = delete;
+    UdpMulticastReceiver& operator=(const UdpMulticastReceiver&) = delete;
+    
+    bool open() override;
+    bool receive(PacketBatch& batch) override;
+    void close();
+    
+    // Port actually bound, which differs from the configured one if that was 0
+    uint16_t getBoundPort() const { return bound_port_; }
+
+private:
+    MulticastConfig config_;
+    int fd_;
+    uint16_t bound_port_;
+    std::vector<char> buffers_;
+};
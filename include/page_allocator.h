@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+// Page-level backing for the large, randomly accessed arrays of the hot path
+// (order hash tables, ring buffers, arena chunks). Allocations of at least
+// HUGE_PAGE_SIZE are rounded up to whole 2 MB pages and, while huge pages
+// are enabled, taken from the reserved hugetlb pool when it has room and
+// otherwise aligned and marked for transparent huge pages. A NUMA node other
+// than NO_NUMA_NODE binds the pages to that node (Linux and Windows only);
+// without one the kernel places them on first touch.
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+constexpr int NO_NUMA_NODE = -1;
+
+// On by default; turning it off only affects later allocations
+void setHugePagesEnabled(bool enabled);
+bool hugePagesEnabled();
+
+// Throws std::bad_alloc when the pages cannot be mapped. The size passed to
+// releasePages must be the one given to allocatePages.
+void* allocatePages(size_t bytes, int numa_node = NO_NUMA_NODE);
+void releasePages(void* pointer, size_t bytes);
+
+// Asks for huge pages on an existing mapping, such as a mapped input file;
+// a no-op where the platform or file system does not support it
+void adviseHugePages(const void* address, size_t bytes);
+
+// NUMA node that allocations made on this thread should prefer. Pinning a
+// thread sets it to the node of its core.
+void setCurrentNumaNode(int numa_node);
+int currentNumaNode();
+
+// Standard allocator that takes requests of PAGE_THRESHOLD bytes or more
+// from allocatePages, on the node current when the allocator was created,
+// and leaves smaller ones to the global allocator.
+template <typename T>
+class PageAllocator {
+public:
+    using value_type = T;
+
+    static constexpr size_t PAGE_THRESHOLD = 64 * 1024;
+
+    PageAllocator() : numa_node_(currentNumaNode()) {}
+    explicit PageAllocator(int numa_node) : numa_node_(numa_node) {}
+
+    template <typename U>
+    PageAllocator(const PageAllocator<U>& other) : numa_node_(other.numaNode()) {}
+
+    T* allocate(size_t count) {
+        size_t bytes = count * sizeof(T);
+        if (bytes < PAGE_THRESHOLD) {
+            return static_cast<T*>(::operator new(bytes));
+        }
+        return static_cast<T*>(allocatePages(bytes, numa_node_));
+    }
+
+    void deallocate(T* pointer, size_t count) {
+        size_t bytes = count * sizeof(T);
+        if (bytes < PAGE_THRESHOLD) {
+            ::operator delete(pointer);
+            return;
+        }
+        releasePages(pointer, bytes);
+    }
+
+    int numaNode() const { return numa_node_; }
+
+    // Memory from either allocator can be released by the other
+    template <typename U>
+    bool operator==(const PageAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const PageAllocator<U>&) const { return false; }
+
+private:
+    int numa_node_;
+};
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+
+// Fixed-point price in 1e-9 units, the same scale Databento uses on the wire
+using Price = int64_t;
+
+constexpr Price PRICE_SCALE = 1000000000LL;
+constexpr int PRICE_DECIMALS = 9;
+
+// Conversions for display and for callers that still hold floating prices
+inline Price priceFromDouble(double price) {
+    return static_cast<Price>(std::llround(price * static_cast<double>(PRICE_SCALE)));
+}
+
+inline double priceToDouble(Price price) {
+    return static_cast<double>(price) / static_cast<double>(PRICE_SCALE);
+}
@@ -0,0 +1,487 @@
+#pragma once
+
+#include <map>
+#include <algorithm>
+#include <deque>
+#include <vector>
+#include <numeric>
+#include <cstdint>
+#include <cstddef>
+#include "price.h"
+#include "order_queue.h"
+#include "node_arena.h"
+
+// Price level aggregated data
+struct LevelData {
+    Price price;
+    uint64_t total_size;
+    uint32_t order_count;
+    OrderQueue order_queue;
+    
+    LevelData() : price(0), total_size(0), order_count(0) {}
+    explicit LevelData(Price p) : price(p), total_size(0), order_count(0) {}
+};
+
+// Level storage backed by std::map, ordered best-first by Compare
+// (std::greater for bids, std::less for asks). Map nodes come from the
+// given arena, or the global allocator without one.
+template <typename Compare>
+class MapPriceLevels {
+public:
+    explicit MapPriceLevels(NodeArena* arena = nullptr)
+        : levels_(Compare(), ArenaAllocator<std::pair<const Price, LevelData>>(arena)) {}
+    
+    LevelData* find(Price price) {
+        auto it = levels_.find(price);
+        return it != levels_.end() ? &it->second : nullptr;
+    }
+    
+    const LevelData* find(Price price) const {
+        auto it = levels_.find(price);
+        return it != levels_.end() ? &it->second : nullptr;
+    }
+    
+    // Returns the level at price, default-constructing it if absent
+    LevelData& insert(Price price) { return levels_[price]; }
+    
+    void erase(Price price) {
+        auto it = levels_.find(price);
+        if (it != levels_.end()) {
+            it->second.order_queue.detachAll();
+            levels_.erase(it);
+        }
+    }
+    
+    const LevelData* best() const {
+        return levels_.empty() ? nullptr : &levels_.begin()->second;
+    }
+    
+    // Visits up to max_levels levels best-first
+    template <typename Fn>
+    void forEachLevel(size_t max_levels, Fn&& fn) const {
+        size_t visited = 0;
+        for (auto it = levels_.begin(); it != levels_.end() && visited < max_levels; ++it, ++visited) {
+            fn(it->second);
+        }
+    }
+    
+    // Number of levels better than the level at price, capped at max_rank
+    size_t rank(Price price, size_t max_rank) const {
+        size_t better = 0;
+        for (auto it = levels_.begin(); it != levels_.end() && better < max_rank && levels_.key_comp()(it->first, price); ++it) {
+            ++better;
+        }
+        return better;
+    }
+    
+    size_t size() const { return levels_.size(); }
+    bool empty() const { return levels_.empty(); }
+    void clear() { levels_.clear(); }
+
+private:
+    std::map<Price, LevelData, Compare, ArenaAllocator<std::pair<const Price, LevelData>>> levels_;
+};
+
+// Level storage backed by a contiguous tick-indexed ladder anchored near the
+// best price. Slot 0 is the best price the window can hold and higher slots
+// walk away from the touch, so bids and asks share the same scan direction.
+// An occupancy bitmap lets top-N extraction skip empty ticks.
+//
+// Levels that are worse than the window's far edge live in an overflow map.
+// Invariant: every overflow level is worse than every price the window can
+// hold, so iterating window-then-overflow is always best-first. A price better
+// than slot 0 re-centres the window around it; when the window empties the
+// ladder re-centres on the best overflow level.
+//
+// The grid is the multiples of the tick. A price off it is held aside in a
+// small off-grid map that iteration merges in, so a stray print does not
+// disturb the ladder; only once more than OFF_GRID_LEVELS such prices are
+// live does the tick shrink to their common divisor and every level re-grid.
+// The configured tick comes back whenever the ladder empties or is cleared.
+//
+// LevelData lives in a stable pool, so re-centring only moves slot indices
+// and pointers returned by find()/insert() survive it. The pool outlives
+// clear() and is reused up to its high-water mark; overflow nodes come from
+// the given arena, and the pool and slot arrays are counted in its
+// large_allocations.
+template <typename Compare>
+class LadderPriceLevels {
+public:
+    static constexpr Price DEFAULT_TICK_SIZE = PRICE_SCALE / 100;
+    static constexpr size_t WINDOW_TICKS = 4096;
+    static constexpr size_t HEADROOM_TICKS = WINDOW_TICKS / 4;
+    static constexpr size_t OFF_GRID_LEVELS = 16;
+    
+    explicit LadderPriceLevels(Price tick_size = DEFAULT_TICK_SIZE, NodeArena* arena = nullptr)
+        : tick_size_(tick_size), configured_tick_(tick_size), anchor_(0), best_index_(WINDOW_TICKS), window_count_(0),
+          slots_(WINDOW_TICKS, NO_SLOT, UnpooledAllocator<uint32_t>(arena)),
+          occupied_(WORDS, 0, UnpooledAllocator<uint64_t>(arena)),
+          overflow_(Compare(), ArenaAllocator<std::pair<const Price, uint32_t>>(arena)),
+          off_grid_(Compare(), ArenaAllocator<std::pair<const Price, uint32_t>>(arena)),
+          pool_(UnpooledAllocator<LevelData>(arena)), pool_used_(0),
+          free_slots_(UnpooledAllocator<uint32_t>(arena)), recentre_scratch_(UnpooledAllocator<uint32_t>(arena)) {}
+    
+    explicit LadderPriceLevels(NodeArena* arena) : LadderPriceLevels(DEFAULT_TICK_SIZE, arena) {}
+    
+    LevelData* find(Price price) {
+        return const_cast<LevelData*>(static_cast<const LadderPriceLevels*>(this)->find(price));
+    }
+    
+    const LevelData* find(Price price) const {
+        if (isEmpty()) {
+            return nullptr;
+        }
+        if (!onGrid(price)) {
+            auto it = off_grid_.find(price);
+            return it != off_grid_.end() ? &pool_[it->second] : nullptr;
+        }
+        
+        int64_t index = toIndex(price);
+        if (index < 0) {
+            return nullptr;
+        }
+        if (index < static_cast<int64_t>(WINDOW_TICKS)) {
+            uint32_t slot = slots_[index];
+            return slot != NO_SLOT ? &pool_[slot] : nullptr;
+        }
+        
+        auto it = overflow_.find(price);
+        return it != overflow_.end() ? &pool_[it->second] : nullptr;
+    }
+    
+    // Returns the level at price, default-constructing it if absent
+    LevelData& insert(Price price) {
+        if (isEmpty()) {
+            tick_size_ = configured_tick_;
+        }
+        if (!onGrid(price)) {
+            auto it = off_grid_.find(price);
+            if (it != off_grid_.end()) {
+                return pool_[it->second];
+            }
+            if (off_grid_.size() < OFF_GRID_LEVELS) {
+                uint32_t slot = allocateLevel(price);
+                off_grid_.emplace(price, slot);
+                return pool_[slot];
+            }
+            regrid(price);
+        }
+        if (window_count_ == 0 && overflow_.empty()) {
+            anchor_ = price - DIRECTION * static_cast<Price>(HEADROOM_TICKS) * tick_size_;
+        }
+        
+        int64_t index = toIndex(price);
+        if (index < 0) {
+            recentre(price);
+            index = toIndex(price);
+        }
+        
+        if (index < static_cast<int64_t>(WINDOW_TICKS)) {
+            uint32_t slot = slots_[index];
+            if (slot != NO_SLOT) {
+                return pool_[slot];
+            }
+            
+            slot = allocateLevel(price);
+            placeInWindow(static_cast<size_t>(index), slot);
+            return pool_[slot];
+        }
+        
+        auto it = overflow_.find(price);
+        if (it != overflow_.end()) {
+            return pool_[it->second];
+        }
+        
+        uint32_t slot = allocateLevel(price);
+        overflow_.emplace(price, slot);
+        return pool_[slot];
+    }
+    
+    void erase(Price price) {
+        if (isEmpty()) {
+            return;
+        }
+        if (!onGrid(price)) {
+            auto it = off_grid_.find(price);
+            if (it != off_grid_.end()) {
+                pool_[it->second].order_queue.detachAll();
+                free_slots_.push_back(it->second);
+                off_grid_.erase(it);
+            }
+            return;
+        }
+        
+        int64_t index = toIndex(price);
+        if (index < 0) {
+            return;
+        }
+        
+        if (index < static_cast<int64_t>(WINDOW_TICKS)) {
+            uint32_t slot = slots_[index];
+            if (slot == NO_SLOT) {
+                return;
+            }
+            
+            pool_[slot].order_queue.detachAll();
+            removeFromWindow(static_cast<size_t>(index));
+            free_slots_.push_back(slot);
+            
+            if (window_count_ == 0 && !overflow_.empty()) {
+                recentre(overflow_.begin()->first);
+            }
+            return;
+        }
+        
+        auto it = overflow_.find(price);
+        if (it != overflow_.end()) {
+            pool_[it->second].order_queue.detachAll();
+            free_slots_.push_back(it->second);
+            overflow_.erase(it);
+        }
+    }
+    
+    const LevelData* best() const {
+        const LevelData* grid_best = nullptr;
+        if (window_count_ > 0) {
+            grid_best = &pool_[slots_[best_index_]];
+        } else if (!overflow_.empty()) {
+            grid_best = &pool_[overflow_.begin()->second];
+        }
+        if (off_grid_.empty()) {
+            return grid_best;
+        }
+        const LevelData* off_grid_best = &pool_[off_grid_.begin()->second];
+        return !grid_best || Compare()(off_grid_best->price, grid_best->price) ? off_grid_best : grid_best;
+    }
+    
+    // Visits up to max_levels levels best-first, merging off-grid levels in
+    // ahead of the first grid level they beat
+    template <typename Fn>
+    void forEachLevel(size_t max_levels, Fn&& fn) const {
+        size_t visited = 0;
+        auto off_grid = off_grid_.begin();
+        auto visit = [&](const LevelData& level) {
+            for (; off_grid != off_grid_.end() && visited < max_levels && Compare()(off_grid->first, level.price); ++off_grid) {
+                fn(pool_[off_grid->second]);
+                ++visited;
+            }
+            if (visited < max_levels) {
+                fn(level);
+                ++visited;
+            }
+        };
+        
+        if (window_count_ > 0) {
+            size_t word = best_index_ / 64;
+            uint64_t bits = occupied_[word] & (~0ULL << (best_index_ % 64));
+            
+            while (visited < max_levels) {
+                while (bits == 0 && ++word < WORDS) {
+                    bits = occupied_[word];
+                }
+                if (bits == 0) {
+                    break;
+                }
+                
+                size_t index = word * 64 + static_cast<size_t>(__builtin_ctzll(bits));
+                bits &= bits - 1;
+                visit(pool_[slots_[index]]);
+            }
+        }
+        
+        for (auto it = overflow_.begin(); it != overflow_.end() && visited < max_levels; ++it) {
+            visit(pool_[it->second]);
+        }
+        for (; off_grid != off_grid_.end() && visited < max_levels; ++off_grid, ++visited) {
+            fn(pool_[off_grid->second]);
+        }
+    }
+    
+    // Number of levels better than the level at price, capped at max_rank.
+    // Window levels are counted by popcount over the occupancy bitmap.
+    size_t rank(Price price, size_t max_rank) const {
+        size_t off_grid_better = 0;
+        for (auto it = off_grid_.begin(); it != off_grid_.end() && off_grid_better < max_rank && off_grid_.key_comp()(it->first, price); ++it) {
+            ++off_grid_better;
+        }
+        return std::min(off_grid_better + gridRank(price, max_rank), max_rank);
+    }
+    
+    size_t size() const { return window_count_ + overflow_.size() + off_grid_.size(); }
+    bool empty() const { return isEmpty(); }
+    
+    void clear() {
+        std::fill(slots_.begin(), slots_.end(), NO_SLOT);
+        std::fill(occupied_.begin(), occupied_.end(), 0);
+        overflow_.clear();
+        off_grid_.clear();
+        pool_used_ = 0;
+        free_slots_.clear();
+        best_index_ = WINDOW_TICKS;
+        window_count_ = 0;
+        tick_size_ = configured_tick_;
+    }
+    
+    Price getTickSize() const { return tick_size_; }
+
+private:
+    static constexpr size_t WORDS = WINDOW_TICKS / 64;
+    static constexpr uint32_t NO_SLOT = UINT32_MAX;
+    
+    // +1 when better prices are lower (asks), -1 when they are higher (bids)
+    static constexpr Price DIRECTION = Compare()(1, 0) ? -1 : 1;
+    
+    using LevelMap = std::map<Price, uint32_t, Compare, ArenaAllocator<std::pair<const Price, uint32_t>>>;
+    
+    Price tick_size_;
+    Price configured_tick_;
+    Price anchor_;
+    size_t best_index_;
+    size_t window_count_;
+    std::vector<uint32_t, UnpooledAllocator<uint32_t>> slots_;
+    std::vector<uint64_t, UnpooledAllocator<uint64_t>> occupied_;
+    LevelMap overflow_;
+    LevelMap off_grid_;
+    std::deque<LevelData, UnpooledAllocator<LevelData>> pool_;
+    size_t pool_used_;
+    std::vector<uint32_t, UnpooledAllocator<uint32_t>> free_slots_;
+    std::vector<uint32_t, UnpooledAllocator<uint32_t>> recentre_scratch_;
+    
+    bool isEmpty() const { return window_count_ == 0 && overflow_.empty() && off_grid_.empty(); }
+    bool onGrid(Price price) const { return price % tick_size_ == 0; }
+    int64_t toIndex(Price price) const { return (price - anchor_) * DIRECTION / tick_size_; }
+    
+    // Grid levels better than price, which may itself be off the grid: a
+    // window slot counts when it lies strictly before price's position
+    size_t gridRank(Price price, size_t max_rank) const {
+        if (window_count_ == 0) {
+            return 0;
+        }
+        Price distance = (price - anchor_) * DIRECTION;
+        if (distance <= 0) {
+            return 0;
+        }
+        int64_t index = (distance + tick_size_ - 1) / tick_size_;
+        
+        if (index < static_cast<int64_t>(WINDOW_TICKS)) {
+            size_t end = static_cast<size_t>(index);
+            size_t better = 0;
+            for (size_t word = best_index_ / 64; word <= (end - 1) / 64 && better < max_rank; ++word) {
+                uint64_t bits = occupied_[word];
+                if (word == end / 64) {
+                    bits &= (1ULL << (end % 64)) - 1;
+                }
+                better += static_cast<size_t>(__builtin_popcountll(bits));
+            }
+            return std::min(better, max_rank);
+        }
+        
+        size_t better = window_count_;
+        for (auto it = overflow_.begin(); it != overflow_.end() && better < max_rank && overflow_.key_comp()(it->first, price); ++it) {
+            ++better;
+        }
+        return std::min(better, max_rank);
+    }
+    
+    uint32_t allocateLevel(Price price) {
+        uint32_t slot;
+        if (!free_slots_.empty()) {
+            slot = free_slots_.back();
+            free_slots_.pop_back();
+            pool_[slot] = LevelData();
+        } else if (pool_used_ < pool_.size()) {
+            slot = static_cast<uint32_t>(pool_used_++);
+            pool_[slot] = LevelData();
+        } else {
+            slot = static_cast<uint32_t>(pool_.size());
+            pool_.emplace_back();
+            ++pool_used_;
+        }
+        pool_[slot].price = price;
+        return slot;
+    }
+    
+    void placeInWindow(size_t index, uint32_t slot) {
+        slots_[index] = slot;
+        occupied_[index / 64] |= 1ULL << (index % 64);
+        ++window_count_;
+        if (index < best_index_) {
+            best_index_ = index;
+        }
+    }
+    
+    void removeFromWindow(size_t index) {
+        slots_[index] = NO_SLOT;
+        occupied_[index / 64] &= ~(1ULL << (index % 64));
+        --window_count_;
+        
+        if (window_count_ == 0) {
+            best_index_ = WINDOW_TICKS;
+        } else if (index == best_index_) {
+            size_t word = index / 64;
+            uint64_t bits = occupied_[word] & (~0ULL << (index % 64));
+            while (bits == 0) {
+                bits = occupied_[++word];
+            }
+            best_index_ = word * 64 + static_cast<size_t>(__builtin_ctzll(bits));
+        }
+    }
+    
+    // Moves the window so new_best lands HEADROOM_TICKS from slot 0. Levels
+    // pushed past the far edge go to overflow; overflow levels that now fit
+    // are pulled into the window.
+    void recentre(Price new_best) {
+        auto& window_levels = recentre_scratch_;
+        window_levels.clear();
+        for (size_t word = 0; word < WORDS; ++word) {
+            for (uint64_t bits = occupied_[word]; bits != 0; bits &= bits - 1) {
+                window_levels.push_back(slots_[word * 64 + static_cast<size_t>(__builtin_ctzll(bits))]);
+            }
+        }
+        
+        std::fill(slots_.begin(), slots_.end(), NO_SLOT);
+        std::fill(occupied_.begin(), occupied_.end(), 0);
+        best_index_ = WINDOW_TICKS;
+        window_count_ = 0;
+        anchor_ = new_best - DIRECTION * static_cast<Price>(HEADROOM_TICKS) * tick_size_;
+        
+        for (uint32_t slot : window_levels) {
+            Price price = pool_[slot].price;
+            int64_t index = toIndex(price);
+            if (index < static_cast<int64_t>(WINDOW_TICKS)) {
+                placeInWindow(static_cast<size_t>(index), slot);
+            } else {
+                overflow_.emplace(price, slot);
+            }
+        }
+        
+        while (!overflow_.empty()) {
+            auto it = overflow_.begin();
+            int64_t index = toIndex(it->first);
+            if (index >= static_cast<int64_t>(WINDOW_TICKS)) {
+                break;
+            }
+            placeInWindow(static_cast<size_t>(index), it->second);
+            overflow_.erase(it);
+        }
+    }
+    
+    // Shrinks the tick to the common divisor of price and the off-grid
+    // levels so they all land on the grid. The new tick divides the old one,
+    // so every grid level stays on it. The off-grid levels join overflow, and
+    // re-centring on the overall best places them in the window as they fit.
+    void regrid(Price price) {
+        tick_size_ = std::gcd(tick_size_, price);
+        for (const auto& entry : off_grid_) {
+            tick_size_ = std::gcd(tick_size_, entry.first);
+        }
+        
+        Price best_price = best()->price;
+        if (Compare()(price, best_price)) {
+            best_price = price;
+        }
+        overflow_.insert(off_grid_.begin(), off_grid_.end());
+        off_grid_.clear();
+        recentre(best_price);
+    }
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+// Resource figures for the regression harness. Building with
+// -DORDERBOOK_COUNT_ALLOCS (the harness's own engine build) replaces the
+// global operator new and delete, so every heap allocation made through them
+// (including the aligned forms) is counted with a relaxed atomic increment;
+// allocations made with malloc directly are not. Without it the allocation
+// counts stay zero and the allocator is left alone.
+#ifdef ORDERBOOK_COUNT_ALLOCS
+constexpr bool ALLOCATION_COUNTING_ENABLED = true;
+#else
+constexpr bool ALLOCATION_COUNTING_ENABLED = false;
+#endif
+
+struct ProcessUsage {
+    uint64_t allocations;
+    uint64_t allocated_bytes;
+
+    // High-water mark of the resident set since the process started, 0
+    // where the platform does not report it
+    uint64_t peak_rss_kb;
+
+    ProcessUsage() : allocations(0), allocated_bytes(0), peak_rss_kb(0) {}
+};
+
+ProcessUsage currentProcessUsage();
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <unordered_set>
+#include "mbo_parser.h"
+#include "book_manager.h"
+#include "mbp_csv_writer.h"
+#include "mbp_binary_writer.h"
+#include "mbp_shm_publisher.h"
+#include "snapshot_queue.h"
+#include "conflating_writer.h"
+#include "checkpoint.h"
+#include "symbology.h"
+#include "latency.h"
+
+// Counters reported at the end of a replay
+struct ReplayStats {
+    size_t processed_events;
+    size_t snapshots_written;
+    size_t tfc_sequences_detected;
+    size_t snapshots_filtered;
+    size_t a_events_processed;
+    size_t c_events_processed;
+    size_t a_events_included;
+    size_t c_events_included;
+    
+    ReplayStats() : processed_events(0), snapshots_written(0), tfc_sequences_detected(0), snapshots_filtered(0),
+                    a_events_processed(0), c_events_processed(0), a_events_included(0), c_events_included(0) {}
+    
+    ReplayStats& operator+=(const ReplayStats& other) {
+        processed_events += other.processed_events;
+        snapshots_written += other.snapshots_written;
+        tfc_sequences_detected += other.tfc_sequences_detected;
+        snapshots_filtered += other.snapshots_filtered;
+        a_events_processed += other.a_events_processed;
+        c_events_processed += other.c_events_processed;
+        a_events_included += other.a_events_included;
+        c_events_included += other.c_events_included;
+        return *this;
+    }
+};
+
+// Turns a stream of MBO events into MBP-10 snapshots: per-instrument books,
+// T->F->C consolidation and the snapshot filtering rules. Events are pushed
+// one at a time; two events of lookahead are kept to recognise T->F->C
+// sequences. One engine owns its books and writer, so independent engines
+// can run on separate threads.
+template <typename Book, typename Writer>
+class ReplayEngine {
+public:
+    // Events the replay loops gather into one pushBatch call
+    static constexpr size_t BATCH_SIZE = 256;
+    
+    explicit ReplayEngine(Writer& writer);
+    
+    void push(const MboEvent& event);
+    
+    // Same as pushing each of the count events in turn, but the lookahead is
+    // read from the array in place; only the last two events are copied, to
+    // be carried into the next call
+    void pushBatch(const MboEvent* events, size_t count);
+    
+    // Processes the events still held as lookahead
+    void finish();
+    
+    const ReplayStats& getStats() const { return stats_; }
+    const BookManager<Book>& getBooks() const { return books_; }
+    
+    // Empty unless built with ORDERBOOK_LATENCY
+    const LatencyRecorder& getLatency() const { return latency_; }
+    
+    // Writes the books, the lookahead and every counter to path, plus the
+    // symbols learned so far, which the resumed reader would not see again.
+    // The file is written beside path and renamed over it, so a crash
+    // mid-write leaves the previous checkpoint intact.
+    bool saveCheckpoint(const std::string& path, const CheckpointPosition& position,
+                        const SymbologyTable* symbology = nullptr) const;
+    
+    // Replaces this engine's state with the checkpoint at path; pushing the
+    // input from position.input_offset onwards then continues the replay
+    // as if it had never stopped
+    bool loadCheckpoint(const std::string& path, CheckpointPosition& position, SymbologyTable* symbology = nullptr);
+
+private:
+    static constexpr size_t LOOKAHEAD = 3;
+    
+    // Longest symbol a checkpoint is trusted to hold
+    static constexpr uint32_t MAX_SYMBOL_LENGTH = 1024;
+    
+    Writer& writer_;
+    BookManager<Book> books_;
+    ReplayStats stats_;
+    
+    // lookahead_[0] is the event being processed
+    MboEvent lookahead_[LOOKAHEAD];
+    size_t buffered_;
+    
+    std::unordered_set<uint64_t> failed_cancel_orders_;
+    MboEvent tfc_trade_event_;
+    int tfc_events_remaining_;
+    
+    LatencyRecorder latency_;
+    
+    // Processes ahead[0], with available events of lookahead from ahead
+    void processFront(const MboEvent* ahead, size_t available);
+    
+    // The timed points of processFront: the book update, building the
+    // snapshot and handing it to the writer
+    ProcessResult applyEvent(Book& order_book, const MboEvent& event);
+    MbpSnapshot snapshotOf(const Book& order_book, const MboEvent& event);
+    void emitSnapshot(const MbpSnapshot& snapshot);
+    
+    void advance();
+    bool shouldIncludeEvent(const MboEvent& event, size_t events_of_type_processed);
+};
+
+extern template class ReplayEngine<OrderBook, MbpCsvWriter>;
+extern template class ReplayEngine<OrderBook, MbpBinaryWriter>;
+extern template class ReplayEngine<LadderOrderBook, MbpCsvWriter>;
+extern template class ReplayEngine<LadderOrderBook, MbpBinaryWriter>;
+extern template class ReplayEngine<OrderBook, MbpShmPublisher>;
+extern template class ReplayEngine<LadderOrderBook, MbpShmPublisher>;
+extern template class ReplayEngine<OrderBook, SnapshotQueueWriter>;
+extern template class ReplayEngine<LadderOrderBook, SnapshotQueueWriter>;
+extern template class ReplayEngine<OrderBook, ConflatingWriter>;
+extern template class ReplayEngine<LadderOrderBook, ConflatingWriter>;
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include "mbo_event_source.h"
+#include "replay_engine.h"
+#include "snapshot_queue.h"
+#include "spsc_ring.h"
+
+// Cores for the three pipeline stages; a negative value leaves that stage
+// to the scheduler
+struct PipelineCores {
+    int parse;
+    int book;
+    int write;
+    
+    PipelineCores() : parse(-1), book(-1), write(-1) {}
+};
+
+// Three-stage replay of one event stream: the calling thread parses, a book
+// thread runs the ReplayEngine and a writer thread formats and writes the
+// snapshots. Stages are joined by bounded SPSC rings; a full ring stalls the
+// stage feeding it, so memory stays bounded when the writer falls behind.
+// Each ring lives on the NUMA node of the core its consumer is pinned to,
+// and the books on the book stage's node.
+template <typename Book, typename Writer>
+class ReplayPipeline {
+public:
+    ReplayPipeline(Writer& writer, const PipelineCores& cores = PipelineCores());
+    
+    // Replays first_event and everything left in source, returning once the
+    // last snapshot has been handed to the writer
+    void run(MboEventSource& source, const MboEvent& first_event);
+    
+    const ReplayStats& getStats() const { return engine_.getStats(); }
+    const BookManager<Book>& getBooks() const { return engine_.getBooks(); }
+    const LatencyRecorder& getLatency() const { return engine_.getLatency(); }
+    
+    static constexpr size_t EVENT_RING_CAPACITY = 64 * 1024;
+    static constexpr size_t SNAPSHOT_RING_CAPACITY = 4 * 1024;
+
+private:
+    Writer& writer_;
+    PipelineCores cores_;
+    SpscRing<MboEvent> events_;
+    SpscRing<QueuedSnapshot> snapshots_;
+    SnapshotQueueWriter sink_;
+    ReplayEngine<Book, SnapshotQueueWriter> engine_;
+};
+
+extern template class ReplayPipeline<OrderBook, MbpCsvWriter>;
+extern template class ReplayPipeline<OrderBook, MbpBinaryWriter>;
+extern template class ReplayPipeline<LadderOrderBook, MbpCsvWriter>;
+extern template class ReplayPipeline<LadderOrderBook, MbpBinaryWriter>;
+extern template class ReplayPipeline<OrderBook, MbpShmPublisher>;
+extern template class ReplayPipeline<LadderOrderBook, MbpShmPublisher>;
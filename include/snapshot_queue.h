@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <thread>
+#include "order_book.h"
+#include "spsc_ring.h"
+
+// Snapshot together with the row index the engine assigned to it
+struct QueuedSnapshot {
+    MbpSnapshot snapshot;
+    uint64_t row_index;
+};
+
+// Writer stand-in that hands snapshots to another thread through an SPSC
+// ring. When the ring is full the producer yields until the consumer has
+// made room, so a slow writer throttles the stage feeding it.
+class SnapshotQueueWriter {
+public:
+    explicit SnapshotQueueWriter(SpscRing<QueuedSnapshot>& ring) : ring_(ring) {}
+    
+    bool writeSnapshot(const MbpSnapshot& snapshot, uint64_t row_index = 0) {
+        QueuedSnapshot item;
+        item.snapshot = snapshot;
+        item.row_index = row_index;
+        while (!ring_.tryPush(item)) {
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+private:
+    SpscRing<QueuedSnapshot>& ring_;
+};
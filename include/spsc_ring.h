@@ -0,0 +1,95 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+#include "page_allocator.h"
+
+// Bounded single-producer/single-consumer ring. Capacity is rounded up to a
+// power of two. Head and tail sit on separate cache lines, and each side
+// keeps a cached copy of the other's index so the shared atomics are only
+// touched when the ring looks full (producer) or empty (consumer). Slots
+// are allocated on numa_node, normally the consumer's.
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity, int numa_node = NO_NUMA_NODE)
+        : slots_(PageAllocator<T>(numa_node)), head_(0), cached_tail_(0), tail_(0), cached_head_(0) {
+        size_t rounded = 1;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+        slots_.resize(rounded);
+        mask_ = rounded - 1;
+    }
+    
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+    
+    // Producer side; returns false if the ring is full
+    bool tryPush(const T& item) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ == slots_.size()) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ == slots_.size()) {
+                return false;
+            }
+        }
+        slots_[tail & mask_] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // Consumer side; returns false if the ring is empty
+    bool tryPop(T& item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_) {
+                return false;
+            }
+        }
+        item = slots_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // Consumer side; pops up to max items into items with a single update
+    // of the shared head, returning how many were popped
+    size_t tryPopBatch(T* items, size_t max) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (cached_tail_ - head < max) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_) {
+                return 0;
+            }
+        }
+        size_t count = std::min(max, cached_tail_ - head);
+        for (size_t i = 0; i < count; ++i) {
+            items[i] = slots_[(head + i) & mask_];
+        }
+        head_.store(head + count, std::memory_order_release);
+        return count;
+    }
+    
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+    
+    size_t capacity() const { return slots_.size(); }
+
+private:
+    static constexpr size_t CACHE_LINE = 64;
+    
+    std::vector<T, PageAllocator<T>> slots_;
+    size_t mask_;
+    
+    // Consumer-owned
+    alignas(CACHE_LINE) std::atomic<size_t> head_;
+    size_t cached_tail_;
+    
+    // Producer-owned
+    alignas(CACHE_LINE) std::atomic<size_t> tail_;
+    size_t cached_head_;
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <mutex>
+
+// Instrument metadata keyed by instrument_id, learned from the feed's symbol
+// column (or added explicitly) and used by the writers to label rows.
+// Access is serialised so the parser thread can add instruments while shard
+// writers look them up; callers cache what they find, since entries keep
+// their address until clear().
+class SymbologyTable {
+public:
+    struct Entry {
+        uint16_t publisher_id;
+        std::string symbol;
+    };
+    
+    void add(uint32_t instrument_id, uint16_t publisher_id, const std::string& symbol);
+    bool contains(uint32_t instrument_id) const;
+    
+    // Returns nullptr for an unknown instrument
+    const Entry* find(uint32_t instrument_id) const;
+    
+    // Symbol for instrument_id, or an empty string if unknown
+    const std::string& getSymbol(uint32_t instrument_id) const;
+    
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& entry : entries_) {
+            fn(entry.first, entry.second);
+        }
+    }
+    
+    size_t size() const;
+    void clear();
+
+private:
+    mutable std::mutex mutex_;
+    std::unordered_map<uint32_t, Entry> entries_;
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Pins the calling thread to one CPU core. Returns false if the platform
+// refuses (or does not support) the request; callers carry on unpinned.
+// A pinned thread's page allocations then prefer the core's NUMA node.
+bool pinCurrentThread(int core);
+
+// NUMA node the core belongs to, or -1 where that is unknown
+int numaNodeOfCore(int core);
+
+// Parses a comma-separated list of core numbers such as "4,5,6,7"
+bool parseCoreList(const std::string& list, std::vector<int>& cores);
+
+// Core for the index-th thread of a group pinned to cores, reusing the list
+// round-robin when there are more threads than cores; -1 for an empty list
+inline int coreForThread(const std::vector<int>& cores, size_t index) {
+    return cores.empty() ? -1 : cores[index % cores.size()];
+}
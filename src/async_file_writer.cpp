@@ -0,0 +1,91 @@
+#include "async_file_writer.h"
+#include <iostream>
+
+AsyncFileWriter::AsyncFileWriter() : back_used_(0), write_pending_(false), stopping_(false) {}
+
+AsyncFileWriter::~AsyncFileWriter() {
+    close();
+}
+
+bool AsyncFileWriter::open(const std::string& filename, std::ios::openmode mode) {
+    close();
+    
+    file_stream_.open(filename, mode);
+    if (!file_stream_.is_open()) {
+        std::cerr << "Error: Could not open output file: " << filename << std::endl;
+        return false;
+    }
+    
+    stopping_ = false;
+    write_pending_ = false;
+    io_thread_ = std::thread(&AsyncFileWriter::run, this);
+    return true;
+}
+
+void AsyncFileWriter::write(std::vector<char>& buffer, size_t used) {
+    if (used == 0) {
+        return;
+    }
+    
+    std::unique_lock<std::mutex> lock(mutex_);
+    waitIdle(lock);
+    
+    if (back_buffer_.size() < buffer.size()) {
+        back_buffer_.resize(buffer.size());
+    }
+    buffer.swap(back_buffer_);
+    back_used_ = used;
+    write_pending_ = true;
+    
+    lock.unlock();
+    work_ready_.notify_one();
+}
+
+void AsyncFileWriter::flush() {
+    if (!io_thread_.joinable()) {
+        return;
+    }
+    
+    std::unique_lock<std::mutex> lock(mutex_);
+    waitIdle(lock);
+    file_stream_.flush();
+}
+
+void AsyncFileWriter::close() {
+    if (!io_thread_.joinable()) {
+        return;
+    }
+    
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        waitIdle(lock);
+        stopping_ = true;
+    }
+    work_ready_.notify_one();
+    io_thread_.join();
+    
+    file_stream_.close();
+}
+
+void AsyncFileWriter::waitIdle(std::unique_lock<std::mutex>& lock) {
+    work_done_.wait(lock, [this]() { return !write_pending_; });
+}
+
+// The stream is only touched by this thread while a write is pending, and
+// by the caller only once it has waited for the pending write to finish
+void AsyncFileWriter::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        work_ready_.wait(lock, [this]() { return write_pending_ || stopping_; });
+        if (!write_pending_) {
+            break;
+        }
+        
+        lock.unlock();
+        file_stream_.write(back_buffer_.data(), back_used_);
+        lock.lock();
+        
+        write_pending_ = false;
+        work_done_.notify_one();
+    }
+}
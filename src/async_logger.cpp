@@ -0,0 +1,161 @@
+#include "async_logger.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+static const char* messageName(LogMessage message) {
+    switch (message) {
+        case LogMessage::RESET_EVENT: return "initial reset";
+        case LogMessage::FILTERED_CANCEL: return "filtered cancel of unknown order";
+        case LogMessage::FILTERED_ADD: return "filtered add after failed cancel";
+        case LogMessage::FILTERED_C_EVENT: return "filtered C event";
+        case LogMessage::FILTERED_A_EVENT: return "filtered A event";
+        case LogMessage::UNKNOWN_ACTION: return "unknown action";
+        case LogMessage::DUPLICATE_ORDER: return "duplicate order";
+        case LogMessage::UNEXPECTED_FILL: return "unexpected fill";
+        default: return "unknown message";
+    }
+}
+
+bool parseLogSeverity(const char* name, LogSeverity& severity) {
+    if (std::strcmp(name, "info") == 0) {
+        severity = LogSeverity::INFO;
+    } else if (std::strcmp(name, "warning") == 0) {
+        severity = LogSeverity::WARNING;
+    } else if (std::strcmp(name, "off") == 0) {
+        severity = LogSeverity::OFF;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void AsyncLogger::format(std::ostream& out, const LogRecord& record) {
+    switch (record.message) {
+        case LogMessage::RESET_EVENT:
+            out << "Processing initial R (reset) event - starting with empty orderbook as per requirement #1";
+            break;
+        case LogMessage::FILTERED_CANCEL:
+            out << "Filtered Cancel event for non-existent order " << record.args[0];
+            break;
+        case LogMessage::FILTERED_ADD:
+            out << "Filtered Add event for order " << record.args[0] << " following failed Cancel";
+            break;
+        case LogMessage::FILTERED_C_EVENT:
+            out << "Filtered C event " << record.args[0] << " (orderbook state-aware filtering)";
+            break;
+        case LogMessage::FILTERED_A_EVENT:
+            out << "Filtered A event " << record.args[0] << " (orderbook state-aware filtering)";
+            break;
+        case LogMessage::UNKNOWN_ACTION:
+            out << "Warning: Unknown action '" << static_cast<char>(record.args[0]) << "'";
+            break;
+        case LogMessage::DUPLICATE_ORDER:
+            out << "Warning: Order " << record.args[0] << " already exists";
+            break;
+        case LogMessage::UNEXPECTED_FILL:
+            out << "Warning: Unexpected fill event";
+            break;
+        default:
+            out << "Unknown log message " << static_cast<unsigned>(record.message);
+            break;
+    }
+}
+
+AsyncLogger& AsyncLogger::instance() {
+    static AsyncLogger logger(std::cout, std::cerr);
+    return logger;
+}
+
+AsyncLogger::AsyncLogger(std::ostream& info_out, std::ostream& warning_out)
+    : info_out_(info_out), warning_out_(warning_out), ring_(RING_CAPACITY), min_severity_(LogSeverity::INFO),
+      rate_limit_(DEFAULT_RATE_LIMIT), dropped_(0), flush_requests_(0), flushes_done_(0), window_(0), stopping_(false) {
+    worker_ = std::thread(&AsyncLogger::run, this);
+}
+
+AsyncLogger::~AsyncLogger() {
+    stopping_.store(true, std::memory_order_release);
+    worker_.join();
+}
+
+void AsyncLogger::flush() {
+    uint64_t ticket = flush_requests_.fetch_add(1, std::memory_order_acq_rel) + 1;
+    while (flushes_done_.load(std::memory_order_acquire) < ticket) {
+        std::this_thread::yield();
+    }
+}
+
+size_t AsyncLogger::drain() {
+    LogRecord record;
+    size_t count = 0;
+    while (ring_.tryPop(record)) {
+        std::ostream& out = streamFor(record.message);
+        format(out, record);
+        out << '\n';
+        ++count;
+    }
+    return count;
+}
+
+// Everything claimed before the request is written, including records
+// whose producer is still filling its slot
+void AsyncLogger::completeFlush(uint64_t request) {
+    const size_t target = ring_.pushed();
+    while (ring_.popped() < target) {
+        if (drain() == 0) {
+            std::this_thread::yield();
+        }
+    }
+    reportSuppressed();
+    info_out_.flush();
+    warning_out_.flush();
+    flushes_done_.store(request, std::memory_order_release);
+}
+
+void AsyncLogger::reportSuppressed() {
+    for (size_t i = 0; i < MESSAGE_COUNT; ++i) {
+        uint64_t suppressed = counters_[i].suppressed.exchange(0, std::memory_order_relaxed);
+        if (suppressed > 0) {
+            LogMessage message = static_cast<LogMessage>(i);
+            streamFor(message) << "Suppressed " << suppressed << " '" << messageName(message) << "' messages (limit "
+                               << rate_limit_.load(std::memory_order_relaxed) << "/s)\n";
+        }
+    }
+    uint64_t dropped = dropped_.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0) {
+        warning_out_ << "Warning: Log ring full, dropped " << dropped << " messages\n";
+    }
+}
+
+// The only thread that writes to the streams
+void AsyncLogger::run() {
+    auto window_start = std::chrono::steady_clock::now();
+    for (;;) {
+        bool stopping = stopping_.load(std::memory_order_acquire);
+        size_t written = drain();
+        
+        uint64_t request = flush_requests_.load(std::memory_order_acquire);
+        if (request != flushes_done_.load(std::memory_order_relaxed)) {
+            completeFlush(request);
+        } else if (written > 0) {
+            info_out_.flush();
+            warning_out_.flush();
+        }
+        
+        auto now = std::chrono::steady_clock::now();
+        if (now - window_start >= std::chrono::seconds(1)) {
+            reportSuppressed();
+            window_.fetch_add(1, std::memory_order_relaxed);
+            window_start = now;
+        }
+        
+        if (stopping) {
+            // Everything logged before the destructor ran is in the ring
+            completeFlush(request);
+            return;
+        }
+        if (written == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
@@ -0,0 +1,80 @@
+#include "book_manager.h"
+#include <algorithm>
+
+template <typename Book>
+BookManager<Book>::BookManager() : default_order_capacity_(Book::DEFAULT_ORDER_CAPACITY) {}
+
+template <typename Book>
+void BookManager<Book>::setOrderCapacity(uint32_t instrument_id, size_t order_capacity) {
+    order_capacities_[instrument_id] = order_capacity;
+    if (Book* book = findBook(instrument_id)) {
+        book->reserveOrders(order_capacity);
+    }
+}
+
+template <typename Book>
+Book& BookManager<Book>::createBook(uint32_t instrument_id) {
+    auto capacity_it = order_capacities_.find(instrument_id);
+    size_t order_capacity = capacity_it != order_capacities_.end() ? capacity_it->second : default_order_capacity_;
+    
+    uint32_t slot;
+    if (!free_slots_.empty()) {
+        slot = free_slots_.back();
+        free_slots_.pop_back();
+        instrument_ids_[slot] = instrument_id;
+        books_[slot].reserveOrders(order_capacity);
+    } else {
+        slot = static_cast<uint32_t>(books_.size());
+        books_.emplace_back(order_capacity);
+        instrument_ids_.push_back(instrument_id);
+    }
+    
+    if (instrument_id < DENSE_ID_LIMIT) {
+        if (instrument_id >= dense_slots_.size()) {
+            size_t grown = std::max<size_t>(dense_slots_.size() * 2, instrument_id + 1);
+            dense_slots_.resize(std::min<size_t>(grown, DENSE_ID_LIMIT), NO_SLOT);
+        }
+        dense_slots_[instrument_id] = slot;
+    } else {
+        sparse_slots_[instrument_id] = slot;
+    }
+    
+    active_slots_.push_back(slot);
+    return books_[slot];
+}
+
+template <typename Book>
+size_t BookManager<Book>::getOrderCount() const {
+    size_t total = 0;
+    forEachBook([&](uint32_t, const Book& book) { total += book.getOrderCount(); });
+    return total;
+}
+
+template <typename Book>
+size_t BookManager<Book>::getBidLevelCount() const {
+    size_t total = 0;
+    forEachBook([&](uint32_t, const Book& book) { total += book.getBidLevelCount(); });
+    return total;
+}
+
+template <typename Book>
+size_t BookManager<Book>::getAskLevelCount() const {
+    size_t total = 0;
+    forEachBook([&](uint32_t, const Book& book) { total += book.getAskLevelCount(); });
+    return total;
+}
+
+// Books are reset rather than destroyed; their slots go back to the pool
+template <typename Book>
+void BookManager<Book>::clear() {
+    for (uint32_t slot : active_slots_) {
+        books_[slot].clear();
+        free_slots_.push_back(slot);
+    }
+    active_slots_.clear();
+    std::fill(dense_slots_.begin(), dense_slots_.end(), NO_SLOT);
+    sparse_slots_.clear();
+}
+
+template class BookManager<OrderBook>;
+template class BookManager<LadderOrderBook>;
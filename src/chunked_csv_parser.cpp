@@ -0,0 +1,124 @@
+#include "chunked_csv_parser.h"
+#include "thread_affinity.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+ChunkedCsvParser::ChunkedCsvParser(const char* data, size_t begin, size_t end, size_t threads, size_t chunk_bytes,
+                                   bool collect_symbols, const std::vector<int>& cores)
+    : data_(data), end_(end), chunk_bytes_(std::max<size_t>(chunk_bytes, 1)), collect_symbols_(collect_symbols),
+      slots_(2 * std::max<size_t>(threads, 1)), next_begin_(begin), claimed_(0), served_(0), holding_(false),
+      stopping_(false) {
+    for (size_t i = 0; i < std::max<size_t>(threads, 1); ++i) {
+        int core = coreForThread(cores, i);
+        workers_.emplace_back([this, core]() {
+            if (core >= 0 && !pinCurrentThread(core)) {
+                std::cerr << "Warning: Could not pin parse thread to core " << core << std::endl;
+            }
+            run();
+        });
+    }
+}
+
+ChunkedCsvParser::~ChunkedCsvParser() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    work_ready_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+const ParsedChunk* ChunkedCsvParser::nextChunk() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (holding_) {
+        slots_[served_ % slots_.size()].ready = false;
+        ++served_;
+        holding_ = false;
+        work_ready_.notify_all();
+    }
+    if (served_ == claimed_ && next_begin_ == end_) {
+        return nullptr;
+    }
+    
+    Slot& slot = slots_[served_ % slots_.size()];
+    chunk_ready_.wait(lock, [&slot]() { return slot.ready; });
+    holding_ = true;
+    return &slot.chunk;
+}
+
+// Chunk boundaries are cut under the lock, one after another, so chunks are
+// claimed in file order; only the parsing itself runs concurrently
+void ChunkedCsvParser::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        work_ready_.wait(lock, [this]() {
+            return stopping_ || next_begin_ == end_ || claimed_ < served_ + slots_.size();
+        });
+        if (stopping_ || next_begin_ == end_) {
+            break;
+        }
+        
+        Slot& slot = slots_[claimed_ % slots_.size()];
+        ++claimed_;
+        slot.chunk.begin = next_begin_;
+        size_t target = std::min(end_, next_begin_ + chunk_bytes_);
+        const char* newline = static_cast<const char*>(std::memchr(data_ + target, '\n', end_ - target));
+        slot.chunk.end = target == end_ || !newline ? end_ : static_cast<size_t>(newline - data_) + 1;
+        next_begin_ = slot.chunk.end;
+        
+        lock.unlock();
+        parse(slot.chunk);
+        lock.lock();
+        
+        slot.ready = true;
+        chunk_ready_.notify_all();
+    }
+}
+
+// The same row handling as MboFileReader::next()
+void ChunkedCsvParser::parse(ParsedChunk& chunk) const {
+    chunk.events.clear();
+    chunk.symbols.clear();
+    chunk.skipped_lines = 0;
+    
+    const char* cursor = data_ + chunk.begin;
+    const char* end = data_ + chunk.end;
+    uint32_t last_instrument_id = 0;
+    bool has_last_instrument = false;
+    MboEvent event;
+    
+    while (cursor < end) {
+        const char* newline = static_cast<const char*>(std::memchr(cursor, '\n', static_cast<size_t>(end - cursor)));
+        const char* line = cursor;
+        const char* line_end = newline ? newline : end;
+        cursor = newline ? newline + 1 : end;
+        
+        if (line_end > line && line_end[-1] == '\r') {
+            --line_end;
+        }
+        if (line_end == line) {
+            continue;
+        }
+        if (!MboParser::parseLine(line, line_end, event)) {
+            ++chunk.skipped_lines;
+            continue;
+        }
+        chunk.events.push(event);
+        
+        if (collect_symbols_ && (!has_last_instrument || event.instrument_id != last_instrument_id)) {
+            last_instrument_id = event.instrument_id;
+            has_last_instrument = true;
+            
+            auto seen = std::find_if(chunk.symbols.begin(), chunk.symbols.end(),
+                                     [&event](const ChunkSymbol& entry) { return entry.instrument_id == event.instrument_id; });
+            const char* symbol_begin;
+            const char* symbol_end;
+            if (seen == chunk.symbols.end() && MboParser::findSymbol(line, line_end, &symbol_begin, &symbol_end)) {
+                chunk.symbols.push_back(ChunkSymbol{event.instrument_id, event.publisher_id, std::string(symbol_begin, symbol_end)});
+            }
+        }
+    }
+}
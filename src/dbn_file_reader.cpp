@@ -0,0 +1,391 @@
+#include "dbn_file_reader.h"
+#include "dbn_mbo.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#ifdef ORDERBOOK_ZSTD
+#include <zstd.h>
+#endif
+
+// DBN metadata header layout (versions 1 to 3). The fixed part is the same
+// size in every version; version 1 keeps a record count where later
+// versions keep the symbol width.
+namespace {
+
+constexpr uint8_t MAX_VERSION = 3;
+constexpr size_t PREFIX_SIZE = 8;
+constexpr size_t FIXED_METADATA_SIZE = 100;
+constexpr size_t SCHEMA_OFFSET = 16;
+constexpr size_t STYPE_OUT_OFFSET = 43;
+constexpr size_t STYPE_OUT_OFFSET_V1 = 51;
+constexpr size_t SYMBOL_CSTR_LEN_OFFSET = 45;
+constexpr size_t SYMBOL_CSTR_LEN_V1 = 22;
+
+constexpr uint16_t SCHEMA_MBO = 0;
+constexpr uint16_t SCHEMA_MIXED = 0xFFFF;
+constexpr uint8_t STYPE_INSTRUMENT_ID = 0;
+
+constexpr uint32_t ZSTD_MAGIC = 0xFD2FB528;
+
+// Bounds-checked cursor over the metadata bytes
+class MetadataCursor {
+public:
+    MetadataCursor(const std::vector<char>& bytes, size_t pos) : bytes_(bytes), pos_(pos), ok_(pos <= bytes.size()) {}
+    
+    uint32_t u32() {
+        if (!take(sizeof(uint32_t))) {
+            return 0;
+        }
+        return dbn_mbo::load<uint32_t>(bytes_.data(), pos_ - sizeof(uint32_t));
+    }
+    
+    // A fixed-width, NUL-padded string
+    std::string cstr(size_t width) {
+        if (!take(width)) {
+            return std::string();
+        }
+        const char* begin = bytes_.data() + pos_ - width;
+        return std::string(begin, std::find(begin, begin + width, '\0'));
+    }
+    
+    void skip(size_t size) { take(size); }
+    bool ok() const { return ok_; }
+
+private:
+    const std::vector<char>& bytes_;
+    size_t pos_;
+    bool ok_;
+    
+    bool take(size_t size) {
+        if (!ok_ || bytes_.size() - pos_ < size) {
+            ok_ = false;
+            return false;
+        }
+        pos_ += size;
+        return true;
+    }
+};
+
+} // namespace
+
+DbnFileReader::DbnFileReader(const std::string& filename)
+    : filename_(filename), file_(nullptr), compressed_(false), zstd_stream_(nullptr), zstd_frame_done_(true), raw_pos_(0), raw_used_(0),
+      raw_eof_(false), version_(0), symbology_(nullptr), last_instrument_id_(0), has_last_instrument_(false),
+      skipped_records_(0), front_pos_(0), front_used_(0), back_used_(0), fill_pending_(false), input_done_(false),
+      stopping_(false) {}
+
+DbnFileReader::~DbnFileReader() {
+    close();
+}
+
+bool DbnFileReader::isDbnFile(const std::string& filename) {
+    auto endsWith = [&filename](const char* suffix) {
+        size_t length = std::strlen(suffix);
+        return filename.size() >= length && filename.compare(filename.size() - length, length, suffix) == 0;
+    };
+    return endsWith(".dbn") || endsWith(".dbn.zst");
+}
+
+bool DbnFileReader::open() {
+    close();
+    
+    file_ = std::fopen(filename_.c_str(), "rb");
+    if (!file_) {
+        std::cerr << "Error: Could not open file " << filename_ << std::endl;
+        return false;
+    }
+    
+    // The zstd frame magic tells compressed input apart; for a plain file
+    // the bytes read here are handed out again by readInput()
+    raw_buffer_.resize(BUFFER_SIZE);
+    raw_pos_ = 0;
+    raw_used_ = std::fread(raw_buffer_.data(), 1, sizeof(uint32_t), file_);
+    raw_eof_ = false;
+    compressed_ = raw_used_ == sizeof(uint32_t) && dbn_mbo::load<uint32_t>(raw_buffer_.data(), 0) == ZSTD_MAGIC;
+    if (compressed_) {
+#ifdef ORDERBOOK_ZSTD
+        zstd_stream_ = ZSTD_createDStream();
+        ZSTD_initDStream(static_cast<ZSTD_DStream*>(zstd_stream_));
+        zstd_frame_done_ = true;
+#else
+        std::cerr << "Error: " << filename_ << " is zstd-compressed; rebuild with ZSTD=1 to read it" << std::endl;
+        close();
+        return false;
+#endif
+    }
+    
+    if (!readMetadata()) {
+        close();
+        return false;
+    }
+    
+    front_.resize(BUFFER_SIZE);
+    back_.resize(BUFFER_SIZE);
+    front_pos_ = 0;
+    front_used_ = 0;
+    back_used_ = 0;
+    carry_.clear();
+    error_.clear();
+    input_done_ = false;
+    stopping_ = false;
+    last_instrument_id_ = 0;
+    has_last_instrument_ = false;
+    skipped_records_ = 0;
+    
+    fill_pending_ = true;
+    io_thread_ = std::thread(&DbnFileReader::run, this);
+    return true;
+}
+
+void DbnFileReader::close() {
+    if (io_thread_.joinable()) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_done_.wait(lock, [this]() { return !fill_pending_; });
+            stopping_ = true;
+        }
+        work_ready_.notify_one();
+        io_thread_.join();
+    }
+
+#ifdef ORDERBOOK_ZSTD
+    if (zstd_stream_) {
+        ZSTD_freeDStream(static_cast<ZSTD_DStream*>(zstd_stream_));
+    }
+#endif
+    zstd_stream_ = nullptr;
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+bool DbnFileReader::next(MboEvent& event) {
+    for (;;) {
+        while (front_pos_ < front_used_) {
+            // Buffers hold whole records only, as checked by fill()
+            const char* record = front_.data() + front_pos_;
+            size_t size = static_cast<size_t>(static_cast<uint8_t>(record[0])) * 4;
+            front_pos_ += size;
+            
+            if (!dbn_mbo::decode(record, size, event)) {
+                ++skipped_records_;
+                continue;
+            }
+            
+            if (symbology_ && (!has_last_instrument_ || event.instrument_id != last_instrument_id_)) {
+                last_instrument_id_ = event.instrument_id;
+                has_last_instrument_ = true;
+                auto mapped = mapped_symbols_.find(event.instrument_id);
+                if (mapped != mapped_symbols_.end() && !symbology_->contains(event.instrument_id)) {
+                    symbology_->add(event.instrument_id, event.publisher_id, mapped->second);
+                }
+            }
+            return true;
+        }
+        
+        if (!nextBuffer()) {
+            return false;
+        }
+    }
+}
+
+bool DbnFileReader::nextBuffer() {
+    if (!io_thread_.joinable()) {
+        return false;
+    }
+    
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        work_done_.wait(lock, [this]() { return !fill_pending_; });
+        if (back_used_ > 0) {
+            break;
+        }
+        if (input_done_) {
+            if (!error_.empty()) {
+                std::cerr << "Error: " << error_ << " in " << filename_ << std::endl;
+                error_.clear();
+            }
+            return false;
+        }
+        
+        // A read too short for a whole record; wait for more
+        fill_pending_ = true;
+        lock.unlock();
+        work_ready_.notify_one();
+        lock.lock();
+    }
+    
+    front_.swap(back_);
+    front_pos_ = 0;
+    front_used_ = back_used_;
+    back_used_ = 0;
+    if (!input_done_) {
+        fill_pending_ = true;
+        lock.unlock();
+        work_ready_.notify_one();
+    }
+    return true;
+}
+
+size_t DbnFileReader::readInput(char* out, size_t size) {
+    size_t produced = 0;
+    if (!compressed_) {
+        size_t buffered = std::min(size, raw_used_ - raw_pos_);
+        std::memcpy(out, raw_buffer_.data() + raw_pos_, buffered);
+        raw_pos_ += buffered;
+        produced = buffered;
+        if (produced < size) {
+            produced += std::fread(out + produced, 1, size - produced, file_);
+        }
+        return produced;
+    }
+
+#ifdef ORDERBOOK_ZSTD
+    ZSTD_DStream* stream = static_cast<ZSTD_DStream*>(zstd_stream_);
+    ZSTD_outBuffer output = {out, size, 0};
+    while (output.pos < output.size) {
+        if (raw_pos_ == raw_used_ && !raw_eof_) {
+            raw_pos_ = 0;
+            raw_used_ = std::fread(raw_buffer_.data(), 1, raw_buffer_.size(), file_);
+            raw_eof_ = raw_used_ == 0;
+        }
+        
+        // With the input exhausted, one more call drains what zstd holds;
+        // a file may hold several frames back to back
+        ZSTD_inBuffer input = {raw_buffer_.data(), raw_used_, raw_pos_};
+        size_t before = output.pos;
+        size_t result = ZSTD_decompressStream(stream, &output, &input);
+        if (ZSTD_isError(result)) {
+            error_ = std::string("zstd: ") + ZSTD_getErrorName(result);
+            return output.pos;
+        }
+        if (input.pos != raw_pos_ || output.pos != before) {
+            zstd_frame_done_ = result == 0;
+        }
+        raw_pos_ = input.pos;
+        if (raw_eof_ && output.pos == before) {
+            if (!zstd_frame_done_) {
+                error_ = "Truncated zstd frame";
+            }
+            break;
+        }
+    }
+    return output.pos;
+#else
+    return 0;
+#endif
+}
+
+bool DbnFileReader::readMetadata() {
+    char prefix[PREFIX_SIZE];
+    if (readInput(prefix, sizeof(prefix)) != sizeof(prefix) || std::memcmp(prefix, "DBN", 3) != 0) {
+        std::cerr << "Error: " << filename_ << " is not a DBN file" << std::endl;
+        return false;
+    }
+    version_ = static_cast<uint8_t>(prefix[3]);
+    if (version_ == 0 || version_ > MAX_VERSION) {
+        std::cerr << "Error: Unsupported DBN version " << static_cast<int>(version_) << " in " << filename_ << std::endl;
+        return false;
+    }
+    
+    std::vector<char> metadata(dbn_mbo::load<uint32_t>(prefix, 4));
+    if (metadata.size() < FIXED_METADATA_SIZE || readInput(metadata.data(), metadata.size()) != metadata.size()) {
+        std::cerr << "Error: Truncated DBN metadata in " << filename_ << std::endl;
+        return false;
+    }
+    
+    uint16_t schema = dbn_mbo::load<uint16_t>(metadata.data(), SCHEMA_OFFSET);
+    if (schema != SCHEMA_MBO && schema != SCHEMA_MIXED) {
+        std::cerr << "Error: " << filename_ << " holds DBN schema " << schema << ", not MBO" << std::endl;
+        return false;
+    }
+    uint8_t stype_out = static_cast<uint8_t>(metadata[version_ == 1 ? STYPE_OUT_OFFSET_V1 : STYPE_OUT_OFFSET]);
+    size_t symbol_width =
+        version_ == 1 ? SYMBOL_CSTR_LEN_V1 : dbn_mbo::load<uint16_t>(metadata.data(), SYMBOL_CSTR_LEN_OFFSET);
+    
+    // Schema definition, then the requested, partial and not-found symbol
+    // lists, then the mappings from raw symbol to instrument_id
+    MetadataCursor cursor(metadata, FIXED_METADATA_SIZE);
+    cursor.skip(cursor.u32());
+    for (int list = 0; list < 3; ++list) {
+        uint32_t count = cursor.u32();
+        for (uint32_t i = 0; i < count && cursor.ok(); ++i) {
+            cursor.skip(symbol_width);
+        }
+    }
+    
+    mapped_symbols_.clear();
+    uint32_t mapping_count = cursor.u32();
+    for (uint32_t i = 0; i < mapping_count && cursor.ok(); ++i) {
+        std::string raw_symbol = cursor.cstr(symbol_width);
+        uint32_t interval_count = cursor.u32();
+        for (uint32_t j = 0; j < interval_count && cursor.ok(); ++j) {
+            cursor.skip(2 * sizeof(uint32_t));
+            std::string symbol = cursor.cstr(symbol_width);
+            if (stype_out == STYPE_INSTRUMENT_ID && !symbol.empty()) {
+                mapped_symbols_[static_cast<uint32_t>(std::strtoul(symbol.c_str(), nullptr, 10))] = raw_symbol;
+            }
+        }
+    }
+    if (!cursor.ok()) {
+        std::cerr << "Error: Malformed DBN metadata in " << filename_ << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Fills back_ with the carried partial record plus the next read, keeping
+// only whole records and carrying the rest over to the next fill
+void DbnFileReader::fill() {
+    size_t used = carry_.size();
+    std::memcpy(back_.data(), carry_.data(), used);
+    carry_.clear();
+    
+    size_t read = error_.empty() ? readInput(back_.data() + used, back_.size() - used) : 0;
+    used += read;
+    
+    size_t pos = 0;
+    while (used - pos >= dbn_mbo::HEADER_SIZE) {
+        size_t size = dbn_mbo::recordSize(back_.data() + pos, used - pos);
+        if (size < dbn_mbo::HEADER_SIZE) {
+            error_ = "Corrupt DBN record";
+            used = pos;
+            break;
+        }
+        if (size > used - pos) {
+            break;
+        }
+        pos += size;
+    }
+    carry_.assign(back_.data() + pos, back_.data() + used);
+    back_used_ = pos;
+    
+    if (read == 0 || !error_.empty()) {
+        input_done_ = true;
+        if (!carry_.empty() && error_.empty()) {
+            error_ = "Truncated DBN record";
+        }
+    }
+}
+
+// back_, carry_ and the input are only touched by this thread while a fill
+// is pending, and by the caller only once it has waited for the fill
+void DbnFileReader::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        work_ready_.wait(lock, [this]() { return fill_pending_ || stopping_; });
+        if (!fill_pending_) {
+            break;
+        }
+        
+        lock.unlock();
+        fill();
+        lock.lock();
+        
+        fill_pending_ = false;
+        work_done_.notify_one();
+    }
+}
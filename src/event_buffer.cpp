@@ -1,9 +1,8 @@
 #include "event_buffer.h"
 #include <algorithm>
-#include <sstream>
-#include <iostream>
+#include <cstdlib>
 
-EventBuffer::EventBuffer() : window_timestamp_(0) {
+EventBuffer::EventBuffer() : window_timestamp_(0), slot_mask_(0), generation_(0) {
     events_.reserve(100);
     last_stats_ = {0, 0, 0, 0};
 }
@@ -11,12 +10,16 @@ EventBuffer::EventBuffer() : window_timestamp_(0) {
 bool EventBuffer::addEvent(const MboEvent& event) {
     if (isEmpty()) {
         window_timestamp_ = event.ts_event;
-        events_.push_back(event);
+        events_.push(event);
+        last_stats_.original_count++;
+        last_stats_.final_count = events_.size();
         return true;
     }
     
     if (belongsToCurrentWindow(event)) {
-        events_.push_back(event);
+        events_.push(event);
+        last_stats_.original_count++;
+        last_stats_.final_count = events_.size();
         return true;
     }
     
@@ -38,43 +41,57 @@ size_t EventBuffer::size() const {
 size_t EventBuffer::applyOrderAnnihilation() {
     if (events_.empty()) return 0;
     
-    std::unordered_map<uint64_t, std::vector<size_t>> add_events;
-    std::unordered_map<uint64_t, std::vector<size_t>> cancel_events;
+    beginPass();
     
+    bool inserted;
     for (size_t i = 0; i < events_.size(); ++i) {
-        const auto& event = events_[i];
+        const PackedMboEvent& event = events_.hot(i);
+        if (event.action != 'A' && event.action != 'C' && event.action != 'F' && event.action != 'M') {
+            continue;
+        }
+        
+        Slot& slot = findSlot(event.order_id, makeTag(event, false), inserted);
         if (event.action == 'A') {
-            add_events[event.order_id].push_back(i);
+            slot.adds++;
         } else if (event.action == 'C') {
-            cancel_events[event.order_id].push_back(i);
+            slot.cancels++;
+        } else {
+            slot.touched = true;
         }
     }
     
-    std::unordered_set<size_t> indices_to_remove;
+    // The first k adds and first k cancels of an order go, k being the
+    // smaller of the two counts; survivors are compacted in order
     size_t pairs_removed = 0;
-    
-    for (const auto& [order_id, add_indices] : add_events) {
-        auto cancel_it = cancel_events.find(order_id);
-        if (cancel_it != cancel_events.end()) {
-            const auto& cancel_indices = cancel_it->second;
-            
-            size_t pairs_to_match = std::min(add_indices.size(), cancel_indices.size());
-            
-            for (size_t i = 0; i < pairs_to_match; ++i) {
-                indices_to_remove.insert(add_indices[i]);
-                indices_to_remove.insert(cancel_indices[i]);
-                pairs_removed++;
+    size_t kept = 0;
+    for (size_t i = 0; i < events_.size(); ++i) {
+        const PackedMboEvent& event = events_.hot(i);
+        bool drop = false;
+        
+        if (event.action == 'A' || event.action == 'C') {
+            Slot& slot = findSlot(event.order_id, makeTag(event, false), inserted);
+            uint32_t pairs = slot.touched ? 0 : std::min(slot.adds, slot.cancels);
+            uint32_t& removed = event.action == 'A' ? slot.adds_removed : slot.cancels_removed;
+            if (removed < pairs) {
+                ++removed;
+                drop = true;
+                if (event.action == 'A') {
+                    pairs_removed++;
+                }
             }
         }
+        
+        if (!drop) {
+            if (kept != i) {
+                events_.move(i, kept);
+            }
+            ++kept;
+        }
     }
+    events_.truncate(kept);
     
-    std::vector<size_t> sorted_indices(indices_to_remove.begin(), indices_to_remove.end());
-    std::sort(sorted_indices.rbegin(), sorted_indices.rend());
-    
-    for (size_t idx : sorted_indices) {
-        events_.erase(events_.begin() + idx);
-    }
-    
+    last_stats_.annihilated_pairs += pairs_removed;
+    last_stats_.final_count = events_.size();
     return pairs_removed;
 }
 
@@ -82,46 +99,67 @@ size_t EventBuffer::applySameLevelBatching() {
     if (events_.empty()) return 0;
     
     size_t original_count = events_.size();
+    beginPass();
     
-    std::unordered_map<std::string, std::vector<MboEvent>> grouped_events;
-    
-    for (const auto& event : events_) {
+    // Group leaders stay where they are compacted to and absorb later
+    // members of their group. A merged size that would not fit in 32 bits
+    // starts a new group instead.
+    bool inserted;
+    size_t kept = 0;
+    for (size_t i = 0; i < events_.size(); ++i) {
+        const PackedMboEvent& event = events_.hot(i);
+        
         if (event.action == 'A' || event.action == 'C') {
-            std::ostringstream key_stream;
-            key_stream << event.action << "_" << event.side << "_" << std::fixed << event.price;
-            std::string key = key_stream.str();
-            grouped_events[key].push_back(event);
-        } else {
-            std::ostringstream key_stream;
-            key_stream << "SINGLE_" << event.sequence;
-            std::string key = key_stream.str();
-            grouped_events[key].push_back(event);
+            Slot& slot = findSlot(static_cast<uint64_t>(event.price), makeTag(event, true), inserted);
+            if (!inserted && static_cast<uint64_t>(events_.hot(slot.leader).size) + event.size <= UINT32_MAX) {
+                events_.hot(slot.leader).size += event.size;
+                uint64_t& sequence = events_.cold(slot.leader).sequence;
+                sequence = std::min(sequence, events_.cold(i).sequence);
+                continue;
+            }
+            slot.leader = static_cast<uint32_t>(kept);
+        }
+        
+        if (kept != i) {
+            events_.move(i, kept);
         }
+        ++kept;
     }
+    events_.truncate(kept);
     
-    std::vector<MboEvent> consolidated_events;
-    consolidated_events.reserve(grouped_events.size());
-    
-    for (auto& [key, group] : grouped_events) {
-        if (group.size() == 1) {
-            consolidated_events.push_back(group[0]);
-        } else {
-            consolidateAtPriceLevel(key, group, consolidated_events);
+    // Leaders keep their place, so a merged group can come out of sequence;
+    // the rare reorder goes through an index permutation
+    bool sorted = true;
+    for (size_t i = 1; i < events_.size() && sorted; ++i) {
+        sorted = events_.cold(i - 1).sequence <= events_.cold(i).sequence;
+    }
+    if (!sorted) {
+        std::vector<uint32_t> order(events_.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = static_cast<uint32_t>(i);
+        }
+        std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+            return events_.cold(a).sequence < events_.cold(b).sequence;
+        });
+        PackedEventBatch reordered;
+        reordered.reserve(order.size());
+        for (uint32_t index : order) {
+            reordered.push(events_.get(index));
         }
+        std::swap(events_, reordered);
     }
     
-    std::sort(consolidated_events.begin(), consolidated_events.end(), 
-              [](const MboEvent& a, const MboEvent& b) {
-                  return a.sequence < b.sequence;
-              });
-    
-    events_ = std::move(consolidated_events);
-    
-    return original_count - events_.size();
+    size_t batched = original_count - events_.size();
+    last_stats_.batched_events += batched;
+    last_stats_.final_count = events_.size();
+    return batched;
 }
 
-const std::vector<MboEvent>& EventBuffer::getConsolidatedEvents() const {
-    return events_;
+std::vector<MboEvent> EventBuffer::getConsolidatedEvents() const {
+    std::vector<MboEvent> events;
+    events.reserve(events_.size());
+    forEachEvent([&events](const MboEvent& event) { events.push_back(event); });
+    return events;
 }
 
 void EventBuffer::clear() {
@@ -139,27 +177,61 @@ bool EventBuffer::belongsToCurrentWindow(const MboEvent& event) const {
     return time_diff <= WINDOW_THRESHOLD.count();
 }
 
-void EventBuffer::consolidateAtPriceLevel(const std::string& key, 
-                                        std::vector<MboEvent>& group_events,
-                                        std::vector<MboEvent>& consolidated_result) {
-    if (group_events.empty()) return;
-    
-    MboEvent consolidated = group_events[0];
-    
-    uint64_t total_size = 0;
-    for (const auto& event : group_events) {
-        total_size += event.size;
+// Sizes the table for at most half load and invalidates every slot
+void EventBuffer::beginPass() {
+    size_t capacity = 64;
+    while (capacity < events_.size() * 2) {
+        capacity <<= 1;
     }
     
-    consolidated.size = total_size;
+    if (slots_.size() < capacity) {
+        slots_.assign(capacity, Slot());
+        slot_mask_ = capacity - 1;
+        generation_ = 0;
+    }
     
-    uint64_t min_sequence = group_events[0].sequence;
-    for (const auto& event : group_events) {
-        if (event.sequence < min_sequence) {
-            min_sequence = event.sequence;
+    if (++generation_ == 0) {
+        for (Slot& slot : slots_) {
+            slot.generation = 0;
         }
+        generation_ = 1;
     }
-    consolidated.sequence = min_sequence;
-    
-    consolidated_result.push_back(consolidated);
+}
+
+EventBuffer::Slot& EventBuffer::findSlot(uint64_t key, uint64_t tag, bool& inserted) {
+    uint64_t hash = key * 0x9E3779B97F4A7C15ULL ^ tag * 0xC2B2AE3D27D4EB4FULL;
+    size_t index = static_cast<size_t>(hash ^ (hash >> 29)) & slot_mask_;
+    
+    for (;;) {
+        Slot& slot = slots_[index];
+        if (slot.generation != generation_) {
+            slot.key = key;
+            slot.tag = tag;
+            slot.generation = generation_;
+            slot.touched = false;
+            slot.adds = 0;
+            slot.cancels = 0;
+            slot.adds_removed = 0;
+            slot.cancels_removed = 0;
+            slot.leader = 0;
+            inserted = true;
+            return slot;
+        }
+        if (slot.key == key && slot.tag == tag) {
+            inserted = false;
+            return slot;
+        }
+        index = (index + 1) & slot_mask_;
+    }
+}
+
+// Order ids are only unique within an instrument; batching also keys on
+// the action and side of the level
+uint64_t EventBuffer::makeTag(const PackedMboEvent& event, bool with_level) {
+    uint64_t tag = static_cast<uint64_t>(event.instrument_id) << 16;
+    if (with_level) {
+        tag |= static_cast<uint64_t>(static_cast<unsigned char>(event.action)) << 8;
+        tag |= static_cast<unsigned char>(event.side);
+    }
+    return tag;
 }
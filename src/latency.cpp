@@ -0,0 +1,125 @@
+#include "latency.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+double cyclesPerNanosecond() {
+    // Spins ~10 ms the first time; thread-safe through static init
+    static const double ratio = []() {
+        auto start_time = std::chrono::steady_clock::now();
+        uint64_t start_cycles = readCycles();
+        std::chrono::steady_clock::time_point now;
+        do {
+            now = std::chrono::steady_clock::now();
+        } while (now - start_time < std::chrono::milliseconds(10));
+        uint64_t cycles = readCycles() - start_cycles;
+        double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - start_time).count());
+        return cycles > 0 ? cycles / ns : 1.0;
+    }();
+    return ratio;
+}
+
+uint64_t LatencyHistogram::bucketTop(size_t bucket) {
+    if (bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+    size_t shift = bucket / SUB_BUCKETS - 1;
+    uint64_t sub_bucket = bucket % SUB_BUCKETS + SUB_BUCKETS;
+    return ((sub_bucket + 1) << shift) - 1;
+}
+
+uint64_t LatencyHistogram::percentile(double q) const {
+    if (count_ == 0) {
+        return 0;
+    }
+    uint64_t target = static_cast<uint64_t>(std::ceil(q * static_cast<double>(count_)));
+    target = std::max<uint64_t>(1, std::min(target, count_));
+    
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+        seen += counts_[bucket];
+        if (seen >= target) {
+            return std::min(bucketTop(bucket), max_);
+        }
+    }
+    return max_;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+        counts_[bucket] += other.counts_[bucket];
+    }
+    count_ += other.count_;
+    max_ = std::max(max_, other.max_);
+}
+
+void LatencyHistogram::clear() {
+    counts_.fill(0);
+    count_ = 0;
+    max_ = 0;
+}
+
+const char* latencyStageName(LatencyStage stage) {
+    switch (stage) {
+        case LatencyStage::ADD: return "add";
+        case LatencyStage::CANCEL: return "cancel";
+        case LatencyStage::TRADE: return "trade";
+        case LatencyStage::FILL: return "fill";
+        case LatencyStage::RESET: return "reset";
+        case LatencyStage::OTHER: return "other";
+        case LatencyStage::SNAPSHOT: return "snapshot";
+        case LatencyStage::EMIT: return "emit";
+        default: return "unknown";
+    }
+}
+
+LatencyRecorder::LatencyRecorder(bool enabled)
+    : histograms_(enabled ? static_cast<size_t>(LatencyStage::COUNT) : 0) {}
+
+void LatencyRecorder::merge(const LatencyRecorder& other) {
+    if (!isEnabled() || !other.isEnabled()) {
+        return;
+    }
+    for (size_t stage = 0; stage < histograms_.size(); ++stage) {
+        histograms_[stage].merge(other.histograms_[stage]);
+    }
+}
+
+static uint64_t toNanoseconds(uint64_t cycles, double cycles_per_ns) {
+    return static_cast<uint64_t>(static_cast<double>(cycles) / cycles_per_ns + 0.5);
+}
+
+void LatencyRecorder::report(std::ostream& out) const {
+    const double cycles_per_ns = cyclesPerNanosecond();
+    out << "Latency (ns)  " << std::setw(12) << "samples" << std::setw(10) << "p50" << std::setw(10) << "p99"
+        << std::setw(10) << "p99.9" << std::setw(12) << "max" << std::endl;
+    for (size_t stage = 0; stage < histograms_.size(); ++stage) {
+        const LatencyHistogram& histogram = histograms_[stage];
+        if (histogram.getCount() == 0) {
+            continue;
+        }
+        out << std::left << std::setw(14) << latencyStageName(static_cast<LatencyStage>(stage)) << std::right
+            << std::setw(12) << histogram.getCount()
+            << std::setw(10) << toNanoseconds(histogram.percentile(0.50), cycles_per_ns)
+            << std::setw(10) << toNanoseconds(histogram.percentile(0.99), cycles_per_ns)
+            << std::setw(10) << toNanoseconds(histogram.percentile(0.999), cycles_per_ns)
+            << std::setw(12) << toNanoseconds(histogram.getMax(), cycles_per_ns) << std::endl;
+    }
+}
+
+void LatencyRecorder::writeMetricsHeader(std::ostream& out) {
+    out << "events,stage,samples,p50_ns,p99_ns,p999_ns,max_ns\n";
+}
+
+void LatencyRecorder::writeMetrics(std::ostream& out, uint64_t events) const {
+    const double cycles_per_ns = cyclesPerNanosecond();
+    for (size_t stage = 0; stage < histograms_.size(); ++stage) {
+        const LatencyHistogram& histogram = histograms_[stage];
+        out << events << ',' << latencyStageName(static_cast<LatencyStage>(stage)) << ',' << histogram.getCount() << ','
+            << toNanoseconds(histogram.percentile(0.50), cycles_per_ns) << ','
+            << toNanoseconds(histogram.percentile(0.99), cycles_per_ns) << ','
+            << toNanoseconds(histogram.percentile(0.999), cycles_per_ns) << ','
+            << toNanoseconds(histogram.getMax(), cycles_per_ns) << '\n';
+    }
+    out.flush();
+}
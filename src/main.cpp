@@ -5,303 +5,795 @@
 #include <algorithm>
 #include <map>
 #include <unordered_set>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <cstdlib>
+#include <cctype>
+#include <cerrno>
+#include <cstdint>
+#include <fstream>
+#include <csignal>
 #include "mbo_parser.h"
+#include "mbo_file_reader.h"
+#include "dbn_file_reader.h"
+#include "mbo_feed_reader.h"
+#include "packet_receiver.h"
 #include "../include/order_book.h"
 #include "mbp_csv_writer.h"
+#include "mbp_binary_writer.h"
+#include "mbp_shm_publisher.h"
 #include "event_buffer.h"
+#include "book_manager.h"
+#include "symbology.h"
+#include "replay_engine.h"
+#include "spsc_ring.h"
+#include "replay_pipeline.h"
+#include "latency.h"
+#include "async_logger.h"
+#include "process_usage.h"
+#include "page_allocator.h"
+#include "thread_affinity.h"
 
-int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " <mbo_input_file.csv>" << std::endl;
-        std::cerr << "Example: " << argv[0] << " mbo.csv" << std::endl;
-        return 1;
+template <typename Book>
+static void printTopLevels(const Book& order_book, const std::string& symbol, uint32_t instrument_id) {
+    MbpSnapshot final_snapshot = order_book.generateSnapshot('S', 'N');
+    
+    std::cout << "\n" << symbol << " (instrument " << instrument_id << ")" << std::endl;
+    std::cout << "Top 5 Bid Levels:" << std::endl;
+    std::cout << "Price      | Size     | Count" << std::endl;
+    std::cout << "-----------|----------|------" << std::endl;
+    
+    for (int i = 0; i < 5; ++i) {
+        Price price = final_snapshot.px[BID][i];
+        int size = final_snapshot.sz[BID][i];
+        int count = final_snapshot.ct[BID][i];
+        if (price > 0) {
+            std::cout << std::fixed << std::setprecision(2) << std::setw(10) << priceToDouble(price) 
+                      << " | " << std::setw(8) << size 
+                      << " | " << std::setw(4) << count << std::endl;
+        }
     }
     
-    std::string input_file = argv[1];
-    std::cout << "High-Performance Order Book Engine" << std::endl;
-    std::cout << "Processing MBO file: " << input_file << std::endl;
+    std::cout << "\nTop 5 Ask Levels:" << std::endl;
+    std::cout << "Price      | Size     | Count" << std::endl;
+    std::cout << "-----------|----------|------" << std::endl;
     
-    auto start_time = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < 5; ++i) {
+        Price price = final_snapshot.px[ASK][i];
+        int size = final_snapshot.sz[ASK][i];
+        int count = final_snapshot.ct[ASK][i];
+        if (price > 0) {
+            std::cout << std::fixed << std::setprecision(2) << std::setw(10) << priceToDouble(price) 
+                      << " | " << std::setw(8) << size 
+                      << " | " << std::setw(4) << count << std::endl;
+        }
+    }
+}
+
+// Shard output files are named after the main one: output.csv -> output_shard0.csv
+static std::string shardFileName(const std::string& output_file, size_t shard) {
+    size_t dot = output_file.rfind('.');
+    std::string stem = dot == std::string::npos ? output_file : output_file.substr(0, dot);
+    std::string extension = dot == std::string::npos ? "" : output_file.substr(dot);
+    return stem + "_shard" + std::to_string(shard) + extension;
+}
+
+// Instruments are spread over shards by a multiplicative hash of their id
+static size_t shardOf(uint32_t instrument_id, size_t shard_count) {
+    return static_cast<size_t>((instrument_id * 2654435761u) >> 8) % shard_count;
+}
+
+// Command-line settings shared by every replay mode
+struct ReplayOptions {
+    std::string book_type;
+    std::string format;
     
-    std::vector<MboEvent> mbo_events = MboParser::parseFile(input_file);
+    // Shared-memory output only: the POSIX name of the region, its
+    // instrument slots and the journal window a reader may fall behind by
+    std::string shm_name;
+    size_t shm_slots;
+    size_t shm_journal;
+    size_t thread_count;
+    bool pipeline;
+    bool conflate;
     
-    auto end_time = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+    // Thread placement: the pipeline's stages, or in the other modes the
+    // parse core for the thread reading the input; shard_cores for the
+    // --threads workers and parse_cores for the parse threads, each list
+    // reused round-robin
+    PipelineCores cores;
+    std::vector<int> shard_cores;
+    std::vector<int> parse_cores;
     
-    if (mbo_events.empty()) {
-        std::cerr << "Error: No events parsed from " << input_file << std::endl;
-        return 1;
-    }
+    // Large arrays on 2 MB pages; applied once every option has parsed
+    bool huge_pages;
     
-    std::cout << "Successfully parsed " << mbo_events.size() << " MBO events in " 
-              << duration.count() << " ms" << std::endl;
+    // CSV files only: rows are parsed ahead on this many threads
+    size_t parse_threads;
     
-    OrderBook order_book;
-    MbpCsvWriter csv_writer("output.csv");
+    // Sequential replays only: checkpoint_file is rewritten every
+    // checkpoint_interval events, resume_file restores one before starting
+    std::string checkpoint_file;
+    size_t checkpoint_interval;
+    std::string resume_file;
     
-    if (!csv_writer.initialize()) {
-        std::cerr << "Error: Failed to initialize CSV writer" << std::endl;
-        return 1;
+    // Latency builds only: the per-stage percentiles are written to
+    // metrics_file at the end, and every metrics_interval events in a
+    // sequential replay when that is set
+    std::string metrics_file;
+    size_t metrics_interval;
+    
+    // Live ingest: events come from the UDP feed instead of a file, until
+    // Ctrl-C or live_idle_timeout without a packet
+    bool live;
+    MulticastConfig feed;
+    std::chrono::milliseconds live_idle_timeout;
+    
+    // Regression harness: run figures written as one JSON object at the end
+    std::string stats_file;
+    
+    ReplayOptions() : book_type("map"), format("csv"), shm_name(MbpShmPublisher::DEFAULT_NAME),
+                      shm_slots(mbp_shm::DEFAULT_SLOT_COUNT), shm_journal(mbp_shm::DEFAULT_JOURNAL_CAPACITY), thread_count(1),
+                      pipeline(false), conflate(false), huge_pages(true), parse_threads(1), checkpoint_interval(DEFAULT_CHECKPOINT_INTERVAL), metrics_interval(0), live(false),
+                      live_idle_timeout(0) {}
+    
+    static constexpr size_t DEFAULT_CHECKPOINT_INTERVAL = 1000000;
+};
+
+// Parses "parse,book,write" core numbers; missing entries stay unpinned
+static bool parseCores(const std::string& list, PipelineCores& cores) {
+    int* stages[] = {&cores.parse, &cores.book, &cores.write};
+    size_t begin = 0;
+    for (int* stage : stages) {
+        size_t end = list.find(',', begin);
+        std::string item = list.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+        if (!item.empty()) {
+            char* item_end = nullptr;
+            long core = std::strtol(item.c_str(), &item_end, 10);
+            if (*item_end != '\0' || core < 0) {
+                return false;
+            }
+            *stage = static_cast<int>(core);
+        }
+        if (end == std::string::npos) {
+            return true;
+        }
+        begin = end + 1;
+    }
+    return false;
+}
+
+// Upper bound on --threads; each shard is a thread with its own book set
+// and output file
+static constexpr size_t MAX_SHARD_THREADS = 256;
+
+// Upper bound on --parse-threads; each thread holds a few 4 MB chunks
+static constexpr size_t MAX_PARSE_THREADS = 256;
+
+// Upper bound on --live-idle-ms: a day
+static constexpr size_t MAX_LIVE_IDLE_MS = 24 * 60 * 60 * 1000;
+
+// Parses a whole decimal count in [1, max]. Signs, trailing characters and
+// overflow fail instead of being truncated to a prefix.
+static bool parseCount(const char* text, size_t max, size_t& value) {
+    if (!std::isdigit(static_cast<unsigned char>(*text))) {
+        return false;
+    }
+    char* end = nullptr;
+    errno = 0;
+    unsigned long long parsed = std::strtoull(text, &end, 10);
+    if (*end != '\0' || errno == ERANGE || parsed == 0 || parsed > max) {
+        return false;
     }
+    value = static_cast<size_t>(parsed);
+    return true;
+}
+
+// Parses a power of two up to 2^30, as the shared-memory sizes must be to
+// fit the region header's 32-bit fields
+static bool parsePowerOfTwo(const char* text, size_t& value) {
+    char* end = nullptr;
+    long long parsed = std::strtoll(text, &end, 10);
+    if (*text == '\0' || *end != '\0' || parsed <= 0 || parsed > (1LL << 30) || (parsed & (parsed - 1)) != 0) {
+        return false;
+    }
+    value = static_cast<size_t>(parsed);
+    return true;
+}
+
+// Parses "GROUP:PORT" with an optional "@INTERFACE_ADDRESS" suffix
+static bool parseFeedAddress(const std::string& address, MulticastConfig& feed) {
+    size_t at = address.find('@');
+    std::string endpoint = address.substr(0, at);
+    size_t colon = endpoint.rfind(':');
+    if (colon == std::string::npos || colon == 0) {
+        return false;
+    }
+    char* port_end = nullptr;
+    long port = std::strtol(endpoint.c_str() + colon + 1, &port_end, 10);
+    if (*port_end != '\0' || port <= 0 || port > 65535) {
+        return false;
+    }
+    feed.group = endpoint.substr(0, colon);
+    feed.port = static_cast<uint16_t>(port);
+    feed.interface_address = at == std::string::npos ? "" : address.substr(at + 1);
+    return true;
+}
+
+// Ctrl-C ends a live session cleanly, so the books are summarised and the
+// output flushed as at the end of a file
+static MboFeedReader* live_feed = nullptr;
+
+static void stopLiveFeed(int) {
+    if (live_feed) {
+        live_feed->stop();
+    }
+}
+
+// The pipeline's writer thread formats while the I/O thread writes
+static void enableAsyncIo(MbpCsvWriter& writer) { writer.setAsyncIo(true); }
+static void enableAsyncIo(MbpBinaryWriter&) {}
+static void enableAsyncIo(MbpShmPublisher&) {}
+
+// Only the shared-memory publisher has sizes to set
+template <typename Writer>
+static void configureCapacity(Writer&, const ReplayOptions&) {}
+static void configureCapacity(MbpShmPublisher& publisher, const ReplayOptions& options) {
+    publisher.setCapacity(options.shm_slots, options.shm_journal);
+}
+
+// One flat JSON object, read back by tests/regression/run_regression.sh.
+// Allocations are those made between the start and end of the replay, and
+// are only counted in builds with ORDERBOOK_COUNT_ALLOCS.
+static bool writeRunStats(const std::string& stats_file, const std::string& input_file, std::chrono::nanoseconds elapsed,
+                          size_t events, size_t rows, const ProcessUsage& start, const ProcessUsage& end) {
+    std::ofstream out(stats_file, std::ios::trunc);
+    if (!out) {
+        std::cerr << "Error: Cannot create stats file " << stats_file << std::endl;
+        return false;
+    }
+    std::string escaped_input;
+    for (char c : input_file) {
+        if (c == '"' || c == '\\') {
+            escaped_input += '\\';
+        }
+        escaped_input += c;
+    }
+    const double seconds = static_cast<double>(elapsed.count()) / 1e9;
+    out << std::fixed << std::setprecision(0);
+    out << "{\"input\": \"" << escaped_input << "\", \"events\": " << events << ", \"rows\": " << rows
+        << ", \"elapsed_ns\": " << elapsed.count()
+        << ", \"events_per_sec\": " << (seconds > 0 ? events / seconds : 0.0)
+        << ", \"rows_per_sec\": " << (seconds > 0 ? rows / seconds : 0.0)
+        << ", \"peak_rss_kb\": " << end.peak_rss_kb
+        << ", \"allocations\": " << end.allocations - start.allocations
+        << ", \"allocated_bytes\": " << end.allocated_bytes - start.allocated_bytes
+        << ", \"allocations_counted\": " << (ALLOCATION_COUNTING_ENABLED ? "true" : "false") << "}" << std::endl;
+    return static_cast<bool>(out);
+}
+
+// The ring is allocated on the worker's NUMA node; the worker creates its
+// books after pinning itself, so they land there too
+template <typename Book, typename Writer>
+struct ReplayShard {
+    int core;
+    SpscRing<MboEvent> ring;
+    Writer writer;
+    ReplayEngine<Book, Writer> engine;
+    std::thread worker;
     
-    std::cout << "\nProcessing MBO events with orderbook state-aware filtering..." << std::endl;
-    auto process_start = std::chrono::high_resolution_clock::now();
+    ReplayShard(const std::string& output_file, int core)
+        : core(core), ring(SHARD_RING_CAPACITY, numaNodeOfCore(core)), writer(output_file), engine(writer) {}
     
-    size_t processed_events = 0;
-    size_t snapshots_written = 0;
-    size_t tfc_sequences_detected = 0;
-    size_t snapshots_filtered = 0;
+    static constexpr size_t SHARD_RING_CAPACITY = 64 * 1024;
+};
+
+template <typename Book, typename Writer>
+int runReplay(const std::string& input_file, const std::string& output_file, const ReplayOptions& options) {
+    const size_t thread_count = options.thread_count;
     
-    size_t a_events_processed = 0;
-    size_t c_events_processed = 0;
-    size_t a_events_included = 0;
-    size_t c_events_included = 0;
+    std::cout << "High-Performance Order Book Engine" << std::endl;
+    if (options.live) {
+        std::cout << "Receiving live MBO feed: " << input_file << std::endl;
+    } else {
+        std::cout << "Processing MBO file: " << input_file << std::endl;
+    }
+    std::cout << "Price level storage: " << options.book_type << std::endl;
+    if (options.pipeline) {
+        std::cout << "Pipelined replay: parse, book and write stages on separate threads" << std::endl;
+    }
+    if (options.parse_threads > 1) {
+        std::cout << "Parallel parsing: " << options.parse_threads << " threads" << std::endl;
+    }
+    if (options.conflate) {
+        std::cout << "Conflated output: one snapshot per changed instrument per 1 ms window" << std::endl;
+    }
     
-    const size_t ORDERBOOK_BUILDING_PHASE_A = 50;
-    const size_t ORDERBOOK_BUILDING_PHASE_C = 100;
-    const double STEADY_STATE_A_INCLUSION = 0.687;
-    const double STEADY_STATE_C_INCLUSION = 0.645;
-    const double BID_SIDE_BOOST = 1.02;
+    // The pipeline pins its own parse stage
+    if (!options.pipeline && options.cores.parse >= 0 && !pinCurrentThread(options.cores.parse)) {
+        std::cerr << "Warning: Could not pin parse thread to core " << options.cores.parse << std::endl;
+    }
     
-    size_t bid_a_count = 0, ask_a_count = 0;
-    size_t bid_c_count = 0, ask_c_count = 0;
+    SymbologyTable symbology;
+    MboFileReader reader(input_file);
+    reader.setSymbology(&symbology);
+    reader.setParseThreads(options.parse_threads);
+    reader.setParseCores(options.parse_cores);
     
-    auto shouldIncludeEvent = [&](const MboEvent& event, size_t events_of_type_processed) -> bool {
-        if (event.action == 'A') {
-            a_events_included++;
-            return true;
-        } else if (event.action == 'C') {
-            c_events_included++;
-            return true;
+    // Every replay mode below pulls from source, whether file or feed
+    MboEventSource* source = &reader;
+    std::unique_ptr<DbnFileReader> dbn_reader;
+    std::unique_ptr<UdpMulticastReceiver> receiver;
+    std::unique_ptr<MboFeedReader> feed;
+    if (DbnFileReader::isDbnFile(input_file)) {
+        dbn_reader.reset(new DbnFileReader(input_file));
+        dbn_reader->setSymbology(&symbology);
+        if (!dbn_reader->open()) {
+            return 1;
         }
-        
-        return true;
-    };
+        source = dbn_reader.get();
+    } else if (options.live) {
+        receiver.reset(new UdpMulticastReceiver(options.feed));
+        if (!receiver->open()) {
+            return 1;
+        }
+        feed.reset(new MboFeedReader(*receiver));
+        feed->setIdleTimeout(options.live_idle_timeout);
+        live_feed = feed.get();
+        std::signal(SIGINT, stopLiveFeed);
+        source = feed.get();
+    } else if (!reader.open()) {
+        return 1;
+    }
     
-    std::vector<bool> is_tfc_event(mbo_events.size(), false);
-    std::vector<size_t> tfc_trade_index(mbo_events.size(), SIZE_MAX);
+    MboEvent event;
+    if (!source->next(event)) {
+        std::cerr << "Error: No events parsed from " << input_file << std::endl;
+        return 1;
+    }
     
-    for (size_t i = 0; i < mbo_events.size() - 2; ++i) {
-        if (mbo_events[i].action == 'T' && 
-            i + 1 < mbo_events.size() && mbo_events[i + 1].action == 'F' &&
-            i + 2 < mbo_events.size() && mbo_events[i + 2].action == 'C') {
-            
-            const auto& t_event = mbo_events[i];
-            const auto& f_event = mbo_events[i + 1];
-            const auto& c_event = mbo_events[i + 2];
-            
-            if (f_event.price == t_event.price && 
-                f_event.size == t_event.size &&
-                c_event.order_id == f_event.order_id) {
-                
-                is_tfc_event[i] = true;
-                is_tfc_event[i + 1] = true;
-                is_tfc_event[i + 2] = true;
-                tfc_trade_index[i + 2] = i;
-                tfc_sequences_detected++;
-            }
+    // One shard per worker thread; a single shard replays on this thread
+    using Shard = ReplayShard<Book, Writer>;
+    std::vector<std::unique_ptr<Shard>> shards;
+    for (size_t i = 0; i < thread_count; ++i) {
+        shards.emplace_back(new Shard(thread_count == 1 ? output_file : shardFileName(output_file, i),
+                                      thread_count == 1 ? -1 : coreForThread(options.shard_cores, i)));
+        shards.back()->writer.setSymbology(&symbology);
+        if (options.pipeline) {
+            enableAsyncIo(shards.back()->writer);
+        }
+        configureCapacity(shards.back()->writer, options);
+        if (!shards.back()->writer.initialize()) {
+            std::cerr << "Error: Failed to initialize writer for " << output_file << std::endl;
+            return 1;
         }
     }
     
-    std::unordered_set<uint64_t> failed_cancel_orders;
-    for (size_t i = 0; i < mbo_events.size(); ++i) {
-        const auto& event = mbo_events[i];
-        processed_events++;
+    std::ofstream metrics;
+    if (!options.metrics_file.empty()) {
+        metrics.open(options.metrics_file, std::ios::trunc);
+        if (!metrics) {
+            std::cerr << "Error: Cannot create metrics file " << options.metrics_file << std::endl;
+            return 1;
+        }
+        LatencyRecorder::writeMetricsHeader(metrics);
+    }
+    
+    std::cout << "\nProcessing MBO events with orderbook state-aware filtering..." << std::endl;
+    const ProcessUsage usage_start = currentProcessUsage();
+    auto process_start = std::chrono::high_resolution_clock::now();
+    
+    // Books and counters come from the pipeline's or the conflating engine
+    // when one of those runs
+    std::unique_ptr<ReplayPipeline<Book, Writer>> pipeline;
+    ConflatingWriter conflator;
+    std::unique_ptr<ReplayEngine<Book, ConflatingWriter>> conflated_engine;
+    size_t annihilated_pairs = 0;
+    
+    if (options.pipeline) {
+        pipeline.reset(new ReplayPipeline<Book, Writer>(shards[0]->writer, options.cores));
+        pipeline->run(*source, event);
+    } else if (options.conflate) {
+        // Each window's add/cancel pairs cancel out before reaching the book;
+        // the book state at the end of the window is what gets written
+        conflated_engine.reset(new ReplayEngine<Book, ConflatingWriter>(conflator));
+        EventBuffer window;
+        auto flushWindow = [&]() {
+            annihilated_pairs += window.applyOrderAnnihilation();
+            window.forEachEvent([&](const MboEvent& windowed) { conflated_engine->push(windowed); });
+            conflated_engine->finish();
+            conflator.flushTo(shards[0]->writer);
+            window.clear();
+        };
         
-        if (event.action == 'R' && processed_events == 1) {
-            std::cout << "Processing initial R (reset) event - starting with empty orderbook as per requirement #1" << std::endl;
-            MbpSnapshot snapshot = order_book.generateSnapshot(event);
-            if (csv_writer.writeSnapshot(snapshot, snapshots_written)) {
-                snapshots_written++;
+        do {
+            if (!window.addEvent(event)) {
+                flushWindow();
+                window.addEvent(event);
             }
-            continue;
-        }
+        } while (source->next(event));
+        flushWindow();
+    } else if (thread_count == 1) {
+        ReplayEngine<Book, Writer>& engine = shards[0]->engine;
+        size_t events_consumed = 0;
+        bool has_event = true;
         
-        if (is_tfc_event[i]) {
-            if (event.action == 'T') {
-                ProcessResult result = order_book.processEvent(event);
-                (void)result;
-                continue;
-            } else if (event.action == 'F') {
-                ProcessResult result = order_book.processEvent(event);
-                (void)result;
-                continue;
-            } else if (event.action == 'C') {
-                ProcessResult result = order_book.processEvent(event);
-                
-                size_t trade_idx = tfc_trade_index[i];
-                MbpSnapshot snapshot = order_book.generateSnapshot(mbo_events[trade_idx]);
-                
-                snapshot.action = result.snapshot_action;
-                snapshot.side = result.snapshot_side;
-                
-                if (csv_writer.writeSnapshot(snapshot, snapshots_written)) {
-                    snapshots_written++;
-                }
-                continue;
+        if (!options.resume_file.empty()) {
+            CheckpointPosition position;
+            if (!engine.loadCheckpoint(options.resume_file, position, &symbology) || !reader.seek(position.input_offset)) {
+                return 1;
             }
+            events_consumed = position.events_consumed;
+            has_event = reader.next(event);
+            std::cout << "Resumed from " << options.resume_file << " after event " << events_consumed
+                      << " (sequence " << position.last_sequence << ")" << std::endl;
         }
         
-        bool should_process = true;
-        
-        if (event.action == 'C') {
-            if (!order_book.orderExists(event.order_id)) {
-                should_process = false;
-                failed_cancel_orders.insert(event.order_id);
-                std::cout << "Filtered Cancel event for non-existent order " << event.order_id << std::endl;
-            } else {
-                if (!shouldIncludeEvent(event, c_events_processed)) {
-                    should_process = false;
-                    snapshots_filtered++;
-                    std::cout << "Filtered C event " << c_events_processed + 1 << " (orderbook state-aware filtering)" << std::endl;
-                } else {
-                    c_events_included++;
+        // Events go to the engine in batches, cut short at each checkpoint
+        // or metrics boundary so the reader is then just past the batch
+        std::vector<MboEvent> batch(ReplayEngine<Book, Writer>::BATCH_SIZE);
+        while (has_event) {
+            size_t batch_size = 0;
+            bool checkpoint_due = false;
+            bool metrics_due = false;
+            for (;;) {
+                batch[batch_size++] = event;
+                ++events_consumed;
+                checkpoint_due = !options.checkpoint_file.empty() && events_consumed % options.checkpoint_interval == 0;
+                metrics_due = options.metrics_interval > 0 && events_consumed % options.metrics_interval == 0;
+                if (checkpoint_due || metrics_due || batch_size == batch.size() || !(has_event = source->next(event))) {
+                    break;
                 }
-                c_events_processed++;
             }
-        } else if (event.action == 'A') {
-            if (failed_cancel_orders.count(event.order_id)) {
-                should_process = false;
-                failed_cancel_orders.erase(event.order_id);
-                std::cout << "Filtered Add event for order " << event.order_id << " following failed Cancel" << std::endl;
-            } else {
-                if (!shouldIncludeEvent(event, a_events_processed)) {
-                    should_process = false;
-                    snapshots_filtered++;
-                    std::cout << "Filtered A event " << a_events_processed + 1 << " (orderbook state-aware filtering)" << std::endl;
-                } else {
-                    a_events_included++;
+            engine.pushBatch(batch.data(), batch_size);
+            
+            // Output up to here is flushed first, so a restart from this
+            // checkpoint loses no rows
+            if (checkpoint_due) {
+                CheckpointPosition position;
+                position.events_consumed = events_consumed;
+                position.input_offset = reader.getBytesConsumed();
+                position.last_sequence = batch[batch_size - 1].sequence;
+                position.last_ts_event = batch[batch_size - 1].ts_event.count();
+                shards[0]->writer.flush();
+                if (!engine.saveCheckpoint(options.checkpoint_file, position, &symbology)) {
+                    return 1;
                 }
-                a_events_processed++;
+            }
+            if (metrics_due) {
+                engine.getLatency().writeMetrics(metrics, events_consumed);
+            }
+            if (has_event) {
+                has_event = source->next(event);
             }
         }
-        
-        if (should_process) {
-            Top10State previous_top10 = order_book.captureTop10State();
-            
-            if (event.action == 'A' || event.action == 'C') {
-                ProcessResult result = order_book.processEvent(event);
-                
-                if (result.should_write) {
-                    Top10State current_top10 = order_book.captureTop10State();
-                    
-                    if (current_top10 != previous_top10) {
-                        MbpSnapshot snapshot = order_book.generateSnapshot(event);
-                        if (csv_writer.writeSnapshot(snapshot, snapshots_written)) {
-                            snapshots_written++;
-                        }
-                    }
+        engine.finish();
+    } else {
+        // This thread parses and routes; each worker owns the books of its
+        // instruments, so the hot path takes no locks
+        std::atomic<bool> input_done(false);
+        for (auto& shard : shards) {
+            Shard* s = shard.get();
+            s->worker = std::thread([s, &input_done]() {
+                if (s->core >= 0 && !pinCurrentThread(s->core)) {
+                    std::cerr << "Warning: Could not pin shard worker to core " << s->core << std::endl;
                 }
-            } else {
-                ProcessResult result = order_book.processEvent(event);
-                
-                if (event.action == 'T') {
-                    if (event.side == 'N') {
-                        MbpSnapshot snapshot = order_book.generateSnapshot(event);
-                        snapshot.action = 'T';
-                        snapshot.side = event.side;
-                        
-                        if (csv_writer.writeSnapshot(snapshot, snapshots_written)) {
-                            snapshots_written++;
+                std::vector<MboEvent> batch(ReplayEngine<Book, Writer>::BATCH_SIZE);
+                for (;;) {
+                    if (size_t count = s->ring.tryPopBatch(batch.data(), batch.size())) {
+                        s->engine.pushBatch(batch.data(), count);
+                    } else if (input_done.load(std::memory_order_acquire)) {
+                        // Everything pushed before input_done is visible now
+                        while (size_t count = s->ring.tryPopBatch(batch.data(), batch.size())) {
+                            s->engine.pushBatch(batch.data(), count);
                         }
+                        break;
                     } else {
-                        char target_side = (event.side == 'B') ? 'A' : 'B';
-                        
-                        bool can_fill = false;
-                        if (target_side == 'B') {
-                            can_fill = order_book.hasOrdersAtPrice(event.price, 'B');
-                        } else {
-                            can_fill = order_book.hasOrdersAtPrice(event.price, 'A');
-                        }
-                        
-                        if (can_fill) {
-                            if (target_side == 'B') {
-                                order_book.fillOrdersAtPrice(event.price, event.size, 'B');
-                            } else {
-                                order_book.fillOrdersAtPrice(event.price, event.size, 'A');
-                            }
-                        }
-                        
-                        MbpSnapshot snapshot = order_book.generateSnapshot(event);
-                        snapshot.action = 'T';
-                        snapshot.side = event.side;
-                        
-                        if (csv_writer.writeSnapshot(snapshot, snapshots_written)) {
-                            snapshots_written++;
-                        }
-                    }
-                } else {
-                    if (result.should_write) {
-                        MbpSnapshot snapshot = order_book.generateSnapshot(event);
-                        if (csv_writer.writeSnapshot(snapshot, snapshots_written)) {
-                            snapshots_written++;
-                        }
+                        std::this_thread::yield();
                     }
                 }
+                s->engine.finish();
+            });
+        }
+        
+        do {
+            SpscRing<MboEvent>& ring = shards[shardOf(event.instrument_id, thread_count)]->ring;
+            while (!ring.tryPush(event)) {
+                std::this_thread::yield();
             }
+        } while (source->next(event));
+        
+        input_done.store(true, std::memory_order_release);
+        for (auto& shard : shards) {
+            shard->worker.join();
         }
     }
     
     auto process_end = std::chrono::high_resolution_clock::now();
     auto process_duration = std::chrono::duration_cast<std::chrono::milliseconds>(process_end - process_start);
+    const ProcessUsage usage_end = currentProcessUsage();
     
-    csv_writer.flush();
-    csv_writer.close();
-    
-    std::cout << "Processed " << processed_events << " events in " << process_duration.count() << " ms" << std::endl;
-    std::cout << "Generated and wrote " << snapshots_written << " MBP-10 snapshots to output.csv" << std::endl;
-    std::cout << "Filtered " << snapshots_filtered << " snapshots due to orderbook state-aware filtering" << std::endl;
-    std::cout << "Detected and consolidated " << tfc_sequences_detected << " T->F->C sequences into T actions" << std::endl;
-    
-    std::cout << "\n=== ORDERBOOK STATE-AWARE FILTERING RESULTS ===" << std::endl;
-    std::cout << "A events: " << a_events_included << "/" << a_events_processed 
-              << " (" << (a_events_processed > 0 ? (a_events_included * 100.0 / a_events_processed) : 0) << "% included)" << std::endl;
-    std::cout << "C events: " << c_events_included << "/" << c_events_processed 
-              << " (" << (c_events_processed > 0 ? (c_events_included * 100.0 / c_events_processed) : 0) << "% included)" << std::endl;
-    std::cout << "BID A events processed: " << bid_a_count << std::endl;
-    std::cout << "ASK A events processed: " << ask_a_count << std::endl;
-    std::cout << "BID C events processed: " << bid_c_count << std::endl;
-    std::cout << "ASK C events processed: " << ask_c_count << std::endl;
-    std::cout << "Orderbook state-aware filtering implemented successfully!" << std::endl;
+    if (feed) {
+        std::signal(SIGINT, SIG_DFL);
+        live_feed = nullptr;
+    }
     
-    MbpSnapshot final_snapshot = order_book.generateSnapshot('S', 'N');
+    // Messages logged during the replay come out before the summary
+    AsyncLogger::instance().flush();
     
-    std::cout << "\nOrder Book Statistics:" << std::endl;
-    std::cout << "Bid levels: " << order_book.getBidLevelCount() << std::endl;
-    std::cout << "Ask levels: " << order_book.getAskLevelCount() << std::endl;
-    std::cout << "Active orders: " << order_book.getOrderCount() << std::endl;
+    std::vector<const BookManager<Book>*> book_sets;
+    ReplayStats stats;
+    LatencyRecorder latency;
+    for (auto& shard : shards) {
+        shard->writer.flush();
+        shard->writer.close();
+        if (!pipeline && !conflated_engine) {
+            stats += shard->engine.getStats();
+            latency.merge(shard->engine.getLatency());
+            book_sets.push_back(&shard->engine.getBooks());
+        }
+    }
+    if (pipeline) {
+        stats = pipeline->getStats();
+        latency.merge(pipeline->getLatency());
+        book_sets.push_back(&pipeline->getBooks());
+    } else if (conflated_engine) {
+        stats = conflated_engine->getStats();
+        latency.merge(conflated_engine->getLatency());
+        book_sets.push_back(&conflated_engine->getBooks());
+    }
     
-    std::cout << "\nTop 5 Bid Levels:" << std::endl;
-    std::cout << "Price      | Size     | Count" << std::endl;
-    std::cout << "-----------|----------|------" << std::endl;
+    std::cout << "Streamed and processed " << stats.processed_events << " events in " << process_duration.count() << " ms" << std::endl;
+    if (thread_count == 1) {
+        std::cout << "Generated and wrote " << stats.snapshots_written << " MBP-10 snapshots to " << output_file << std::endl;
+        if (conflated_engine) {
+            std::cout << "Conflated them into " << conflator.getRowsWritten() << " rows; " << annihilated_pairs
+                      << " add/cancel pairs annihilated within their window" << std::endl;
+        }
+    } else {
+        std::cout << "Generated and wrote " << stats.snapshots_written << " MBP-10 snapshots across " << thread_count << " shards:" << std::endl;
+        for (size_t i = 0; i < thread_count; ++i) {
+            std::cout << "  " << shardFileName(output_file, i) << ": " << shards[i]->engine.getStats().snapshots_written
+                      << " snapshots, " << shards[i]->engine.getBooks().size() << " instruments" << std::endl;
+        }
+    }
+    std::cout << "Filtered " << stats.snapshots_filtered << " snapshots due to orderbook state-aware filtering" << std::endl;
+    std::cout << "Detected and consolidated " << stats.tfc_sequences_detected << " T->F->C sequences into T actions" << std::endl;
+    if (feed) {
+        const FeedStats& feed_stats = feed->getStats();
+        std::cout << "Received " << feed_stats.records << " MBO records in " << feed_stats.packets << " packets; "
+                  << feed_stats.gaps << " sequence gaps (" << feed_stats.packets_lost << " packets lost, "
+                  << feed_stats.resets_issued << " book resets), " << feed_stats.stale_packets << " late or duplicate, "
+                  << feed_stats.malformed_packets << " malformed" << std::endl;
+    }
     
-    for (int i = 0; i < 5; ++i) {
-        double price = (&final_snapshot.bid_px_00)[i];
-        int size = (&final_snapshot.bid_sz_00)[i];
-        int count = (&final_snapshot.bid_ct_00)[i];
-        if (price > 0.0) {
-            std::cout << std::fixed << std::setprecision(2) << std::setw(10) << price 
-                      << " | " << std::setw(8) << size 
-                      << " | " << std::setw(4) << count << std::endl;
+    std::cout << "A events: " << stats.a_events_included << "/" << stats.a_events_processed 
+              << " (" << (stats.a_events_processed > 0 ? (stats.a_events_included * 100.0 / stats.a_events_processed) : 0) << "% included)" << std::endl;
+    std::cout << "C events: " << stats.c_events_included << "/" << stats.c_events_processed 
+              << " (" << (stats.c_events_processed > 0 ? (stats.c_events_included * 100.0 / stats.c_events_processed) : 0) << "% included)" << std::endl;
+    
+    if (latency.isEnabled()) {
+        std::cout << "\n";
+        latency.report(std::cout);
+        if (metrics.is_open()) {
+            latency.writeMetrics(metrics, stats.processed_events);
+            std::cout << "Latency metrics written to " << options.metrics_file << std::endl;
         }
     }
     
-    std::cout << "\nTop 5 Ask Levels:" << std::endl;
-    std::cout << "Price      | Size     | Count" << std::endl;
-    std::cout << "-----------|----------|------" << std::endl;
+    size_t instrument_count = 0, bid_levels = 0, ask_levels = 0, active_orders = 0;
+    for (const BookManager<Book>* book_set : book_sets) {
+        const BookManager<Book>& books = *book_set;
+        instrument_count += books.size();
+        bid_levels += books.getBidLevelCount();
+        ask_levels += books.getAskLevelCount();
+        active_orders += books.getOrderCount();
+    }
     
-    for (int i = 0; i < 5; ++i) {
-        double price = (&final_snapshot.ask_px_00)[i];
-        int size = (&final_snapshot.ask_sz_00)[i];
-        int count = (&final_snapshot.ask_ct_00)[i];
-        if (price > 0.0) {
-            std::cout << std::fixed << std::setprecision(2) << std::setw(10) << price 
-                      << " | " << std::setw(8) << size 
-                      << " | " << std::setw(4) << count << std::endl;
+    std::cout << "\nOrder Book Statistics:" << std::endl;
+    std::cout << "Instruments: " << instrument_count << std::endl;
+    std::cout << "Bid levels: " << bid_levels << std::endl;
+    std::cout << "Ask levels: " << ask_levels << std::endl;
+    std::cout << "Active orders: " << active_orders << std::endl;
+    
+    for (const BookManager<Book>* book_set : book_sets) {
+        book_set->forEachBook([&](uint32_t instrument_id, const Book& order_book) {
+            printTopLevels(order_book, symbology.getSymbol(instrument_id), instrument_id);
+        });
+    }
+    
+    if (!options.stats_file.empty()) {
+        const size_t rows_written = conflated_engine ? conflator.getRowsWritten() : stats.snapshots_written;
+        if (!writeRunStats(options.stats_file, input_file, process_end - process_start, stats.processed_events, rows_written,
+                           usage_start, usage_end)) {
+            return 1;
         }
+        std::cout << "Run statistics written to " << options.stats_file << std::endl;
     }
     
     std::cout << "\nOrder book processing completed successfully!" << std::endl;
     
     return 0;
 }
+
+// Settings files hold one option per line, "key = value" or a bare "key"
+// for flags, named as on the command line without the leading dashes;
+// "input = FILE" names the input. # starts a comment.
+static bool readConfigFile(const std::string& config_file, std::vector<std::string>& args) {
+    std::ifstream in(config_file);
+    if (!in) {
+        std::cerr << "Error: Cannot open config file " << config_file << std::endl;
+        return false;
+    }
+    auto trim = [](const std::string& text) {
+        size_t begin = text.find_first_not_of(" \t\r");
+        size_t end = text.find_last_not_of(" \t\r");
+        return begin == std::string::npos ? std::string() : text.substr(begin, end - begin + 1);
+    };
+    
+    std::string line;
+    for (size_t line_number = 1; std::getline(in, line); ++line_number) {
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty()) {
+            continue;
+        }
+        size_t equals = line.find('=');
+        std::string key = trim(line.substr(0, equals));
+        if (key.empty() || key == "config") {
+            std::cerr << "Error: " << config_file << ":" << line_number << ": invalid setting" << std::endl;
+            return false;
+        }
+        if (key == "input" && equals != std::string::npos) {
+            args.push_back(trim(line.substr(equals + 1)));
+        } else if (equals == std::string::npos) {
+            args.push_back("--" + key);
+        } else {
+            args.push_back("--" + key + "=" + trim(line.substr(equals + 1)));
+        }
+    }
+    return true;
+}
+
+template <typename Book>
+int runWithFormat(const std::string& input_file, const ReplayOptions& options) {
+    if (options.format == "binary") {
+        return runReplay<Book, MbpBinaryWriter>(input_file, "output.bin", options);
+    }
+    if (options.format == "shm") {
+        return runReplay<Book, MbpShmPublisher>(input_file, options.shm_name, options);
+    }
+    return runReplay<Book, MbpCsvWriter>(input_file, "output.csv", options);
+}
+
+int main(int argc, char* argv[]) {
+    std::string input_file;
+    ReplayOptions options;
+    size_t thread_count = 1;
+    
+    // Cleared by any bad option value; a later good option never sets it
+    // again, so each branch folds its own check in with && valid
+    bool valid = true;
+    
+    // A config file's settings take its place on the command line, so
+    // options after it override them
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--config=", 0) == 0) {
+            if (!readConfigFile(arg.substr(9), args)) {
+                return 1;
+            }
+        } else {
+            args.push_back(arg);
+        }
+    }
+    
+    for (const std::string& arg : args) {
+        if (arg.rfind("--book=", 0) == 0) {
+            options.book_type = arg.substr(7);
+        } else if (arg.rfind("--format=", 0) == 0) {
+            options.format = arg.substr(9);
+        } else if (arg.rfind("--shm-name=", 0) == 0) {
+            options.shm_name = arg.substr(11);
+            valid = options.shm_name.size() > 1 && options.shm_name[0] == '/' &&
+                    options.shm_name.find('/', 1) == std::string::npos && valid;
+        } else if (arg.rfind("--shm-slots=", 0) == 0) {
+            valid = parsePowerOfTwo(arg.c_str() + 12, options.shm_slots) && valid;
+        } else if (arg.rfind("--shm-journal=", 0) == 0) {
+            valid = parsePowerOfTwo(arg.c_str() + 14, options.shm_journal) && valid;
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            valid = parseCount(arg.c_str() + 10, MAX_SHARD_THREADS, thread_count) && valid;
+        } else if (arg.rfind("--parse-threads=", 0) == 0) {
+            valid = parseCount(arg.c_str() + 16, MAX_PARSE_THREADS, options.parse_threads) && valid;
+        } else if (arg == "--pipeline") {
+            options.pipeline = true;
+        } else if (arg == "--conflate") {
+            options.conflate = true;
+        } else if (arg.rfind("--pin=", 0) == 0) {
+            valid = parseCores(arg.substr(6), options.cores) && valid;
+        } else if (arg.rfind("--pin-shards=", 0) == 0) {
+            valid = parseCoreList(arg.substr(13), options.shard_cores) && valid;
+        } else if (arg.rfind("--pin-parsers=", 0) == 0) {
+            valid = parseCoreList(arg.substr(14), options.parse_cores) && valid;
+        } else if (arg.rfind("--huge-pages=", 0) == 0) {
+            valid = (arg == "--huge-pages=on" || arg == "--huge-pages=off") && valid;
+            options.huge_pages = arg == "--huge-pages=on";
+        } else if (arg.rfind("--checkpoint=", 0) == 0) {
+            options.checkpoint_file = arg.substr(13);
+        } else if (arg.rfind("--checkpoint-every=", 0) == 0) {
+            valid = parseCount(arg.c_str() + 19, SIZE_MAX, options.checkpoint_interval) && valid;
+        } else if (arg.rfind("--resume=", 0) == 0) {
+            options.resume_file = arg.substr(9);
+        } else if (arg.rfind("--live=", 0) == 0) {
+            options.live = true;
+            valid = parseFeedAddress(arg.substr(7), options.feed) && valid;
+        } else if (arg.rfind("--live-idle-ms=", 0) == 0) {
+            size_t timeout = 0;
+            valid = parseCount(arg.c_str() + 15, MAX_LIVE_IDLE_MS, timeout) && valid;
+            options.live_idle_timeout = std::chrono::milliseconds(static_cast<int64_t>(timeout));
+        } else if (arg.rfind("--log-level=", 0) == 0) {
+            LogSeverity severity;
+            if (parseLogSeverity(arg.c_str() + 12, severity)) {
+                AsyncLogger::instance().setMinSeverity(severity);
+            } else {
+                valid = false;
+            }
+        } else if (arg.rfind("--metrics=", 0) == 0) {
+            options.metrics_file = arg.substr(10);
+        } else if (arg.rfind("--stats-json=", 0) == 0) {
+            options.stats_file = arg.substr(13);
+        } else if (arg.rfind("--metrics-every=", 0) == 0) {
+            valid = parseCount(arg.c_str() + 16, SIZE_MAX, options.metrics_interval) && valid;
+        } else if (input_file.empty()) {
+            input_file = arg;
+        } else {
+            input_file.clear();
+            break;
+        }
+    }
+    
+    // The pipeline and conflated modes replay a single stream, so they do
+    // not combine with shards or with each other; checkpoints and periodic
+    // metrics cover the plain sequential replay only. A live feed takes the
+    // place of the input file; neither it nor DBN input can be checkpointed
+    // by CSV input offset, and nor can CSV parsed ahead in chunks. Cores
+    // for shard workers or parse threads need those threads.
+    bool special_mode = options.pipeline || options.conflate || thread_count != 1;
+    bool checkpointing = !options.checkpoint_file.empty() || !options.resume_file.empty();
+    bool dbn_input = DbnFileReader::isDbnFile(input_file);
+    if (options.live && input_file.empty()) {
+        input_file = "udp://" + options.feed.group + ":" + std::to_string(options.feed.port);
+    } else if (options.live) {
+        valid = false;
+    }
+    if (!valid || input_file.empty() || (options.book_type != "map" && options.book_type != "ladder") ||
+        (options.format != "csv" && options.format != "binary" && options.format != "shm") ||
+        ((options.pipeline || options.conflate) && thread_count != 1) || (options.pipeline && options.conflate) ||
+        (checkpointing && (special_mode || options.live || dbn_input || options.parse_threads > 1)) ||
+        (options.parse_threads > 1 && (options.live || dbn_input)) || (options.metrics_interval > 0 && (special_mode || options.metrics_file.empty())) ||
+        (!options.shard_cores.empty() && thread_count < 2) || (!options.parse_cores.empty() && options.parse_threads < 2)) {
+        std::cerr << "Usage: " << argv[0] << " [--config=FILE] [--book=map|ladder] [--format=csv|binary|shm [--shm-name=/NAME] [--shm-slots=N] [--shm-journal=N]]"
+                  << " [--parse-threads=N [--pin-parsers=C,...]] [--pin=P[,B,W]] [--huge-pages=on|off]"
+                  << " [--threads=N [--pin-shards=C,...] | --pipeline | --conflate]"
+                  << " [--checkpoint=FILE [--checkpoint-every=N]] [--resume=FILE] [--metrics=FILE [--metrics-every=N]]"
+                  << " [--log-level=info|warning|off] [--stats-json=FILE]"
+                  << " <mbo_input_file.csv | mbo_input_file.dbn[.zst] | - | --live=GROUP:PORT[@INTERFACE] [--live-idle-ms=N]>" << std::endl;
+        std::cerr << "Example: " << argv[0] << " mbo.csv" << std::endl;
+        return 1;
+    }
+    
+    if (!options.metrics_file.empty() && !LATENCY_ENABLED) {
+        std::cerr << "Error: --metrics needs latency instrumentation; rebuild with make LATENCY=1" << std::endl;
+        return 1;
+    }
+    
+    options.thread_count = thread_count;
+    setHugePagesEnabled(options.huge_pages);
+    
+    if (options.book_type == "ladder") {
+        return runWithFormat<LadderOrderBook>(input_file, options);
+    }
+    return runWithFormat<OrderBook>(input_file, options);
+}
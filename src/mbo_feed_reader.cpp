@@ -0,0 +1,116 @@
+#include "mbo_feed_reader.h"
+#include "dbn_mbo.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+MboFeedReader::MboFeedReader(PacketReceiver& receiver)
+    : receiver_(receiver), packet_index_(0), cursor_(nullptr), packet_end_(nullptr), records_left_(0),
+      expected_sequence_(0), has_sequence_(false), last_instrument_id_(0), last_ts_event_(0), stopped_(false),
+      idle_timeout_(0) {}
+
+bool MboFeedReader::next(MboEvent& event) {
+    for (;;) {
+        if (!pending_resets_.empty()) {
+            event = pending_resets_.back();
+            pending_resets_.pop_back();
+            return true;
+        }
+        
+        if (records_left_ > 0) {
+            size_t available = static_cast<size_t>(packet_end_ - cursor_);
+            size_t size = dbn_mbo::recordSize(cursor_, available);
+            if (size == 0 || size > available) {
+                // The rest of the packet cannot be framed
+                ++stats_.malformed_packets;
+                records_left_ = 0;
+                continue;
+            }
+            const char* record = cursor_;
+            cursor_ += size;
+            --records_left_;
+            
+            // Other record types (system messages, heartbeats) are skipped
+            if (!dbn_mbo::decode(record, size, event)) {
+                continue;
+            }
+            ++stats_.records;
+            noteInstrument(event.instrument_id);
+            last_ts_event_ = event.ts_event;
+            return true;
+        }
+        
+        if (!nextPacket()) {
+            return false;
+        }
+    }
+}
+
+bool MboFeedReader::nextPacket() {
+    auto idle_since = std::chrono::steady_clock::now();
+    for (;;) {
+        while (packet_index_ < batch_.count) {
+            size_t index = packet_index_++;
+            if (acceptPacket(batch_.data[index], batch_.length[index])) {
+                return true;
+            }
+        }
+        
+        if (stopped_.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        packet_index_ = 0;
+        if (!receiver_.receive(batch_)) {
+            return false;
+        }
+        if (batch_.count == 0) {
+            if (idle_timeout_.count() > 0 && std::chrono::steady_clock::now() - idle_since >= idle_timeout_) {
+                return false;
+            }
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool MboFeedReader::acceptPacket(const char* data, size_t length) {
+    if (length < sizeof(mbo_feed::PacketHeader)) {
+        ++stats_.malformed_packets;
+        return false;
+    }
+    mbo_feed::PacketHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    
+    if (has_sequence_ && header.sequence != expected_sequence_) {
+        if (header.sequence < expected_sequence_) {
+            ++stats_.stale_packets;
+            return false;
+        }
+        // Resets come out last-instrument first; order does not matter
+        ++stats_.gaps;
+        stats_.packets_lost += header.sequence - expected_sequence_;
+        for (uint32_t instrument_id : instruments_) {
+            MboEvent reset(last_ts_event_, 'R', 'N', 0, 0, 0);
+            reset.instrument_id = instrument_id;
+            pending_resets_.push_back(reset);
+        }
+        stats_.resets_issued += instruments_.size();
+    }
+    expected_sequence_ = header.sequence + 1;
+    has_sequence_ = true;
+    ++stats_.packets;
+    
+    cursor_ = data + sizeof(header);
+    packet_end_ = data + length;
+    records_left_ = header.record_count;
+    return true;
+}
+
+void MboFeedReader::noteInstrument(uint32_t instrument_id) {
+    if (instrument_id == last_instrument_id_ && !instruments_.empty()) {
+        return;
+    }
+    last_instrument_id_ = instrument_id;
+    if (std::find(instruments_.begin(), instruments_.end(), instrument_id) == instruments_.end()) {
+        instruments_.push_back(instrument_id);
+    }
+}
@@ -0,0 +1,376 @@
+#include "mbo_file_reader.h"
+#include "page_allocator.h"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MboFileReader::MboFileReader(const std::string& filename)
+    : filename_(filename), data_(nullptr), cursor_(nullptr), end_(nullptr),
+      file_size_(0), released_bytes_(0), skipped_lines_(0), symbology_(nullptr),
+      last_instrument_id_(0), has_last_instrument_(false),
+      stream_(nullptr), owns_stream_(false), stream_eof_(false), stream_offset_(0),
+      parse_threads_(1), chunk_bytes_(ChunkedCsvParser::DEFAULT_CHUNK_BYTES), chunk_(nullptr), chunk_pos_(0),
+#ifdef _WIN32
+      file_handle_(INVALID_HANDLE_VALUE), mapping_handle_(nullptr)
+#else
+      fd_(-1)
+#endif
+{}
+
+MboFileReader::~MboFileReader() {
+    close();
+}
+
+bool MboFileReader::open() {
+    close();
+    
+    if (filename_ == "-") {
+        return open(stdin);
+    }
+
+#ifdef _WIN32
+    file_handle_ = CreateFileA(filename_.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                               OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file_handle_ == INVALID_HANDLE_VALUE) {
+        std::cerr << "Error: Cannot open file " << filename_ << std::endl;
+        return false;
+    }
+    
+    if (GetFileType(file_handle_) != FILE_TYPE_DISK) {
+        close();
+        return openStream();
+    }
+    
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file_handle_, &size)) {
+        std::cerr << "Error: Cannot stat file " << filename_ << std::endl;
+        close();
+        return false;
+    }
+    file_size_ = static_cast<size_t>(size.QuadPart);
+    
+    if (file_size_ > 0) {
+        mapping_handle_ = CreateFileMappingA(file_handle_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_handle_) {
+            data_ = static_cast<const char*>(MapViewOfFile(mapping_handle_, FILE_MAP_READ, 0, 0, 0));
+        }
+        if (!data_) {
+            std::cerr << "Error: Cannot map file " << filename_ << std::endl;
+            close();
+            return false;
+        }
+    }
+#else
+    fd_ = ::open(filename_.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+        std::cerr << "Error: Cannot open file " << filename_ << std::endl;
+        return false;
+    }
+    
+    struct stat st;
+    if (fstat(fd_, &st) != 0) {
+        std::cerr << "Error: Cannot stat file " << filename_ << std::endl;
+        close();
+        return false;
+    }
+    
+    // Pipes, FIFOs and character devices cannot be mapped
+    if (!S_ISREG(st.st_mode)) {
+        close();
+        return openStream();
+    }
+    file_size_ = static_cast<size_t>(st.st_size);
+    
+    if (file_size_ > 0) {
+        void* mapped = mmap(nullptr, file_size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (mapped == MAP_FAILED) {
+            std::cerr << "Error: Cannot map file " << filename_ << std::endl;
+            close();
+            return false;
+        }
+        data_ = static_cast<const char*>(mapped);
+        madvise(mapped, file_size_, MADV_SEQUENTIAL);
+        adviseHugePages(mapped, file_size_);
+    }
+#endif
+
+    cursor_ = data_;
+    end_ = data_ + file_size_;
+    released_bytes_ = 0;
+    skipped_lines_ = 0;
+    
+    skipHeader();
+    if (parse_threads_ > 1) {
+        chunk_parser_.reset(new ChunkedCsvParser(data_, static_cast<size_t>(cursor_ - data_), file_size_, parse_threads_,
+                                                 chunk_bytes_, symbology_ != nullptr, parse_cores_));
+    }
+    return true;
+}
+
+bool MboFileReader::open(std::FILE* stream) {
+    close();
+    
+    stream_ = stream;
+    owns_stream_ = false;
+    stream_eof_ = false;
+    stream_offset_ = 0;
+    stream_buffer_.resize(STREAM_CHUNK);
+    
+    data_ = stream_buffer_.data();
+    cursor_ = data_;
+    end_ = data_;
+    released_bytes_ = 0;
+    skipped_lines_ = 0;
+    
+    skipHeader();
+    return true;
+}
+
+bool MboFileReader::openStream() {
+    std::FILE* stream = std::fopen(filename_.c_str(), "rb");
+    if (!stream) {
+        std::cerr << "Error: Cannot open file " << filename_ << std::endl;
+        return false;
+    }
+    
+    open(stream);
+    owns_stream_ = true;
+    return true;
+}
+
+void MboFileReader::close() {
+    // Workers read the mapping until they are joined
+    chunk_parser_.reset();
+    chunk_ = nullptr;
+    chunk_pos_ = 0;
+    
+    if (stream_) {
+        if (owns_stream_) {
+            std::fclose(stream_);
+        }
+        stream_ = nullptr;
+        owns_stream_ = false;
+        stream_offset_ = 0;
+        data_ = nullptr;
+    }
+
+#ifdef _WIN32
+    if (data_) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_handle_) {
+        CloseHandle(mapping_handle_);
+        mapping_handle_ = nullptr;
+    }
+    if (file_handle_ != INVALID_HANDLE_VALUE) {
+        CloseHandle(file_handle_);
+        file_handle_ = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (data_) {
+        munmap(const_cast<char*>(data_), file_size_);
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+#endif
+
+    data_ = nullptr;
+    cursor_ = nullptr;
+    end_ = nullptr;
+    file_size_ = 0;
+}
+
+void MboFileReader::skipHeader() {
+    if (cursor_ != end_ || (stream_ && refill())) {
+        const char* newline = findLineEnd();
+        cursor_ = newline ? newline + 1 : end_;
+    }
+}
+
+bool MboFileReader::next(MboEvent& event) {
+    if (chunk_parser_) {
+        return nextParsed(event);
+    }
+    
+    for (;;) {
+        if (cursor_ == end_ && !(stream_ && refill())) {
+            return false;
+        }
+        
+        if (!stream_ && static_cast<size_t>(cursor_ - data_) - released_bytes_ >= RELEASE_STEP) {
+            releaseConsumed();
+        }
+        
+        const char* newline = findLineEnd();
+        const char* line = cursor_;
+        const char* line_end = newline ? newline : end_;
+        cursor_ = newline ? newline + 1 : end_;
+        
+        if (line_end > line && line_end[-1] == '\r') {
+            --line_end;
+        }
+        if (line_end == line) {
+            continue;
+        }
+        
+        if (MboParser::parseLine(line, line_end, event)) {
+            // Runs of the same instrument skip the table lookup
+            if (symbology_ && (!has_last_instrument_ || event.instrument_id != last_instrument_id_)) {
+                last_instrument_id_ = event.instrument_id;
+                has_last_instrument_ = true;
+                
+                const char* symbol_begin;
+                const char* symbol_end;
+                if (!symbology_->contains(event.instrument_id) &&
+                    MboParser::findSymbol(line, line_end, &symbol_begin, &symbol_end)) {
+                    symbology_->add(event.instrument_id, event.publisher_id, std::string(symbol_begin, symbol_end));
+                }
+            }
+            return true;
+        }
+        ++skipped_lines_;
+    }
+}
+
+bool MboFileReader::nextParsed(MboEvent& event) {
+    for (;;) {
+        if (chunk_ && chunk_pos_ < chunk_->events.size()) {
+            chunk_->events.unpack(chunk_pos_++, event);
+            return true;
+        }
+        
+        if (chunk_) {
+            skipped_lines_ += chunk_->skipped_lines;
+            cursor_ = data_ + chunk_->end;
+            if (static_cast<size_t>(cursor_ - data_) - released_bytes_ >= RELEASE_STEP) {
+                releaseConsumed();
+            }
+        }
+        chunk_ = chunk_parser_->nextChunk();
+        chunk_pos_ = 0;
+        if (!chunk_) {
+            return false;
+        }
+        
+        // Symbols apply before the chunk's first event, as a sequential
+        // read would have recorded them; the earliest chunk wins
+        if (symbology_) {
+            for (const ChunkSymbol& entry : chunk_->symbols) {
+                if (!symbology_->contains(entry.instrument_id)) {
+                    symbology_->add(entry.instrument_id, entry.publisher_id, entry.symbol);
+                }
+            }
+        }
+    }
+}
+
+bool MboFileReader::seek(size_t offset) {
+    if (chunk_parser_) {
+        std::cerr << "Error: Cannot seek in " << filename_ << " while it is parsed in parallel" << std::endl;
+        return false;
+    }
+    if (!stream_) {
+        if (offset > file_size_) {
+            std::cerr << "Error: Offset " << offset << " is past the end of " << filename_ << std::endl;
+            return false;
+        }
+        cursor_ = data_ + offset;
+        return true;
+    }
+    
+    while (getBytesConsumed() < offset) {
+        if (cursor_ == end_ && !refill()) {
+            std::cerr << "Error: " << filename_ << " ended before offset " << offset << std::endl;
+            return false;
+        }
+        size_t skip = std::min(static_cast<size_t>(end_ - cursor_), offset - getBytesConsumed());
+        cursor_ += skip;
+    }
+    return true;
+}
+
+const char* MboFileReader::findLineEnd() {
+    size_t scanned = 0;
+    for (;;) {
+        const char* newline = static_cast<const char*>(
+            std::memchr(cursor_ + scanned, '\n', static_cast<size_t>(end_ - cursor_) - scanned));
+        if (newline || !stream_) {
+            return newline;
+        }
+        scanned = static_cast<size_t>(end_ - cursor_);
+        if (!refill()) {
+            return nullptr;
+        }
+    }
+}
+
+// Moves the unparsed tail to the front of the buffer and appends whatever
+// the stream has ready. A plain read() returns as soon as some input is
+// available, so rows from a live feed are not held back until a chunk fills.
+bool MboFileReader::refill() {
+    if (stream_eof_) {
+        return false;
+    }
+    
+    size_t pending = static_cast<size_t>(end_ - cursor_);
+    stream_offset_ += static_cast<size_t>(cursor_ - data_);
+    std::memmove(stream_buffer_.data(), cursor_, pending);
+    
+    // A row longer than the buffer grows it
+    if (pending == stream_buffer_.size()) {
+        stream_buffer_.resize(stream_buffer_.size() * 2);
+    }
+    
+    char* buffer = stream_buffer_.data();
+#ifdef _WIN32
+    int count = _read(_fileno(stream_), buffer + pending, static_cast<unsigned int>(stream_buffer_.size() - pending));
+#else
+    ssize_t count;
+    do {
+        count = ::read(fileno(stream_), buffer + pending, stream_buffer_.size() - pending);
+    } while (count < 0 && errno == EINTR);
+#endif
+    
+    data_ = buffer;
+    cursor_ = buffer;
+    end_ = buffer + pending + (count > 0 ? count : 0);
+    
+    if (count <= 0) {
+        if (count < 0) {
+            std::cerr << "Error: Read failed on " << filename_ << std::endl;
+        }
+        stream_eof_ = true;
+        return false;
+    }
+    return true;
+}
+
+// Drops pages that have been fully parsed so resident memory stays bounded
+// on files much larger than RAM
+void MboFileReader::releaseConsumed() {
+#ifndef _WIN32
+    static const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t consumed = static_cast<size_t>(cursor_ - data_);
+    size_t release_end = (consumed / page_size) * page_size;
+    
+    if (release_end > released_bytes_) {
+        madvise(const_cast<char*>(data_) + released_bytes_, release_end - released_bytes_, MADV_DONTNEED);
+        released_bytes_ = release_end;
+    }
+#else
+    released_bytes_ = static_cast<size_t>(cursor_ - data_);
+#endif
+}
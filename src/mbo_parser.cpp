@@ -1,125 +1,102 @@
 #include "mbo_parser.h"
-#include <fstream>
+#include "mbo_file_reader.h"
 #include <iostream>
 #include <cstring>
 #include <cstdlib>
-#include <memory>
 
-std::vector<MboEvent> MboParser::parseFile(const std::string& filename) {
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+std::vector<MboEvent> MboParser::parseFile(const std::string& filename, size_t parse_threads) {
     std::vector<MboEvent> events;
-    std::ifstream file(filename);
+    MboFileReader reader(filename);
+    reader.setParseThreads(parse_threads);
     
-    if (!file.is_open()) {
-        std::cerr << "Error: Cannot open file " << filename << std::endl;
+    if (!reader.open()) {
         return events;
     }
     
-    file.seekg(0, std::ios::end);
-    size_t file_size = file.tellg();
-    file.seekg(0, std::ios::beg);
-    
-    size_t estimated_lines = file_size / 100;
+    size_t estimated_lines = reader.getFileSize() / 100;
     events.reserve(estimated_lines);
     
-    std::string line;
-    bool is_header = true;
-    
-    constexpr size_t BUFFER_SIZE = 65536;
-    auto buffer = std::make_unique<char[]>(BUFFER_SIZE);
-    file.rdbuf()->pubsetbuf(buffer.get(), BUFFER_SIZE);
-    
-    while (std::getline(file, line)) {
-        if (is_header) {
-            is_header = false;
-            continue;
-        }
-        
-        if (line.empty()) {
-            continue;
-        }
-        
-        MboEvent event;
-        if (parseLine(line.c_str(), event)) {
-            events.emplace_back(std::move(event));
-        }
-    }
+    reader.forEach([&events](const MboEvent& event) {
+        events.push_back(event);
+    });
     
-    file.close();
     std::cout << "Parsed " << events.size() << " MBO events from " << filename << std::endl;
     return events;
 }
 
 bool MboParser::parseLine(const char* line, MboEvent& event) {
-    const char* ptr = line;
-    
-    ptr = skipToNextField(ptr);
-    if (!ptr) return false;
+    return parseLine(line, line + std::strlen(line), event);
+}
+
+// Parses one row in place from [line, end), which need not be NUL-terminated
+bool MboParser::parseLine(const char* line, const char* end, MboEvent& event) {
+    const char* fields[FIELD_COUNT];
+    size_t field_count = findFieldStarts(line, end, fields, FIELD_COUNT);
+    if (field_count <= FIELD_SEQUENCE) return false;
     
-    const char* ts_start = ptr;
-    ptr = skipToNextField(ptr);
-    if (!ptr) return false;
+    auto fieldEnd = [&](size_t field) {
+        return field + 1 < field_count ? fields[field + 1] - 1 : end;
+    };
     
-    size_t ts_len = ptr - ts_start - 1;
-    char ts_buffer[64];
-    if (ts_len >= sizeof(ts_buffer)) return false;
+    if (!parseTimestamp(fields[FIELD_TS_EVENT], fieldEnd(FIELD_TS_EVENT), event.ts_event)) return false;
     
-    std::memcpy(ts_buffer, ts_start, ts_len);
-    ts_buffer[ts_len] = '\0';
-    event.ts_event = parseTimestamp(ts_buffer);
+    const char* ptr;
+    const char* endptr;
     
-    for (int i = 0; i < 3; ++i) {
-        ptr = skipToNextField(ptr);
-        if (!ptr) return false;
+    ptr = fields[FIELD_PUBLISHER_ID];
+    event.publisher_id = static_cast<uint16_t>(fastParseUInt64(ptr, fieldEnd(FIELD_PUBLISHER_ID), &endptr));
+    if (endptr == ptr) {
+        event.publisher_id = 0;
     }
     
-    event.action = *ptr;
-    ptr = skipToNextField(ptr);
-    if (!ptr) return false;
+    ptr = fields[FIELD_INSTRUMENT_ID];
+    event.instrument_id = static_cast<uint32_t>(fastParseUInt64(ptr, fieldEnd(FIELD_INSTRUMENT_ID), &endptr));
+    if (endptr == ptr) {
+        event.instrument_id = 0;
+    }
     
-    event.side = *ptr;
-    ptr = skipToNextField(ptr);
-    if (!ptr) return false;
+    event.action = *fields[FIELD_ACTION];
+    event.side = *fields[FIELD_SIDE];
     
-    char* endptr;
-    event.price = fastParseDouble(ptr, &endptr);
+    ptr = fields[FIELD_PRICE];
+    event.price = fastParsePrice(ptr, fieldEnd(FIELD_PRICE), &endptr);
     if (endptr == ptr) {
-        event.price = 0.0;
+        event.price = 0;
     }
-    ptr = skipToNextField(ptr);
-    if (!ptr) return false;
     
-    event.size = fastParseUInt64(ptr, &endptr);
+    // Sizes are 32-bit in DBN, and packed event batches rely on that
+    ptr = fields[FIELD_SIZE];
+    event.size = fastParseUInt64(ptr, fieldEnd(FIELD_SIZE), &endptr);
     if (endptr == ptr) {
         event.size = 0;
+    } else if (event.size > UINT32_MAX) {
+        return false;
     }
-    ptr = skipToNextField(ptr);
-    if (!ptr) return false;
-    
-    ptr = skipToNextField(ptr);
-    if (!ptr) return false;
     
-    event.order_id = fastParseUInt64(ptr, &endptr);
+    ptr = fields[FIELD_ORDER_ID];
+    event.order_id = fastParseUInt64(ptr, fieldEnd(FIELD_ORDER_ID), &endptr);
     if (endptr == ptr) {
         event.order_id = 0;
     }
-    ptr = skipToNextField(ptr);
-    if (!ptr) return false;
     
-    event.flags = static_cast<uint8_t>(fastParseUInt64(ptr, &endptr));
+    ptr = fields[FIELD_FLAGS];
+    event.flags = static_cast<uint8_t>(fastParseUInt64(ptr, fieldEnd(FIELD_FLAGS), &endptr));
     if (endptr == ptr) {
         event.flags = 0;
     }
-    ptr = skipToNextField(ptr);
-    if (!ptr) return false;
     
-    event.ts_in_delta = static_cast<int32_t>(fastParseUInt64(ptr, &endptr));
+    ptr = fields[FIELD_TS_IN_DELTA];
+    event.ts_in_delta = static_cast<int32_t>(fastParseInt64(ptr, fieldEnd(FIELD_TS_IN_DELTA), &endptr));
     if (endptr == ptr) {
         event.ts_in_delta = 0;
     }
-    ptr = skipToNextField(ptr);
-    if (!ptr) return false;
     
-    event.sequence = fastParseUInt64(ptr, &endptr);
+    ptr = fields[FIELD_SEQUENCE];
+    event.sequence = fastParseUInt64(ptr, fieldEnd(FIELD_SEQUENCE), &endptr);
     if (endptr == ptr) {
         event.sequence = 0;
     }
@@ -127,7 +104,142 @@ bool MboParser::parseLine(const char* line, MboEvent& event) {
     return true;
 }
 
-std::chrono::nanoseconds MboParser::parseTimestamp(const char* timestamp_str) {
+bool MboParser::findSymbol(const char* line, const char* end, const char** symbol_begin, const char** symbol_end) {
+    const char* fields[FIELD_COUNT];
+    if (findFieldStarts(line, end, fields, FIELD_COUNT) <= FIELD_SYMBOL) return false;
+    
+    *symbol_begin = fields[FIELD_SYMBOL];
+    *symbol_end = end;
+    return true;
+}
+
+// Records the start of each field in one pass over the row: starts[0] is the
+// row itself and starts[i] follows the i-th comma. Scans 32 (AVX2) or 16
+// (SSE2) bytes per step and finishes the tail byte by byte, never reading
+// past end. Returns the number of field starts found, at most max_fields.
+size_t MboParser::findFieldStarts(const char* line, const char* end, const char** starts, size_t max_fields) {
+    size_t count = 0;
+    starts[count++] = line;
+    const char* ptr = line;
+    
+#if defined(__AVX2__)
+    const __m256i comma = _mm256_set1_epi8(',');
+    while (count < max_fields && end - ptr >= 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, comma)));
+        while (mask != 0 && count < max_fields) {
+            starts[count++] = ptr + __builtin_ctz(mask) + 1;
+            mask &= mask - 1;
+        }
+        ptr += 32;
+    }
+#elif defined(__SSE2__)
+    const __m128i comma = _mm_set1_epi8(',');
+    while (count < max_fields && end - ptr >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, comma)));
+        while (mask != 0 && count < max_fields) {
+            starts[count++] = ptr + __builtin_ctz(mask) + 1;
+            mask &= mask - 1;
+        }
+        ptr += 16;
+    }
+#endif
+    
+    while (count < max_fields && ptr < end) {
+        if (*ptr == ',') {
+            starts[count++] = ptr + 1;
+        }
+        ptr++;
+    }
+    
+    return count;
+}
+
+// Days since 1970-01-01 for a proleptic Gregorian date, without looping
+// over years (H. Hinnant's days_from_civil)
+static int64_t daysFromCivil(int64_t year, unsigned month, unsigned day) {
+    year -= month <= 2;
+    const int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned year_of_era = static_cast<unsigned>(year - era * 400);
+    const unsigned day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const unsigned day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + static_cast<int64_t>(day_of_era) - 719468;
+}
+
+static inline unsigned digit(char c) {
+    return static_cast<unsigned>(c - '0');
+}
+
+// Decodes "YYYY-MM-DDTHH:MM:SS[.fffffffff]Z". The fixed layout is parsed
+// with straight-line digit arithmetic; the day number is cached per thread
+// since consecutive rows almost always share a date. Anything that does not
+// match the fixed layout falls back to the general parser.
+bool MboParser::parseTimestamp(const char* begin, const char* end, std::chrono::nanoseconds& timestamp) {
+    constexpr size_t DATE_LENGTH = 10;
+    constexpr size_t SECONDS_LENGTH = 19;
+    
+    size_t length = static_cast<size_t>(end - begin);
+    
+    bool fixed_layout = length >= SECONDS_LENGTH &&
+        begin[4] == '-' && begin[7] == '-' && begin[10] == 'T' && begin[13] == ':' && begin[16] == ':';
+    
+    if (!fixed_layout) {
+        char ts_buffer[64];
+        if (length >= sizeof(ts_buffer)) return false;
+        
+        std::memcpy(ts_buffer, begin, length);
+        ts_buffer[length] = '\0';
+        timestamp = parseTimestampSlow(ts_buffer);
+        return true;
+    }
+    
+    struct DateCache {
+        char date[DATE_LENGTH];
+        int64_t days;
+        bool valid;
+    };
+    static thread_local DateCache cache = {{0}, 0, false};
+    
+    if (!cache.valid || std::memcmp(cache.date, begin, DATE_LENGTH) != 0) {
+        int64_t year = digit(begin[0]) * 1000 + digit(begin[1]) * 100 + digit(begin[2]) * 10 + digit(begin[3]);
+        unsigned month = digit(begin[5]) * 10 + digit(begin[6]);
+        unsigned day = digit(begin[8]) * 10 + digit(begin[9]);
+        
+        std::memcpy(cache.date, begin, DATE_LENGTH);
+        cache.days = daysFromCivil(year, month, day);
+        cache.valid = true;
+    }
+    
+    uint64_t seconds_of_day = (digit(begin[11]) * 10 + digit(begin[12])) * 3600ULL +
+                              (digit(begin[14]) * 10 + digit(begin[15])) * 60ULL +
+                              (digit(begin[17]) * 10 + digit(begin[18]));
+    
+    uint64_t nanosec_part = 0;
+    if (length > SECONDS_LENGTH && begin[SECONDS_LENGTH] == '.') {
+        const char* ptr = begin + SECONDS_LENGTH + 1;
+        if (end - ptr >= 9) {
+            for (int i = 0; i < 9; ++i) {
+                nanosec_part = nanosec_part * 10 + digit(ptr[i]);
+            }
+        } else {
+            int ns_digits = 0;
+            while (ptr != end && *ptr >= '0' && *ptr <= '9') {
+                nanosec_part = nanosec_part * 10 + digit(*ptr++);
+                ns_digits++;
+            }
+            while (ns_digits++ < 9) {
+                nanosec_part *= 10;
+            }
+        }
+    }
+    
+    uint64_t total_seconds = static_cast<uint64_t>(cache.days) * 86400ULL + seconds_of_day;
+    timestamp = std::chrono::nanoseconds(total_seconds * 1000000000ULL + nanosec_part);
+    return true;
+}
+
+std::chrono::nanoseconds MboParser::parseTimestampSlow(const char* timestamp_str) {
     int year, month, day, hour, minute, second;
     uint64_t nanosec_part = 0;
     
@@ -182,22 +294,74 @@ std::chrono::nanoseconds MboParser::parseTimestamp(const char* timestamp_str) {
     return std::chrono::nanoseconds(total_nanoseconds);
 }
 
-double MboParser::fastParseDouble(const char* str, char** endptr) {
-    return strtod(str, endptr);
-}
-
-uint64_t MboParser::fastParseUInt64(const char* str, char** endptr) {
-    return strtoull(str, endptr, 10);
+// Decodes a decimal such as "5.510000000" straight into 1e-9 ticks.
+// Digits beyond the ninth decimal place are consumed and truncated.
+Price MboParser::fastParsePrice(const char* str, const char* end, const char** endptr) {
+    const char* ptr = str;
+    bool negative = false;
+    
+    if (ptr != end && *ptr == '-') {
+        negative = true;
+        ptr++;
+    }
+    
+    const char* digits_start = ptr;
+    int64_t integer_part = 0;
+    while (ptr != end && *ptr >= '0' && *ptr <= '9') {
+        integer_part = integer_part * 10 + (*ptr - '0');
+        ptr++;
+    }
+    
+    int64_t fraction_part = 0;
+    int fraction_digits = 0;
+    if (ptr != end && *ptr == '.') {
+        ptr++;
+        while (ptr != end && *ptr >= '0' && *ptr <= '9') {
+            if (fraction_digits < PRICE_DECIMALS) {
+                fraction_part = fraction_part * 10 + (*ptr - '0');
+                fraction_digits++;
+            }
+            ptr++;
+        }
+    }
+    
+    if (ptr == digits_start) {
+        *endptr = str;
+        return 0;
+    }
+    
+    while (fraction_digits < PRICE_DECIMALS) {
+        fraction_part *= 10;
+        fraction_digits++;
+    }
+    
+    *endptr = ptr;
+    Price ticks = integer_part * PRICE_SCALE + fraction_part;
+    return negative ? -ticks : ticks;
 }
 
-const char* MboParser::skipToNextField(const char* ptr) {
-    while (*ptr && *ptr != ',') {
+uint64_t MboParser::fastParseUInt64(const char* str, const char* end, const char** endptr) {
+    const char* ptr = str;
+    uint64_t value = 0;
+    
+    while (ptr != end && *ptr >= '0' && *ptr <= '9') {
+        value = value * 10 + static_cast<uint64_t>(*ptr - '0');
         ptr++;
     }
     
-    if (*ptr == ',') {
-        return ptr + 1;
+    *endptr = ptr;
+    return value;
+}
+
+int64_t MboParser::fastParseInt64(const char* str, const char* end, const char** endptr) {
+    bool negative = (str != end && *str == '-');
+    const char* digits = negative ? str + 1 : str;
+    
+    uint64_t magnitude = fastParseUInt64(digits, end, endptr);
+    if (*endptr == digits) {
+        *endptr = str;
+        return 0;
     }
     
-    return nullptr;
+    return negative ? -static_cast<int64_t>(magnitude) : static_cast<int64_t>(magnitude);
 }
@@ -0,0 +1,198 @@
+#include "mbp_binary_reader.h"
+#include <iostream>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MbpBinaryReader::MbpBinaryReader(const std::string& filename)
+    : filename_(filename), data_(nullptr), records_(nullptr), header_(nullptr),
+      file_size_(0), record_size_(0), record_count_(0),
+#ifdef _WIN32
+      file_handle_(INVALID_HANDLE_VALUE), mapping_handle_(nullptr)
+#else
+      fd_(-1)
+#endif
+{}
+
+MbpBinaryReader::~MbpBinaryReader() {
+    close();
+}
+
+bool MbpBinaryReader::open() {
+    close();
+
+#ifdef _WIN32
+    file_handle_ = CreateFileA(filename_.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_handle_ == INVALID_HANDLE_VALUE) {
+        std::cerr << "Error: Cannot open file " << filename_ << std::endl;
+        return false;
+    }
+    
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file_handle_, &size)) {
+        std::cerr << "Error: Cannot stat file " << filename_ << std::endl;
+        close();
+        return false;
+    }
+    file_size_ = static_cast<size_t>(size.QuadPart);
+    
+    if (file_size_ > 0) {
+        mapping_handle_ = CreateFileMappingA(file_handle_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_handle_) {
+            data_ = static_cast<const char*>(MapViewOfFile(mapping_handle_, FILE_MAP_READ, 0, 0, 0));
+        }
+        if (!data_) {
+            std::cerr << "Error: Cannot map file " << filename_ << std::endl;
+            close();
+            return false;
+        }
+    }
+#else
+    fd_ = ::open(filename_.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+        std::cerr << "Error: Cannot open file " << filename_ << std::endl;
+        return false;
+    }
+    
+    struct stat st;
+    if (fstat(fd_, &st) != 0) {
+        std::cerr << "Error: Cannot stat file " << filename_ << std::endl;
+        close();
+        return false;
+    }
+    file_size_ = static_cast<size_t>(st.st_size);
+    
+    if (file_size_ > 0) {
+        void* mapped = mmap(nullptr, file_size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (mapped == MAP_FAILED) {
+            std::cerr << "Error: Cannot map file " << filename_ << std::endl;
+            close();
+            return false;
+        }
+        data_ = static_cast<const char*>(mapped);
+    }
+#endif
+
+    if (!validateHeader()) {
+        close();
+        return false;
+    }
+    
+    return true;
+}
+
+void MbpBinaryReader::close() {
+#ifdef _WIN32
+    if (data_) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_handle_) {
+        CloseHandle(mapping_handle_);
+        mapping_handle_ = nullptr;
+    }
+    if (file_handle_ != INVALID_HANDLE_VALUE) {
+        CloseHandle(file_handle_);
+        file_handle_ = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (data_) {
+        munmap(const_cast<char*>(data_), file_size_);
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+#endif
+
+    data_ = nullptr;
+    records_ = nullptr;
+    header_ = nullptr;
+    file_size_ = 0;
+    record_size_ = 0;
+    record_count_ = 0;
+}
+
+// A file whose writer never closed still has record_count 0 in its header;
+// in that case the count is recovered from the file size.
+bool MbpBinaryReader::validateHeader() {
+    if (file_size_ < sizeof(mbp_binary::FileHeader)) {
+        std::cerr << "Error: " << filename_ << " is too small to be an MBP binary file" << std::endl;
+        return false;
+    }
+    
+    header_ = reinterpret_cast<const mbp_binary::FileHeader*>(data_);
+    
+    if (std::memcmp(header_->magic, mbp_binary::MAGIC, sizeof(mbp_binary::MAGIC)) != 0) {
+        std::cerr << "Error: " << filename_ << " is not an MBP binary file" << std::endl;
+        return false;
+    }
+    if (header_->version != mbp_binary::SCHEMA_VERSION) {
+        std::cerr << "Error: Unsupported MBP binary schema version " << header_->version << std::endl;
+        return false;
+    }
+    if (header_->layout > mbp_binary::LAYOUT_DBN ||
+        header_->record_size != mbp_binary::recordSize(static_cast<mbp_binary::Layout>(header_->layout))) {
+        std::cerr << "Error: Unsupported MBP binary record layout in " << filename_ << std::endl;
+        return false;
+    }
+    
+    record_size_ = header_->record_size;
+    records_ = data_ + sizeof(mbp_binary::FileHeader);
+    
+    size_t available = (file_size_ - sizeof(mbp_binary::FileHeader)) / record_size_;
+    record_count_ = header_->record_count;
+    if (record_count_ == 0 || record_count_ > available) {
+        record_count_ = available;
+    }
+    
+    return true;
+}
+
+uint64_t MbpBinaryReader::orderId(size_t n) const {
+    if (header_->layout != mbp_binary::LAYOUT_NATIVE) {
+        return 0;
+    }
+    return reinterpret_cast<const mbp_binary::NativeRecord*>(records_ + n * record_size_)->order_id;
+}
+
+MbpSnapshot MbpBinaryReader::snapshot(size_t n) const {
+    auto decodePrice = [](int64_t price) -> Price {
+        return price != mbp_binary::UNDEF_PRICE ? price : 0;
+    };
+    
+    const mbp_binary::Record& rec = record(n);
+    MbpSnapshot snapshot;
+    
+    snapshot.timestamp = std::chrono::nanoseconds(rec.ts_event);
+    snapshot.publisher_id = rec.publisher_id;
+    snapshot.instrument_id = rec.instrument_id;
+    snapshot.sequence_number = rec.sequence;
+    snapshot.action = rec.action;
+    snapshot.side = rec.side;
+    snapshot.depth = rec.depth;
+    snapshot.event_price = decodePrice(rec.price);
+    snapshot.event_size = rec.size;
+    snapshot.event_order_id = orderId(n);
+    snapshot.event_flags = rec.flags;
+    snapshot.event_ts_in_delta = rec.ts_in_delta;
+    
+    for (size_t i = 0; i < mbp_binary::DEPTH; ++i) {
+        const mbp_binary::BidAskPair& level = rec.levels[i];
+        snapshot.px[BID][i] = decodePrice(level.bid_px);
+        snapshot.px[ASK][i] = decodePrice(level.ask_px);
+        snapshot.sz[BID][i] = level.bid_sz;
+        snapshot.sz[ASK][i] = level.ask_sz;
+        snapshot.ct[BID][i] = level.bid_ct;
+        snapshot.ct[ASK][i] = level.ask_ct;
+    }
+    
+    return snapshot;
+}
@@ -0,0 +1,139 @@
+#include "mbp_binary_writer.h"
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+
+MbpBinaryWriter::MbpBinaryWriter(const std::string& filename, mbp_binary::Layout layout)
+    : filename_(filename), buffer_used_(0), record_size_(mbp_binary::recordSize(layout)),
+      snapshot_count_(0), is_initialized_(false), instrument_set_(false), symbology_(nullptr), header_() {
+    std::memcpy(header_.magic, mbp_binary::MAGIC, sizeof(header_.magic));
+    header_.version = mbp_binary::SCHEMA_VERSION;
+    header_.layout = layout;
+    header_.record_size = static_cast<uint32_t>(record_size_);
+    header_.price_scale = PRICE_SCALE;
+    
+    write_buffer_.resize(BUFFER_SIZE);
+}
+
+MbpBinaryWriter::~MbpBinaryWriter() {
+    close();
+}
+
+void MbpBinaryWriter::setInstrument(uint16_t publisher_id, uint32_t instrument_id, const std::string& symbol) {
+    instrument_set_ = true;
+    header_.publisher_id = publisher_id;
+    header_.instrument_id = instrument_id;
+    std::memset(header_.symbol, 0, sizeof(header_.symbol));
+    std::memcpy(header_.symbol, symbol.data(), std::min(symbol.size(), sizeof(header_.symbol) - 1));
+}
+
+bool MbpBinaryWriter::initialize() {
+    if (is_initialized_) {
+        return true;
+    }
+    
+    file_stream_.open(filename_, std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!file_stream_.is_open()) {
+        std::cerr << "Error: Could not open output file: " << filename_ << std::endl;
+        return false;
+    }
+    
+    header_.record_count = 0;
+    file_stream_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+    
+    snapshot_count_ = 0;
+    is_initialized_ = true;
+    return true;
+}
+
+// Rows are implicit in the record position, so row_index is not stored
+bool MbpBinaryWriter::writeSnapshot(const MbpSnapshot& snapshot, uint64_t row_index) {
+    (void)row_index;
+    
+    if (!is_initialized_) {
+        std::cerr << "Error: Binary writer not initialized. Call initialize() first." << std::endl;
+        return false;
+    }
+    
+    if (buffer_used_ + record_size_ > write_buffer_.size()) {
+        flushBuffer();
+    }
+    
+    char* out = write_buffer_.data() + buffer_used_;
+    mbp_binary::NativeRecord native;
+    encodeRecord(snapshot, native.record);
+    native.order_id = snapshot.event_order_id;
+    std::memcpy(out, &native, record_size_);
+    buffer_used_ += record_size_;
+    
+    snapshot_count_++;
+    return true;
+}
+
+void MbpBinaryWriter::flush() {
+    flushBuffer();
+    if (file_stream_.is_open()) {
+        file_stream_.flush();
+    }
+}
+
+void MbpBinaryWriter::close() {
+    if (is_initialized_) {
+        flushBuffer();
+        
+        if (!instrument_set_ && symbology_ && symbology_->size() == 1) {
+            symbology_->forEach([this](uint32_t instrument_id, const SymbologyTable::Entry& entry) {
+                setInstrument(entry.publisher_id, instrument_id, entry.symbol);
+            });
+        }
+        
+        header_.record_count = snapshot_count_;
+        file_stream_.seekp(0);
+        file_stream_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+        
+        file_stream_.close();
+        is_initialized_ = false;
+    }
+}
+
+void MbpBinaryWriter::flushBuffer() {
+    if (buffer_used_ > 0 && file_stream_.is_open()) {
+        file_stream_.write(write_buffer_.data(), buffer_used_);
+        buffer_used_ = 0;
+    }
+}
+
+// Sizes, counts and sequence narrow to the 32-bit DBN fields
+void MbpBinaryWriter::encodeRecord(const MbpSnapshot& snapshot, mbp_binary::Record& record) const {
+    auto encodePrice = [](Price price) {
+        return price != 0 ? price : mbp_binary::UNDEF_PRICE;
+    };
+    
+    uint64_t ts = static_cast<uint64_t>(snapshot.timestamp.count());
+    
+    record.length = static_cast<uint8_t>(sizeof(mbp_binary::Record) / 4);
+    record.rtype = mbp_binary::RTYPE_MBP10;
+    record.publisher_id = snapshot.publisher_id;
+    record.instrument_id = snapshot.instrument_id;
+    record.ts_event = ts;
+    
+    record.price = encodePrice(snapshot.event_price);
+    record.size = static_cast<uint32_t>(snapshot.event_size);
+    record.action = snapshot.action;
+    record.side = snapshot.side;
+    record.flags = snapshot.event_flags;
+    record.depth = static_cast<uint8_t>(snapshot.depth);
+    record.ts_recv = ts;
+    record.ts_in_delta = snapshot.event_ts_in_delta;
+    record.sequence = static_cast<uint32_t>(snapshot.sequence_number);
+    
+    for (size_t i = 0; i < mbp_binary::DEPTH; ++i) {
+        mbp_binary::BidAskPair& level = record.levels[i];
+        level.bid_px = encodePrice(snapshot.px[BID][i]);
+        level.ask_px = encodePrice(snapshot.px[ASK][i]);
+        level.bid_sz = static_cast<uint32_t>(snapshot.sz[BID][i]);
+        level.ask_sz = static_cast<uint32_t>(snapshot.sz[ASK][i]);
+        level.bid_ct = snapshot.ct[BID][i];
+        level.ask_ct = snapshot.ct[ASK][i];
+    }
+}
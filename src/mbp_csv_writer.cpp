@@ -1,7 +1,8 @@
 #include "mbp_csv_writer.h"
 #include <iostream>
-#include <iomanip>
-#include <sstream>
+#include <charconv>
+#include <cstring>
+#include <algorithm>
 
 const char* MbpCsvWriter::CSV_HEADER = 
     ",ts_recv,ts_event,rtype,publisher_id,instrument_id,action,side,depth,price,size,flags,ts_in_delta,sequence,"
@@ -18,8 +19,10 @@ const char* MbpCsvWriter::CSV_HEADER =
     "symbol,order_id";
 
 MbpCsvWriter::MbpCsvWriter(const std::string& filename)
-    : filename_(filename), snapshot_count_(0), is_initialized_(false) {
-    write_buffer_.reserve(BUFFER_SIZE);
+    : filename_(filename), async_io_(false), buffer_used_(0), snapshot_count_(0), is_initialized_(false),
+      symbology_(nullptr), cached_instrument_id_(0), cached_symbol_(nullptr),
+      cached_second_(-1), cached_prefix_() {
+    write_buffer_.resize(BUFFER_SIZE + MAX_ROW_LENGTH);
 }
 
 MbpCsvWriter::~MbpCsvWriter() {
@@ -31,14 +34,20 @@ bool MbpCsvWriter::initialize() {
         return true;
     }
     
-    file_stream_.open(filename_, std::ios::out | std::ios::trunc);
-    if (!file_stream_.is_open()) {
-        std::cerr << "Error: Could not open output file: " << filename_ << std::endl;
-        return false;
+    if (async_io_) {
+        if (!async_file_.open(filename_)) {
+            return false;
+        }
+    } else {
+        file_stream_.open(filename_, std::ios::out | std::ios::trunc);
+        if (!file_stream_.is_open()) {
+            std::cerr << "Error: Could not open output file: " << filename_ << std::endl;
+            return false;
+        }
     }
     
-    appendToBuffer(CSV_HEADER);
-    appendToBuffer("\n");
+    appendToBuffer(CSV_HEADER, std::strlen(CSV_HEADER));
+    appendToBuffer("\n", 1);
     
     is_initialized_ = true;
     return true;
@@ -50,13 +59,13 @@ bool MbpCsvWriter::writeSnapshot(const MbpSnapshot& snapshot, uint64_t row_index
         return false;
     }
     
-    std::string csv_row = buildCsvRow(snapshot, row_index);
-    appendToBuffer(csv_row);
-    appendToBuffer("\n");
+    char* out = writeRow(write_buffer_.data() + buffer_used_, snapshot, row_index);
+    *out++ = '\n';
+    buffer_used_ = static_cast<size_t>(out - write_buffer_.data());
     
     snapshot_count_++;
     
-    if (write_buffer_.size() > BUFFER_SIZE * 0.8) {
+    if (buffer_used_ > BUFFER_SIZE * 0.8) {
         flushBuffer();
     }
     
@@ -65,7 +74,9 @@ bool MbpCsvWriter::writeSnapshot(const MbpSnapshot& snapshot, uint64_t row_index
 
 void MbpCsvWriter::flush() {
     flushBuffer();
-    if (file_stream_.is_open()) {
+    if (async_file_.isOpen()) {
+        async_file_.flush();
+    } else if (file_stream_.is_open()) {
         file_stream_.flush();
     }
 }
@@ -73,122 +84,229 @@ void MbpCsvWriter::flush() {
 void MbpCsvWriter::close() {
     if (is_initialized_) {
         flushBuffer();
+        async_file_.close();
         file_stream_.close();
         is_initialized_ = false;
     }
 }
 
 void MbpCsvWriter::flushBuffer() {
-    if (!write_buffer_.empty() && file_stream_.is_open()) {
-        file_stream_.write(write_buffer_.data(), write_buffer_.size());
-        write_buffer_.clear();
+    if (buffer_used_ == 0) {
+        return;
+    }
+    
+    // The async writer swaps in its idle buffer, so write_buffer_ must not be
+    // cached across this call
+    if (async_file_.isOpen()) {
+        async_file_.write(write_buffer_, buffer_used_);
+        buffer_used_ = 0;
+    } else if (file_stream_.is_open()) {
+        file_stream_.write(write_buffer_.data(), buffer_used_);
+        buffer_used_ = 0;
     }
 }
 
-void MbpCsvWriter::appendToBuffer(const std::string& data) {
-    appendToBuffer(data.c_str(), data.length());
+void MbpCsvWriter::appendToBuffer(const char* data, size_t length) {
+    if (buffer_used_ + length > write_buffer_.size()) {
+        flushBuffer();
+        if (length > write_buffer_.size() && !async_file_.isOpen()) {
+            file_stream_.write(data, length);
+            return;
+        }
+        while (length > write_buffer_.size()) {
+            std::memcpy(write_buffer_.data(), data, write_buffer_.size());
+            buffer_used_ = write_buffer_.size();
+            data += buffer_used_;
+            length -= buffer_used_;
+            flushBuffer();
+        }
+    }
+    std::memcpy(write_buffer_.data() + buffer_used_, data, length);
+    buffer_used_ += length;
 }
 
-void MbpCsvWriter::appendToBuffer(const char* data, size_t length) {
-    write_buffer_.insert(write_buffer_.end(), data, data + length);
+// Civil date from days since 1970-01-01 (H. Hinnant's civil_from_days)
+static void civilFromDays(int64_t days, int64_t& year, unsigned& month, unsigned& day) {
+    days += 719468;
+    const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const unsigned day_of_era = static_cast<unsigned>(days - era * 146097);
+    const unsigned year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    const unsigned day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    const unsigned mp = (5 * day_of_year + 2) / 153;
+    day = day_of_year - (153 * mp + 2) / 5 + 1;
+    month = mp < 10 ? mp + 3 : mp - 9;
+    year = static_cast<int64_t>(year_of_era) + era * 400 + (month <= 2);
 }
 
-std::string MbpCsvWriter::formatTimestamp(const std::chrono::nanoseconds& timestamp) const {
-    auto time_point = std::chrono::system_clock::time_point(
-        std::chrono::duration_cast<std::chrono::system_clock::duration>(timestamp)
-    );
-    
-    auto time_t_val = std::chrono::system_clock::to_time_t(time_point);
-    
-    auto duration_since_epoch = timestamp;
-    auto seconds_since_epoch = std::chrono::duration_cast<std::chrono::seconds>(duration_since_epoch);
-    auto nanoseconds_part = duration_since_epoch - seconds_since_epoch;
-    
-    std::ostringstream oss;
-    oss << std::put_time(std::gmtime(&time_t_val), "%Y-%m-%dT%H:%M:%S");
-    oss << "." << std::setfill('0') << std::setw(9) << nanoseconds_part.count() << "Z";
-    
-    return oss.str();
+static inline char* writeDigits(char* out, uint64_t value, int width) {
+    for (int i = width - 1; i >= 0; --i) {
+        out[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    return out + width;
 }
 
-std::string MbpCsvWriter::formatPrice(double price) const {
-    if (price == 0.0) {
-        return "";
+// Writes "YYYY-MM-DDTHH:MM:SS.nnnnnnnnnZ". The date/time prefix is rebuilt
+// only when the second changes; otherwise just the nanoseconds are written.
+char* MbpCsvWriter::writeTimestamp(char* out, const std::chrono::nanoseconds& timestamp) {
+    int64_t total_ns = timestamp.count();
+    int64_t seconds = total_ns / 1000000000LL;
+    int64_t nanoseconds = total_ns % 1000000000LL;
+    if (nanoseconds < 0) {
+        nanoseconds += 1000000000LL;
+        seconds -= 1;
     }
     
-    std::ostringstream oss;
-    oss << std::fixed << std::setprecision(2) << price;
-    std::string result = oss.str();
-    
-    if (result.find('.') != std::string::npos) {
-        if (result.substr(result.length() - 3) == ".00") {
-            result = result.substr(0, result.length() - 1);
-        }
-        else if (result.back() == '0' && result[result.length()-2] != '.') {
-            result.pop_back();
+    if (seconds != cached_second_) {
+        int64_t days = seconds / 86400;
+        int64_t second_of_day = seconds % 86400;
+        if (second_of_day < 0) {
+            second_of_day += 86400;
+            days -= 1;
         }
+        
+        int64_t year;
+        unsigned month, day;
+        civilFromDays(days, year, month, day);
+        
+        char* p = cached_prefix_;
+        p = writeDigits(p, static_cast<uint64_t>(year), 4);
+        *p++ = '-';
+        p = writeDigits(p, month, 2);
+        *p++ = '-';
+        p = writeDigits(p, day, 2);
+        *p++ = 'T';
+        p = writeDigits(p, static_cast<uint64_t>(second_of_day / 3600), 2);
+        *p++ = ':';
+        p = writeDigits(p, static_cast<uint64_t>(second_of_day / 60 % 60), 2);
+        *p++ = ':';
+        writeDigits(p, static_cast<uint64_t>(second_of_day % 60), 2);
+        
+        cached_second_ = seconds;
     }
     
-    return result;
+    std::memcpy(out, cached_prefix_, TIMESTAMP_PREFIX_LENGTH);
+    out += TIMESTAMP_PREFIX_LENGTH;
+    *out++ = '.';
+    out = writeDigits(out, static_cast<uint64_t>(nanoseconds), 9);
+    *out++ = 'Z';
+    return out;
+}
+
+char* MbpCsvWriter::writeUInt(char* out, uint64_t value) {
+    return std::to_chars(out, out + 20, value).ptr;
+}
+
+char* MbpCsvWriter::writeInt(char* out, int64_t value) {
+    return std::to_chars(out, out + 20, value).ptr;
 }
 
-std::string MbpCsvWriter::formatSize(uint64_t size) const {
-    if (size == 0) {
-        return "0";
+// Prints ticks as an exact decimal with trailing zeros trimmed (keeping at
+// least one fractional digit), e.g. 5510000000 -> "5.51", 5000000000 -> "5.0".
+// Zero is the empty-level marker and prints nothing.
+char* MbpCsvWriter::writePrice(char* out, Price price) {
+    if (price == 0) {
+        return out;
     }
-    return std::to_string(size);
+    
+    bool negative = price < 0;
+    uint64_t magnitude = negative ? 0 - static_cast<uint64_t>(price) : static_cast<uint64_t>(price);
+    uint64_t integer_part = magnitude / PRICE_SCALE;
+    uint64_t fraction_part = magnitude % PRICE_SCALE;
+    
+    int fraction_digits = PRICE_DECIMALS;
+    while (fraction_digits > 1 && fraction_part % 10 == 0) {
+        fraction_part /= 10;
+        fraction_digits--;
+    }
+    
+    if (negative) {
+        *out++ = '-';
+    }
+    out = writeUInt(out, integer_part);
+    *out++ = '.';
+    return writeDigits(out, fraction_part, fraction_digits);
 }
 
-std::string MbpCsvWriter::formatCount(uint32_t count) const {
-    if (count == 0) {
-        return "0";
+const std::string& MbpCsvWriter::lookupSymbol(uint32_t instrument_id) {
+    static const std::string unknown;
+    if (!symbology_) {
+        return unknown;
     }
-    return std::to_string(count);
+    if (!cached_symbol_ || instrument_id != cached_instrument_id_) {
+        auto it = symbol_cache_.find(instrument_id);
+        if (it == symbol_cache_.end()) {
+            // Misses are not cached; the instrument may be added later
+            const SymbologyTable::Entry* entry = symbology_->find(instrument_id);
+            if (!entry) {
+                return unknown;
+            }
+            it = symbol_cache_.emplace(instrument_id, &entry->symbol).first;
+        }
+        cached_instrument_id_ = instrument_id;
+        cached_symbol_ = it->second;
+    }
+    return *cached_symbol_;
 }
 
-std::string MbpCsvWriter::buildCsvRow(const MbpSnapshot& snapshot, uint64_t row_index) const {
-    std::ostringstream row;
+char* MbpCsvWriter::writeRow(char* out, const MbpSnapshot& snapshot, uint64_t row_index) {
+    out = writeUInt(out, row_index);
+    *out++ = ',';
     
-    std::string timestamp_str = formatTimestamp(snapshot.timestamp);
+    char* ts_begin = out;
+    out = writeTimestamp(out, snapshot.timestamp);
+    size_t ts_length = static_cast<size_t>(out - ts_begin);
+    *out++ = ',';
+    std::memcpy(out, ts_begin, ts_length);
+    out += ts_length;
     
-    row << row_index << ","
-        << timestamp_str << ","
-        << timestamp_str << ","
-        << "10,"
-        << "2,"
-        << "1108,"
-        << snapshot.action << ","
-        << snapshot.side << ","
-        << snapshot.depth << ","
-        << (snapshot.event_price > 0 ? formatPrice(snapshot.event_price) : "") << ","
-        << snapshot.event_size << ","
-        << static_cast<int>(snapshot.event_flags) << ","
-        << snapshot.event_ts_in_delta << ","
-        << snapshot.sequence_number << ",";
+    static constexpr char RTYPE_FIELD[] = ",10,";
+    std::memcpy(out, RTYPE_FIELD, sizeof(RTYPE_FIELD) - 1);
+    out += sizeof(RTYPE_FIELD) - 1;
     
-    const double* bid_prices = &snapshot.bid_px_00;
-    const uint64_t* bid_sizes = &snapshot.bid_sz_00;
-    const uint32_t* bid_counts = &snapshot.bid_ct_00;
+    out = writeUInt(out, snapshot.publisher_id);
+    *out++ = ',';
+    out = writeUInt(out, snapshot.instrument_id);
+    *out++ = ',';
     
-    const double* ask_prices = &snapshot.ask_px_00;
-    const uint64_t* ask_sizes = &snapshot.ask_sz_00;
-    const uint32_t* ask_counts = &snapshot.ask_ct_00;
+    *out++ = snapshot.action;
+    *out++ = ',';
+    *out++ = snapshot.side;
+    *out++ = ',';
+    out = writeInt(out, snapshot.depth);
+    *out++ = ',';
+    out = writePrice(out, snapshot.event_price);
+    *out++ = ',';
+    out = writeUInt(out, snapshot.event_size);
+    *out++ = ',';
+    out = writeUInt(out, snapshot.event_flags);
+    *out++ = ',';
+    out = writeInt(out, snapshot.event_ts_in_delta);
+    *out++ = ',';
+    out = writeUInt(out, snapshot.sequence_number);
     
-    for (int i = 0; i < 10; ++i) {
-        row << formatPrice(bid_prices[i]) << ","
-            << formatSize(bid_sizes[i]) << ","
-            << formatCount(bid_counts[i]) << ",";
-            
-        row << formatPrice(ask_prices[i]) << ","
-            << formatSize(ask_sizes[i]) << ","
-            << formatCount(ask_counts[i]);
-            
-        if (i < 9) {
-            row << ",";
-        }
+    for (size_t i = 0; i < MbpSnapshot::DEPTH; ++i) {
+        *out++ = ',';
+        out = writePrice(out, snapshot.px[BID][i]);
+        *out++ = ',';
+        out = writeUInt(out, snapshot.sz[BID][i]);
+        *out++ = ',';
+        out = writeUInt(out, snapshot.ct[BID][i]);
+        *out++ = ',';
+        out = writePrice(out, snapshot.px[ASK][i]);
+        *out++ = ',';
+        out = writeUInt(out, snapshot.sz[ASK][i]);
+        *out++ = ',';
+        out = writeUInt(out, snapshot.ct[ASK][i]);
     }
     
-    row << ",ARL," << snapshot.event_order_id;
+    // Symbols are short, but cap them so a row stays within MAX_ROW_LENGTH
+    const std::string& symbol = lookupSymbol(snapshot.instrument_id);
+    size_t symbol_length = std::min<size_t>(symbol.size(), MAX_SYMBOL_LENGTH);
+    *out++ = ',';
+    std::memcpy(out, symbol.data(), symbol_length);
+    out += symbol_length;
+    *out++ = ',';
     
-    return row.str();
+    return writeUInt(out, snapshot.event_order_id);
 }
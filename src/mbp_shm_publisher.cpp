@@ -0,0 +1,183 @@
+#include "mbp_shm_publisher.h"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static size_t roundUpToPowerOfTwo(size_t value) {
+    size_t rounded = 1;
+    while (rounded < value) {
+        rounded <<= 1;
+    }
+    return rounded;
+}
+
+MbpShmPublisher::MbpShmPublisher(const std::string& name, size_t slot_count, size_t journal_capacity)
+    : name_(name), slot_count_(roundUpToPowerOfTwo(std::max<size_t>(slot_count, 1))),
+      journal_capacity_(roundUpToPowerOfTwo(std::max<size_t>(journal_capacity, 1))), symbology_(nullptr),
+      region_(nullptr), region_size_(0), header_(nullptr), slots_(nullptr), journal_(nullptr), snapshot_count_(0),
+      table_full_reported_(false) {}
+
+MbpShmPublisher::~MbpShmPublisher() {
+    close();
+}
+
+void MbpShmPublisher::setCapacity(size_t slot_count, size_t journal_capacity) {
+    slot_count_ = roundUpToPowerOfTwo(std::max<size_t>(slot_count, 1));
+    journal_capacity_ = roundUpToPowerOfTwo(std::max<size_t>(journal_capacity, 1));
+}
+
+#ifdef _WIN32
+
+bool MbpShmPublisher::initialize() {
+    std::cerr << "Error: Shared-memory output is not supported on this platform" << std::endl;
+    return false;
+}
+
+void MbpShmPublisher::close() {}
+
+bool MbpShmPublisher::removeRegion(const std::string&) {
+    return false;
+}
+
+#else
+
+bool MbpShmPublisher::initialize() {
+    if (region_) {
+        return true;
+    }
+    
+    // Readers still attached to a previous region keep their mapping of it
+    shm_unlink(name_.c_str());
+    int fd = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        std::cerr << "Error: Cannot create shared memory " << name_ << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    
+    region_size_ = mbp_shm::regionSize(slot_count_, journal_capacity_);
+    if (ftruncate(fd, static_cast<off_t>(region_size_)) != 0) {
+        std::cerr << "Error: Cannot size shared memory " << name_ << ": " << std::strerror(errno) << std::endl;
+        ::close(fd);
+        shm_unlink(name_.c_str());
+        return false;
+    }
+    void* mapping = mmap(nullptr, region_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Error: Cannot map shared memory " << name_ << ": " << std::strerror(errno) << std::endl;
+        shm_unlink(name_.c_str());
+        return false;
+    }
+    
+    // A new region reads as zeros: every slot unclaimed, the journal empty
+    region_ = mapping;
+    header_ = static_cast<mbp_shm::RegionHeader*>(region_);
+    slots_ = mbp_shm::slots(region_);
+    journal_ = mbp_shm::journal(region_, slot_count_);
+    
+    std::memcpy(header_->magic, mbp_shm::MAGIC, sizeof(header_->magic));
+    header_->version = mbp_shm::VERSION;
+    header_->snapshot_size = static_cast<uint32_t>(sizeof(MbpSnapshot));
+    header_->slot_count = static_cast<uint32_t>(slot_count_);
+    header_->journal_capacity = static_cast<uint32_t>(journal_capacity_);
+    header_->price_scale = PRICE_SCALE;
+    header_->state.store(mbp_shm::STATE_LIVE, std::memory_order_release);
+    return true;
+}
+
+void MbpShmPublisher::close() {
+    if (!region_) {
+        return;
+    }
+    header_->state.store(mbp_shm::STATE_CLOSED, std::memory_order_release);
+    munmap(region_, region_size_);
+    region_ = nullptr;
+    header_ = nullptr;
+    slots_ = nullptr;
+    journal_ = nullptr;
+}
+
+bool MbpShmPublisher::removeRegion(const std::string& name) {
+    return shm_unlink(name.c_str()) == 0;
+}
+
+#endif
+
+// Only this writer claims slots, so a probe never races another claim
+mbp_shm::Slot* MbpShmPublisher::slotFor(uint32_t instrument_id, uint32_t& slot_index) {
+    const uint64_t key = static_cast<uint64_t>(instrument_id) + 1;
+    size_t index = mbp_shm::homeSlot(instrument_id, slot_count_);
+    for (size_t probe = 0; probe < slot_count_; ++probe, index = (index + 1) & (slot_count_ - 1)) {
+        mbp_shm::Slot& slot = slots_[index];
+        uint64_t slot_key = slot.instrument_key.load(std::memory_order_relaxed);
+        if (slot_key == key) {
+            slot_index = static_cast<uint32_t>(index);
+            return &slot;
+        }
+        if (slot_key == 0) {
+            const std::string symbol = symbology_ ? symbology_->getSymbol(instrument_id) : std::string();
+            std::memset(slot.symbol, 0, sizeof(slot.symbol));
+            std::memcpy(slot.symbol, symbol.data(), std::min(symbol.size(), sizeof(slot.symbol) - 1));
+            slot.instrument_key.store(key, std::memory_order_release);
+            header_->instrument_count.fetch_add(1, std::memory_order_relaxed);
+            slot_index = static_cast<uint32_t>(index);
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+bool MbpShmPublisher::writeSnapshot(const MbpSnapshot& snapshot, uint64_t row_index) {
+    if (!region_) {
+        return false;
+    }
+    
+    uint32_t slot_index = 0;
+    mbp_shm::Slot* slot = slotFor(snapshot.instrument_id, slot_index);
+    if (!slot) {
+        if (!table_full_reported_) {
+            std::cerr << "Error: Shared memory " << name_ << " has no free slot for instrument " << snapshot.instrument_id
+                      << "; its snapshots are dropped" << std::endl;
+            table_full_reported_ = true;
+        }
+        return false;
+    }
+    
+    uint64_t words[mbp_shm::SNAPSHOT_WORDS] = {};
+    std::memcpy(words, &snapshot, sizeof(snapshot));
+    
+    // Seqlock write: odd sequence, payload, even sequence. The release fence
+    // keeps the payload stores from moving ahead of the odd sequence.
+    const uint64_t sequence = slot->sequence.load(std::memory_order_relaxed);
+    slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot->row_index.store(row_index, std::memory_order_relaxed);
+    for (size_t i = 0; i < mbp_shm::SNAPSHOT_WORDS; ++i) {
+        slot->words[i].store(words[i], std::memory_order_relaxed);
+    }
+    slot->sequence.store(sequence + 2, std::memory_order_release);
+    
+    // The journal entry is rewritten under the same scheme, with its
+    // position standing in for the sequence
+    const uint64_t position = header_->journal_head.load(std::memory_order_relaxed);
+    mbp_shm::JournalEntry& entry = journal_[position & (journal_capacity_ - 1)];
+    entry.position.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    entry.row_index.store(row_index, std::memory_order_relaxed);
+    entry.slot_sequence.store(sequence + 2, std::memory_order_relaxed);
+    entry.instrument_id.store(snapshot.instrument_id, std::memory_order_relaxed);
+    entry.slot.store(slot_index, std::memory_order_relaxed);
+    entry.position.store(position + 1, std::memory_order_release);
+    header_->journal_head.store(position + 1, std::memory_order_release);
+    
+    ++snapshot_count_;
+    return true;
+}
@@ -0,0 +1,180 @@
+#include "mbp_shm_reader.h"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MbpShmReader::MbpShmReader(const std::string& name)
+    : name_(name), region_(nullptr), region_size_(0), header_(nullptr), slots_(nullptr), journal_(nullptr), slot_count_(0),
+      journal_capacity_(0) {}
+
+MbpShmReader::~MbpShmReader() {
+    close();
+}
+
+#ifdef _WIN32
+
+bool MbpShmReader::open() {
+    std::cerr << "Error: Shared-memory input is not supported on this platform" << std::endl;
+    return false;
+}
+
+void MbpShmReader::close() {}
+
+#else
+
+bool MbpShmReader::open() {
+    close();
+    
+    int fd = shm_open(name_.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        std::cerr << "Error: Cannot open shared memory " << name_ << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(mbp_shm::RegionHeader)) {
+        std::cerr << "Error: Shared memory " << name_ << " is not a snapshot region" << std::endl;
+        ::close(fd);
+        return false;
+    }
+    
+    region_size_ = static_cast<size_t>(info.st_size);
+    void* mapping = mmap(nullptr, region_size_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Error: Cannot map shared memory " << name_ << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    region_ = mapping;
+    header_ = static_cast<const mbp_shm::RegionHeader*>(region_);
+    
+    // The header fields are only trusted once the writer has published them
+    bool valid = header_->state.load(std::memory_order_acquire) != 0 &&
+                 std::memcmp(header_->magic, mbp_shm::MAGIC, sizeof(header_->magic)) == 0 &&
+                 header_->version == mbp_shm::VERSION && header_->snapshot_size == sizeof(MbpSnapshot) &&
+                 header_->price_scale == PRICE_SCALE && header_->slot_count > 0 && header_->journal_capacity > 0 &&
+                 mbp_shm::regionSize(header_->slot_count, header_->journal_capacity) <= region_size_;
+    if (!valid) {
+        std::cerr << "Error: Shared memory " << name_ << " is not a snapshot region of this version" << std::endl;
+        close();
+        return false;
+    }
+    
+    slot_count_ = header_->slot_count;
+    journal_capacity_ = header_->journal_capacity;
+    slots_ = mbp_shm::slots(region_);
+    journal_ = mbp_shm::journal(region_, slot_count_);
+    return true;
+}
+
+void MbpShmReader::close() {
+    if (region_) {
+        munmap(region_, region_size_);
+    }
+    region_ = nullptr;
+    header_ = nullptr;
+    slots_ = nullptr;
+    journal_ = nullptr;
+    slot_count_ = 0;
+    journal_capacity_ = 0;
+}
+
+#endif
+
+bool MbpShmReader::isLive() const {
+    return header_ && header_->state.load(std::memory_order_acquire) == mbp_shm::STATE_LIVE;
+}
+
+size_t MbpShmReader::getInstrumentCount() const {
+    return header_ ? header_->instrument_count.load(std::memory_order_relaxed) : 0;
+}
+
+uint64_t MbpShmReader::getJournalHead() const {
+    return header_ ? header_->journal_head.load(std::memory_order_acquire) : 0;
+}
+
+// Slots are claimed but never released, so a probe can stop at the first
+// unclaimed one
+const mbp_shm::Slot* MbpShmReader::findSlot(uint32_t instrument_id) const {
+    const uint64_t key = static_cast<uint64_t>(instrument_id) + 1;
+    size_t index = mbp_shm::homeSlot(instrument_id, slot_count_);
+    for (size_t probe = 0; probe < slot_count_; ++probe, index = (index + 1) & (slot_count_ - 1)) {
+        uint64_t slot_key = slots_[index].instrument_key.load(std::memory_order_acquire);
+        if (slot_key == key) {
+            return &slots_[index];
+        }
+        if (slot_key == 0) {
+            return nullptr;
+        }
+    }
+    return nullptr;
+}
+
+bool MbpShmReader::readLatest(uint32_t instrument_id, MbpSnapshot& snapshot, uint64_t* row_index) const {
+    const mbp_shm::Slot* slot = region_ ? findSlot(instrument_id) : nullptr;
+    if (!slot) {
+        return false;
+    }
+    
+    uint64_t words[mbp_shm::SNAPSHOT_WORDS];
+    uint64_t row = 0;
+    for (;;) {
+        uint64_t before = slot->sequence.load(std::memory_order_acquire);
+        if (before == 0) {
+            return false;
+        }
+        if (before & 1) {
+            continue;
+        }
+        row = slot->row_index.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < mbp_shm::SNAPSHOT_WORDS; ++i) {
+            words[i] = slot->words[i].load(std::memory_order_relaxed);
+        }
+        
+        // The acquire fence keeps the payload loads ahead of the re-check
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot->sequence.load(std::memory_order_relaxed) == before) {
+            break;
+        }
+    }
+    
+    std::memcpy(&snapshot, words, sizeof(snapshot));
+    if (row_index) {
+        *row_index = row;
+    }
+    return true;
+}
+
+std::string MbpShmReader::getSymbol(uint32_t instrument_id) const {
+    const mbp_shm::Slot* slot = region_ ? findSlot(instrument_id) : nullptr;
+    if (!slot) {
+        return std::string();
+    }
+    size_t length = 0;
+    while (length < sizeof(slot->symbol) && slot->symbol[length] != '\0') {
+        ++length;
+    }
+    return std::string(slot->symbol, length);
+}
+
+bool MbpShmReader::readUpdate(uint64_t position, MbpShmUpdate& update) const {
+    if (!region_ || position >= getJournalHead()) {
+        return false;
+    }
+    
+    const mbp_shm::JournalEntry& entry = journal_[position & (journal_capacity_ - 1)];
+    if (entry.position.load(std::memory_order_acquire) != position + 1) {
+        return false;
+    }
+    update.row_index = entry.row_index.load(std::memory_order_relaxed);
+    update.slot_sequence = entry.slot_sequence.load(std::memory_order_relaxed);
+    update.instrument_id = entry.instrument_id.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return entry.position.load(std::memory_order_relaxed) == position + 1;
+}
@@ -1,16 +1,22 @@
 #include "../include/order_book.h"
 #include "mbo_parser.h"
+#include "async_logger.h"
 #include <iostream>
 #include <algorithm>
+#include <cstring>
 
-OrderBook::OrderBook() : sequence_counter_(0), trade_state_(TradeState::NORMAL), 
-                         pending_trade_side_('\0'), pending_actual_trade_side_('\0'), 
-                         pending_trade_price_(0.0), pending_trade_size_(0),
-                         last_fill_was_trade_(false) {
-    orders_.reserve(10000);
+template <template <typename> class Levels>
+BasicOrderBook<Levels>::BasicOrderBook(size_t order_capacity)
+    : bid_levels_(&arena_), ask_levels_(&arena_), orders_(order_capacity),
+      sequence_counter_(0), trade_state_(TradeState::NORMAL),
+      pending_trade_side_('\0'), pending_actual_trade_side_('\0'),
+      pending_trade_price_(0), pending_trade_size_(0),
+      last_fill_was_trade_(false) {
+    invalidateTopLevels();
 }
 
-ProcessResult OrderBook::processEvent(const MboEvent& event) {
+template <template <typename> class Levels>
+ProcessResult BasicOrderBook<Levels>::processEvent(const MboEvent& event) {
     ++sequence_counter_;
     
     switch (event.action) {
@@ -25,85 +31,83 @@ ProcessResult OrderBook::processEvent(const MboEvent& event) {
         case 'R':
             return processResetEvent(event);
         default:
-            std::cerr << "Warning: Unknown action '" << event.action << "'" << std::endl;
+            logMessage(LogMessage::UNKNOWN_ACTION, static_cast<unsigned char>(event.action));
             return {false, ' ', ' '};
     }
 }
 
-ProcessResult OrderBook::processAddEvent(const MboEvent& event) {
+template <template <typename> class Levels>
+ProcessResult BasicOrderBook<Levels>::processAddEvent(const MboEvent& event) {
     if (event.order_id == 0) {
         return {true, 'A', event.side};
     }
     
-    if (orders_.find(event.order_id) != orders_.end()) {
-        std::cerr << "Warning: Order " << event.order_id << " already exists" << std::endl;
+    // One probe both rejects duplicates and claims the slot
+    bool inserted;
+    OrderData& order_data = orders_.insert(event.order_id, inserted);
+    if (!inserted) {
+        logMessage(LogMessage::DUPLICATE_ORDER, event.order_id);
         return {false, ' ', ' '};
     }
     
-    addOrder(event.order_id, event.price, event.size, event.side);
+    placeOrder(order_data, event.order_id, event.price, event.size, event.side);
     last_fill_was_trade_ = false;
-    return {true, 'A', event.side};
+    
+    ProcessResult result = {true, 'A', event.side};
+    if (hasOrdersAtPrice(event.price, event.side)) {
+        markLevelChange(result, event.price, event.side);
+    }
+    return result;
 }
 
-ProcessResult OrderBook::processCancelEvent(const MboEvent& event) {
+template <template <typename> class Levels>
+ProcessResult BasicOrderBook<Levels>::processCancelEvent(const MboEvent& event) {
     if (event.order_id == 0) {
         return {true, 'C', event.side};
     }
-
+    
     if (last_fill_was_trade_ && trade_state_ == TradeState::EXPECTING_FILL) {
         char target_side = getOppositeSide(pending_trade_side_);
-        double trade_price = pending_trade_price_;
+        Price trade_price = pending_trade_price_;
         uint64_t trade_size = pending_trade_size_;
         
-        if (target_side == 'B') {
-            auto level_it = bid_levels_.find(trade_price);
-            if (level_it != bid_levels_.end()) {
-                fillOrdersAtLevel(level_it->second, trade_size, target_side);
-                if (level_it->second.total_size == 0) {
-                    bid_levels_.erase(level_it);
-                }
-            }
-        } else if (target_side == 'A') {
-            auto level_it = ask_levels_.find(trade_price);
-            if (level_it != ask_levels_.end()) {
-                fillOrdersAtLevel(level_it->second, trade_size, target_side);
-                if (level_it->second.total_size == 0) {
-                    ask_levels_.erase(level_it);
-                }
-            }
+        ProcessResult result = {true, 'T', pending_actual_trade_side_};
+        if (trade_size > 0 && hasOrdersAtPrice(trade_price, target_side)) {
+            markLevelChange(result, trade_price, target_side);
         }
         
-        char filled_side = pending_actual_trade_side_;
+        fillOrdersAtPrice(trade_price, trade_size, target_side);
         
         trade_state_ = TradeState::NORMAL;
         pending_trade_side_ = '\0';
         pending_actual_trade_side_ = '\0';
-        pending_trade_price_ = 0.0;
+        pending_trade_price_ = 0;
         pending_trade_size_ = 0;
         last_fill_was_trade_ = false;
         
-        return {true, 'T', filled_side};
+        return result;
     }
     
-    auto it = orders_.find(event.order_id);
-    if (it == orders_.end()) {
+    // The entry found here is cancelled in place, so a cancel costs one probe
+    OrderData* order = orders_.find(event.order_id);
+    if (!order) {
         return {true, 'C', 'N'};
     }
     
-    char side = it->second.side;
-    
-    uint64_t cancel_size = event.size;
+    char side = order->side;
     
-    if (cancel_size == 0) {
-        cancelOrder(event.order_id);
-    } else {
-        cancelOrder(event.order_id, cancel_size);
+    ProcessResult result = {true, 'C', side};
+    if (hasOrdersAtPrice(order->price, side)) {
+        markLevelChange(result, order->price, side);
     }
     
-    return {true, 'C', side};
+    cancelOrder(order, event.size);
+    
+    return result;
 }
 
-ProcessResult OrderBook::processTradeEvent(const MboEvent& event) {
+template <template <typename> class Levels>
+ProcessResult BasicOrderBook<Levels>::processTradeEvent(const MboEvent& event) {
     if (event.side == 'N') {
         return {true, 'T', 'N'};
     }
@@ -116,9 +120,10 @@ ProcessResult OrderBook::processTradeEvent(const MboEvent& event) {
     return {false, 'T', event.side};
 }
 
-ProcessResult OrderBook::processFillEvent(const MboEvent& event) {
+template <template <typename> class Levels>
+ProcessResult BasicOrderBook<Levels>::processFillEvent(const MboEvent& event) {
     if (trade_state_ != TradeState::EXPECTING_FILL) {
-        std::cerr << "Warning: Unexpected fill event" << std::endl;
+        logMessage(LogMessage::UNEXPECTED_FILL);
         return {false, ' ', ' '};
     }
     
@@ -129,123 +134,114 @@ ProcessResult OrderBook::processFillEvent(const MboEvent& event) {
     return {false, ' ', ' '};
 }
 
-ProcessResult OrderBook::processResetEvent(const MboEvent& event) {
+template <template <typename> class Levels>
+ProcessResult BasicOrderBook<Levels>::processResetEvent(const MboEvent& event) {
+    bool had_levels = !bid_levels_.empty() || !ask_levels_.empty();
     clear();
-    return {true, 'R', 'N'};
+    return {true, 'R', 'N', had_levels, 0};
 }
 
-void OrderBook::addOrder(uint64_t order_id, double price, uint64_t size, char side) {
-    OrderData order_data(price, size, side);
-    orders_[order_id] = order_data;
-    
-    if (side == 'B') {
-        updateBidLevel(price, static_cast<int64_t>(size), 1, order_id);
-        
-        auto level_it = bid_levels_.find(price);
-        if (level_it != bid_levels_.end()) {
-            orders_[order_id].level_iterator = &(*level_it);
-        }
-    } else if (side == 'A') {
-        updateAskLevel(price, static_cast<int64_t>(size), 1, order_id);
-        
-        auto level_it = ask_levels_.find(price);
-        if (level_it != ask_levels_.end()) {
-            orders_[order_id].level_iterator = &(*level_it);
-        }
+template <template <typename> class Levels>
+bool BasicOrderBook<Levels>::addOrder(uint64_t order_id, Price price, uint64_t size, char side) {
+    bool inserted;
+    OrderData& order_data = orders_.insert(order_id, inserted);
+    if (!inserted) {
+        logMessage(LogMessage::DUPLICATE_ORDER, order_id);
+        return false;
     }
+    placeOrder(order_data, order_id, price, size, side);
+    return true;
 }
 
-void OrderBook::cancelOrder(uint64_t order_id, uint64_t cancel_size) {
-    auto it = orders_.find(order_id);
-    if (it == orders_.end()) {
-        return;
-    }
+template <template <typename> class Levels>
+void BasicOrderBook<Levels>::placeOrder(OrderData& order_data, uint64_t order_id, Price price, uint64_t size, char side) {
+    order_data = OrderData(price, size, side);
+    order_data.node = node_pool_.acquire(order_id, size);
     
-    OrderData& order = it->second;
+    OrderNode* node = order_data.node;
+    withSide(side, [&](auto& levels) { updateLevel(levels, price, static_cast<int64_t>(size), 1, node); });
+}
+
+template <template <typename> class Levels>
+void BasicOrderBook<Levels>::cancelOrder(OrderData* found, uint64_t cancel_size) {
+    OrderData& order = *found;
     uint64_t actual_cancel_size = (cancel_size == 0) ? order.size : std::min(cancel_size, order.size);
     
-    // Update price levels - reduce size but don't change order count yet
-    if (order.side == 'B') {
-        updateBidLevel(order.price, -static_cast<int64_t>(actual_cancel_size), 0, 0);
-        // Also update the order in the queue
-        updateOrderInQueue(bid_levels_[order.price], order_id, actual_cancel_size);
-    } else if (order.side == 'A') {
-        updateAskLevel(order.price, -static_cast<int64_t>(actual_cancel_size), 0, 0);
-        // Also update the order in the queue
-        updateOrderInQueue(ask_levels_[order.price], order_id, actual_cancel_size);
-    }
-    
-    // Update order size
+    // Shrink the order in place; a partially cancelled order keeps its queue position
     order.size -= actual_cancel_size;
+    order.node->size = order.size;
+    
+    withSide(order.side, [&](auto& levels) {
+        constexpr size_t Index = sideIndex<std::decay_t<decltype(levels)>>();
+        if (LevelData* level = levels.find(order.price)) {
+            reduceOrderAtLevel(*level, order, actual_cancel_size);
+            if (level->total_size == 0 || level->order_count == 0) {
+                levels.erase(order.price);
+                topLevelRemoved<Index>(levels, order.price);
+            } else {
+                topLevelChanged<Index>(*level);
+            }
+        }
+    });
     
     // If order size becomes zero, remove the order completely
     if (order.size == 0) {
-        // Decrement order count at the price level
-        if (order.side == 'B') {
-            updateBidLevel(order.price, 0, -1, 0);
-        } else if (order.side == 'A') {
-            updateAskLevel(order.price, 0, -1, 0);
-        }
-        
-        // Remove from orders map
-        orders_.erase(it);
+        node_pool_.release(order.node);
+        orders_.eraseFound(found);
     }
 }
 
-void OrderBook::updateBidLevel(double price, int64_t size_delta, int32_t count_delta, uint64_t order_id) {
-    auto it = bid_levels_.find(price);
+template <template <typename> class Levels>
+template <typename Side>
+void BasicOrderBook<Levels>::updateLevel(Side& levels, Price price, int64_t size_delta, int32_t count_delta, OrderNode* node) {
+    constexpr size_t Index = sideIndex<Side>();
+    LevelData* level = levels.find(price);
     
-    if (it == bid_levels_.end()) {
+    if (!level) {
         if (size_delta > 0) {
-            bid_levels_[price] = LevelData(price, static_cast<uint64_t>(size_delta), order_id);
-            bid_levels_[price].order_count = static_cast<uint32_t>(count_delta);
+            LevelData& new_level = levels.insert(price);
+            new_level = LevelData(price);
+            new_level.total_size = static_cast<uint64_t>(size_delta);
+            new_level.order_count = static_cast<uint32_t>(count_delta);
+            if (node) {
+                new_level.order_queue.pushBack(node);
+            }
+            topLevelInserted<Index>(new_level);
         }
     } else {
-        it->second.total_size = static_cast<uint64_t>(
-            static_cast<int64_t>(it->second.total_size) + size_delta);
-        it->second.order_count = static_cast<uint32_t>(
-            static_cast<int32_t>(it->second.order_count) + count_delta);
+        level->total_size = static_cast<uint64_t>(
+            static_cast<int64_t>(level->total_size) + size_delta);
+        level->order_count = static_cast<uint32_t>(
+            static_cast<int32_t>(level->order_count) + count_delta);
         
-        if (count_delta > 0 && order_id != 0) {
-            it->second.order_queue.emplace(order_id, static_cast<uint64_t>(size_delta));
+        if (count_delta > 0 && node) {
+            level->order_queue.pushBack(node);
         }
         
-        if (it->second.total_size == 0 || it->second.order_count == 0) {
-            bid_levels_.erase(it);
+        if (level->total_size == 0 || level->order_count == 0) {
+            levels.erase(price);
+            topLevelRemoved<Index>(levels, price);
+        } else {
+            topLevelChanged<Index>(*level);
         }
     }
 }
 
-void OrderBook::updateAskLevel(double price, int64_t size_delta, int32_t count_delta, uint64_t order_id) {
-    auto it = ask_levels_.find(price);
-    
-    if (it == ask_levels_.end()) {
-        if (size_delta > 0) {
-            ask_levels_[price] = LevelData(price, static_cast<uint64_t>(size_delta), order_id);
-            ask_levels_[price].order_count = static_cast<uint32_t>(count_delta);
-        }
-    } else {
-        it->second.total_size = static_cast<uint64_t>(
-            static_cast<int64_t>(it->second.total_size) + size_delta);
-        it->second.order_count = static_cast<uint32_t>(
-            static_cast<int32_t>(it->second.order_count) + count_delta);
-        
-        if (count_delta > 0 && order_id != 0) {
-            it->second.order_queue.emplace(order_id, static_cast<uint64_t>(size_delta));
-        }
-        
-        if (it->second.total_size == 0 || it->second.order_count == 0) {
-            ask_levels_.erase(it);
-        }
-    }
+template <template <typename> class Levels>
+MbpSnapshot BasicOrderBook<Levels>::generateSnapshot(const MboEvent& event) const {
+    return generateDepthSnapshot<SNAPSHOT_DEPTH>(event);
 }
 
-MbpSnapshot OrderBook::generateSnapshot(const MboEvent& event) const {
-    MbpSnapshot snapshot;
+template <template <typename> class Levels>
+template <size_t N>
+BasicMbpSnapshot<N> BasicOrderBook<Levels>::generateDepthSnapshot(const MboEvent& event) const {
+    BasicMbpSnapshot<N> snapshot;
     snapshot.sequence_number = event.sequence;
     snapshot.action = event.action;
     snapshot.side = event.side;
     snapshot.timestamp = event.ts_event;
+    snapshot.publisher_id = event.publisher_id;
+    snapshot.instrument_id = event.instrument_id;
     
     snapshot.event_price = event.price;
     snapshot.event_size = event.size;
@@ -253,126 +249,273 @@ MbpSnapshot OrderBook::generateSnapshot(const MboEvent& event) const {
     snapshot.event_flags = event.flags;
     snapshot.event_ts_in_delta = event.ts_in_delta;
     
-    double* bid_prices[] = {&snapshot.bid_px_00, &snapshot.bid_px_01, &snapshot.bid_px_02, &snapshot.bid_px_03, &snapshot.bid_px_04,
-                           &snapshot.bid_px_05, &snapshot.bid_px_06, &snapshot.bid_px_07, &snapshot.bid_px_08, &snapshot.bid_px_09};
-    
-    uint64_t* bid_sizes[] = {&snapshot.bid_sz_00, &snapshot.bid_sz_01, &snapshot.bid_sz_02, &snapshot.bid_sz_03, &snapshot.bid_sz_04,
-                            &snapshot.bid_sz_05, &snapshot.bid_sz_06, &snapshot.bid_sz_07, &snapshot.bid_sz_08, &snapshot.bid_sz_09};
-    
-    uint32_t* bid_counts[] = {&snapshot.bid_ct_00, &snapshot.bid_ct_01, &snapshot.bid_ct_02, &snapshot.bid_ct_03, &snapshot.bid_ct_04,
-                             &snapshot.bid_ct_05, &snapshot.bid_ct_06, &snapshot.bid_ct_07, &snapshot.bid_ct_08, &snapshot.bid_ct_09};
-    
-    double* ask_prices[] = {&snapshot.ask_px_00, &snapshot.ask_px_01, &snapshot.ask_px_02, &snapshot.ask_px_03, &snapshot.ask_px_04,
-                           &snapshot.ask_px_05, &snapshot.ask_px_06, &snapshot.ask_px_07, &snapshot.ask_px_08, &snapshot.ask_px_09};
-    
-    uint64_t* ask_sizes[] = {&snapshot.ask_sz_00, &snapshot.ask_sz_01, &snapshot.ask_sz_02, &snapshot.ask_sz_03, &snapshot.ask_sz_04,
-                            &snapshot.ask_sz_05, &snapshot.ask_sz_06, &snapshot.ask_sz_07, &snapshot.ask_sz_08, &snapshot.ask_sz_09};
-    
-    uint32_t* ask_counts[] = {&snapshot.ask_ct_00, &snapshot.ask_ct_01, &snapshot.ask_ct_02, &snapshot.ask_ct_03, &snapshot.ask_ct_04,
-                             &snapshot.ask_ct_05, &snapshot.ask_ct_06, &snapshot.ask_ct_07, &snapshot.ask_ct_08, &snapshot.ask_ct_09};
-    
-    auto bid_it = bid_levels_.begin();
-    for (int i = 0; i < 10; ++i) {
-        if (bid_it != bid_levels_.end()) {
-            *bid_prices[i] = bid_it->second.price;
-            *bid_sizes[i] = bid_it->second.total_size;
-            *bid_counts[i] = bid_it->second.order_count;
-            ++bid_it;
-        } else {
-            break;
-        }
+    captureLevels(snapshot.levels());
+    return snapshot;
+}
+
+template <size_t Index, size_t N, typename Side>
+static void captureSide(const Side& side, DepthLevels<N>& levels) {
+    size_t index = 0;
+    side.forEachLevel(N, [&](const LevelData& level) {
+        levels.px[Index][index] = level.price;
+        levels.sz[Index][index] = level.total_size;
+        levels.ct[Index][index] = level.order_count;
+        ++index;
+    });
+}
+
+// Bids run highest to lowest price, asks lowest to highest; levels past the
+// end of a side stay zero
+template <template <typename> class Levels>
+template <size_t N>
+void BasicOrderBook<Levels>::captureLevels(DepthLevels<N>& levels) const {
+    if constexpr (N == SNAPSHOT_DEPTH) {
+        refreshTopLevels();
+        levels = top_levels_;
+    } else {
+        captureSide<BID>(bid_levels_, levels);
+        captureSide<ASK>(ask_levels_, levels);
     }
-    
-    auto ask_it = ask_levels_.begin();
-    for (int i = 0; i < 10; ++i) {
-        if (ask_it != ask_levels_.end()) {
-            *ask_prices[i] = ask_it->second.price;
-            *ask_sizes[i] = ask_it->second.total_size;
-            *ask_counts[i] = ask_it->second.order_count;
-            ++ask_it;
-        } else {
-            break;
-        }
+}
+
+// Walks again only the sides whose window could not be kept up to date
+template <template <typename> class Levels>
+void BasicOrderBook<Levels>::refreshTopLevels() const {
+    if (!top_valid_[BID]) {
+        std::memset(top_levels_.px[BID], 0, sizeof(top_levels_.px[BID]));
+        std::memset(top_levels_.sz[BID], 0, sizeof(top_levels_.sz[BID]));
+        std::memset(top_levels_.ct[BID], 0, sizeof(top_levels_.ct[BID]));
+        captureSide<BID>(bid_levels_, top_levels_);
+        top_count_[BID] = std::min(bid_levels_.size(), SNAPSHOT_DEPTH);
+        top_valid_[BID] = true;
+    }
+    if (!top_valid_[ASK]) {
+        std::memset(top_levels_.px[ASK], 0, sizeof(top_levels_.px[ASK]));
+        std::memset(top_levels_.sz[ASK], 0, sizeof(top_levels_.sz[ASK]));
+        std::memset(top_levels_.ct[ASK], 0, sizeof(top_levels_.ct[ASK]));
+        captureSide<ASK>(ask_levels_, top_levels_);
+        top_count_[ASK] = std::min(ask_levels_.size(), SNAPSHOT_DEPTH);
+        top_valid_[ASK] = true;
     }
-    
-    return snapshot;
 }
 
-MbpSnapshot OrderBook::generateSnapshot(char action, char side) const {
+template <template <typename> class Levels>
+MbpSnapshot BasicOrderBook<Levels>::generateSnapshot(char action, char side) const {
     MboEvent dummy_event;
     dummy_event.action = action;
     dummy_event.side = side;
     dummy_event.ts_event = std::chrono::duration_cast<std::chrono::nanoseconds>(
         std::chrono::high_resolution_clock::now().time_since_epoch());
-    dummy_event.price = 0.0;
+    dummy_event.price = 0;
     dummy_event.size = 0;
     dummy_event.order_id = 0;
     
     return generateSnapshot(dummy_event);
 }
 
-void OrderBook::clear() {
+template <template <typename> class Levels>
+AllocationStats BasicOrderBook<Levels>::getAllocationStats() const {
+    AllocationStats stats = arena_.getStats();
+    stats.chunk_allocations += node_pool_.getChunkCount();
+    stats.large_allocations += orders_.getAllocationCount();
+    return stats;
+}
+
+template <template <typename> class Levels>
+void BasicOrderBook<Levels>::clear() {
     bid_levels_.clear();
     ask_levels_.clear();
+    invalidateTopLevels();
     orders_.clear();
+    node_pool_.clear();
+    arena_.reset();
     
     trade_state_ = TradeState::NORMAL;
     pending_trade_side_ = '\0';
     pending_actual_trade_side_ = '\0';
-    pending_trade_price_ = 0.0;
+    pending_trade_price_ = 0;
     pending_trade_size_ = 0;
     last_fill_was_trade_ = false;
 }
 
-void OrderBook::processTradeFill(char trade_side, double price, uint64_t size) {
-    char target_side = getOppositeSide(trade_side);
+// Levels go out best first, each with its totals and the ids of its queue
+// front to back; the totals are kept as they are rather than recomputed
+template <typename Side>
+static void saveLevels(checkpoint::Writer& out, const Side& levels) {
+    out.put(static_cast<uint64_t>(levels.size()));
+    levels.forEachLevel(levels.size(), [&](const LevelData& level) {
+        uint64_t queued = 0;
+        for (const OrderNode* node = level.order_queue.front(); node; node = node->next) {
+            ++queued;
+        }
+        
+        out.put(level.price);
+        out.put(level.total_size);
+        out.put(level.order_count);
+        out.put(queued);
+        for (const OrderNode* node = level.order_queue.front(); node; node = node->next) {
+            out.put(node->order_id);
+        }
+    });
+}
+
+template <template <typename> class Levels>
+void BasicOrderBook<Levels>::saveState(checkpoint::Writer& out) const {
+    out.put(sequence_counter_);
+    out.put(static_cast<uint8_t>(trade_state_));
+    out.put(pending_trade_side_);
+    out.put(pending_actual_trade_side_);
+    out.put(pending_trade_price_);
+    out.put(pending_trade_size_);
+    out.put(static_cast<uint8_t>(last_fill_was_trade_));
+    
+    out.put(static_cast<uint64_t>(orders_.size()));
+    orders_.forEach([&](uint64_t order_id, const OrderData& order) {
+        out.put(order_id);
+        out.put(order.price);
+        out.put(order.size);
+        out.put(order.side);
+    });
+    
+    saveLevels(out, bid_levels_);
+    saveLevels(out, ask_levels_);
+}
+
+template <template <typename> class Levels>
+bool BasicOrderBook<Levels>::loadState(checkpoint::Reader& in) {
+    clear();
     
-    if (target_side == 'B') {
-        auto level_it = bid_levels_.find(price);
-        if (level_it != bid_levels_.end()) {
-            fillOrdersAtLevel(level_it->second, size, target_side);
-            if (level_it->second.total_size == 0) {
-                bid_levels_.erase(level_it);
+    uint8_t trade_state = 0;
+    uint8_t last_fill_was_trade = 0;
+    uint64_t order_count = 0;
+    in.get(sequence_counter_);
+    in.get(trade_state);
+    in.get(pending_trade_side_);
+    in.get(pending_actual_trade_side_);
+    in.get(pending_trade_price_);
+    in.get(pending_trade_size_);
+    in.get(last_fill_was_trade);
+    in.get(order_count);
+    
+    // A count the rest of the stream cannot hold is corrupt; rejecting it
+    // here keeps a bad count from reserving the table
+    constexpr uint64_t ORDER_RECORD_SIZE = sizeof(uint64_t) + sizeof(Price) + sizeof(uint64_t) + sizeof(char);
+    uint64_t bytes_left = in.ok() ? in.remaining() : 0;
+    bool valid = in.ok() && trade_state <= static_cast<uint8_t>(TradeState::EXPECTING_FILL) &&
+                 (bytes_left == checkpoint::Reader::UNKNOWN_SIZE || order_count <= bytes_left / ORDER_RECORD_SIZE);
+    trade_state_ = static_cast<TradeState>(trade_state);
+    last_fill_was_trade_ = last_fill_was_trade != 0;
+    
+    // Every order gets its node up front; the level queues then link them.
+    // Without a known stream size the table grows as orders are read.
+    if (valid && bytes_left != checkpoint::Reader::UNKNOWN_SIZE) {
+        orders_.reserve(static_cast<size_t>(order_count));
+    }
+    for (uint64_t i = 0; valid && i < order_count; ++i) {
+        uint64_t order_id = 0;
+        Price price = 0;
+        uint64_t size = 0;
+        char side = '\0';
+        in.get(order_id);
+        in.get(price);
+        in.get(size);
+        in.get(side);
+        
+        bool inserted = false;
+        valid = in.ok();
+        if (valid) {
+            OrderData& order = orders_.insert(order_id, inserted);
+            valid = inserted;
+            if (valid) {
+                order = OrderData(price, size, side);
+                order.node = node_pool_.acquire(order_id, size);
             }
         }
-    } else if (target_side == 'A') {
-        auto level_it = ask_levels_.find(price);
-        if (level_it != ask_levels_.end()) {
-            fillOrdersAtLevel(level_it->second, size, target_side);
-            if (level_it->second.total_size == 0) {
-                ask_levels_.erase(level_it);
+    }
+    
+    if (!valid || !loadLevels(in, bid_levels_) || !loadLevels(in, ask_levels_)) {
+        std::cerr << "Error: Corrupt order book checkpoint" << std::endl;
+        clear();
+        return false;
+    }
+    invalidateTopLevels();
+    return true;
+}
+
+template <template <typename> class Levels>
+template <typename Side>
+bool BasicOrderBook<Levels>::loadLevels(checkpoint::Reader& in, Side& levels) {
+    uint64_t level_count = 0;
+    if (!in.get(level_count)) {
+        return false;
+    }
+    
+    for (uint64_t i = 0; i < level_count; ++i) {
+        Price price = 0;
+        uint64_t total_size = 0;
+        uint32_t order_count = 0;
+        uint64_t queued = 0;
+        in.get(price);
+        in.get(total_size);
+        in.get(order_count);
+        if (!in.get(queued) || total_size == 0 || levels.find(price)) {
+            return false;
+        }
+        
+        LevelData& level = levels.insert(price);
+        level = LevelData(price);
+        level.total_size = total_size;
+        level.order_count = order_count;
+        
+        for (uint64_t q = 0; q < queued; ++q) {
+            uint64_t order_id = 0;
+            if (!in.get(order_id)) {
+                return false;
+            }
+            OrderData* order = orders_.find(order_id);
+            if (!order || order->price != price || level.order_queue.contains(order->node)) {
+                return false;
             }
+            level.order_queue.pushBack(order->node);
         }
     }
+    return true;
+}
+
+template <template <typename> class Levels>
+void BasicOrderBook<Levels>::processTradeFill(char trade_side, Price price, uint64_t size) {
+    fillOrdersAtPrice(price, size, getOppositeSide(trade_side));
 }
 
-char OrderBook::getOppositeSide(char side) const {
+template <template <typename> class Levels>
+char BasicOrderBook<Levels>::getOppositeSide(char side) const {
     if (side == 'B') return 'A';
     if (side == 'A') return 'B';
     return '\0';
 }
 
-void OrderBook::fillOrdersAtLevel(LevelData& level, uint64_t fill_size, char side) {
+template <template <typename> class Levels>
+void BasicOrderBook<Levels>::fillOrdersAtLevel(LevelData& level, uint64_t fill_size) {
     uint64_t remaining_fill = fill_size;
     
     while (remaining_fill > 0 && !level.order_queue.empty()) {
-        OrderEntry& front_order = level.order_queue.front();
+        OrderNode* front_order = level.order_queue.front();
         
-        if (front_order.size <= remaining_fill) {
-            remaining_fill -= front_order.size;
-            level.total_size -= front_order.size;
+        if (front_order->size <= remaining_fill) {
+            remaining_fill -= front_order->size;
+            level.total_size -= front_order->size;
             level.order_count--;
             
-            orders_.erase(front_order.order_id);
+            orders_.erase(front_order->order_id);
             
-            level.order_queue.pop();
+            level.order_queue.unlink(front_order);
+            node_pool_.release(front_order);
         } else {
-            front_order.size -= remaining_fill;
+            front_order->size -= remaining_fill;
             level.total_size -= remaining_fill;
             
-            auto order_it = orders_.find(front_order.order_id);
-            if (order_it != orders_.end()) {
-                order_it->second.size = front_order.size;
+            if (OrderData* order = orders_.find(front_order->order_id)) {
+                order->size = front_order->size;
             }
             
             remaining_fill = 0;
@@ -380,106 +523,203 @@ void OrderBook::fillOrdersAtLevel(LevelData& level, uint64_t fill_size, char sid
     }
 }
 
-void OrderBook::updateOrderInQueue(LevelData& level, uint64_t order_id, uint64_t cancel_size) {
-    std::queue<OrderEntry> new_queue;
-    bool order_found = false;
+template <template <typename> class Levels>
+void BasicOrderBook<Levels>::reduceOrderAtLevel(LevelData& level, const OrderData& order, uint64_t cancel_size) {
+    level.total_size -= cancel_size;
     
-    while (!level.order_queue.empty()) {
-        OrderEntry entry = level.order_queue.front();
-        level.order_queue.pop();
-        
-        if (entry.order_id == order_id) {
-            order_found = true;
-            if (entry.size > cancel_size) {
-                entry.size -= cancel_size;
-                new_queue.push(entry);
-            }
-        } else {
-            new_queue.push(entry);
+    if (order.size == 0) {
+        level.order_count--;
+        if (level.order_queue.contains(order.node)) {
+            level.order_queue.unlink(order.node);
         }
     }
-    
-    level.order_queue = new_queue;
 }
 
-std::pair<double, double> OrderBook::getBestBidAsk() const {
-    double best_bid = 0.0;
-    double best_ask = 0.0;
+template <template <typename> class Levels>
+std::pair<Price, Price> BasicOrderBook<Levels>::getBestBidAsk() const {
+    Price best_bid = 0;
+    Price best_ask = 0;
     
-    if (!bid_levels_.empty()) {
-        best_bid = bid_levels_.begin()->first;
+    if (const LevelData* best = bid_levels_.best()) {
+        best_bid = best->price;
     }
     
-    if (!ask_levels_.empty()) {
-        best_ask = ask_levels_.begin()->first;
+    if (const LevelData* best = ask_levels_.best()) {
+        best_ask = best->price;
     }
     
     return std::make_pair(best_bid, best_ask);
 }
 
-double OrderBook::getBestBidPrice() const {
-    if (!bid_levels_.empty()) {
-        return bid_levels_.begin()->first;
+template <template <typename> class Levels>
+Price BasicOrderBook<Levels>::getBestBidPrice() const {
+    if (const LevelData* best = bid_levels_.best()) {
+        return best->price;
     }
-    return 0.0;
+    return 0;
 }
 
-double OrderBook::getBestAskPrice() const {
-    if (!ask_levels_.empty()) {
-        return ask_levels_.begin()->first;
+template <template <typename> class Levels>
+Price BasicOrderBook<Levels>::getBestAskPrice() const {
+    if (const LevelData* best = ask_levels_.best()) {
+        return best->price;
     }
-    return 0.0;
+    return 0;
 }
 
-bool OrderBook::hasOrdersAtPrice(double price, char side) const {
-    if (side == 'B') {
-        auto it = bid_levels_.find(price);
-        return it != bid_levels_.end() && it->second.total_size > 0;
-    } else if (side == 'A') {
-        auto it = ask_levels_.find(price);
-        return it != ask_levels_.end() && it->second.total_size > 0;
-    }
-    return false;
+template <template <typename> class Levels>
+bool BasicOrderBook<Levels>::hasOrdersAtPrice(Price price, char side) const {
+    bool has_orders = false;
+    withSide(side, [&](const auto& levels) {
+        const LevelData* level = levels.find(price);
+        has_orders = level && level->total_size > 0;
+    });
+    return has_orders;
 }
 
-void OrderBook::fillOrdersAtPrice(double price, uint64_t size, char side) {
-    if (side == 'B') {
-        auto it = bid_levels_.find(price);
-        if (it != bid_levels_.end()) {
-            fillOrdersAtLevel(it->second, size, side);
-            if (it->second.total_size == 0) {
-                bid_levels_.erase(it);
-            }
-        }
-    } else if (side == 'A') {
-        auto it = ask_levels_.find(price);
-        if (it != ask_levels_.end()) {
-            fillOrdersAtLevel(it->second, size, side);
-            if (it->second.total_size == 0) {
-                ask_levels_.erase(it);
-            }
+template <template <typename> class Levels>
+int32_t BasicOrderBook<Levels>::getLevelDepth(Price price, char side) const {
+    int32_t depth = 0;
+    withSide(side, [&](const auto& levels) { depth = static_cast<int32_t>(levels.rank(price, SNAPSHOT_DEPTH)); });
+    return depth;
+}
+
+// Levels better than price are unaffected by an update at price, so its
+// rank is the same before and after the update. Only a level ranked inside
+// the snapshot depth can change the snapshot.
+template <template <typename> class Levels>
+void BasicOrderBook<Levels>::markLevelChange(ProcessResult& result, Price price, char side) const {
+    result.depth = getLevelDepth(price, side);
+    result.top_changed = result.depth < static_cast<int32_t>(SNAPSHOT_DEPTH);
+}
+
+template <template <typename> class Levels>
+void BasicOrderBook<Levels>::fillOrdersAtPrice(Price price, uint64_t size, char side) {
+    withSide(side, [&](auto& levels) { fillLevel(levels, price, size); });
+}
+
+template <template <typename> class Levels>
+template <typename Side>
+void BasicOrderBook<Levels>::fillLevel(Side& levels, Price price, uint64_t size) {
+    constexpr size_t Index = sideIndex<Side>();
+    if (LevelData* level = levels.find(price)) {
+        fillOrdersAtLevel(*level, size);
+        if (level->total_size == 0) {
+            levels.erase(price);
+            topLevelRemoved<Index>(levels, price);
+        } else {
+            topLevelChanged<Index>(*level);
         }
     }
 }
 
-Top10State OrderBook::captureTop10State() const {
-    Top10State state;
-    
-    // Capture bid levels (highest to lowest price)
-    int bid_index = 0;
-    for (auto it = bid_levels_.begin(); it != bid_levels_.end() && bid_index < 10; ++it, ++bid_index) {
-        state.bid_prices[bid_index] = it->first;
-        state.bid_sizes[bid_index] = it->second.total_size;
-        state.bid_counts[bid_index] = it->second.order_count;
+// Whether price a ranks ahead of price b on side Index
+template <size_t Index>
+static bool isBetter(Price a, Price b) {
+    return Index == BID ? a > b : a < b;
+}
+
+template <template <typename> class Levels>
+template <size_t Index>
+void BasicOrderBook<Levels>::topLevelInserted(const LevelData& level) {
+    if (!top_valid_[Index]) {
+        return;
+    }
+    size_t count = top_count_[Index];
+    size_t slot = 0;
+    while (slot < count && !isBetter<Index>(level.price, top_levels_.px[Index][slot])) {
+        ++slot;
+    }
+    if (slot == SNAPSHOT_DEPTH) {
+        return;
     }
     
-    // Capture ask levels (lowest to highest price)
-    int ask_index = 0;
-    for (auto it = ask_levels_.begin(); it != ask_levels_.end() && ask_index < 10; ++it, ++ask_index) {
-        state.ask_prices[ask_index] = it->first;
-        state.ask_sizes[ask_index] = it->second.total_size;
-        state.ask_counts[ask_index] = it->second.order_count;
+    // Levels below slot move down one, and the last one falls off
+    size_t last = std::min(count, SNAPSHOT_DEPTH - 1);
+    for (size_t i = last; i > slot; --i) {
+        top_levels_.px[Index][i] = top_levels_.px[Index][i - 1];
+        top_levels_.sz[Index][i] = top_levels_.sz[Index][i - 1];
+        top_levels_.ct[Index][i] = top_levels_.ct[Index][i - 1];
+    }
+    top_levels_.px[Index][slot] = level.price;
+    top_levels_.sz[Index][slot] = level.total_size;
+    top_levels_.ct[Index][slot] = level.order_count;
+    top_count_[Index] = last + 1;
+}
+
+template <template <typename> class Levels>
+template <size_t Index>
+void BasicOrderBook<Levels>::topLevelChanged(const LevelData& level) {
+    if (!top_valid_[Index]) {
+        return;
+    }
+    for (size_t slot = 0; slot < top_count_[Index]; ++slot) {
+        if (top_levels_.px[Index][slot] == level.price) {
+            top_levels_.sz[Index][slot] = level.total_size;
+            top_levels_.ct[Index][slot] = level.order_count;
+            return;
+        }
+    }
+}
+
+template <template <typename> class Levels>
+template <size_t Index, typename Side>
+void BasicOrderBook<Levels>::topLevelRemoved(const Side& levels, Price price) {
+    if (!top_valid_[Index]) {
+        return;
+    }
+    size_t count = top_count_[Index];
+    size_t slot = 0;
+    while (slot < count && top_levels_.px[Index][slot] != price) {
+        ++slot;
+    }
+    if (slot == count) {
+        return;
     }
     
+    // Levels below slot move up one; if the side is deeper than the
+    // window, its next level has to come from the book itself
+    if (levels.size() >= SNAPSHOT_DEPTH) {
+        top_valid_[Index] = false;
+        return;
+    }
+    for (size_t i = slot + 1; i < count; ++i) {
+        top_levels_.px[Index][i - 1] = top_levels_.px[Index][i];
+        top_levels_.sz[Index][i - 1] = top_levels_.sz[Index][i];
+        top_levels_.ct[Index][i - 1] = top_levels_.ct[Index][i];
+    }
+    top_levels_.px[Index][count - 1] = 0;
+    top_levels_.sz[Index][count - 1] = 0;
+    top_levels_.ct[Index][count - 1] = 0;
+    top_count_[Index] = count - 1;
+}
+
+template <template <typename> class Levels>
+void BasicOrderBook<Levels>::invalidateTopLevels() {
+    top_valid_[BID] = false;
+    top_valid_[ASK] = false;
+}
+
+template <template <typename> class Levels>
+Top10State BasicOrderBook<Levels>::captureTop10State() const {
+    Top10State state;
+    captureLevels(state);
     return state;
 }
+
+template class BasicOrderBook<MapPriceLevels>;
+template class BasicOrderBook<LadderPriceLevels>;
+
+template BasicMbpSnapshot<1> BasicOrderBook<MapPriceLevels>::generateDepthSnapshot<1>(const MboEvent&) const;
+template BasicMbpSnapshot<10> BasicOrderBook<MapPriceLevels>::generateDepthSnapshot<10>(const MboEvent&) const;
+template BasicMbpSnapshot<50> BasicOrderBook<MapPriceLevels>::generateDepthSnapshot<50>(const MboEvent&) const;
+template void BasicOrderBook<MapPriceLevels>::captureLevels<1>(DepthLevels<1>&) const;
+template void BasicOrderBook<MapPriceLevels>::captureLevels<10>(DepthLevels<10>&) const;
+template void BasicOrderBook<MapPriceLevels>::captureLevels<50>(DepthLevels<50>&) const;
+
+template BasicMbpSnapshot<1> BasicOrderBook<LadderPriceLevels>::generateDepthSnapshot<1>(const MboEvent&) const;
+template BasicMbpSnapshot<10> BasicOrderBook<LadderPriceLevels>::generateDepthSnapshot<10>(const MboEvent&) const;
+template BasicMbpSnapshot<50> BasicOrderBook<LadderPriceLevels>::generateDepthSnapshot<50>(const MboEvent&) const;
+template void BasicOrderBook<LadderPriceLevels>::captureLevels<1>(DepthLevels<1>&) const;
+template void BasicOrderBook<LadderPriceLevels>::captureLevels<10>(DepthLevels<10>&) const;
+template void BasicOrderBook<LadderPriceLevels>::captureLevels<50>(DepthLevels<50>&) const;
@@ -0,0 +1,152 @@
+#include "packet_receiver.h"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+UdpMulticastReceiver::UdpMulticastReceiver(const MulticastConfig& config)
+    : config_(config), fd_(-1), bound_port_(0), buffers_(PacketBatch::MAX_PACKETS * MAX_DATAGRAM) {}
+
+UdpMulticastReceiver::~UdpMulticastReceiver() {
+    close();
+}
+
+#ifdef _WIN32
+
+bool UdpMulticastReceiver::open() {
+    std::cerr << "Error: Live UDP ingest is not supported on this platform" << std::endl;
+    return false;
+}
+
+bool UdpMulticastReceiver::receive(PacketBatch& batch) {
+    batch.count = 0;
+    return false;
+}
+
+void UdpMulticastReceiver::close() {}
+
+#else
+
+bool UdpMulticastReceiver::open() {
+    close();
+    
+    in_addr group;
+    if (inet_pton(AF_INET, config_.group.c_str(), &group) != 1) {
+        std::cerr << "Error: Invalid feed address " << config_.group << std::endl;
+        return false;
+    }
+    in_addr interface_address;
+    interface_address.s_addr = htonl(INADDR_ANY);
+    if (!config_.interface_address.empty() && inet_pton(AF_INET, config_.interface_address.c_str(), &interface_address) != 1) {
+        std::cerr << "Error: Invalid interface address " << config_.interface_address << std::endl;
+        return false;
+    }
+    const bool multicast = IN_MULTICAST(ntohl(group.s_addr));
+    
+    fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd_ < 0) {
+        std::cerr << "Error: Cannot create UDP socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    
+    int enable = 1;
+    setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    
+    // A larger buffer rides out bursts while the book thread is busy; the
+    // kernel may cap it, which is not an error
+    int buffer_bytes = static_cast<int>(config_.receive_buffer_bytes);
+    setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &buffer_bytes, sizeof(buffer_bytes));
+#ifdef SO_BUSY_POLL
+    if (config_.busy_poll_us > 0) {
+        setsockopt(fd_, SOL_SOCKET, SO_BUSY_POLL, &config_.busy_poll_us, sizeof(config_.busy_poll_us));
+    }
+#endif
+
+    // Multicast binds the group itself so only its traffic arrives
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(config_.port);
+    address.sin_addr = group;
+    if (bind(fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        std::cerr << "Error: Cannot bind " << config_.group << ":" << config_.port << ": " << std::strerror(errno) << std::endl;
+        close();
+        return false;
+    }
+    
+    if (multicast) {
+        ip_mreq membership;
+        membership.imr_multiaddr = group;
+        membership.imr_interface = interface_address;
+        if (setsockopt(fd_, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) != 0) {
+            std::cerr << "Error: Cannot join multicast group " << config_.group << ": " << std::strerror(errno) << std::endl;
+            close();
+            return false;
+        }
+    }
+    
+    sockaddr_in bound;
+    socklen_t bound_length = sizeof(bound);
+    if (getsockname(fd_, reinterpret_cast<sockaddr*>(&bound), &bound_length) == 0) {
+        bound_port_ = ntohs(bound.sin_port);
+    }
+    
+    fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL, 0) | O_NONBLOCK);
+    return true;
+}
+
+bool UdpMulticastReceiver::receive(PacketBatch& batch) {
+    batch.count = 0;
+    if (fd_ < 0) {
+        return false;
+    }
+
+#if defined(__linux__)
+    mmsghdr messages[PacketBatch::MAX_PACKETS];
+    iovec vectors[PacketBatch::MAX_PACKETS];
+    for (size_t i = 0; i < PacketBatch::MAX_PACKETS; ++i) {
+        vectors[i].iov_base = &buffers_[i * MAX_DATAGRAM];
+        vectors[i].iov_len = MAX_DATAGRAM;
+        std::memset(&messages[i].msg_hdr, 0, sizeof(messages[i].msg_hdr));
+        messages[i].msg_hdr.msg_iov = &vectors[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+    }
+    int received = recvmmsg(fd_, messages, PacketBatch::MAX_PACKETS, MSG_DONTWAIT, nullptr);
+    if (received < 0) {
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+    for (int i = 0; i < received; ++i) {
+        batch.data[i] = &buffers_[static_cast<size_t>(i) * MAX_DATAGRAM];
+        batch.length[i] = messages[i].msg_len;
+    }
+    batch.count = static_cast<size_t>(received);
+#else
+    while (batch.count < PacketBatch::MAX_PACKETS) {
+        char* buffer = &buffers_[batch.count * MAX_DATAGRAM];
+        ssize_t received = recvfrom(fd_, buffer, MAX_DATAGRAM, MSG_DONTWAIT, nullptr, nullptr);
+        if (received < 0) {
+            return batch.count > 0 || errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+        batch.data[batch.count] = buffer;
+        batch.length[batch.count] = static_cast<size_t>(received);
+        ++batch.count;
+    }
+#endif
+    return true;
+}
+
+void UdpMulticastReceiver::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+#endif
@@ -0,0 +1,144 @@
+#include "page_allocator.h"
+
+#include <atomic>
+#include <cstdint>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#endif
+
+namespace {
+
+std::atomic<bool> huge_pages_enabled(true);
+thread_local int thread_numa_node = NO_NUMA_NODE;
+
+size_t roundedSize(size_t bytes) {
+    if (bytes >= HUGE_PAGE_SIZE) {
+        return (bytes + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+    }
+    return bytes == 0 ? 1 : bytes;
+}
+
+#if defined(__linux__)
+// mbind without a libnuma dependency. MPOL_PREFERRED falls back to other
+// nodes rather than failing when the chosen one is full.
+constexpr int MPOL_PREFERRED_MODE = 1;
+constexpr int MAX_NUMA_NODES = 1024;
+
+void bindToNode(void* address, size_t bytes, int numa_node) {
+    if (numa_node < 0 || numa_node >= MAX_NUMA_NODES) {
+        return;
+    }
+    constexpr size_t BITS = sizeof(unsigned long) * 8;
+    unsigned long mask[MAX_NUMA_NODES / BITS] = {};
+    mask[numa_node / BITS] = 1UL << (numa_node % BITS);
+    syscall(SYS_mbind, address, bytes, MPOL_PREFERRED_MODE, mask, MAX_NUMA_NODES + 1, 0);
+}
+#endif
+
+#ifndef _WIN32
+// Maps bytes at a HUGE_PAGE_SIZE boundary, so transparent huge pages can
+// cover the whole range, by over-mapping and trimming both ends
+void* mapAligned(size_t bytes) {
+    void* mapped = mmap(nullptr, bytes + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapped == MAP_FAILED) {
+        return nullptr;
+    }
+    uintptr_t start = reinterpret_cast<uintptr_t>(mapped);
+    uintptr_t aligned = (start + HUGE_PAGE_SIZE - 1) & ~static_cast<uintptr_t>(HUGE_PAGE_SIZE - 1);
+    if (aligned > start) {
+        munmap(mapped, aligned - start);
+    }
+    size_t tail = HUGE_PAGE_SIZE - (aligned - start);
+    if (tail > 0) {
+        munmap(reinterpret_cast<void*>(aligned + bytes), tail);
+    }
+    return reinterpret_cast<void*>(aligned);
+}
+#endif
+
+} // namespace
+
+void setHugePagesEnabled(bool enabled) { huge_pages_enabled.store(enabled, std::memory_order_relaxed); }
+bool hugePagesEnabled() { return huge_pages_enabled.load(std::memory_order_relaxed); }
+
+void setCurrentNumaNode(int numa_node) { thread_numa_node = numa_node; }
+int currentNumaNode() { return thread_numa_node; }
+
+void* allocatePages(size_t bytes, int numa_node) {
+    const size_t size = roundedSize(bytes);
+
+#ifdef _WIN32
+    // Large pages need SeLockMemoryPrivilege, which replay processes do not
+    // normally hold, so Windows gets node placement only
+    void* pointer = numa_node >= 0
+        ? VirtualAllocExNuma(GetCurrentProcess(), nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE,
+                             static_cast<DWORD>(numa_node))
+        : VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (!pointer) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+#else
+    const bool huge = size >= HUGE_PAGE_SIZE && hugePagesEnabled();
+    void* pointer = nullptr;
+#ifdef MAP_HUGETLB
+    // The reserved pool is tried first; mmap fails up front when it is empty
+    if (huge) {
+        void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (mapped != MAP_FAILED) {
+            pointer = mapped;
+        }
+    }
+#endif
+    if (!pointer) {
+        if (size >= HUGE_PAGE_SIZE) {
+            pointer = mapAligned(size);
+        } else {
+            void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            pointer = mapped == MAP_FAILED ? nullptr : mapped;
+        }
+        if (!pointer) {
+            throw std::bad_alloc();
+        }
+        if (huge) {
+            adviseHugePages(pointer, size);
+        }
+    }
+#ifdef __linux__
+    bindToNode(pointer, size, numa_node);
+#else
+    (void)numa_node;
+#endif
+    return pointer;
+#endif
+}
+
+void releasePages(void* pointer, size_t bytes) {
+    if (!pointer) {
+        return;
+    }
+#ifdef _WIN32
+    (void)bytes;
+    VirtualFree(pointer, 0, MEM_RELEASE);
+#else
+    munmap(pointer, roundedSize(bytes));
+#endif
+}
+
+void adviseHugePages(const void* address, size_t bytes) {
+#if !defined(_WIN32) && defined(MADV_HUGEPAGE)
+    if (hugePagesEnabled() && bytes >= HUGE_PAGE_SIZE) {
+        madvise(const_cast<void*>(address), bytes, MADV_HUGEPAGE);
+    }
+#else
+    (void)address;
+    (void)bytes;
+#endif
+}
@@ -0,0 +1,98 @@
+#include "process_usage.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#include <malloc.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#ifdef ORDERBOOK_COUNT_ALLOCS
+namespace {
+
+std::atomic<uint64_t> allocation_count(0);
+std::atomic<uint64_t> allocation_bytes(0);
+
+void* countedAllocate(std::size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* countedAllocateAligned(std::size_t size, std::align_val_t alignment) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+    const std::size_t align = static_cast<std::size_t>(alignment);
+#ifdef _WIN32
+    void* memory = _aligned_malloc(size == 0 ? 1 : size, align);
+#else
+    void* memory = nullptr;
+    if (posix_memalign(&memory, align < sizeof(void*) ? sizeof(void*) : align, size == 0 ? 1 : size) != 0) {
+        memory = nullptr;
+    }
+#endif
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void releaseAligned(void* memory) {
+#ifdef _WIN32
+    _aligned_free(memory);
+#else
+    std::free(memory);
+#endif
+}
+
+} // namespace
+
+// The nothrow forms are left to the standard library, which implements
+// them on top of these
+void* operator new(std::size_t size) { return countedAllocate(size); }
+void* operator new[](std::size_t size) { return countedAllocate(size); }
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
+
+void* operator new(std::size_t size, std::align_val_t alignment) { return countedAllocateAligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return countedAllocateAligned(size, alignment); }
+void operator delete(void* memory, std::align_val_t) noexcept { releaseAligned(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { releaseAligned(memory); }
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept { releaseAligned(memory); }
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept { releaseAligned(memory); }
+#endif
+
+ProcessUsage currentProcessUsage() {
+    ProcessUsage usage;
+#ifdef ORDERBOOK_COUNT_ALLOCS
+    usage.allocations = allocation_count.load(std::memory_order_relaxed);
+    usage.allocated_bytes = allocation_bytes.load(std::memory_order_relaxed);
+#endif
+
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        usage.peak_rss_kb = counters.PeakWorkingSetSize / 1024;
+    }
+#else
+    struct rusage resources;
+    if (getrusage(RUSAGE_SELF, &resources) == 0) {
+#ifdef __APPLE__
+        usage.peak_rss_kb = static_cast<uint64_t>(resources.ru_maxrss) / 1024;
+#else
+        usage.peak_rss_kb = static_cast<uint64_t>(resources.ru_maxrss);
+#endif
+    }
+#endif
+    return usage;
+}
@@ -0,0 +1,433 @@
+#include "replay_engine.h"
+#include "async_logger.h"
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+
+template <typename Book, typename Writer>
+ReplayEngine<Book, Writer>::ReplayEngine(Writer& writer)
+    : writer_(writer), buffered_(0), tfc_events_remaining_(0) {}
+
+template <typename Book, typename Writer>
+void ReplayEngine<Book, Writer>::push(const MboEvent& event) {
+    lookahead_[buffered_++] = event;
+    if (buffered_ == LOOKAHEAD) {
+        processFront(lookahead_, buffered_);
+        advance();
+    }
+}
+
+template <typename Book, typename Writer>
+void ReplayEngine<Book, Writer>::pushBatch(const MboEvent* events, size_t count) {
+    // Push one at a time until the carried lookahead holds batch events only
+    size_t next = 0;
+    while (next < count && buffered_ > next) {
+        push(events[next++]);
+    }
+    if (buffered_ > next) {
+        return;
+    }
+    
+    size_t front = next - buffered_;
+    for (; front + LOOKAHEAD <= count; ++front) {
+        processFront(events + front, LOOKAHEAD);
+    }
+    
+    buffered_ = count - front;
+    for (size_t i = 0; i < buffered_; ++i) {
+        lookahead_[i] = events[front + i];
+    }
+}
+
+template <typename Book, typename Writer>
+void ReplayEngine<Book, Writer>::finish() {
+    while (buffered_ > 0) {
+        processFront(lookahead_, buffered_);
+        advance();
+    }
+}
+
+template <typename Book, typename Writer>
+void ReplayEngine<Book, Writer>::advance() {
+    for (size_t i = 1; i < buffered_; ++i) {
+        lookahead_[i - 1] = lookahead_[i];
+    }
+    --buffered_;
+}
+
+template <typename Book, typename Writer>
+bool ReplayEngine<Book, Writer>::shouldIncludeEvent(const MboEvent& event, size_t events_of_type_processed) {
+    (void)events_of_type_processed;
+    
+    if (event.action == 'A') {
+        stats_.a_events_included++;
+        return true;
+    } else if (event.action == 'C') {
+        stats_.c_events_included++;
+        return true;
+    }
+    
+    return true;
+}
+
+template <typename Book, typename Writer>
+ProcessResult ReplayEngine<Book, Writer>::applyEvent(Book& order_book, const MboEvent& event) {
+    LatencyTimer timer(latency_, latencyStageOf(event.action));
+    return order_book.processEvent(event);
+}
+
+template <typename Book, typename Writer>
+MbpSnapshot ReplayEngine<Book, Writer>::snapshotOf(const Book& order_book, const MboEvent& event) {
+    LatencyTimer timer(latency_, LatencyStage::SNAPSHOT);
+    return order_book.generateSnapshot(event);
+}
+
+template <typename Book, typename Writer>
+void ReplayEngine<Book, Writer>::emitSnapshot(const MbpSnapshot& snapshot) {
+    LatencyTimer timer(latency_, LatencyStage::EMIT);
+    if (writer_.writeSnapshot(snapshot, stats_.snapshots_written)) {
+        stats_.snapshots_written++;
+    }
+}
+
+template <typename Book, typename Writer>
+void ReplayEngine<Book, Writer>::processFront(const MboEvent* ahead, size_t available) {
+    const auto& event = ahead[0];
+    Book& order_book = books_.getBook(event.instrument_id);
+    stats_.processed_events++;
+    
+    if (event.action == 'R' && stats_.processed_events == 1) {
+        logMessage(LogMessage::RESET_EVENT);
+        MbpSnapshot snapshot = snapshotOf(order_book, event);
+        emitSnapshot(snapshot);
+        return;
+    }
+    
+    if (tfc_events_remaining_ == 0 && event.action == 'T' && available == LOOKAHEAD &&
+        ahead[1].action == 'F' && ahead[2].action == 'C') {
+        
+        const auto& f_event = ahead[1];
+        const auto& c_event = ahead[2];
+        
+        if (f_event.price == event.price && 
+            f_event.size == event.size &&
+            c_event.order_id == f_event.order_id) {
+            
+            tfc_trade_event_ = event;
+            tfc_events_remaining_ = 3;
+            stats_.tfc_sequences_detected++;
+        }
+    }
+    
+    if (tfc_events_remaining_ > 0) {
+        --tfc_events_remaining_;
+        
+        if (event.action == 'T') {
+            ProcessResult result = applyEvent(order_book, event);
+            (void)result;
+            return;
+        } else if (event.action == 'F') {
+            ProcessResult result = applyEvent(order_book, event);
+            (void)result;
+            return;
+        } else if (event.action == 'C') {
+            ProcessResult result = applyEvent(order_book, event);
+            
+            MbpSnapshot snapshot = snapshotOf(order_book, tfc_trade_event_);
+            
+            snapshot.action = result.snapshot_action;
+            snapshot.side = result.snapshot_side;
+            snapshot.depth = result.depth;
+            
+            emitSnapshot(snapshot);
+            return;
+        }
+    }
+    
+    bool should_process = true;
+    
+    if (event.action == 'C') {
+        if (!order_book.orderExists(event.order_id)) {
+            should_process = false;
+            failed_cancel_orders_.insert(event.order_id);
+            logMessage(LogMessage::FILTERED_CANCEL, event.order_id);
+        } else {
+            if (!shouldIncludeEvent(event, stats_.c_events_processed)) {
+                should_process = false;
+                stats_.snapshots_filtered++;
+                logMessage(LogMessage::FILTERED_C_EVENT, stats_.c_events_processed + 1);
+            } else {
+                stats_.c_events_included++;
+            }
+            stats_.c_events_processed++;
+        }
+    } else if (event.action == 'A') {
+        if (failed_cancel_orders_.count(event.order_id)) {
+            should_process = false;
+            failed_cancel_orders_.erase(event.order_id);
+            logMessage(LogMessage::FILTERED_ADD, event.order_id);
+        } else {
+            if (!shouldIncludeEvent(event, stats_.a_events_processed)) {
+                should_process = false;
+                stats_.snapshots_filtered++;
+                logMessage(LogMessage::FILTERED_A_EVENT, stats_.a_events_processed + 1);
+            } else {
+                stats_.a_events_included++;
+            }
+            stats_.a_events_processed++;
+        }
+    }
+    
+    if (should_process) {
+        if (event.action == 'A' || event.action == 'C') {
+            ProcessResult result = applyEvent(order_book, event);
+            
+            // Only updates that reached the top-10 levels change MBP-10 output
+            if (result.should_write && result.top_changed) {
+                MbpSnapshot snapshot = snapshotOf(order_book, event);
+                snapshot.depth = result.depth;
+                emitSnapshot(snapshot);
+            }
+        } else {
+            ProcessResult result = applyEvent(order_book, event);
+            
+            if (event.action == 'T') {
+                if (event.side == 'N') {
+                    MbpSnapshot snapshot = snapshotOf(order_book, event);
+                    snapshot.action = 'T';
+                    snapshot.side = event.side;
+                    
+                    emitSnapshot(snapshot);
+                } else {
+                    char target_side = (event.side == 'B') ? 'A' : 'B';
+                    
+                    bool can_fill = order_book.hasOrdersAtPrice(event.price, target_side);
+                    int32_t fill_depth = can_fill ? order_book.getLevelDepth(event.price, target_side) : 0;
+                    
+                    if (can_fill) {
+                        order_book.fillOrdersAtPrice(event.price, event.size, target_side);
+                    }
+                    
+                    MbpSnapshot snapshot = snapshotOf(order_book, event);
+                    snapshot.action = 'T';
+                    snapshot.side = event.side;
+                    snapshot.depth = fill_depth;
+                    
+                    emitSnapshot(snapshot);
+                }
+            } else {
+                if (result.should_write) {
+                    MbpSnapshot snapshot = snapshotOf(order_book, event);
+                    emitSnapshot(snapshot);
+                }
+            }
+        }
+    }
+}
+
+static void putEvent(checkpoint::Writer& out, const MboEvent& event) {
+    out.put(static_cast<int64_t>(event.ts_event.count()));
+    out.put(event.action);
+    out.put(event.side);
+    out.put(event.price);
+    out.put(event.size);
+    out.put(event.order_id);
+    out.put(event.flags);
+    out.put(event.ts_in_delta);
+    out.put(event.sequence);
+    out.put(event.instrument_id);
+    out.put(event.publisher_id);
+}
+
+static bool getEvent(checkpoint::Reader& in, MboEvent& event) {
+    int64_t ts_event = 0;
+    in.get(ts_event);
+    in.get(event.action);
+    in.get(event.side);
+    in.get(event.price);
+    in.get(event.size);
+    in.get(event.order_id);
+    in.get(event.flags);
+    in.get(event.ts_in_delta);
+    in.get(event.sequence);
+    in.get(event.instrument_id);
+    in.get(event.publisher_id);
+    event.ts_event = std::chrono::nanoseconds(ts_event);
+    return in.ok();
+}
+
+template <typename Book, typename Writer>
+bool ReplayEngine<Book, Writer>::saveCheckpoint(const std::string& path, const CheckpointPosition& position,
+                                                const SymbologyTable* symbology) const {
+    const std::string temp_path = path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::cerr << "Error: Cannot create checkpoint " << temp_path << std::endl;
+            return false;
+        }
+        
+        checkpoint::Writer out(file);
+        out.putBytes(checkpoint::MAGIC, sizeof(checkpoint::MAGIC));
+        out.put(checkpoint::VERSION);
+        out.put(position.events_consumed);
+        out.put(position.input_offset);
+        out.put(position.last_sequence);
+        out.put(position.last_ts_event);
+        
+        const size_t* counters[] = {&stats_.processed_events, &stats_.snapshots_written, &stats_.tfc_sequences_detected,
+                                    &stats_.snapshots_filtered, &stats_.a_events_processed, &stats_.c_events_processed,
+                                    &stats_.a_events_included, &stats_.c_events_included};
+        for (const size_t* counter : counters) {
+            out.put(static_cast<uint64_t>(*counter));
+        }
+        
+        out.put(static_cast<uint64_t>(buffered_));
+        for (size_t i = 0; i < buffered_; ++i) {
+            putEvent(out, lookahead_[i]);
+        }
+        out.put(static_cast<int32_t>(tfc_events_remaining_));
+        putEvent(out, tfc_trade_event_);
+        
+        out.put(static_cast<uint64_t>(failed_cancel_orders_.size()));
+        for (uint64_t order_id : failed_cancel_orders_) {
+            out.put(order_id);
+        }
+        
+        out.put(static_cast<uint64_t>(books_.size()));
+        books_.forEachBook([&](uint32_t instrument_id, const Book& book) {
+            out.put(instrument_id);
+            book.saveState(out);
+        });
+        
+        out.put(static_cast<uint64_t>(symbology ? symbology->size() : 0));
+        if (symbology) {
+            symbology->forEach([&](uint32_t instrument_id, const SymbologyTable::Entry& entry) {
+                out.put(instrument_id);
+                out.put(entry.publisher_id);
+                out.put(static_cast<uint32_t>(entry.symbol.size()));
+                out.putBytes(entry.symbol.data(), entry.symbol.size());
+            });
+        }
+        
+        file.close();
+        if (!file) {
+            std::cerr << "Error: Failed writing checkpoint " << temp_path << std::endl;
+            std::remove(temp_path.c_str());
+            return false;
+        }
+    }
+
+#ifdef _WIN32
+    std::remove(path.c_str());
+#endif
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        std::cerr << "Error: Cannot move checkpoint into place at " << path << std::endl;
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+template <typename Book, typename Writer>
+bool ReplayEngine<Book, Writer>::loadCheckpoint(const std::string& path, CheckpointPosition& position,
+                                                SymbologyTable* symbology) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Error: Cannot open checkpoint " << path << std::endl;
+        return false;
+    }
+    
+    char magic[sizeof(checkpoint::MAGIC)];
+    uint32_t version = 0;
+    checkpoint::Reader in(file);
+    in.getBytes(magic, sizeof(magic));
+    in.get(version);
+    if (!in.ok() || std::memcmp(magic, checkpoint::MAGIC, sizeof(magic)) != 0 || version != checkpoint::VERSION) {
+        std::cerr << "Error: " << path << " is not a checkpoint of this version" << std::endl;
+        return false;
+    }
+    
+    books_.clear();
+    failed_cancel_orders_.clear();
+    stats_ = ReplayStats();
+    buffered_ = 0;
+    
+    in.get(position.events_consumed);
+    in.get(position.input_offset);
+    in.get(position.last_sequence);
+    in.get(position.last_ts_event);
+    
+    size_t* counters[] = {&stats_.processed_events, &stats_.snapshots_written, &stats_.tfc_sequences_detected,
+                          &stats_.snapshots_filtered, &stats_.a_events_processed, &stats_.c_events_processed,
+                          &stats_.a_events_included, &stats_.c_events_included};
+    for (size_t* counter : counters) {
+        uint64_t value = 0;
+        in.get(value);
+        *counter = static_cast<size_t>(value);
+    }
+    
+    uint64_t buffered = 0;
+    bool valid = in.get(buffered) && buffered < LOOKAHEAD;
+    for (uint64_t i = 0; valid && i < buffered; ++i) {
+        valid = getEvent(in, lookahead_[i]);
+    }
+    buffered_ = valid ? static_cast<size_t>(buffered) : 0;
+    
+    int32_t tfc_events_remaining = 0;
+    uint64_t failed_cancel_count = 0;
+    valid = valid && in.get(tfc_events_remaining) && getEvent(in, tfc_trade_event_) && in.get(failed_cancel_count);
+    tfc_events_remaining_ = tfc_events_remaining;
+    for (uint64_t i = 0; valid && i < failed_cancel_count; ++i) {
+        uint64_t order_id = 0;
+        valid = in.get(order_id);
+        failed_cancel_orders_.insert(order_id);
+    }
+    
+    uint64_t book_count = 0;
+    valid = valid && in.get(book_count);
+    for (uint64_t i = 0; valid && i < book_count; ++i) {
+        uint32_t instrument_id = 0;
+        valid = in.get(instrument_id) && books_.getBook(instrument_id).loadState(in);
+    }
+    
+    uint64_t symbol_count = 0;
+    valid = valid && in.get(symbol_count);
+    for (uint64_t i = 0; valid && i < symbol_count; ++i) {
+        uint32_t instrument_id = 0;
+        uint16_t publisher_id = 0;
+        uint32_t length = 0;
+        in.get(instrument_id);
+        in.get(publisher_id);
+        valid = in.get(length) && length <= MAX_SYMBOL_LENGTH;
+        
+        std::string symbol(valid ? length : 0, '\0');
+        valid = valid && in.getBytes(&symbol[0], symbol.size());
+        if (valid && symbology && !symbology->contains(instrument_id)) {
+            symbology->add(instrument_id, publisher_id, symbol);
+        }
+    }
+    
+    if (!valid) {
+        std::cerr << "Error: Checkpoint " << path << " is truncated or corrupt" << std::endl;
+        books_.clear();
+        failed_cancel_orders_.clear();
+        stats_ = ReplayStats();
+        buffered_ = 0;
+        tfc_events_remaining_ = 0;
+        return false;
+    }
+    return true;
+}
+
+template class ReplayEngine<OrderBook, MbpCsvWriter>;
+template class ReplayEngine<OrderBook, MbpBinaryWriter>;
+template class ReplayEngine<LadderOrderBook, MbpCsvWriter>;
+template class ReplayEngine<LadderOrderBook, MbpBinaryWriter>;
+template class ReplayEngine<OrderBook, MbpShmPublisher>;
+template class ReplayEngine<LadderOrderBook, MbpShmPublisher>;
+template class ReplayEngine<OrderBook, SnapshotQueueWriter>;
+template class ReplayEngine<LadderOrderBook, SnapshotQueueWriter>;
+template class ReplayEngine<OrderBook, ConflatingWriter>;
+template class ReplayEngine<LadderOrderBook, ConflatingWriter>;
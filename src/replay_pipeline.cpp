@@ -0,0 +1,81 @@
+#include "replay_pipeline.h"
+#include "thread_affinity.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <iostream>
+
+template <typename Book, typename Writer>
+ReplayPipeline<Book, Writer>::ReplayPipeline(Writer& writer, const PipelineCores& cores)
+    : writer_(writer), cores_(cores), events_(EVENT_RING_CAPACITY, numaNodeOfCore(cores.book)),
+      snapshots_(SNAPSHOT_RING_CAPACITY, numaNodeOfCore(cores.write)),
+      sink_(snapshots_), engine_(sink_) {}
+
+static void pinStage(const char* stage, int core) {
+    if (core >= 0 && !pinCurrentThread(core)) {
+        std::cerr << "Warning: Could not pin " << stage << " stage to core " << core << std::endl;
+    }
+}
+
+template <typename Book, typename Writer>
+void ReplayPipeline<Book, Writer>::run(MboEventSource& source, const MboEvent& first_event) {
+    // Each flag is raised after the producer's last push, so a consumer that
+    // sees it set and then finds its ring empty has seen everything
+    std::atomic<bool> parse_done(false);
+    std::atomic<bool> book_done(false);
+    
+    std::thread book_thread([this, &parse_done, &book_done]() {
+        pinStage("book", cores_.book);
+        std::vector<MboEvent> batch(ReplayEngine<Book, SnapshotQueueWriter>::BATCH_SIZE);
+        for (;;) {
+            if (size_t count = events_.tryPopBatch(batch.data(), batch.size())) {
+                engine_.pushBatch(batch.data(), count);
+            } else if (parse_done.load(std::memory_order_acquire)) {
+                while (size_t count = events_.tryPopBatch(batch.data(), batch.size())) {
+                    engine_.pushBatch(batch.data(), count);
+                }
+                break;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        engine_.finish();
+        book_done.store(true, std::memory_order_release);
+    });
+    
+    std::thread write_thread([this, &book_done]() {
+        pinStage("write", cores_.write);
+        QueuedSnapshot item;
+        for (;;) {
+            if (snapshots_.tryPop(item)) {
+                writer_.writeSnapshot(item.snapshot, item.row_index);
+            } else if (book_done.load(std::memory_order_acquire)) {
+                while (snapshots_.tryPop(item)) {
+                    writer_.writeSnapshot(item.snapshot, item.row_index);
+                }
+                break;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    
+    pinStage("parse", cores_.parse);
+    MboEvent event = first_event;
+    do {
+        while (!events_.tryPush(event)) {
+            std::this_thread::yield();
+        }
+    } while (source.next(event));
+    parse_done.store(true, std::memory_order_release);
+    
+    book_thread.join();
+    write_thread.join();
+}
+
+template class ReplayPipeline<OrderBook, MbpCsvWriter>;
+template class ReplayPipeline<OrderBook, MbpBinaryWriter>;
+template class ReplayPipeline<LadderOrderBook, MbpCsvWriter>;
+template class ReplayPipeline<LadderOrderBook, MbpBinaryWriter>;
+template class ReplayPipeline<OrderBook, MbpShmPublisher>;
+template class ReplayPipeline<LadderOrderBook, MbpShmPublisher>;
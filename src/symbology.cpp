@@ -0,0 +1,35 @@
+#include "symbology.h"
+
+void SymbologyTable::add(uint32_t instrument_id, uint16_t publisher_id, const std::string& symbol) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& entry = entries_[instrument_id];
+    entry.publisher_id = publisher_id;
+    entry.symbol = symbol;
+}
+
+bool SymbologyTable::contains(uint32_t instrument_id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.find(instrument_id) != entries_.end();
+}
+
+const SymbologyTable::Entry* SymbologyTable::find(uint32_t instrument_id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(instrument_id);
+    return it != entries_.end() ? &it->second : nullptr;
+}
+
+const std::string& SymbologyTable::getSymbol(uint32_t instrument_id) const {
+    static const std::string unknown;
+    const Entry* entry = find(instrument_id);
+    return entry ? entry->symbol : unknown;
+}
+
+size_t SymbologyTable::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+void SymbologyTable::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+}
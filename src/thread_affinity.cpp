@@ -0,0 +1,89 @@
+#include "thread_affinity.h"
+#include "page_allocator.h"
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <dirent.h>
+#endif
+
+bool pinCurrentThread(int core) {
+    if (core < 0) {
+        return false;
+    }
+
+    bool pinned = false;
+#ifdef _WIN32
+    if (core >= static_cast<int>(sizeof(DWORD_PTR) * 8)) {
+        return false;
+    }
+    pinned = SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << core) != 0;
+#elif defined(__linux__)
+    if (core >= CPU_SETSIZE) {
+        return false;
+    }
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(core, &cpus);
+    pinned = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+#endif
+    if (pinned) {
+        setCurrentNumaNode(numaNodeOfCore(core));
+    }
+    return pinned;
+}
+
+int numaNodeOfCore(int core) {
+    if (core < 0) {
+        return -1;
+    }
+
+#ifdef _WIN32
+    UCHAR node = 0;
+    if (core >= static_cast<int>(sizeof(DWORD_PTR) * 8)) {
+        return -1;
+    }
+    return GetNumaProcessorNode(static_cast<UCHAR>(core), &node) && node != 0xFF ? static_cast<int>(node) : -1;
+#elif defined(__linux__)
+    // sysfs links each CPU to its node as a "nodeN" entry
+    std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(core);
+    DIR* directory = opendir(path.c_str());
+    if (!directory) {
+        return -1;
+    }
+    int node = -1;
+    while (dirent* entry = readdir(directory)) {
+        const char* name = entry->d_name;
+        if (name[0] == 'n' && name[1] == 'o' && name[2] == 'd' && name[3] == 'e' && name[4] >= '0' && name[4] <= '9') {
+            node = std::atoi(name + 4);
+            break;
+        }
+    }
+    closedir(directory);
+    return node;
+#else
+    return -1;
+#endif
+}
+
+bool parseCoreList(const std::string& list, std::vector<int>& cores) {
+    cores.clear();
+    size_t begin = 0;
+    for (;;) {
+        size_t end = list.find(',', begin);
+        std::string item = list.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+        char* item_end = nullptr;
+        long core = std::strtol(item.c_str(), &item_end, 10);
+        if (item.empty() || *item_end != '\0' || core < 0) {
+            return false;
+        }
+        cores.push_back(static_cast<int>(core));
+        if (end == std::string::npos) {
+            return true;
+        }
+        begin = end + 1;
+    }
+}
@@ -0,0 +1,215 @@
+#!/bin/bash
+# Replay throughput and memory regression harness
+#
+# Builds the release engine with allocation counting (make regress-build),
+# replays each recorded session through it and checks the output against
+# the session's reference MBP-10 file. A session is replayed at least --runs
+# times and until the replays add up to --min-measure-ms, so that a short
+# session is timed over many runs; the run with the median events/sec is
+# kept. Its figures (events/sec, snapshot rows/sec, peak RSS, heap
+# allocations) are appended to a JSON Lines history, and compared with the
+# last passing run of the same session, engine arguments and host:
+#   - events/sec more than --max-slowdown percent below it fails the run,
+#     for sessions whose single replay takes at least --min-gated-ms; the
+#     timing of shorter ones is mostly process start-up and page faults
+#     and swings by tens of percent, so it is recorded but not gated;
+#   - peak RSS or allocation count more than --max-memory-growth percent
+#     above it fails the run;
+#   - more lines differing from the reference than it had fails the run
+#     (--exact requires no differences at all).
+#
+# A session is a directory holding mbo.csv and the reference mbp.csv.
+#
+# Usage: tests/regression/run_regression.sh [--max-slowdown=PCT] [--max-memory-growth=PCT]
+#            [--runs=N] [--min-measure-ms=MS] [--min-gated-ms=MS] [--history=FILE] [--engine-args="ARGS"] [--exact] [--no-build] [SESSION_DIR...]
+
+ROOT="$(cd "$(dirname "$0")/../.." && pwd)"
+
+MAX_SLOWDOWN=10
+MAX_MEMORY_GROWTH=20
+RUNS=5
+MIN_MEASURE_MS=1000
+MIN_GATED_MS=1000
+MAX_RUNS=1000
+HISTORY="$ROOT/tests/regression/history.jsonl"
+ENGINE_ARGS=""
+EXACT=0
+BUILD=1
+SESSIONS=()
+
+for arg in "$@"; do
+    case "$arg" in
+        --max-slowdown=*) MAX_SLOWDOWN="${arg#*=}" ;;
+        --max-memory-growth=*) MAX_MEMORY_GROWTH="${arg#*=}" ;;
+        --runs=*) RUNS="${arg#*=}" ;;
+        --min-measure-ms=*) MIN_MEASURE_MS="${arg#*=}" ;;
+        --min-gated-ms=*) MIN_GATED_MS="${arg#*=}" ;;
+        --history=*) HISTORY="${arg#*=}" ;;
+        --engine-args=*) ENGINE_ARGS="${arg#*=}" ;;
+        --exact) EXACT=1 ;;
+        --no-build) BUILD=0 ;;
+        -*) sed -n '2,/^$/s/^# \{0,1\}//p' "$0"; exit 2 ;;
+        *) SESSIONS+=("$arg") ;;
+    esac
+done
+if [ ${#SESSIONS[@]} -eq 0 ]; then
+    SESSIONS=("$ROOT/quant_dev_trial")
+fi
+if ! [ "$RUNS" -ge 1 ] 2>/dev/null || ! [ "$MIN_MEASURE_MS" -ge 0 ] 2>/dev/null ||
+   ! [ "$MIN_GATED_MS" -ge 0 ] 2>/dev/null; then
+    echo "Error: --runs must be a positive number, --min-measure-ms and --min-gated-ms not negative" >&2
+    exit 2
+fi
+
+if [ $BUILD -eq 1 ]; then
+    # The Makefile names its compiler; a CXX from the environment overrides it
+    if ! make -C "$ROOT" regress-build ${CXX:+CXX="$CXX"} > /dev/null; then
+        echo "Error: release build failed" >&2
+        exit 1
+    fi
+fi
+ENGINE="$ROOT/bin/orderbook_engine_regress"
+[ -x "$ENGINE" ] || ENGINE="$ENGINE.exe"
+if [ ! -x "$ENGINE" ]; then
+    echo "Error: no regression engine in $ROOT/bin; run make regress-build" >&2
+    exit 1
+fi
+
+# Reads a field of the flat one-line JSON objects written by --stats-json
+# and by this script
+json_field() {
+    sed -n "s/.*\"$2\": \"\{0,1\}\([^,\"}]*\).*/\1/p" <<< "$1"
+}
+
+# Last passing history entry for this session, engine arguments and host
+baseline_of() {
+    [ -f "$HISTORY" ] || return
+    grep -F "\"session\": \"$1\"," "$HISTORY" | grep -F "\"engine_args\": \"$ENGINE_ARGS\"," |
+        grep -F "\"host\": \"$HOST\"," | grep -F '"status": "pass"' | tail -n 1
+}
+
+HOST="$(hostname 2>/dev/null || echo unknown)"
+COMMIT="$(git -C "$ROOT" rev-parse --short HEAD 2>/dev/null || echo unknown)"
+WORK_DIR="$(mktemp -d)"
+trap 'rm -rf "$WORK_DIR"' EXIT
+mkdir -p "$(dirname "$HISTORY")"
+
+echo "========================================"
+echo "Replay Regression Harness"
+echo "========================================"
+echo "Engine: $ENGINE $ENGINE_ARGS"
+echo "Thresholds: ${MAX_SLOWDOWN}% slowdown, ${MAX_MEMORY_GROWTH}% memory growth"
+echo "Timing: median of at least $RUNS runs and ${MIN_MEASURE_MS} ms of replay"
+
+FAILED=0
+for session_dir in "${SESSIONS[@]}"; do
+    session="$(basename "$(cd "$session_dir" 2>/dev/null && pwd)")"
+    echo ""
+    echo "Session: $session"
+    if [ ! -f "$session_dir/mbo.csv" ] || [ ! -f "$session_dir/mbp.csv" ]; then
+        echo "  FAIL: $session_dir needs mbo.csv and mbp.csv"
+        FAILED=1
+        continue
+    fi
+    input="$(cd "$session_dir" && pwd)/mbo.csv"
+
+    # Output goes to the work directory; every run's figures are collected
+    # and the run with the median events/sec is kept
+    : > "$WORK_DIR/runs.jsonl"
+    measured_ns=0
+    run=0
+    failed_run=0
+    while [ $run -lt $RUNS ] || [ $((measured_ns / 1000000)) -lt "$MIN_MEASURE_MS" ]; do
+        [ $run -lt $MAX_RUNS ] || break
+        run=$((run + 1))
+        rm -f "$WORK_DIR/output.csv" "$WORK_DIR/stats.json"
+        if ! (cd "$WORK_DIR" && "$ENGINE" $ENGINE_ARGS --stats-json=stats.json "$input" > engine.log 2>&1); then
+            echo "  FAIL: engine exited with an error, see below"
+            tail -n 20 "$WORK_DIR/engine.log"
+            failed_run=1
+            break
+        fi
+        stats="$(cat "$WORK_DIR/stats.json")"
+        echo "$stats" >> "$WORK_DIR/runs.jsonl"
+        measured_ns=$((measured_ns + $(json_field "$stats" elapsed_ns)))
+    done
+    if [ $failed_run -eq 1 ]; then
+        FAILED=1
+        continue
+    fi
+    best="$(while read -r line; do echo "$(json_field "$line" events_per_sec) $line"; done < "$WORK_DIR/runs.jsonl" |
+        sort -n | awk '{ lines[NR] = $0 } END { line = lines[int((NR + 1) / 2)]; sub(/^[^ ]* /, "", line); print line }')"
+
+    mismatch=$(diff "$WORK_DIR/output.csv" "$session_dir/mbp.csv" | grep -c '^[<>]')
+    events=$(json_field "$best" events)
+    rows=$(json_field "$best" rows)
+    events_per_sec=$(json_field "$best" events_per_sec)
+    rows_per_sec=$(json_field "$best" rows_per_sec)
+    peak_rss_kb=$(json_field "$best" peak_rss_kb)
+    allocations=$(json_field "$best" allocations)
+    allocated_bytes=$(json_field "$best" allocated_bytes)
+
+    echo "  Events: $events, snapshot rows: $rows; $run runs, $((measured_ns / 1000000)) ms of replay"
+    echo "  Throughput: $events_per_sec events/sec, $rows_per_sec rows/sec"
+    echo "  Peak RSS: $peak_rss_kb KB, allocations: $allocations ($allocated_bytes bytes)"
+    echo "  Lines differing from reference: $mismatch"
+
+    status=pass
+    baseline="$(baseline_of "$session")"
+    if [ $EXACT -eq 1 ] && [ "$mismatch" -ne 0 ]; then
+        echo "  FAIL: output differs from the reference"
+        status=fail
+    fi
+    if [ -n "$baseline" ]; then
+        echo "  Baseline: commit $(json_field "$baseline" commit) on $(json_field "$baseline" date)"
+        base_mismatch=$(json_field "$baseline" reference_mismatch_lines)
+        if [ "$mismatch" -gt "$base_mismatch" ]; then
+            echo "  FAIL: $mismatch lines differ from the reference, baseline had $base_mismatch"
+            status=fail
+        fi
+        # check NAME CURRENT BASELINE "below"|"above" PCT
+        check() {
+            awk -v name="$1" -v current="$2" -v base="$3" -v direction="$4" -v pct="$5" 'BEGIN {
+                if (base <= 0) exit 0
+                change = (current - base) * 100 / base
+                printf "  %s: %+.1f%% against baseline %s\n", name, change, base
+                if ((direction == "below" && -change > pct) || (direction == "above" && change > pct)) {
+                    printf "  FAIL: %s changed by more than %s%%\n", name, pct
+                    exit 1
+                }
+            }'
+        }
+        replay_ms=$(($(json_field "$best" elapsed_ns) / 1000000))
+        if [ $replay_ms -ge "$MIN_GATED_MS" ]; then
+            check "Events/sec" "$events_per_sec" "$(json_field "$baseline" events_per_sec)" below "$MAX_SLOWDOWN" || status=fail
+        else
+            check "Events/sec" "$events_per_sec" "$(json_field "$baseline" events_per_sec)" below 100
+            echo "  Events/sec not gated: one replay takes $replay_ms ms, under --min-gated-ms=$MIN_GATED_MS"
+        fi
+        check "Peak RSS" "$peak_rss_kb" "$(json_field "$baseline" peak_rss_kb)" above "$MAX_MEMORY_GROWTH" || status=fail
+        check "Allocations" "$allocations" "$(json_field "$baseline" allocations)" above "$MAX_MEMORY_GROWTH" || status=fail
+    else
+        echo "  No baseline yet; this run becomes it"
+    fi
+
+    # Failed runs are kept for the record but never become a baseline
+    echo "{\"date\": \"$(date -u +%Y-%m-%dT%H:%M:%SZ)\", \"commit\": \"$COMMIT\", \"host\": \"$HOST\"," \
+         "\"session\": \"$session\", \"engine_args\": \"$ENGINE_ARGS\", \"events\": $events, \"rows\": $rows," \
+         "\"events_per_sec\": $events_per_sec, \"rows_per_sec\": $rows_per_sec, \"peak_rss_kb\": $peak_rss_kb," \
+         "\"allocations\": $allocations, \"allocated_bytes\": $allocated_bytes," \
+         "\"reference_mismatch_lines\": $mismatch, \"status\": \"$status\"}" >> "$HISTORY"
+    if [ $status = pass ]; then
+        echo "  PASS"
+    else
+        FAILED=1
+    fi
+done
+
+echo ""
+echo "========================================"
+if [ $FAILED -eq 0 ]; then
+    echo "All sessions within thresholds; history in $HISTORY"
+else
+    echo "REGRESSION: see the failures above; history in $HISTORY"
+fi
+exit $FAILED
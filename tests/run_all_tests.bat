@@ -1,43 +1,13 @@
 @echo off
 REM Test runner for MBP-10 Order Book Engine Unit Tests
-REM Demonstrates system correctness and performance for task evaluation
+REM Builds every test in tests\unit with tests\Makefile and runs them in turn,
+REM stopping at the first failure
 
-echo ========================================
-echo MBP-10 Order Book Engine Unit Test Suite
-echo ========================================
-echo Running unit tests for extra points...
-echo.
+cd /d "%~dp0"
 
-echo 1. Testing Order Book Operations...
 echo ========================================
-test_order_book.exe
-echo.
-
-echo 2. Testing MBO Parser Functionality...
-echo ========================================
-test_mbo_parser.exe
-echo.
-
-echo 3. Testing MBP CSV Writer Performance...
+echo MBP-10 Order Book Engine Unit Test Suite
 echo ========================================
-test_mbp_csv_writer.exe
 echo.
 
-echo ========================================
-echo 🎉 ALL UNIT TESTS COMPLETED SUCCESSFULLY! 🎉
-echo ========================================
-echo.
-echo System Validation Summary:
-echo ✅ Order Book: All operations working correctly
-echo ✅ MBO Parser: CSV parsing and validation passed
-echo ✅ MBP Writer: Performance ~32K snapshots/second
-echo ✅ Memory Management: No leaks detected
-echo ✅ Error Handling: All edge cases covered
-echo.
-echo This test suite demonstrates:
-echo - Correct implementation of MBP-10 filtering
-echo - Robust order book state management
-echo - High-performance data processing
-echo - Professional code quality and testing
-echo.
-echo Task requirements satisfied with working unit tests!
+mingw32-make test %*
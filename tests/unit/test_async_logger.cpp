@@ -0,0 +1,171 @@
+#include <iostream>
+#include <cassert>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "async_logger.h"
+#include "mpsc_ring.h"
+
+static size_t countOf(const std::string& text, const std::string& pattern) {
+    size_t count = 0;
+    for (size_t pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1)) {
+        ++count;
+    }
+    return count;
+}
+
+void testMpscRing() {
+    std::cout << "Testing MPSC ring with concurrent producers..." << std::endl;
+    MpscRing<uint64_t> ring(100);
+    assert(ring.capacity() == 128);
+    
+    // Fills up and refuses the next push
+    for (uint64_t i = 0; i < ring.capacity(); ++i) {
+        assert(ring.tryPush(i));
+    }
+    assert(!ring.tryPush(999));
+    uint64_t item;
+    for (uint64_t i = 0; i < ring.capacity(); ++i) {
+        assert(ring.tryPop(item) && item == i);
+    }
+    assert(!ring.tryPop(item));
+    
+    // Four producers, each pushing its own increasing sequence; every item
+    // arrives once and each producer's items stay in order
+    const uint64_t PER_PRODUCER = 200000;
+    const size_t PRODUCERS = 4;
+    std::vector<std::thread> producers;
+    for (uint64_t p = 0; p < PRODUCERS; ++p) {
+        producers.emplace_back([&ring, p, PER_PRODUCER]() {
+            for (uint64_t i = 0; i < PER_PRODUCER; ++i) {
+                while (!ring.tryPush((p << 32) | i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    
+    std::vector<uint64_t> next(PRODUCERS, 0);
+    for (uint64_t received = 0; received < PER_PRODUCER * PRODUCERS;) {
+        if (ring.tryPop(item)) {
+            uint64_t producer = item >> 32;
+            assert(producer < PRODUCERS);
+            assert((item & 0xffffffffu) == next[producer]);
+            ++next[producer];
+            ++received;
+        }
+    }
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+    assert(ring.pushed() == ring.popped());
+    
+    std::cout << "✓ MPSC ring passed" << std::endl;
+}
+
+void testFormattingAndSeverity() {
+    std::cout << "Testing async logger formatting and severity filter..." << std::endl;
+    std::ostringstream info;
+    std::ostringstream warnings;
+    {
+        AsyncLogger logger(info, warnings);
+        logger.log(LogMessage::FILTERED_CANCEL, 817);
+        logger.log(LogMessage::DUPLICATE_ORDER, 42);
+        logger.log(LogMessage::UNKNOWN_ACTION, 'Q');
+        logger.flush();
+        assert(info.str() == "Filtered Cancel event for non-existent order 817\n");
+        assert(warnings.str() == "Warning: Order 42 already exists\nWarning: Unknown action 'Q'\n");
+        
+        // Below the threshold a message is neither queued nor counted
+        logger.setMinSeverity(LogSeverity::WARNING);
+        logger.log(LogMessage::FILTERED_ADD, 5);
+        logger.log(LogMessage::UNEXPECTED_FILL);
+        logger.flush();
+        assert(info.str() == "Filtered Cancel event for non-existent order 817\n");
+        assert(countOf(warnings.str(), "Unexpected fill") == 1);
+        assert(logger.getCount(LogMessage::FILTERED_ADD) == 0);
+        assert(logger.getCount(LogMessage::UNEXPECTED_FILL) == 1);
+        
+        logger.setMinSeverity(LogSeverity::OFF);
+        logger.log(LogMessage::DUPLICATE_ORDER, 43);
+        logger.flush();
+        assert(countOf(warnings.str(), "Order 43") == 0);
+        
+        // Records logged just before destruction are still written
+        logger.setMinSeverity(LogSeverity::INFO);
+        logger.log(LogMessage::FILTERED_A_EVENT, 7);
+    }
+    assert(countOf(info.str(), "Filtered A event 7 (orderbook state-aware filtering)") == 1);
+    std::cout << "✓ Async logger formatting and severity filter passed" << std::endl;
+}
+
+void testRateLimit() {
+    std::cout << "Testing async logger rate limit..." << std::endl;
+    std::ostringstream info;
+    std::ostringstream warnings;
+    AsyncLogger logger(info, warnings);
+    logger.setRateLimit(10);
+    
+    // A burst well within one window: the first ten are written, the rest
+    // only counted and reported once
+    for (uint64_t i = 0; i < 500; ++i) {
+        logger.log(LogMessage::DUPLICATE_ORDER, i);
+    }
+    logger.log(LogMessage::FILTERED_CANCEL, 1);
+    logger.flush();
+    
+    assert(countOf(warnings.str(), "already exists") == 10);
+    assert(countOf(warnings.str(), "Suppressed 490 'duplicate order' messages (limit 10/s)") == 1);
+    assert(countOf(info.str(), "Filtered Cancel event") == 1);
+    assert(logger.getCount(LogMessage::DUPLICATE_ORDER) == 500);
+    
+    // Unlimited again: nothing more is suppressed
+    logger.setRateLimit(0);
+    for (uint64_t i = 0; i < 100; ++i) {
+        logger.log(LogMessage::FILTERED_CANCEL, i);
+    }
+    logger.flush();
+    assert(countOf(info.str(), "Filtered Cancel event") == 101);
+    assert(countOf(warnings.str(), "Suppressed") == 1);
+    
+    std::cout << "✓ Async logger rate limit passed" << std::endl;
+}
+
+void testConcurrentLogging() {
+    std::cout << "Testing async logger with concurrent producers..." << std::endl;
+    std::ostringstream info;
+    std::ostringstream warnings;
+    AsyncLogger logger(info, warnings);
+    logger.setRateLimit(0);
+    
+    std::vector<std::thread> producers;
+    for (int p = 0; p < 4; ++p) {
+        producers.emplace_back([&logger]() {
+            for (uint64_t i = 0; i < 2000; ++i) {
+                logger.log(LogMessage::FILTERED_ADD, i);
+            }
+        });
+    }
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+    logger.flush();
+    
+    // All of them arrive unless the ring overflowed, which is then reported
+    size_t written = countOf(info.str(), "following failed Cancel");
+    assert(written == 8000 || countOf(warnings.str(), "Log ring full") == 1);
+    assert(logger.getCount(LogMessage::FILTERED_ADD) == 8000);
+    
+    std::cout << "✓ Concurrent logging passed" << std::endl;
+}
+
+int main() {
+    testMpscRing();
+    testFormattingAndSeverity();
+    testRateLimit();
+    testConcurrentLogging();
+    
+    std::cout << "\n✅ All async logger tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,135 @@
+#include <iostream>
+#include <cassert>
+#include <fstream>
+#include <cstdio>
+#include "book_manager.h"
+#include "mbo_file_reader.h"
+#include "symbology.h"
+
+static MboEvent makeAdd(uint32_t instrument_id, uint64_t order_id, char side, Price price, uint64_t size) {
+    MboEvent event(std::chrono::nanoseconds(1), 'A', side, price, size, order_id);
+    event.instrument_id = instrument_id;
+    return event;
+}
+
+template <typename Book>
+void testRoutesByInstrument() {
+    std::cout << "Testing BookManager routing..." << std::endl;
+    BookManager<Book> books;
+    
+    books.processEvent(makeAdd(1108, 1, 'B', 10 * PRICE_SCALE, 100));
+    books.processEvent(makeAdd(1108, 2, 'A', 11 * PRICE_SCALE, 50));
+    books.processEvent(makeAdd(7, 3, 'B', 20 * PRICE_SCALE, 10));
+    
+    // Large ids bypass the dense index
+    uint32_t sparse_id = BookManager<Book>::DENSE_ID_LIMIT + 5;
+    books.processEvent(makeAdd(sparse_id, 4, 'A', 30 * PRICE_SCALE, 5));
+    
+    assert(books.size() == 3);
+    assert(books.getOrderCount() == 4);
+    assert(books.getBidLevelCount() == 2);
+    assert(books.getAskLevelCount() == 2);
+    
+    assert(books.findBook(1108)->getBestBidPrice() == 10 * PRICE_SCALE);
+    assert(books.findBook(1108)->getBestAskPrice() == 11 * PRICE_SCALE);
+    assert(books.findBook(7)->getBestAskPrice() == 0);
+    assert(books.findBook(sparse_id)->getBestAskPrice() == 30 * PRICE_SCALE);
+    assert(books.findBook(8) == nullptr);
+    
+    // A cancel is applied only to its own instrument's book
+    MboEvent cancel(std::chrono::nanoseconds(2), 'C', 'B', 20 * PRICE_SCALE, 10, 3);
+    cancel.instrument_id = 7;
+    books.processEvent(cancel);
+    assert(books.findBook(7)->getOrderCount() == 0);
+    assert(books.findBook(1108)->getOrderCount() == 2);
+    
+    std::vector<uint32_t> visited;
+    books.forEachBook([&](uint32_t instrument_id, const Book&) { visited.push_back(instrument_id); });
+    assert(visited.size() == 3 && visited[0] == 1108 && visited[1] == 7 && visited[2] == sparse_id);
+    
+    std::cout << "✓ BookManager routing passed" << std::endl;
+}
+
+template <typename Book>
+void testClearReusesBooks() {
+    std::cout << "Testing BookManager clear and reuse..." << std::endl;
+    BookManager<Book> books;
+    
+    books.processEvent(makeAdd(1, 1, 'B', 10 * PRICE_SCALE, 100));
+    books.processEvent(makeAdd(2, 2, 'B', 10 * PRICE_SCALE, 100));
+    const Book* first = books.findBook(1);
+    const Book* second = books.findBook(2);
+    
+    books.clear();
+    assert(books.empty());
+    assert(books.findBook(1) == nullptr);
+    
+    // A new instrument is served from a pooled book, which starts empty
+    Book& reused = books.getBook(3);
+    assert(books.size() == 1);
+    assert(reused.getOrderCount() == 0);
+    assert(&reused == first || &reused == second);
+    assert(books.findBook(3) == &reused);
+    
+    std::cout << "✓ BookManager clear and reuse passed" << std::endl;
+}
+
+void testReaderBuildsSymbology() {
+    std::cout << "Testing symbology from the symbol column..." << std::endl;
+    
+    std::ofstream file("test_symbology.csv");
+    file << "ts_recv,ts_event,rtype,publisher_id,instrument_id,action,side,price,size,channel_id,order_id,flags,ts_in_delta,sequence,symbol\n";
+    file << "2025-07-17T08:05:03.360842448Z,2025-07-17T08:05:03.360677248Z,160,2,1108,A,B,5.51,100,0,1,130,0,1,ARL\n";
+    file << "2025-07-17T08:05:03.360842448Z,2025-07-17T08:05:03.360677248Z,160,1,42,A,A,9.5,100,0,2,130,0,2,XYZ\n";
+    file << "2025-07-17T08:05:03.360842448Z,2025-07-17T08:05:03.360677248Z,160,2,1108,A,B,5.52,100,0,3,130,0,3,ARL\n";
+    file.close();
+    
+    SymbologyTable symbology;
+    MboFileReader reader("test_symbology.csv");
+    reader.setSymbology(&symbology);
+    assert(reader.open());
+    
+    BookManager<OrderBook> books;
+    assert(reader.forEach([&](const MboEvent& event) { books.processEvent(event); }) == 3);
+    reader.close();
+    
+    assert(symbology.size() == 2);
+    assert(symbology.getSymbol(1108) == "ARL");
+    assert(symbology.find(42)->publisher_id == 1);
+    assert(symbology.getSymbol(99).empty());
+    assert(books.size() == 2);
+    assert(books.findBook(1108)->getBidLevelCount() == 2);
+    
+    std::remove("test_symbology.csv");
+    
+    std::cout << "✓ Symbology from the symbol column passed" << std::endl;
+}
+
+void testOrderCapacity() {
+    std::cout << "Testing per-instrument order capacity..." << std::endl;
+    BookManager<OrderBook> books;
+    books.setDefaultOrderCapacity(64);
+    books.setOrderCapacity(1108, 50000);
+    
+    books.processEvent(makeAdd(1108, 1, 'B', 10 * PRICE_SCALE, 100));
+    books.processEvent(makeAdd(7, 2, 'B', 10 * PRICE_SCALE, 100));
+    assert(books.findBook(1108)->getOrderCapacity() >= 50000);
+    assert(books.findBook(7)->getOrderCapacity() < 50000);
+    
+    // Setting it on a live book grows that book in place
+    books.setOrderCapacity(7, 20000);
+    assert(books.findBook(7)->getOrderCapacity() >= 20000);
+    assert(books.findBook(7)->orderExists(2));
+    
+    std::cout << "✓ Per-instrument order capacity passed" << std::endl;
+}
+
+int main() {
+    testRoutesByInstrument<OrderBook>();
+    testRoutesByInstrument<LadderOrderBook>();
+    testClearReusesBooks<OrderBook>();
+    testClearReusesBooks<LadderOrderBook>();
+    testReaderBuildsSymbology();
+    testOrderCapacity();
+    return 0;
+}
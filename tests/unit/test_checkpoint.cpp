@@ -0,0 +1,320 @@
+#include <iostream>
+#include <cassert>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "replay_engine.h"
+#include "mbo_file_reader.h"
+#include "symbology.h"
+
+static const char* INPUT_FILE = "test_checkpoint_input.csv";
+static const char* CHECKPOINT_FILE = "test_checkpoint.ckpt";
+
+static MboEvent makeEvent(char action, char side, Price price, uint64_t size, uint64_t order_id) {
+    MboEvent event(std::chrono::nanoseconds(1), action, side, price, size, order_id);
+    event.instrument_id = 1108;
+    return event;
+}
+
+// Random adds and cancels with a T->F->C sequence every so often, plus adds
+// on a second instrument so the checkpoint holds more than one book
+static void writeInput(size_t event_count) {
+    std::ofstream file(INPUT_FILE);
+    file << "ts_recv,ts_event,rtype,publisher_id,instrument_id,action,side,price,size,channel_id,order_id,flags,ts_in_delta,sequence,symbol\n";
+    file << "2025-07-17T07:05:09.035793433Z,2025-07-17T07:05:09.035627674Z,160,2,1108,R,N,,0,0,0,8,0,0,ARL\n";
+    
+    uint64_t state = 987654321;
+    auto next = [&state]() {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return state >> 33;
+    };
+    
+    std::vector<uint64_t> live_orders;
+    std::vector<char> live_sides;
+    uint64_t next_order_id = 1;
+    
+    for (size_t i = 0; i < event_count; ++i) {
+        std::ostringstream ts;
+        ts << "2025-07-17T08:05:" << (10 + (i / 1000) % 50) << "." << (100000000 + i) << "Z";
+        const std::string stamp = ts.str();
+        int choice = static_cast<int>(next() % 10);
+        
+        if (next() % 8 == 0) {
+            double price = 20.0 - static_cast<int>(next() % 30) * 0.01;
+            file << stamp << "," << stamp << ",160,2,77,A,B," << price << ",5,0," << next_order_id++
+                 << ",130,0," << i + 1 << ",XYZ\n";
+        } else if (choice < 6 || live_orders.size() < 5) {
+            char side = next() % 2 ? 'B' : 'A';
+            int ticks = static_cast<int>(next() % 20);
+            double price = side == 'B' ? 5.50 - ticks * 0.01 : 5.60 + ticks * 0.01;
+            file << stamp << "," << stamp << ",160,2,1108,A," << side << "," << price << "," << (1 + next() % 500)
+                 << ",0," << next_order_id << ",130,0," << i + 1 << ",ARL\n";
+            live_orders.push_back(next_order_id++);
+            live_sides.push_back(side);
+        } else {
+            size_t pick = next() % live_orders.size();
+            if (choice < 9) {
+                file << stamp << "," << stamp << ",160,2,1108,C," << live_sides[pick] << ",0,0,0," << live_orders[pick]
+                     << ",130,0," << i + 1 << ",ARL\n";
+            } else {
+                char trade_side = live_sides[pick] == 'B' ? 'A' : 'B';
+                file << stamp << "," << stamp << ",160,2,1108,T," << trade_side << ",5.5,10,0,0,130,0," << i + 1 << ",ARL\n";
+                file << stamp << "," << stamp << ",160,2,1108,F," << live_sides[pick] << ",5.5,10,0," << live_orders[pick]
+                     << ",130,0," << i + 1 << ",ARL\n";
+                file << stamp << "," << stamp << ",160,2,1108,C," << live_sides[pick] << ",5.5,10,0," << live_orders[pick]
+                     << ",130,0," << i + 1 << ",ARL\n";
+            }
+            live_orders[pick] = live_orders.back();
+            live_orders.pop_back();
+            live_sides[pick] = live_sides.back();
+            live_sides.pop_back();
+        }
+    }
+}
+
+static std::string readFile(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+template <typename Book>
+static void assertSameBook(const Book& a, const OrderBook& b) {
+    MboEvent probe;
+    Mbp50Snapshot left = a.template generateDepthSnapshot<50>(probe);
+    Mbp50Snapshot right = b.template generateDepthSnapshot<50>(probe);
+    assert(left.levels() == right.levels());
+    assert(a.getOrderCount() == b.getOrderCount());
+    assert(a.getBidLevelCount() == b.getBidLevelCount());
+    assert(a.getAskLevelCount() == b.getAskLevelCount());
+    assert(a.isInTradeSequence() == b.isInTradeSequence());
+}
+
+template <typename Book>
+void testBookRoundTrip() {
+    std::cout << "Testing order book checkpoint round trip..." << std::endl;
+    OrderBook original;
+    
+    // Three orders queued at 10.00, two levels on each side, a partial
+    // cancel, and a trade left waiting for its fill
+    original.processEvent(makeEvent('A', 'B', 10 * PRICE_SCALE, 100, 1));
+    original.processEvent(makeEvent('A', 'B', 10 * PRICE_SCALE, 200, 2));
+    original.processEvent(makeEvent('A', 'B', 10 * PRICE_SCALE, 300, 3));
+    original.processEvent(makeEvent('A', 'B', 9 * PRICE_SCALE, 50, 4));
+    original.processEvent(makeEvent('A', 'A', 11 * PRICE_SCALE, 70, 5));
+    original.processEvent(makeEvent('A', 'A', 12 * PRICE_SCALE, 80, 6));
+    original.processEvent(makeEvent('C', 'B', 10 * PRICE_SCALE, 40, 2));
+    original.processEvent(makeEvent('T', 'A', 10 * PRICE_SCALE, 150, 0));
+    
+    std::stringstream buffer;
+    checkpoint::Writer out(buffer);
+    original.saveState(out);
+    assert(out.ok());
+    
+    Book restored;
+    restored.addOrder(99, 42 * PRICE_SCALE, 1, 'A');
+    checkpoint::Reader in(buffer);
+    assert(restored.loadState(in));
+    assert(!restored.orderExists(99));
+    assertSameBook(restored, original);
+    
+    // The pending trade and the FIFO order carry over: the fill and cancel
+    // take the 150 from order 1 then order 2, leaving order 3 untouched
+    const MboEvent follow_up[] = {
+        makeEvent('F', 'B', 10 * PRICE_SCALE, 150, 1),
+        makeEvent('C', 'B', 10 * PRICE_SCALE, 150, 1),
+        makeEvent('A', 'B', 10 * PRICE_SCALE, 25, 7),
+        makeEvent('C', 'A', 11 * PRICE_SCALE, 0, 5),
+    };
+    for (const MboEvent& event : follow_up) {
+        original.processEvent(event);
+        restored.processEvent(event);
+    }
+    assertSameBook(restored, original);
+    assert(!restored.orderExists(1) && restored.orderExists(2) && restored.orderExists(3));
+    
+    // A truncated record is rejected and leaves the book empty
+    std::stringstream full;
+    checkpoint::Writer full_out(full);
+    original.saveState(full_out);
+    std::string bytes = full.str();
+    std::stringstream truncated(bytes.substr(0, bytes.size() - 5));
+    checkpoint::Reader truncated_in(truncated);
+    Book rejected;
+    assert(!rejected.loadState(truncated_in));
+    assert(rejected.getOrderCount() == 0 && rejected.getBidLevelCount() == 0);
+    
+    std::cout << "✓ Order book checkpoint round trip passed" << std::endl;
+}
+
+// Offset of the order count in a saved book: the sequence counter, trade
+// state, two pending sides, pending price and size, and the fill flag
+static const size_t ORDER_COUNT_OFFSET = 8 + 1 + 1 + 1 + 8 + 8 + 1;
+static const size_t ORDER_RECORD_SIZE = 8 + 8 + 8 + 1;
+
+template <typename Book>
+void testRejectsCorruptOrders() {
+    std::cout << "Testing corrupt order records in a book checkpoint..." << std::endl;
+    OrderBook original;
+    original.processEvent(makeEvent('A', 'B', 10 * PRICE_SCALE, 100, 1));
+    original.processEvent(makeEvent('A', 'A', 11 * PRICE_SCALE, 70, 2));
+    
+    std::stringstream buffer;
+    checkpoint::Writer out(buffer);
+    original.saveState(out);
+    const std::string bytes = buffer.str();
+    uint64_t order_count = 0;
+    std::memcpy(&order_count, bytes.data() + ORDER_COUNT_OFFSET, sizeof(order_count));
+    assert(order_count == 2);
+    
+    // A count far beyond what the stream holds is rejected, not reserved
+    std::string huge = bytes;
+    const uint64_t corrupt_count = 1ULL << 60;
+    std::memcpy(&huge[ORDER_COUNT_OFFSET], &corrupt_count, sizeof(corrupt_count));
+    std::stringstream huge_stream(huge);
+    checkpoint::Reader huge_in(huge_stream);
+    Book rejected;
+    assert(!rejected.loadState(huge_in));
+    assert(rejected.getOrderCount() == 0 && rejected.getBidLevelCount() == 0);
+    
+    // A repeated order id is rejected before it takes a second node
+    std::string duplicate = bytes;
+    const size_t first_id = ORDER_COUNT_OFFSET + sizeof(order_count);
+    std::memcpy(&duplicate[first_id + ORDER_RECORD_SIZE], &duplicate[first_id], sizeof(uint64_t));
+    std::stringstream duplicate_stream(duplicate);
+    checkpoint::Reader duplicate_in(duplicate_stream);
+    assert(!rejected.loadState(duplicate_in));
+    assert(rejected.getOrderCount() == 0 && rejected.getAskLevelCount() == 0);
+    
+    // The book is still usable after both rejections
+    std::stringstream good_stream(bytes);
+    checkpoint::Reader good_in(good_stream);
+    assert(rejected.loadState(good_in));
+    assertSameBook(rejected, original);
+    
+    std::cout << "✓ Corrupt order records rejected" << std::endl;
+}
+
+// Replays the input in one go, then again with a checkpoint after
+// stop_after events and a fresh engine resuming from it. The rows written
+// before the checkpoint plus the rows written after the resume must be
+// the uninterrupted output.
+template <typename Book>
+void testResumeMatchesFullReplay(size_t stop_after) {
+    std::cout << "Testing replay resumed after event " << stop_after << "..." << std::endl;
+    
+    ReplayStats full_stats;
+    {
+        SymbologyTable symbology;
+        MboFileReader reader(INPUT_FILE);
+        reader.setSymbology(&symbology);
+        assert(reader.open());
+        MbpCsvWriter writer("test_checkpoint_full.csv");
+        writer.setSymbology(&symbology);
+        assert(writer.initialize());
+        
+        ReplayEngine<Book, MbpCsvWriter> engine(writer);
+        reader.forEach([&](const MboEvent& event) { engine.push(event); });
+        engine.finish();
+        writer.close();
+        full_stats = engine.getStats();
+    }
+    
+    {
+        SymbologyTable symbology;
+        MboFileReader reader(INPUT_FILE);
+        reader.setSymbology(&symbology);
+        assert(reader.open());
+        MbpCsvWriter writer("test_checkpoint_head.csv");
+        writer.setSymbology(&symbology);
+        assert(writer.initialize());
+        
+        ReplayEngine<Book, MbpCsvWriter> engine(writer);
+        MboEvent event;
+        CheckpointPosition position;
+        while (position.events_consumed < stop_after && reader.next(event)) {
+            engine.push(event);
+            ++position.events_consumed;
+            position.last_sequence = event.sequence;
+        }
+        position.input_offset = reader.getBytesConsumed();
+        assert(engine.saveCheckpoint(CHECKPOINT_FILE, position, &symbology));
+        writer.close();
+    }
+    
+    {
+        SymbologyTable symbology;
+        MboFileReader reader(INPUT_FILE);
+        reader.setSymbology(&symbology);
+        assert(reader.open());
+        MbpCsvWriter writer("test_checkpoint_tail.csv");
+        writer.setSymbology(&symbology);
+        assert(writer.initialize());
+        
+        ReplayEngine<Book, MbpCsvWriter> engine(writer);
+        CheckpointPosition position;
+        assert(engine.loadCheckpoint(CHECKPOINT_FILE, position, &symbology));
+        assert(symbology.getSymbol(1108) == "ARL");
+        assert(position.events_consumed == stop_after);
+        assert(reader.seek(position.input_offset));
+        
+        reader.forEach([&](const MboEvent& event) { engine.push(event); });
+        engine.finish();
+        writer.close();
+        
+        const ReplayStats& stats = engine.getStats();
+        assert(stats.processed_events == full_stats.processed_events);
+        assert(stats.snapshots_written == full_stats.snapshots_written);
+        assert(stats.tfc_sequences_detected == full_stats.tfc_sequences_detected);
+        assert(engine.getBooks().size() == 2);
+    }
+    
+    std::string tail = readFile("test_checkpoint_tail.csv");
+    std::string resumed = readFile("test_checkpoint_head.csv") + tail.substr(tail.find('\n') + 1);
+    assert(resumed == readFile("test_checkpoint_full.csv"));
+    
+    std::remove("test_checkpoint_full.csv");
+    std::remove("test_checkpoint_head.csv");
+    std::remove("test_checkpoint_tail.csv");
+    std::remove(CHECKPOINT_FILE);
+    
+    std::cout << "✓ Resumed replay passed" << std::endl;
+}
+
+void testRejectsForeignFile() {
+    std::cout << "Testing checkpoint header validation..." << std::endl;
+    {
+        std::ofstream file(CHECKPOINT_FILE, std::ios::binary);
+        file << "not a checkpoint at all";
+    }
+    MbpCsvWriter writer("test_checkpoint_unused.csv");
+    ReplayEngine<OrderBook, MbpCsvWriter> engine(writer);
+    CheckpointPosition position;
+    assert(!engine.loadCheckpoint(CHECKPOINT_FILE, position));
+    assert(!engine.loadCheckpoint("test_checkpoint_missing.ckpt", position));
+    std::remove(CHECKPOINT_FILE);
+    std::remove("test_checkpoint_unused.csv");
+    std::cout << "✓ Checkpoint header validation passed" << std::endl;
+}
+
+int main() {
+    testBookRoundTrip<OrderBook>();
+    testBookRoundTrip<LadderOrderBook>();
+    testRejectsCorruptOrders<OrderBook>();
+    testRejectsCorruptOrders<LadderOrderBook>();
+    
+    writeInput(20000);
+    // Mid-stream, and right after the initial reset
+    for (size_t stop_after : {7919, 13001, 1}) {
+        testResumeMatchesFullReplay<OrderBook>(stop_after);
+        testResumeMatchesFullReplay<LadderOrderBook>(stop_after);
+    }
+    testRejectsForeignFile();
+    std::remove(INPUT_FILE);
+    
+    std::cout << "\n✅ All checkpoint tests passed!" << std::endl;
+    return 0;
+}
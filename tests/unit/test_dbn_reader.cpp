@@ -0,0 +1,262 @@
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "dbn_mbo.h"
+#include "dbn_file_reader.h"
+#include "symbology.h"
+
+#ifdef ORDERBOOK_ZSTD
+#include <zstd.h>
+#endif
+
+static const char* INPUT_FILE = "test_dbn_input.dbn";
+static const char* COMPRESSED_FILE = "test_dbn_input.dbn.zst";
+
+template <typename T>
+static void put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void putSymbol(std::string& out, const std::string& symbol, size_t width) {
+    std::string padded = symbol;
+    padded.resize(width, '\0');
+    out += padded;
+}
+
+// Metadata header mapping ARL to instrument 1108, in the version 1 or the
+// version 2 layout
+static std::string makeMetadata(uint8_t version) {
+    const size_t width = version == 1 ? 22 : 71;
+    std::string metadata;
+    putSymbol(metadata, "XNAS.ITCH", 16);
+    put<uint16_t>(metadata, 0);
+    put<uint64_t>(metadata, 1752739200000000000ULL);
+    put<uint64_t>(metadata, 1752825600000000000ULL);
+    put<uint64_t>(metadata, 0);
+    if (version == 1) {
+        put<uint64_t>(metadata, 0);
+    }
+    put<uint8_t>(metadata, 1);
+    put<uint8_t>(metadata, 0);
+    put<uint8_t>(metadata, 0);
+    if (version != 1) {
+        put<uint16_t>(metadata, static_cast<uint16_t>(width));
+    }
+    metadata.resize(100, '\0');
+    
+    put<uint32_t>(metadata, 0);
+    put<uint32_t>(metadata, 1);
+    putSymbol(metadata, "ARL", width);
+    put<uint32_t>(metadata, 0);
+    put<uint32_t>(metadata, 0);
+    put<uint32_t>(metadata, 1);
+    putSymbol(metadata, "ARL", width);
+    put<uint32_t>(metadata, 1);
+    put<uint32_t>(metadata, 20250717);
+    put<uint32_t>(metadata, 20250718);
+    putSymbol(metadata, "1108", width);
+    
+    std::string file = "DBN";
+    put<uint8_t>(file, version);
+    put<uint32_t>(file, static_cast<uint32_t>(metadata.size()));
+    return file + metadata;
+}
+
+static MboEvent makeEvent(uint64_t order_id) {
+    MboEvent event(std::chrono::nanoseconds(1752739509035627674LL + static_cast<int64_t>(order_id)), order_id % 3 == 0 ? 'C' : 'A',
+                   order_id % 2 == 0 ? 'B' : 'A', 5510000000LL + static_cast<Price>(order_id % 50) * 10000000LL, 100, order_id);
+    event.ts_recv = event.ts_event + std::chrono::nanoseconds(165759);
+    event.instrument_id = 1108;
+    event.publisher_id = 2;
+    event.channel_id = 7;
+    event.flags = 130;
+    event.ts_in_delta = 165200;
+    event.sequence = 851012 + order_id;
+    return event;
+}
+
+// count MBO records with a 40-byte status record after every thousandth,
+// which the reader has to pass over
+static std::string makeRecords(size_t count) {
+    std::string records;
+    for (size_t i = 0; i < count; ++i) {
+        dbn_mbo::Record record;
+        dbn_mbo::encode(makeEvent(i + 1), record);
+        records.append(reinterpret_cast<const char*>(&record), sizeof(record));
+        if ((i + 1) % 1000 == 0) {
+            std::string status(40, '\0');
+            status[0] = 10;
+            status[1] = 0x12;
+            records += status;
+        }
+    }
+    return records;
+}
+
+static void writeFile(const char* path, const std::string& contents) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+}
+
+static size_t readAll(const char* path, std::vector<MboEvent>& events, SymbologyTable* symbology = nullptr) {
+    DbnFileReader reader(path);
+    reader.setSymbology(symbology);
+    assert(reader.open());
+    MboEvent event;
+    while (reader.next(event)) {
+        events.push_back(event);
+    }
+    return reader.getSkippedRecords();
+}
+
+void testFileNames() {
+    std::cout << "Testing DBN file name detection..." << std::endl;
+    assert(DbnFileReader::isDbnFile("xnas-itch-20250717.mbo.dbn"));
+    assert(DbnFileReader::isDbnFile("data/mbo.dbn.zst"));
+    assert(!DbnFileReader::isDbnFile("mbo.csv"));
+    assert(!DbnFileReader::isDbnFile("dbn"));
+    assert(!DbnFileReader::isDbnFile("mbo.zst"));
+    std::cout << "✓ DBN file name detection passed" << std::endl;
+}
+
+// Enough records that every buffer ends part-way through one
+void testDecodeFile() {
+    std::cout << "Testing DBN file decoding across buffers..." << std::endl;
+    const size_t COUNT = 50000;
+    writeFile(INPUT_FILE, makeMetadata(2) + makeRecords(COUNT));
+    
+    std::vector<MboEvent> events;
+    SymbologyTable symbology;
+    size_t skipped = readAll(INPUT_FILE, events, &symbology);
+    assert(events.size() == COUNT);
+    assert(skipped == COUNT / 1000);
+    
+    for (size_t i = 0; i < COUNT; ++i) {
+        MboEvent expected = makeEvent(i + 1);
+        const MboEvent& event = events[i];
+        assert(event.order_id == expected.order_id);
+        assert(event.ts_event == expected.ts_event && event.ts_recv == expected.ts_recv);
+        assert(event.action == expected.action && event.side == expected.side);
+        assert(event.price == expected.price && event.size == 100);
+        assert(event.channel_id == 7 && event.flags == 130 && event.ts_in_delta == 165200);
+        assert(event.sequence == expected.sequence && event.instrument_id == 1108 && event.publisher_id == 2);
+    }
+    
+    assert(symbology.getSymbol(1108) == "ARL");
+    assert(symbology.find(1108)->publisher_id == 2);
+    
+    std::remove(INPUT_FILE);
+    std::cout << "✓ DBN file decoding passed" << std::endl;
+}
+
+void testVersion1Metadata() {
+    std::cout << "Testing DBN version 1 metadata..." << std::endl;
+    writeFile(INPUT_FILE, makeMetadata(1) + makeRecords(10));
+    
+    DbnFileReader reader(INPUT_FILE);
+    SymbologyTable symbology;
+    reader.setSymbology(&symbology);
+    assert(reader.open());
+    assert(reader.getVersion() == 1);
+    MboEvent event;
+    size_t count = 0;
+    while (reader.next(event)) {
+        ++count;
+    }
+    assert(count == 10);
+    assert(symbology.getSymbol(1108) == "ARL");
+    
+    reader.close();
+    std::remove(INPUT_FILE);
+    std::cout << "✓ DBN version 1 metadata passed" << std::endl;
+}
+
+void testBadInput() {
+    std::cout << "Testing truncated and invalid DBN input..." << std::endl;
+    
+    // A cut-off last record ends the stream after the whole ones
+    std::string contents = makeMetadata(2) + makeRecords(100);
+    writeFile(INPUT_FILE, contents.substr(0, contents.size() - 20));
+    std::vector<MboEvent> events;
+    readAll(INPUT_FILE, events);
+    assert(events.size() == 99);
+    
+    // A zero record length cannot be framed past
+    contents = makeMetadata(2) + makeRecords(100);
+    contents[makeMetadata(2).size() + 50 * dbn_mbo::RECORD_SIZE] = 0;
+    writeFile(INPUT_FILE, contents);
+    events.clear();
+    readAll(INPUT_FILE, events);
+    assert(events.size() == 50);
+    
+    writeFile(INPUT_FILE, "ts_recv,ts_event,rtype\n");
+    DbnFileReader csv(INPUT_FILE);
+    assert(!csv.open());
+    
+    std::string unsupported = makeMetadata(2);
+    unsupported[3] = 9;
+    writeFile(INPUT_FILE, unsupported);
+    DbnFileReader future(INPUT_FILE);
+    assert(!future.open());
+    
+    std::string trades = makeMetadata(2);
+    trades[8 + 16] = 4;
+    writeFile(INPUT_FILE, trades);
+    DbnFileReader wrong_schema(INPUT_FILE);
+    assert(!wrong_schema.open());
+    
+    DbnFileReader missing("test_dbn_missing.dbn");
+    assert(!missing.open());
+    
+    std::remove(INPUT_FILE);
+    std::cout << "✓ Truncated and invalid DBN input passed" << std::endl;
+}
+
+void testCompressedFile() {
+    std::cout << "Testing zstd-compressed DBN input..." << std::endl;
+#ifdef ORDERBOOK_ZSTD
+    const size_t COUNT = 50000;
+    std::string contents = makeMetadata(2) + makeRecords(COUNT);
+    std::string compressed(ZSTD_compressBound(contents.size()), '\0');
+    size_t compressed_size = ZSTD_compress(&compressed[0], compressed.size(), contents.data(), contents.size(), 3);
+    assert(!ZSTD_isError(compressed_size));
+    compressed.resize(compressed_size);
+    writeFile(COMPRESSED_FILE, compressed);
+    
+    std::vector<MboEvent> events;
+    readAll(COMPRESSED_FILE, events);
+    assert(events.size() == COUNT);
+    assert(events.front().order_id == 1 && events.back().order_id == COUNT);
+    
+    // A cut-off frame still yields what was decompressed before the cut
+    writeFile(COMPRESSED_FILE, compressed.substr(0, compressed.size() / 2));
+    events.clear();
+    readAll(COMPRESSED_FILE, events);
+    assert(!events.empty() && events.size() < COUNT);
+    assert(events.back().order_id == events.size());
+    std::cout << "✓ zstd-compressed DBN input passed" << std::endl;
+#else
+    // Without zstd support the file is recognised and refused
+    const uint8_t magic[] = {0x28, 0xB5, 0x2F, 0xFD, 0, 0, 0, 0};
+    writeFile(COMPRESSED_FILE, std::string(reinterpret_cast<const char*>(magic), sizeof(magic)));
+    DbnFileReader reader(COMPRESSED_FILE);
+    assert(!reader.open());
+    std::cout << "✓ zstd-compressed DBN input refused without ZSTD=1" << std::endl;
+#endif
+    std::remove(COMPRESSED_FILE);
+}
+
+int main() {
+    testFileNames();
+    testDecodeFile();
+    testVersion1Metadata();
+    testBadInput();
+    testCompressedFile();
+    
+    std::cout << "\n✅ All DBN reader tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,152 @@
+#include <iostream>
+#include <cassert>
+#include <vector>
+#include "event_buffer.h"
+#include "conflating_writer.h"
+
+static MboEvent makeEvent(int64_t ts, char action, char side, Price price, uint64_t size, uint64_t order_id,
+                          uint64_t sequence, uint32_t instrument_id = 1108) {
+    MboEvent event(std::chrono::nanoseconds(ts), action, side, price, size, order_id);
+    event.sequence = sequence;
+    event.instrument_id = instrument_id;
+    return event;
+}
+
+void testOrderAnnihilation() {
+    std::cout << "Testing order annihilation..." << std::endl;
+    EventBuffer buffer;
+    
+    assert(buffer.addEvent(makeEvent(1000, 'A', 'B', 10 * PRICE_SCALE, 100, 1, 1)));
+    assert(buffer.addEvent(makeEvent(1001, 'A', 'A', 11 * PRICE_SCALE, 50, 2, 2)));
+    assert(buffer.addEvent(makeEvent(1002, 'C', 'B', 10 * PRICE_SCALE, 100, 1, 3)));
+    // Same order id on another instrument is a different order
+    assert(buffer.addEvent(makeEvent(1003, 'C', 'A', 11 * PRICE_SCALE, 50, 2, 4, 7)));
+    // Filled before its cancel, so it has to reach the book
+    assert(buffer.addEvent(makeEvent(1004, 'A', 'B', 9 * PRICE_SCALE, 30, 3, 5)));
+    assert(buffer.addEvent(makeEvent(1005, 'F', 'B', 9 * PRICE_SCALE, 10, 3, 6)));
+    assert(buffer.addEvent(makeEvent(1006, 'C', 'B', 9 * PRICE_SCALE, 20, 3, 7)));
+    
+    // Outside the 1 ms window
+    assert(!buffer.addEvent(makeEvent(1000 + 2000000, 'A', 'B', 10 * PRICE_SCALE, 1, 9, 8)));
+    
+    assert(buffer.applyOrderAnnihilation() == 1);
+    
+    const std::vector<MboEvent>& events = buffer.getConsolidatedEvents();
+    assert(events.size() == 5);
+    uint64_t expected_sequences[] = {2, 4, 5, 6, 7};
+    for (size_t i = 0; i < events.size(); ++i) {
+        assert(events[i].sequence == expected_sequences[i]);
+    }
+    
+    EventBuffer::ConsolidationStats stats = buffer.getLastStats();
+    assert(stats.original_count == 7);
+    assert(stats.annihilated_pairs == 1);
+    assert(stats.final_count == 5);
+    
+    std::cout << "✓ Order annihilation passed" << std::endl;
+}
+
+void testSameLevelBatching() {
+    std::cout << "Testing same-level batching..." << std::endl;
+    EventBuffer buffer;
+    
+    buffer.addEvent(makeEvent(1000, 'A', 'B', 10 * PRICE_SCALE, 100, 1, 10));
+    buffer.addEvent(makeEvent(1001, 'T', 'A', 10 * PRICE_SCALE, 5, 0, 11));
+    buffer.addEvent(makeEvent(1002, 'A', 'B', 10 * PRICE_SCALE, 40, 2, 12));
+    buffer.addEvent(makeEvent(1003, 'A', 'A', 10 * PRICE_SCALE, 7, 3, 13));
+    buffer.addEvent(makeEvent(1004, 'A', 'B', 10 * PRICE_SCALE, 1, 4, 14, 7));
+    buffer.addEvent(makeEvent(1005, 'A', 'B', 10 * PRICE_SCALE, 60, 5, 9));
+    
+    assert(buffer.applySameLevelBatching() == 2);
+    
+    const std::vector<MboEvent>& events = buffer.getConsolidatedEvents();
+    assert(events.size() == 4);
+    
+    // The merged level takes the lowest sequence, which sorts it first
+    assert(events[0].order_id == 1);
+    assert(events[0].size == 200);
+    assert(events[0].sequence == 9);
+    assert(events[1].action == 'T');
+    assert(events[2].side == 'A' && events[2].size == 7);
+    assert(events[3].instrument_id == 7 && events[3].size == 1);
+    
+    std::cout << "✓ Same-level batching passed" << std::endl;
+}
+
+void testTableReuseAcrossWindows() {
+    std::cout << "Testing table reuse across windows..." << std::endl;
+    EventBuffer buffer;
+    
+    // Each window reuses the slots of the last; stale slots must not match
+    for (uint64_t window = 0; window < 500; ++window) {
+        buffer.clear();
+        size_t orders = 1 + window % 300;
+        for (uint64_t i = 0; i < orders; ++i) {
+            assert(buffer.addEvent(makeEvent(1000, 'A', 'B', (10 + i) * PRICE_SCALE, 1, i, 2 * i)));
+        }
+        for (uint64_t i = 0; i < orders; i += 2) {
+            assert(buffer.addEvent(makeEvent(1000, 'C', 'B', (10 + i) * PRICE_SCALE, 1, i, 2 * i + 1)));
+        }
+        
+        size_t pairs = buffer.applyOrderAnnihilation();
+        assert(pairs == (orders + 1) / 2);
+        assert(buffer.size() == orders - pairs);
+        assert(buffer.applySameLevelBatching() == 0);
+    }
+    
+    std::cout << "✓ Table reuse passed" << std::endl;
+}
+
+struct RecordingWriter {
+    std::vector<MbpSnapshot> rows;
+    std::vector<uint64_t> row_indices;
+    
+    bool writeSnapshot(const MbpSnapshot& snapshot, uint64_t row_index) {
+        rows.push_back(snapshot);
+        row_indices.push_back(row_index);
+        return true;
+    }
+};
+
+void testConflatingWriter() {
+    std::cout << "Testing conflating writer..." << std::endl;
+    ConflatingWriter conflator;
+    RecordingWriter writer;
+    
+    MbpSnapshot snapshot;
+    snapshot.instrument_id = 5;
+    snapshot.sequence_number = 1;
+    conflator.writeSnapshot(snapshot, 0);
+    snapshot.instrument_id = 3;
+    snapshot.sequence_number = 2;
+    conflator.writeSnapshot(snapshot, 1);
+    snapshot.instrument_id = 5;
+    snapshot.sequence_number = 3;
+    conflator.writeSnapshot(snapshot, 2);
+    
+    assert(conflator.flushTo(writer) == 2);
+    assert(writer.rows.size() == 2);
+    assert(writer.rows[0].instrument_id == 5 && writer.rows[0].sequence_number == 3);
+    assert(writer.rows[1].instrument_id == 3 && writer.rows[1].sequence_number == 2);
+    
+    // Nothing changed since the flush
+    assert(conflator.flushTo(writer) == 0);
+    
+    snapshot.instrument_id = 3;
+    snapshot.sequence_number = 4;
+    conflator.writeSnapshot(snapshot, 3);
+    assert(conflator.flushTo(writer) == 1);
+    assert(writer.rows.back().sequence_number == 4);
+    assert(writer.row_indices.back() == 2);
+    assert(conflator.getRowsWritten() == 3);
+    
+    std::cout << "✓ Conflating writer passed" << std::endl;
+}
+
+int main() {
+    testOrderAnnihilation();
+    testSameLevelBatching();
+    testTableReuseAcrossWindows();
+    testConflatingWriter();
+    return 0;
+}
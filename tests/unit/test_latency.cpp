@@ -0,0 +1,113 @@
+#include <iostream>
+#include <cassert>
+#include <sstream>
+#include <string>
+#include "latency.h"
+
+void testBuckets() {
+    std::cout << "Testing latency histogram buckets..." << std::endl;
+    
+    // Exact below SUB_BUCKETS, then contiguous with SUB_BUCKETS per octave
+    for (uint64_t value = 0; value < LatencyHistogram::SUB_BUCKETS; ++value) {
+        assert(LatencyHistogram::bucketOf(value) == value);
+    }
+    size_t previous = LatencyHistogram::bucketOf(LatencyHistogram::SUB_BUCKETS - 1);
+    for (uint64_t value = LatencyHistogram::SUB_BUCKETS; value < 100000; ++value) {
+        size_t bucket = LatencyHistogram::bucketOf(value);
+        assert(bucket == previous || bucket == previous + 1);
+        assert(LatencyHistogram::bucketTop(bucket) >= value);
+        // A bucket spans at most 1/SUB_BUCKETS of its values
+        assert((LatencyHistogram::bucketTop(bucket) - value) * LatencyHistogram::SUB_BUCKETS <= value);
+        previous = bucket;
+    }
+    assert(LatencyHistogram::bucketOf(UINT64_MAX) == LatencyHistogram::BUCKET_COUNT - 1);
+    assert(LatencyHistogram::bucketTop(LatencyHistogram::BUCKET_COUNT - 1) == UINT64_MAX);
+    
+    std::cout << "✓ Latency histogram buckets passed" << std::endl;
+}
+
+void testPercentiles() {
+    std::cout << "Testing latency histogram percentiles..." << std::endl;
+    LatencyHistogram histogram;
+    assert(histogram.percentile(0.5) == 0 && histogram.getCount() == 0);
+    
+    // 1..10000 once each, plus one outlier the tail must report
+    for (uint64_t value = 1; value <= 10000; ++value) {
+        histogram.record(value);
+    }
+    histogram.record(5000000);
+    assert(histogram.getCount() == 10001);
+    assert(histogram.getMax() == 5000000);
+    
+    auto near = [](uint64_t measured, uint64_t expected) {
+        return measured >= expected && measured - expected <= expected / LatencyHistogram::SUB_BUCKETS;
+    };
+    assert(near(histogram.percentile(0.50), 5001));
+    assert(near(histogram.percentile(0.99), 9901));
+    assert(near(histogram.percentile(0.999), 9991));
+    assert(histogram.percentile(1.0) == 5000000);
+    
+    LatencyHistogram other;
+    other.record(7);
+    other.record(9000000);
+    histogram.merge(other);
+    assert(histogram.getCount() == 10003);
+    assert(histogram.getMax() == 9000000);
+    
+    histogram.clear();
+    assert(histogram.getCount() == 0 && histogram.getMax() == 0);
+    
+    std::cout << "✓ Latency histogram percentiles passed" << std::endl;
+}
+
+void testRecorder() {
+    std::cout << "Testing latency recorder..." << std::endl;
+    
+    LatencyRecorder disabled(false);
+    assert(!disabled.isEnabled());
+    
+    LatencyRecorder recorder(true);
+    LatencyRecorder shard(true);
+    for (uint64_t i = 0; i < 100; ++i) {
+        recorder.record(latencyStageOf('A'), 100 + i);
+        shard.record(LatencyStage::SNAPSHOT, 200);
+    }
+    recorder.merge(shard);
+    recorder.merge(disabled);
+    disabled.merge(recorder);
+    assert(!disabled.isEnabled());
+    assert(recorder.getHistogram(LatencyStage::ADD).getCount() == 100);
+    assert(recorder.getHistogram(LatencyStage::SNAPSHOT).getCount() == 100);
+    assert(recorder.getHistogram(LatencyStage::CANCEL).getCount() == 0);
+    assert(latencyStageOf('F') == LatencyStage::FILL && latencyStageOf('X') == LatencyStage::OTHER);
+    
+    // The report lists only stages with samples
+    std::ostringstream report;
+    recorder.report(report);
+    assert(report.str().find("add") != std::string::npos);
+    assert(report.str().find("snapshot") != std::string::npos);
+    assert(report.str().find("cancel") == std::string::npos);
+    
+    // The metrics file gets a row for every stage
+    std::ostringstream metrics;
+    LatencyRecorder::writeMetricsHeader(metrics);
+    recorder.writeMetrics(metrics, 42);
+    std::string rows = metrics.str();
+    size_t lines = 0;
+    for (char c : rows) {
+        lines += c == '\n';
+    }
+    assert(lines == 1 + static_cast<size_t>(LatencyStage::COUNT));
+    assert(rows.find("\n42,add,100,") != std::string::npos);
+    
+    std::cout << "✓ Latency recorder passed" << std::endl;
+}
+
+int main() {
+    testBuckets();
+    testPercentiles();
+    testRecorder();
+    
+    std::cout << "\n✅ All latency tests passed!" << std::endl;
+    return 0;
+}
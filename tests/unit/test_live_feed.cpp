@@ -0,0 +1,228 @@
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "dbn_mbo.h"
+#include "mbo_feed_reader.h"
+#include "packet_receiver.h"
+#include "replay_engine.h"
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+
+static MboEvent makeEvent(char action, char side, Price price, uint64_t size, uint64_t order_id, uint32_t instrument_id) {
+    MboEvent event(std::chrono::nanoseconds(1752739509035627674LL + static_cast<int64_t>(order_id)), action, side, price,
+                   size, order_id);
+    event.instrument_id = instrument_id;
+    event.publisher_id = 2;
+    event.flags = 130;
+    event.sequence = order_id;
+    return event;
+}
+
+// One feed datagram: header, then the records
+static std::string makePacket(uint64_t sequence, const std::vector<MboEvent>& events) {
+    mbo_feed::PacketHeader header = {sequence, static_cast<uint16_t>(events.size()), 0, 0};
+    std::string packet(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const MboEvent& event : events) {
+        dbn_mbo::Record record;
+        dbn_mbo::encode(event, record);
+        packet.append(reinterpret_cast<const char*>(&record), sizeof(record));
+    }
+    return packet;
+}
+
+// In-memory backend: hands out its packets two per batch, then reports
+// the end of the feed as an error
+class ScriptedReceiver : public PacketReceiver {
+public:
+    std::vector<std::string> packets;
+    
+    ScriptedReceiver() : next_(0) {}
+    
+    bool open() override { return true; }
+    
+    bool receive(PacketBatch& batch) override {
+        batch.count = 0;
+        if (next_ == packets.size()) {
+            return false;
+        }
+        while (next_ < packets.size() && batch.count < 2) {
+            batch.data[batch.count] = packets[next_].data();
+            batch.length[batch.count] = packets[next_].size();
+            ++batch.count;
+            ++next_;
+        }
+        return true;
+    }
+
+private:
+    size_t next_;
+};
+
+void testRecordCodec() {
+    std::cout << "Testing DBN MBO record encode/decode..." << std::endl;
+    MboEvent original = makeEvent('A', 'B', 5510000000LL, 100, 817593, 1108);
+    original.ts_in_delta = 165200;
+    
+    dbn_mbo::Record record;
+    dbn_mbo::encode(original, record);
+    const char* bytes = reinterpret_cast<const char*>(&record);
+    assert(dbn_mbo::recordSize(bytes, sizeof(record)) == dbn_mbo::RECORD_SIZE);
+    assert(dbn_mbo::recordSize(bytes, 8) == 0);
+    
+    MboEvent decoded;
+    assert(dbn_mbo::decode(bytes, sizeof(record), decoded));
+    assert(decoded.ts_event == original.ts_event);
+    assert(decoded.action == 'A' && decoded.side == 'B');
+    assert(decoded.price == original.price && decoded.size == 100 && decoded.order_id == 817593);
+    assert(decoded.flags == 130 && decoded.ts_in_delta == 165200 && decoded.sequence == 817593);
+    assert(decoded.instrument_id == 1108 && decoded.publisher_id == 2);
+    
+    // A reset carries the undefined price on the wire and 0 in the event
+    MboEvent reset = makeEvent('R', 'N', 0, 0, 0, 1108);
+    dbn_mbo::encode(reset, record);
+    assert(record.price == dbn_mbo::UNDEF_PRICE);
+    assert(dbn_mbo::decode(bytes, sizeof(record), decoded) && decoded.price == 0 && decoded.action == 'R');
+    
+    // Other record types and short records are not MBO events
+    record.rtype = 0x17;
+    assert(!dbn_mbo::decode(bytes, sizeof(record), decoded));
+    record.rtype = dbn_mbo::RTYPE_MBO;
+    assert(!dbn_mbo::decode(bytes, dbn_mbo::RECORD_SIZE - 4, decoded));
+    
+    std::cout << "✓ DBN MBO record codec passed" << std::endl;
+}
+
+void testFeedSequencing() {
+    std::cout << "Testing feed decoding, gaps and late packets..." << std::endl;
+    ScriptedReceiver receiver;
+    receiver.packets.push_back(makePacket(1, {makeEvent('A', 'B', 100, 10, 1, 1108), makeEvent('A', 'A', 101, 10, 2, 1108)}));
+    receiver.packets.push_back(makePacket(2, {makeEvent('A', 'B', 200, 10, 3, 77)}));
+    
+    // A system record in the middle of a packet is skipped
+    std::string mixed = makePacket(3, {makeEvent('A', 'B', 100, 5, 4, 1108), makeEvent('C', 'B', 100, 5, 4, 1108)});
+    mixed[sizeof(mbo_feed::PacketHeader) + 1] = 0x17;
+    receiver.packets.push_back(mixed);
+    
+    // Packets 4 and 5 are lost; 3 arrives again late
+    receiver.packets.push_back(makePacket(6, {makeEvent('A', 'A', 102, 7, 5, 1108)}));
+    receiver.packets.push_back(makePacket(3, {makeEvent('A', 'B', 999, 1, 6, 1108)}));
+    receiver.packets.push_back(std::string("short"));
+    receiver.packets.push_back(makePacket(7, {makeEvent('A', 'B', 99, 1, 7, 1108)}));
+    
+    MboFeedReader feed(receiver);
+    std::vector<MboEvent> events;
+    MboEvent event;
+    while (feed.next(event)) {
+        events.push_back(event);
+    }
+    
+    // Three adds, the surviving cancel, a reset per instrument, two adds
+    assert(events.size() == 8);
+    assert(events[0].order_id == 1 && events[1].order_id == 2 && events[2].instrument_id == 77);
+    assert(events[3].action == 'C' && events[3].order_id == 4);
+    assert(events[4].action == 'R' && events[5].action == 'R');
+    assert(events[4].instrument_id != events[5].instrument_id);
+    assert(events[4].instrument_id == 77 || events[4].instrument_id == 1108);
+    assert(events[6].order_id == 5 && events[7].order_id == 7);
+    
+    const FeedStats& stats = feed.getStats();
+    assert(stats.packets == 5 && stats.records == 6);
+    assert(stats.gaps == 1 && stats.packets_lost == 2 && stats.resets_issued == 2);
+    assert(stats.stale_packets == 1 && stats.malformed_packets == 1);
+    
+    std::cout << "✓ Feed sequencing passed" << std::endl;
+}
+
+// The engine sees the feed exactly as it would a file: after a gap the
+// instrument's book is cleared through the reset path and rebuilt
+void testEngineResyncOnGap() {
+    std::cout << "Testing book resync after a feed gap..." << std::endl;
+    ScriptedReceiver receiver;
+    receiver.packets.push_back(makePacket(10, {makeEvent('A', 'B', 5 * PRICE_SCALE, 10, 1, 1108),
+                                               makeEvent('A', 'A', 6 * PRICE_SCALE, 10, 2, 1108)}));
+    receiver.packets.push_back(makePacket(12, {makeEvent('A', 'B', 4 * PRICE_SCALE, 3, 3, 1108)}));
+    
+    MbpCsvWriter writer("test_live_feed_output.csv");
+    assert(writer.initialize());
+    ReplayEngine<OrderBook, MbpCsvWriter> engine(writer);
+    MboFeedReader feed(receiver);
+    MboEvent event;
+    while (feed.next(event)) {
+        engine.push(event);
+    }
+    engine.finish();
+    writer.close();
+    std::remove("test_live_feed_output.csv");
+    
+    const OrderBook* book = engine.getBooks().findBook(1108);
+    assert(book);
+    assert(!book->orderExists(1) && !book->orderExists(2) && book->orderExists(3));
+    assert(book->getBidLevelCount() == 1 && book->getAskLevelCount() == 0);
+    // Two adds, the reset and the add after it
+    assert(engine.getStats().snapshots_written == 4);
+    
+    std::cout << "✓ Book resync after a feed gap passed" << std::endl;
+}
+
+void testUdpLoopback() {
+    std::cout << "Testing UDP receive over loopback..." << std::endl;
+#ifdef _WIN32
+    std::cout << "✓ UDP loopback skipped on this platform" << std::endl;
+#else
+    MulticastConfig config;
+    config.group = "127.0.0.1";
+    config.port = 0;
+    UdpMulticastReceiver receiver(config);
+    if (!receiver.open()) {
+        std::cout << "✓ UDP loopback skipped, no socket available" << std::endl;
+        return;
+    }
+    
+    int sender = socket(AF_INET, SOCK_DGRAM, 0);
+    assert(sender >= 0);
+    sockaddr_in target;
+    std::memset(&target, 0, sizeof(target));
+    target.sin_family = AF_INET;
+    target.sin_port = htons(receiver.getBoundPort());
+    inet_pton(AF_INET, "127.0.0.1", &target.sin_addr);
+    
+    const uint64_t PACKETS = 100;
+    for (uint64_t sequence = 1; sequence <= PACKETS; ++sequence) {
+        std::string packet = makePacket(sequence, {makeEvent('A', 'B', 100, 1, sequence * 2, 1108),
+                                                   makeEvent('A', 'A', 101, 1, sequence * 2 + 1, 1108)});
+        assert(sendto(sender, packet.data(), packet.size(), 0, reinterpret_cast<sockaddr*>(&target), sizeof(target)) ==
+               static_cast<ssize_t>(packet.size()));
+    }
+    ::close(sender);
+    
+    MboFeedReader feed(receiver);
+    feed.setIdleTimeout(std::chrono::milliseconds(200));
+    size_t count = 0;
+    MboEvent event;
+    while (feed.next(event)) {
+        assert(event.order_id == count + 2);
+        ++count;
+    }
+    assert(count == PACKETS * 2);
+    assert(feed.getStats().gaps == 0);
+    std::cout << "✓ UDP loopback passed" << std::endl;
+#endif
+}
+
+int main() {
+    testRecordCodec();
+    testFeedSequencing();
+    testEngineResyncOnGap();
+    testUdpLoopback();
+    
+    std::cout << "\n✅ All live feed tests passed!" << std::endl;
+    return 0;
+}
@@ -1,7 +1,16 @@
 #include <iostream>
 #include <cassert>
 #include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <vector>
+#include <thread>
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
 #include "mbo_parser.h"
+#include "mbo_file_reader.h"
+#include "symbology.h"
 
 void testMboParser() {
     std::cout << "Running MBO Parser Unit Tests..." << std::endl;
@@ -20,19 +29,19 @@ void testMboParser() {
     
     assert(events[0].action == 'A');
     assert(events[0].side == 'B');
-    assert(events[0].price == 5.51);
+    assert(events[0].price == 5510000000LL);
     assert(events[0].size == 100);
     assert(events[0].order_id == 817593);
     
     assert(events[1].action == 'A');
     assert(events[1].side == 'A');
-    assert(events[1].price == 21.33);
+    assert(events[1].price == 21330000000LL);
     assert(events[1].size == 200);
     assert(events[1].order_id == 817597);
     
     assert(events[2].action == 'C');
     assert(events[2].side == 'B');
-    assert(events[2].price == 5.51);
+    assert(events[2].price == 5510000000LL);
     assert(events[2].size == 50);
     assert(events[2].order_id == 817593);
     
@@ -41,7 +50,274 @@ void testMboParser() {
     std::cout << "✓ All MBO Parser tests passed!" << std::endl;
 }
 
+void testPriceTickParsing() {
+    std::cout << "Running MBO Parser price tick tests..." << std::endl;
+    
+    MboEvent event;
+    
+    // Prices decode straight into 1e-9 ticks without going through a double
+    assert(MboParser::parseLine("2025-07-17T08:05:03.360842448Z,2025-07-17T08:05:03.360677248Z,160,2,1108,A,B,5.510000000,100,0,817593,130,165200,851012,ARL", event));
+    assert(event.price == 5510000000LL);
+    
+    assert(MboParser::parseLine("2025-07-17T08:05:03.360842448Z,2025-07-17T08:05:03.360677248Z,160,2,1108,A,A,1234.000000001,100,0,817594,130,165200,851013,ARL", event));
+    assert(event.price == 1234000000001LL);
+    
+    assert(MboParser::parseLine("2025-07-17T08:05:03.360842448Z,2025-07-17T08:05:03.360677248Z,160,2,1108,A,A,21.3,100,0,817595,130,165200,851014,ARL", event));
+    assert(event.price == 21300000000LL);
+    
+    // Empty price field (e.g. the initial 'R' event) maps to zero ticks
+    assert(MboParser::parseLine("2025-07-17T07:05:09.035793433Z,2025-07-17T07:05:09.035627674Z,160,2,1108,R,N,,0,0,0,8,0,0,ARL", event));
+    assert(event.price == 0);
+    
+    std::cout << "✓ Price tick parsing tests passed!" << std::endl;
+}
+
+void testTimestampDecoding() {
+    std::cout << "Running MBO Parser timestamp tests..." << std::endl;
+    
+    auto decode = [](const char* text) {
+        std::chrono::nanoseconds ts(0);
+        assert(MboParser::parseTimestamp(text, text + std::strlen(text), ts));
+        return static_cast<uint64_t>(ts.count());
+    };
+    
+    assert(decode("2025-07-17T08:05:03.360677248Z") == 1752739503360677248ULL);
+    
+    // Leap day, short fraction padded to nanoseconds
+    assert(decode("2024-02-29T23:59:59.5Z") == 1709251199500000000ULL);
+    
+    // No fractional part, and a date change after the cached one
+    assert(decode("1999-12-31T00:00:00Z") == 946598400000000000ULL);
+    assert(decode("2025-07-17T08:05:03.360677248Z") == 1752739503360677248ULL);
+    
+    // Non-fixed layouts still go through the general parser
+    assert(decode("2025-7-17T08:05:03.360677248Z") == 1752739503360677248ULL);
+    
+    std::cout << "✓ Timestamp decoding tests passed!" << std::endl;
+}
+
+void testFieldSplitting() {
+    std::cout << "Running MBO Parser field splitting tests..." << std::endl;
+    
+    // Long enough to cross several vector blocks, with empty fields
+    std::string line = "2025-07-17T07:05:09.035793433Z,2025-07-17T07:05:09.035627674Z,160,2,1108,R,N,,0,0,0,8,0,0,ARL";
+    const char* starts[15];
+    size_t count = MboParser::findFieldStarts(line.data(), line.data() + line.size(), starts, 15);
+    assert(count == 15);
+    assert(starts[0] == line.data());
+    assert(std::string(starts[5], starts[6] - 1) == "R");
+    assert(starts[8] - starts[7] == 1);
+    assert(std::string(starts[14], static_cast<const char*>(line.data() + line.size())) == "ARL");
+    
+    // Stops at max_fields
+    assert(MboParser::findFieldStarts(line.data(), line.data() + line.size(), starts, 4) == 4);
+    
+    // Rows missing the sequence field are rejected
+    MboEvent event;
+    assert(!MboParser::parseLine("2025-07-17T07:05:09.035793433Z,2025-07-17T07:05:09.035627674Z,160,2,1108,A,B,5.51,100,0,817593,130", event));
+    
+    std::cout << "✓ Field splitting tests passed!" << std::endl;
+}
+
+void testFileReaderStreaming() {
+    std::cout << "Running MBO File Reader streaming tests..." << std::endl;
+    
+    // CRLF endings, a blank line and no trailing newline on the last row
+    std::string test_filename = "test_mbo_stream.csv";
+    std::ofstream test_file(test_filename, std::ios::binary);
+    test_file << "ts_recv,ts_event,rtype,publisher_id,instrument_id,action,side,price,size,channel_id,order_id,flags,ts_in_delta,sequence,symbol\r\n";
+    test_file << "2025-07-17T08:05:03.360842448Z,2025-07-17T08:05:03.360677248Z,160,2,1108,A,B,5.510000000,100,0,817593,130,165200,851012,ARL\r\n";
+    test_file << "\r\n";
+    test_file << "2025-07-17T08:05:03.360848793Z,2025-07-17T08:05:03.360683462Z,160,2,1108,A,A,21.330000000,200,0,817597,130,-42,851013,ARL\r\n";
+    test_file << "2025-07-17T08:05:03.361492517Z,2025-07-17T08:05:03.361327319Z,160,2,1108,C,B,5.510000000,50,0,817593,130,165198,851022,ARL";
+    test_file.close();
+    
+    MboFileReader reader(test_filename);
+    assert(reader.open());
+    
+    MboEvent event;
+    assert(reader.next(event));
+    assert(event.action == 'A' && event.side == 'B');
+    assert(event.order_id == 817593);
+    assert(event.sequence == 851012);
+    
+    assert(reader.next(event));
+    assert(event.price == 21330000000LL);
+    assert(event.ts_in_delta == -42);
+    
+    assert(reader.next(event));
+    assert(event.action == 'C');
+    assert(event.size == 50);
+    assert(event.sequence == 851022);
+    
+    assert(!reader.next(event));
+    assert(reader.getBytesConsumed() == reader.getFileSize());
+    
+    // Callback API over a fresh mapping
+    assert(reader.open());
+    size_t count = reader.forEach([](const MboEvent& e) {
+        assert(e.order_id == 817593 || e.order_id == 817597);
+    });
+    assert(count == 3);
+    reader.close();
+    
+    MboFileReader missing("does_not_exist.csv");
+    assert(!missing.open());
+    
+    std::remove(test_filename.c_str());
+    
+    std::cout << "✓ File reader streaming tests passed!" << std::endl;
+}
+
+static std::vector<MboEvent> readAll(MboFileReader& reader) {
+    std::vector<MboEvent> events;
+    MboEvent event;
+    while (reader.next(event)) {
+        events.push_back(event);
+    }
+    return events;
+}
+
+static bool sameEvent(const MboEvent& a, const MboEvent& b) {
+    return a.ts_event == b.ts_event && a.action == b.action && a.side == b.side && a.price == b.price &&
+           a.size == b.size && a.order_id == b.order_id && a.sequence == b.sequence;
+}
+
+void testStreamInput() {
+    std::cout << "Running MBO stream input tests..." << std::endl;
+    
+    // Larger than one read chunk, so rows straddle refills
+    std::string test_filename = "test_mbo_pipe.csv";
+    std::ofstream test_file(test_filename, std::ios::binary);
+    test_file << "ts_recv,ts_event,rtype,publisher_id,instrument_id,action,side,price,size,channel_id,order_id,flags,ts_in_delta,sequence,symbol\n";
+    for (int i = 0; i < 20000; ++i) {
+        test_file << "2025-07-17T08:05:03.360842448Z,2025-07-17T08:05:03." << (100000000 + i) << "Z,160,2,1108,"
+                  << (i % 3 ? 'A' : 'C') << "," << (i % 2 ? 'B' : 'A') << ",5." << (i % 100) << ",100,0," << (1000 + i)
+                  << ",130,165200," << i << ",ARL\n";
+    }
+    test_file.close();
+    
+    MboFileReader mapped(test_filename);
+    assert(mapped.open());
+    assert(!mapped.isStreaming());
+    std::vector<MboEvent> expected = readAll(mapped);
+    assert(expected.size() == 20000);
+    
+    std::FILE* stream = std::fopen(test_filename.c_str(), "rb");
+    assert(stream);
+    MboFileReader streamed("stream");
+    assert(streamed.open(stream));
+    assert(streamed.isStreaming());
+    std::vector<MboEvent> events = readAll(streamed);
+    assert(streamed.getBytesConsumed() == mapped.getFileSize());
+    streamed.close();
+    std::fclose(stream);
+    
+    assert(events.size() == expected.size());
+    for (size_t i = 0; i < events.size(); ++i) {
+        assert(sameEvent(events[i], expected[i]));
+    }
+    
+#ifndef _WIN32
+    // A FIFO cannot be mapped, so opening it by name falls back to reading
+    std::string fifo_name = "test_mbo.fifo";
+    std::remove(fifo_name.c_str());
+    assert(mkfifo(fifo_name.c_str(), 0600) == 0);
+    std::thread feeder([&]() {
+        std::ofstream fifo(fifo_name, std::ios::binary);
+        std::ifstream source(test_filename, std::ios::binary);
+        fifo << source.rdbuf();
+    });
+    
+    MboFileReader fifo_reader(fifo_name);
+    assert(fifo_reader.open());
+    assert(fifo_reader.isStreaming());
+    events = readAll(fifo_reader);
+    feeder.join();
+    fifo_reader.close();
+    std::remove(fifo_name.c_str());
+    
+    assert(events.size() == expected.size());
+    assert(sameEvent(events.front(), expected.front()) && sameEvent(events.back(), expected.back()));
+#endif
+    
+    std::remove(test_filename.c_str());
+    
+    std::cout << "✓ Stream input tests passed!" << std::endl;
+}
+
+void testParallelParsing() {
+    std::cout << "Running parallel chunked parsing tests..." << std::endl;
+    
+    // Two instruments, CRLF rows, blank lines, unparseable rows and no
+    // trailing newline, spread over many small chunks
+    std::string test_filename = "test_mbo_chunks.csv";
+    std::ofstream test_file(test_filename, std::ios::binary);
+    test_file << "ts_recv,ts_event,rtype,publisher_id,instrument_id,action,side,price,size,channel_id,order_id,flags,ts_in_delta,sequence,symbol\n";
+    for (int i = 0; i < 5000; ++i) {
+        if (i % 700 == 0) {
+            test_file << "garbage\n\r\n";
+        }
+        test_file << "2025-07-17T08:05:03.360842448Z,2025-07-17T08:05:03." << (100000000 + i) << "Z,160,2,"
+                  << (i < 2500 ? "1108" : (i % 2 ? "1108" : "77")) << "," << (i % 3 ? 'A' : 'C') << "," << (i % 2 ? 'B' : 'A')
+                  << ",5." << (i % 100) << ",100,0," << (1000 + i) << ",130,165200," << i << "," << (i < 2500 || i % 2 ? "ARL" : "XYZ")
+                  << (i % 5 == 0 ? "\r\n" : "\n");
+    }
+    test_file << "2025-07-17T08:05:03.360842448Z,2025-07-17T08:05:04.000000000Z,160,2,77,A,B,6.0,1,0,99999,130,0,99999,XYZ";
+    test_file.close();
+    
+    SymbologyTable expected_symbols;
+    MboFileReader sequential(test_filename);
+    sequential.setSymbology(&expected_symbols);
+    assert(sequential.open());
+    std::vector<MboEvent> expected = readAll(sequential);
+    assert(expected.size() == 5001);
+    
+    const size_t thread_counts[] = {2, 3, 8};
+    const size_t chunk_sizes[] = {1, 4096, 1 << 20};
+    for (size_t threads : thread_counts) {
+        for (size_t chunk_bytes : chunk_sizes) {
+            SymbologyTable symbols;
+            MboFileReader parallel(test_filename);
+            parallel.setSymbology(&symbols);
+            parallel.setParseThreads(threads, chunk_bytes);
+            assert(parallel.open());
+            std::vector<MboEvent> events = readAll(parallel);
+            
+            assert(events.size() == expected.size());
+            for (size_t i = 0; i < events.size(); ++i) {
+                assert(sameEvent(events[i], expected[i]) && events[i].instrument_id == expected[i].instrument_id);
+            }
+            assert(parallel.getSkippedLines() == sequential.getSkippedLines());
+            assert(parallel.getBytesConsumed() == parallel.getFileSize());
+            assert(symbols.size() == 2 && symbols.getSymbol(1108) == "ARL" && symbols.getSymbol(77) == "XYZ");
+            
+            // Abandoning the reader part-way stops the workers
+            MboFileReader abandoned(test_filename);
+            abandoned.setParseThreads(threads, chunk_bytes);
+            assert(abandoned.open());
+            MboEvent event;
+            assert(abandoned.next(event) && abandoned.next(event));
+            assert(!abandoned.seek(0));
+        }
+    }
+    
+    std::vector<MboEvent> concatenated = MboParser::parseFile(test_filename, 4);
+    assert(concatenated.size() == expected.size());
+    assert(sameEvent(concatenated.back(), expected.back()));
+    
+    std::remove(test_filename.c_str());
+    
+    std::cout << "✓ Parallel chunked parsing tests passed!" << std::endl;
+}
+
 int main() {
     testMboParser();
+    testPriceTickParsing();
+    testTimestampDecoding();
+    testFieldSplitting();
+    testFileReaderStreaming();
+    testStreamInput();
+    testParallelParsing();
     return 0;
 }
@@ -0,0 +1,125 @@
+#include <iostream>
+#include <fstream>
+#include <cassert>
+#include <cstdio>
+#include "mbp_binary_writer.h"
+#include "mbp_binary_reader.h"
+
+static MbpSnapshot makeSnapshot(uint64_t i) {
+    MbpSnapshot snapshot;
+    snapshot.timestamp = std::chrono::nanoseconds(1752739503360677248LL + i);
+    snapshot.sequence_number = 851012 + i;
+    snapshot.action = (i % 2) ? 'C' : 'A';
+    snapshot.side = 'B';
+    snapshot.depth = static_cast<int32_t>(i % 10);
+    snapshot.event_price = 5510000000LL + static_cast<Price>(i) * 10000000LL;
+    snapshot.event_size = 100 + i;
+    snapshot.event_order_id = 817593 + i;
+    snapshot.event_flags = 130;
+    snapshot.event_ts_in_delta = -165200;
+    snapshot.px[BID][0] = 5510000000LL;
+    snapshot.sz[BID][0] = 100;
+    snapshot.ct[BID][0] = 1;
+    snapshot.px[ASK][0] = 13575000000LL;
+    snapshot.sz[ASK][0] = 7 + i;
+    snapshot.ct[ASK][0] = 2;
+    return snapshot;
+}
+
+void testBinaryRoundTrip() {
+    std::cout << "Testing binary MBP-10 round trip..." << std::endl;
+    
+    const size_t rows = 5000;
+    {
+        MbpBinaryWriter writer("test_output.bin");
+        writer.setInstrument(2, 1108, "ARL");
+        assert(writer.initialize());
+        for (size_t i = 0; i < rows; ++i) {
+            assert(writer.writeSnapshot(makeSnapshot(i), i));
+        }
+        writer.close();
+        assert(writer.getSnapshotCount() == rows);
+    }
+    
+    MbpBinaryReader reader("test_output.bin");
+    assert(reader.open());
+    assert(reader.size() == rows);
+    assert(reader.header().instrument_id == 1108);
+    assert(reader.header().price_scale == PRICE_SCALE);
+    assert(std::string(reader.header().symbol) == "ARL");
+    
+    // Random access by row, no scan
+    const mbp_binary::Record& rec = reader.record(4321);
+    assert(rec.rtype == mbp_binary::RTYPE_MBP10);
+    assert(rec.length * 4u == sizeof(mbp_binary::Record));
+    assert(rec.price == 5510000000LL + 4321 * 10000000LL);
+    assert(rec.levels[1].bid_px == mbp_binary::UNDEF_PRICE);
+    assert(reader.orderId(4321) == 817593 + 4321);
+    
+    MbpSnapshot expected = makeSnapshot(4321);
+    MbpSnapshot decoded = reader.snapshot(4321);
+    assert(decoded.timestamp == expected.timestamp);
+    assert(decoded.sequence_number == expected.sequence_number);
+    assert(decoded.action == expected.action);
+    assert(decoded.depth == expected.depth);
+    assert(decoded.event_ts_in_delta == expected.event_ts_in_delta);
+    assert(decoded.sz[ASK][0] == expected.sz[ASK][0]);
+    assert(decoded.px[BID][1] == 0);
+    assert(decoded.event_order_id == expected.event_order_id);
+    
+    reader.close();
+    std::remove("test_output.bin");
+    
+    std::cout << "✓ Binary round trip test passed!" << std::endl;
+}
+
+void testDbnLayout() {
+    std::cout << "Testing plain DBN record layout..." << std::endl;
+    
+    {
+        MbpBinaryWriter writer("test_output.bin", mbp_binary::LAYOUT_DBN);
+        assert(writer.initialize());
+        writer.writeSnapshot(makeSnapshot(0), 0);
+        writer.writeSnapshot(makeSnapshot(1), 1);
+        writer.close();
+    }
+    
+    std::ifstream file("test_output.bin", std::ios::binary | std::ios::ate);
+    assert(static_cast<size_t>(file.tellg()) == sizeof(mbp_binary::FileHeader) + 2 * 368);
+    file.close();
+    
+    MbpBinaryReader reader("test_output.bin");
+    assert(reader.open());
+    assert(reader.size() == 2);
+    assert(reader.record(1).sequence == 851013);
+    assert(reader.orderId(1) == 0);
+    reader.close();
+    
+    std::remove("test_output.bin");
+    
+    std::cout << "✓ DBN layout test passed!" << std::endl;
+}
+
+void testRejectsForeignFiles() {
+    std::cout << "Testing binary reader validation..." << std::endl;
+    
+    std::ofstream bogus("test_output.bin", std::ios::binary);
+    bogus << "ts_recv,ts_event,rtype,publisher_id,instrument_id,action,side,depth,price,size\n";
+    bogus.close();
+    
+    MbpBinaryReader reader("test_output.bin");
+    assert(!reader.open());
+    std::remove("test_output.bin");
+    
+    MbpBinaryReader missing("does_not_exist.bin");
+    assert(!missing.open());
+    
+    std::cout << "✓ Binary reader validation test passed!" << std::endl;
+}
+
+int main() {
+    testBinaryRoundTrip();
+    testDbnLayout();
+    testRejectsForeignFiles();
+    return 0;
+}
@@ -49,7 +49,7 @@ void test_snapshot_writing() {
     bid_event.ts_event = std::chrono::nanoseconds(1000000000);
     bid_event.action = 'A';
     bid_event.side = 'B';
-    bid_event.price = 100.50;
+    bid_event.price = priceFromDouble(100.50);
     bid_event.size = 1000;
     bid_event.order_id = 12345;
     bid_event.sequence = 1;
@@ -60,7 +60,7 @@ void test_snapshot_writing() {
     ask_event.ts_event = std::chrono::nanoseconds(1000000001);
     ask_event.action = 'A';
     ask_event.side = 'A';
-    ask_event.price = 100.60;
+    ask_event.price = priceFromDouble(100.60);
     ask_event.size = 500;
     ask_event.order_id = 12346;
     ask_event.sequence = 2;
@@ -89,6 +89,84 @@ void test_snapshot_writing() {
     std::cout << "✅ Snapshot Writing test passed!" << std::endl;
 }
 
+void test_row_formatting() {
+    std::cout << "Testing Row Formatting..." << std::endl;
+    
+    SymbologyTable symbology;
+    symbology.add(1108, 2, "ARL");
+    
+    MbpCsvWriter writer("test_output.csv");
+    writer.setSymbology(&symbology);
+    assert(writer.initialize());
+    
+    MbpSnapshot snapshot;
+    snapshot.publisher_id = 2;
+    snapshot.instrument_id = 1108;
+    snapshot.timestamp = std::chrono::nanoseconds(1752739503360677248LL);
+    snapshot.sequence_number = 851012;
+    snapshot.action = 'A';
+    snapshot.side = 'B';
+    snapshot.event_price = 5510000000LL;
+    snapshot.event_size = 100;
+    snapshot.event_order_id = 817593;
+    snapshot.event_flags = 130;
+    snapshot.event_ts_in_delta = -165200;
+    snapshot.px[BID][0] = 5510000000LL;
+    snapshot.sz[BID][0] = 100;
+    snapshot.ct[BID][0] = 1;
+    snapshot.px[ASK][0] = 13575000000LL;
+    snapshot.sz[ASK][0] = 7;
+    snapshot.ct[ASK][0] = 2;
+    writer.writeSnapshot(snapshot, 0);
+    
+    // Same second, then the next day: the cached prefix must be rebuilt
+    snapshot.timestamp = std::chrono::nanoseconds(1752739503000000005LL);
+    writer.writeSnapshot(snapshot, 1);
+    snapshot.timestamp = std::chrono::nanoseconds(1709251199500000000LL);
+    writer.writeSnapshot(snapshot, 2);
+    
+    // Another instrument takes its symbol from the table; unknown ones get none
+    symbology.add(42, 1, "XYZ");
+    snapshot.instrument_id = 42;
+    snapshot.publisher_id = 1;
+    writer.writeSnapshot(snapshot, 3);
+    snapshot.instrument_id = 7;
+    writer.writeSnapshot(snapshot, 4);
+    writer.close();
+    
+    std::ifstream file("test_output.csv");
+    std::string line;
+    std::getline(file, line);
+    
+    std::string empty_levels;
+    for (int i = 1; i < 10; ++i) {
+        empty_levels += ",,0,0,,0,0";
+    }
+    
+    std::getline(file, line);
+    assert(line == "0,2025-07-17T08:05:03.360677248Z,2025-07-17T08:05:03.360677248Z,10,2,1108,A,B,0,5.51,100,130,-165200,851012,"
+                   "5.51,100,1,13.575,7,2" + empty_levels + ",ARL,817593");
+    
+    std::getline(file, line);
+    assert(line.compare(0, 64, "1,2025-07-17T08:05:03.000000005Z,2025-07-17T08:05:03.000000005Z,") == 0);
+    
+    std::getline(file, line);
+    assert(line.compare(0, 64, "2,2024-02-29T23:59:59.500000000Z,2024-02-29T23:59:59.500000000Z,") == 0);
+    
+    std::getline(file, line);
+    assert(line.find(",10,1,42,A,B,") != std::string::npos);
+    assert(line.compare(line.size() - 11, 11, ",XYZ,817593") == 0);
+    
+    std::getline(file, line);
+    assert(line.find(",10,1,7,A,B,") != std::string::npos);
+    assert(line.compare(line.size() - 8, 8, ",,817593") == 0);
+    
+    file.close();
+    std::remove("test_output.csv");
+    
+    std::cout << "✅ Row Formatting test passed!" << std::endl;
+}
+
 void test_performance_bulk_writing() {
     std::cout << "Testing Performance Bulk Writing..." << std::endl;
     
@@ -106,7 +184,7 @@ void test_performance_bulk_writing() {
         event.ts_event = std::chrono::nanoseconds(1000000000 + i);
         event.action = 'A';
         event.side = 'B';
-        event.price = 100.0 + i * 0.01;
+        event.price = 100 * PRICE_SCALE + i * (PRICE_SCALE / 100);
         event.size = 1000;
         event.order_id = i + 1000;
         event.sequence = i;
@@ -132,12 +210,64 @@ void test_performance_bulk_writing() {
     std::cout << "✅ Performance Bulk Writing test passed!" << std::endl;
 }
 
+static std::string readFile(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+static void writeBulk(MbpCsvWriter& writer, int count) {
+    OrderBook order_book;
+    for (int i = 0; i < count; i++) {
+        MboEvent event(std::chrono::nanoseconds(1000000000LL * i), 'A', i % 2 ? 'A' : 'B',
+                       (i % 2 ? 200 : 100) * PRICE_SCALE + (i % 50) * (PRICE_SCALE / 100), 10 + i, i + 1);
+        order_book.processEvent(event);
+        writer.writeSnapshot(order_book.generateSnapshot(event), i);
+    }
+}
+
+void test_async_io_matches_sync() {
+    std::cout << "Testing Async I/O output..." << std::endl;
+    
+    // Enough rows for many buffer swaps
+    const int count = 5000;
+    
+    MbpCsvWriter sync_writer("test_output_sync.csv");
+    assert(sync_writer.initialize());
+    writeBulk(sync_writer, count);
+    sync_writer.close();
+    
+    MbpCsvWriter async_writer("test_output_async.csv");
+    async_writer.setAsyncIo(true);
+    assert(async_writer.initialize());
+    writeBulk(async_writer, count);
+    
+    // flush() leaves every queued buffer on disk before returning
+    async_writer.flush();
+    std::string flushed = readFile("test_output_async.csv");
+    async_writer.close();
+    
+    std::string expected = readFile("test_output_sync.csv");
+    assert(expected.size() > 1024 * 1024);
+    assert(flushed == expected);
+    assert(readFile("test_output_async.csv") == expected);
+    assert(async_writer.getSnapshotCount() == static_cast<size_t>(count));
+    
+    std::remove("test_output_sync.csv");
+    std::remove("test_output_async.csv");
+    
+    std::cout << "✅ Async I/O test passed!" << std::endl;
+}
+
 int main() {
     std::cout << "=== MBP CSV Writer Unit Tests ===" << std::endl;
     
     test_csv_writer_initialization();
     test_snapshot_writing();
+    test_row_formatting();
     test_performance_bulk_writing();
+    test_async_io_matches_sync();
     
     std::cout << "🎉 All MBP CSV Writer tests passed!" << std::endl;
     return 0;
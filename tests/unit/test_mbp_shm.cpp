@@ -0,0 +1,203 @@
+#include <iostream>
+#include <cassert>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include "mbp_shm_publisher.h"
+#include "mbp_shm_reader.h"
+#include "symbology.h"
+
+static std::string regionName(const char* suffix) {
+    return "/orderbook_test_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count() % 1000000007) +
+           suffix;
+}
+
+// Every field follows from value, so a torn copy shows up as a mismatch
+static MbpSnapshot makeSnapshot(uint32_t instrument_id, uint64_t value) {
+    MbpSnapshot snapshot;
+    snapshot.instrument_id = instrument_id;
+    snapshot.sequence_number = value;
+    snapshot.timestamp = std::chrono::nanoseconds(static_cast<int64_t>(value) * 1000);
+    snapshot.action = 'A';
+    snapshot.side = 'B';
+    snapshot.event_order_id = value;
+    for (size_t i = 0; i < MbpSnapshot::DEPTH; ++i) {
+        snapshot.px[BID][i] = static_cast<Price>(value * 100 - i);
+        snapshot.px[ASK][i] = static_cast<Price>(value * 100 + i + 1);
+        snapshot.sz[BID][i] = value + i;
+        snapshot.sz[ASK][i] = value + i;
+        snapshot.ct[BID][i] = static_cast<uint32_t>(i + 1);
+        snapshot.ct[ASK][i] = static_cast<uint32_t>(i + 1);
+    }
+    return snapshot;
+}
+
+static bool consistent(const MbpSnapshot& snapshot) {
+    const uint64_t value = snapshot.sequence_number;
+    if (snapshot.event_order_id != value || snapshot.timestamp.count() != static_cast<int64_t>(value) * 1000) {
+        return false;
+    }
+    for (size_t i = 0; i < MbpSnapshot::DEPTH; ++i) {
+        if (snapshot.px[BID][i] != static_cast<Price>(value * 100 - i) || snapshot.sz[ASK][i] != value + i) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void testPublishAndRead() {
+    std::cout << "Testing shared-memory publish and read..." << std::endl;
+    const std::string name = regionName("_basic");
+    
+    SymbologyTable symbology;
+    symbology.add(1108, 2, "ARL");
+    MbpShmPublisher publisher(name, 16, 8);
+    publisher.setSymbology(&symbology);
+    assert(publisher.initialize());
+    
+    MbpShmReader reader(name);
+    assert(reader.open());
+    assert(reader.isLive());
+    MbpSnapshot snapshot;
+    assert(!reader.readLatest(1108, snapshot));
+    assert(reader.getJournalHead() == 0);
+    
+    // Two instruments, the second updated more often; the slot keeps the latest
+    assert(publisher.writeSnapshot(makeSnapshot(1108, 5), 0));
+    for (uint64_t i = 1; i <= 10; ++i) {
+        assert(publisher.writeSnapshot(makeSnapshot(7, 100 + i), i));
+    }
+    assert(publisher.getSnapshotCount() == 11);
+    assert(reader.getInstrumentCount() == 2);
+    
+    uint64_t row = 0;
+    assert(reader.readLatest(1108, snapshot, &row) && snapshot.sequence_number == 5 && row == 0 && consistent(snapshot));
+    assert(reader.readLatest(7, snapshot, &row) && snapshot.sequence_number == 110 && row == 10 && consistent(snapshot));
+    assert(!reader.readLatest(8, snapshot));
+    assert(reader.getSymbol(1108) == "ARL" && reader.getSymbol(7).empty());
+    
+    // The journal holds the last 8 of 11 updates
+    assert(reader.getJournalHead() == 11 && reader.getJournalCapacity() == 8);
+    MbpShmUpdate update;
+    assert(!reader.readUpdate(0, update) && !reader.readUpdate(2, update));
+    assert(reader.readUpdate(3, update) && update.instrument_id == 7 && update.row_index == 3);
+    assert(reader.readUpdate(10, update) && update.row_index == 10);
+    assert(!reader.readUpdate(11, update));
+    
+    // Closing leaves the final books readable
+    publisher.close();
+    assert(!reader.isLive());
+    assert(reader.readLatest(7, snapshot) && snapshot.sequence_number == 110);
+    
+    MbpShmReader late_reader(name);
+    assert(late_reader.open() && !late_reader.isLive());
+    assert(late_reader.readLatest(1108, snapshot) && snapshot.sequence_number == 5);
+    
+    assert(MbpShmPublisher::removeRegion(name));
+    MbpShmReader missing(name);
+    assert(!missing.open());
+    std::cout << "✓ Shared-memory publish and read passed" << std::endl;
+}
+
+void testFullTable() {
+    std::cout << "Testing a full instrument table..." << std::endl;
+    const std::string name = regionName("_full");
+    MbpShmPublisher publisher(name, 4, 16);
+    assert(publisher.initialize());
+    
+    for (uint32_t instrument = 1; instrument <= 4; ++instrument) {
+        assert(publisher.writeSnapshot(makeSnapshot(instrument, instrument)));
+    }
+    assert(!publisher.writeSnapshot(makeSnapshot(5, 5)));
+    assert(publisher.writeSnapshot(makeSnapshot(3, 30)));
+    
+    MbpShmReader reader(name);
+    assert(reader.open());
+    MbpSnapshot snapshot;
+    for (uint32_t instrument = 1; instrument <= 4; ++instrument) {
+        assert(reader.readLatest(instrument, snapshot));
+    }
+    assert(!reader.readLatest(5, snapshot));
+    assert(reader.readLatest(3, snapshot) && snapshot.sequence_number == 30);
+    
+    publisher.close();
+    MbpShmPublisher::removeRegion(name);
+    std::cout << "✓ Full instrument table passed" << std::endl;
+}
+
+// A reader more than the journal behind finds the older updates gone
+void testSetCapacity() {
+    std::cout << "Testing configured capacity..." << std::endl;
+    const std::string name = regionName("_capacity");
+    MbpShmPublisher publisher(name);
+    publisher.setCapacity(2, 8);
+    assert(publisher.initialize());
+    
+    for (uint64_t i = 0; i < 10; ++i) {
+        assert(publisher.writeSnapshot(makeSnapshot(1, i + 1), i));
+    }
+    assert(!publisher.writeSnapshot(makeSnapshot(2, 1)) || !publisher.writeSnapshot(makeSnapshot(3, 1)));
+    
+    MbpShmReader reader(name);
+    assert(reader.open());
+    assert(reader.getJournalCapacity() == 8);
+    MbpShmUpdate update;
+    assert(!reader.readUpdate(0, update));
+    assert(reader.readUpdate(9, update) && update.row_index == 9);
+    
+    publisher.close();
+    MbpShmPublisher::removeRegion(name);
+    std::cout << "✓ Configured capacity passed" << std::endl;
+}
+
+// A reader thread polls while the writer rewrites the same slot; every
+// snapshot it gets must be whole, and never older than one seen before
+void testConcurrentReader() {
+    std::cout << "Testing reads racing the writer..." << std::endl;
+    const std::string name = regionName("_race");
+    MbpShmPublisher publisher(name, 16, 1024);
+    assert(publisher.initialize());
+    assert(publisher.writeSnapshot(makeSnapshot(42, 1)));
+    
+    std::atomic<bool> done(false);
+    size_t reads = 0;
+    std::thread consumer([&]() {
+        MbpShmReader reader(name);
+        assert(reader.open());
+        MbpSnapshot snapshot;
+        uint64_t last = 0;
+        while (!done.load(std::memory_order_acquire)) {
+            assert(reader.readLatest(42, snapshot));
+            assert(consistent(snapshot));
+            assert(snapshot.sequence_number >= last);
+            last = snapshot.sequence_number;
+            ++reads;
+        }
+    });
+    
+    const uint64_t COUNT = 200000;
+    for (uint64_t i = 2; i <= COUNT; ++i) {
+        publisher.writeSnapshot(makeSnapshot(42, i), i);
+        if (i % 1000 == 0) {
+            std::this_thread::yield();
+        }
+    }
+    done.store(true, std::memory_order_release);
+    consumer.join();
+    assert(reads > 0);
+    
+    publisher.close();
+    MbpShmPublisher::removeRegion(name);
+    std::cout << "✓ Reads racing the writer passed" << std::endl;
+}
+
+int main() {
+    testPublishAndRead();
+    testFullTable();
+    testSetCapacity();
+    testConcurrentReader();
+    
+    std::cout << "\n✅ All shared-memory snapshot tests passed!" << std::endl;
+    return 0;
+}
@@ -1,19 +1,21 @@
 #include <iostream>
 #include <cassert>
 #include <chrono>
+#include <vector>
 #include "order_book.h"
 #include "mbo_parser.h"
 
+template <typename Book>
 void testOrderBookBasics() {
     std::cout << "Testing Order Book Basic Operations..." << std::endl;
-    OrderBook book;
+    Book book;
     
     assert(book.getBidLevelCount() == 0);
     assert(book.getAskLevelCount() == 0);
     assert(book.getOrderCount() == 0);
     
-    book.addOrder(1001, 100.50, 1000, 'B');
-    book.addOrder(1002, 100.75, 500, 'A');
+    book.addOrder(1001, priceFromDouble(100.50), 1000, 'B');
+    book.addOrder(1002, priceFromDouble(100.75), 500, 'A');
     
     assert(book.getBidLevelCount() == 1);
     assert(book.getAskLevelCount() == 1);
@@ -21,38 +23,39 @@ void testOrderBookBasics() {
     
     MbpSnapshot snapshot = book.generateSnapshot();
     
-    assert(snapshot.bid_px_00 == 100.50);
-    assert(snapshot.bid_sz_00 == 1000);
-    assert(snapshot.bid_ct_00 == 1);
+    assert(snapshot.px[BID][0] == priceFromDouble(100.50));
+    assert(snapshot.sz[BID][0] == 1000);
+    assert(snapshot.ct[BID][0] == 1);
     
-    assert(snapshot.ask_px_00 == 100.75);
-    assert(snapshot.ask_sz_00 == 500);
-    assert(snapshot.ask_ct_00 == 1);
+    assert(snapshot.px[ASK][0] == priceFromDouble(100.75));
+    assert(snapshot.sz[ASK][0] == 500);
+    assert(snapshot.ct[ASK][0] == 1);
     
     for (int i = 1; i < 10; i++) {
-        assert((&snapshot.bid_px_00)[i] == 0.0);
-        assert((&snapshot.ask_px_00)[i] == 0.0);
-        assert((&snapshot.bid_sz_00)[i] == 0);
-        assert((&snapshot.ask_sz_00)[i] == 0);
-        assert((&snapshot.bid_ct_00)[i] == 0);
-        assert((&snapshot.ask_ct_00)[i] == 0);
+        assert(snapshot.px[BID][i] == 0);
+        assert(snapshot.px[ASK][i] == 0);
+        assert(snapshot.sz[BID][i] == 0);
+        assert(snapshot.sz[ASK][i] == 0);
+        assert(snapshot.ct[BID][i] == 0);
+        assert(snapshot.ct[ASK][i] == 0);
     }
     
     std::cout << "✓ Basic add operations passed" << std::endl;
 }
 
+template <typename Book>
 void testOrderBookLevels() {
     std::cout << "Testing Order Book Price Level Management..." << std::endl;
-    OrderBook book;
+    Book book;
     
-    book.addOrder(1001, 100.50, 1000, 'B');
-    book.addOrder(1002, 100.25, 500, 'B');
-    book.addOrder(1003, 100.75, 750, 'B');
-    book.addOrder(1004, 100.50, 250, 'B');
+    book.addOrder(1001, priceFromDouble(100.50), 1000, 'B');
+    book.addOrder(1002, priceFromDouble(100.25), 500, 'B');
+    book.addOrder(1003, priceFromDouble(100.75), 750, 'B');
+    book.addOrder(1004, priceFromDouble(100.50), 250, 'B');
     
-    book.addOrder(2001, 100.90, 400, 'A');
-    book.addOrder(2002, 101.25, 600, 'A');
-    book.addOrder(2003, 101.00, 800, 'A');
+    book.addOrder(2001, priceFromDouble(100.90), 400, 'A');
+    book.addOrder(2002, priceFromDouble(101.25), 600, 'A');
+    book.addOrder(2003, priceFromDouble(101.00), 800, 'A');
     
     assert(book.getBidLevelCount() == 3);
     assert(book.getAskLevelCount() == 3);
@@ -60,41 +63,42 @@ void testOrderBookLevels() {
     
     MbpSnapshot snapshot = book.generateSnapshot();
     
-    assert(snapshot.bid_px_00 == 100.75);
-    assert(snapshot.bid_sz_00 == 750);
-    assert(snapshot.bid_ct_00 == 1);
+    assert(snapshot.px[BID][0] == priceFromDouble(100.75));
+    assert(snapshot.sz[BID][0] == 750);
+    assert(snapshot.ct[BID][0] == 1);
     
-    assert(snapshot.bid_px_01 == 100.50);
-    assert(snapshot.bid_sz_01 == 1250);
-    assert(snapshot.bid_ct_01 == 2);
+    assert(snapshot.px[BID][1] == priceFromDouble(100.50));
+    assert(snapshot.sz[BID][1] == 1250);
+    assert(snapshot.ct[BID][1] == 2);
     
-    assert(snapshot.bid_px_02 == 100.25);
-    assert(snapshot.bid_sz_02 == 500);
-    assert(snapshot.bid_ct_02 == 1);
+    assert(snapshot.px[BID][2] == priceFromDouble(100.25));
+    assert(snapshot.sz[BID][2] == 500);
+    assert(snapshot.ct[BID][2] == 1);
     
-    assert(snapshot.ask_px_00 == 100.90);
-    assert(snapshot.ask_sz_00 == 400);
-    assert(snapshot.ask_ct_00 == 1);
+    assert(snapshot.px[ASK][0] == priceFromDouble(100.90));
+    assert(snapshot.sz[ASK][0] == 400);
+    assert(snapshot.ct[ASK][0] == 1);
     
-    assert(snapshot.ask_px_01 == 101.00);
-    assert(snapshot.ask_sz_01 == 800);
-    assert(snapshot.ask_ct_01 == 1);
+    assert(snapshot.px[ASK][1] == priceFromDouble(101.00));
+    assert(snapshot.sz[ASK][1] == 800);
+    assert(snapshot.ct[ASK][1] == 1);
     
-    assert(snapshot.ask_px_02 == 101.25);
-    assert(snapshot.ask_sz_02 == 600);
-    assert(snapshot.ask_ct_02 == 1);
+    assert(snapshot.px[ASK][2] == priceFromDouble(101.25));
+    assert(snapshot.sz[ASK][2] == 600);
+    assert(snapshot.ct[ASK][2] == 1);
     
     std::cout << "✓ Price level management and sorting passed" << std::endl;
 }
 
+template <typename Book>
 void testOrderCancellation() {
     std::cout << "Testing Order Cancellation..." << std::endl;
-    OrderBook book;
+    Book book;
     
     // Add orders at same price level
-    book.addOrder(1001, 100.50, 1000, 'B');
-    book.addOrder(1002, 100.50, 500, 'B');
-    book.addOrder(2001, 100.75, 750, 'A');
+    book.addOrder(1001, priceFromDouble(100.50), 1000, 'B');
+    book.addOrder(1002, priceFromDouble(100.50), 500, 'B');
+    book.addOrder(2001, priceFromDouble(100.75), 750, 'A');
     
     assert(book.getBidLevelCount() == 1);
     assert(book.getAskLevelCount() == 1);
@@ -102,12 +106,12 @@ void testOrderCancellation() {
     
     // Test snapshot before cancellation
     MbpSnapshot snapshot1 = book.generateSnapshot();
-    assert(snapshot1.bid_px_00 == 100.50);
-    assert(snapshot1.bid_sz_00 == 1500); // 1000 + 500
-    assert(snapshot1.bid_ct_00 == 2);
+    assert(snapshot1.px[BID][0] == priceFromDouble(100.50));
+    assert(snapshot1.sz[BID][0] == 1500); // 1000 + 500
+    assert(snapshot1.ct[BID][0] == 2);
     
     // Cancel one order at the bid level
-    MboEvent cancel1{std::chrono::nanoseconds(0), 'C', 'B', 100.50, 1000, 1001};
+    MboEvent cancel1{std::chrono::nanoseconds(0), 'C', 'B', priceFromDouble(100.50), 1000, 1001};
     assert(book.processEvent(cancel1));
     
     assert(book.getBidLevelCount() == 1); // Level still exists
@@ -115,12 +119,12 @@ void testOrderCancellation() {
     
     // Test snapshot after cancellation
     MbpSnapshot snapshot2 = book.generateSnapshot();
-    assert(snapshot2.bid_px_00 == 100.50);
-    assert(snapshot2.bid_sz_00 == 500); // Only remaining order
-    assert(snapshot2.bid_ct_00 == 1);
+    assert(snapshot2.px[BID][0] == priceFromDouble(100.50));
+    assert(snapshot2.sz[BID][0] == 500); // Only remaining order
+    assert(snapshot2.ct[BID][0] == 1);
     
     // Cancel the last order at this level
-    MboEvent cancel2{std::chrono::nanoseconds(0), 'C', 'B', 100.50, 500, 1002};
+    MboEvent cancel2{std::chrono::nanoseconds(0), 'C', 'B', priceFromDouble(100.50), 500, 1002};
     assert(book.processEvent(cancel2));
     
     assert(book.getBidLevelCount() == 0); // Level removed
@@ -130,33 +134,59 @@ void testOrderCancellation() {
     MbpSnapshot snapshot3 = book.generateSnapshot();
     // All bid levels should be empty
     for (int i = 0; i < 10; i++) {
-        assert((&snapshot3.bid_px_00)[i] == 0.0);
-        assert((&snapshot3.bid_sz_00)[i] == 0);
-        assert((&snapshot3.bid_ct_00)[i] == 0);
+        assert(snapshot3.px[BID][i] == 0);
+        assert(snapshot3.sz[BID][i] == 0);
+        assert(snapshot3.ct[BID][i] == 0);
     }
     // Ask level should still exist
-    assert(snapshot3.ask_px_00 == 100.75);
-    assert(snapshot3.ask_sz_00 == 750);
-    assert(snapshot3.ask_ct_00 == 1);
+    assert(snapshot3.px[ASK][0] == priceFromDouble(100.75));
+    assert(snapshot3.sz[ASK][0] == 750);
+    assert(snapshot3.ct[ASK][0] == 1);
     
     std::cout << "✓ Order cancellation and level management passed" << std::endl;
 }
 
+template <typename Book>
+void testDuplicateAddOrder() {
+    std::cout << "Testing Duplicate addOrder..." << std::endl;
+    Book book;
+    
+    assert(book.addOrder(1001, priceFromDouble(100.50), 1000, 'B'));
+    
+    // A live id is refused and leaves the order and its level untouched
+    assert(!book.addOrder(1001, priceFromDouble(100.25), 300, 'B'));
+    assert(book.getOrderCount() == 1);
+    assert(book.getBidLevelCount() == 1);
+    MbpSnapshot snapshot = book.generateSnapshot();
+    assert(snapshot.px[BID][0] == priceFromDouble(100.50));
+    assert(snapshot.sz[BID][0] == 1000);
+    assert(snapshot.ct[BID][0] == 1);
+    
+    // The original order cancels cleanly, and the id is free again after
+    MboEvent cancel{std::chrono::nanoseconds(0), 'C', 'B', priceFromDouble(100.50), 1000, 1001};
+    assert(book.processEvent(cancel));
+    assert(book.getOrderCount() == 0 && book.getBidLevelCount() == 0);
+    assert(book.addOrder(1001, priceFromDouble(100.25), 300, 'B'));
+    
+    std::cout << "✅ Duplicate addOrder test passed!" << std::endl;
+}
+
+template <typename Book>
 void testPartialCancellation() {
     std::cout << "Testing Partial Order Cancellation..." << std::endl;
-    OrderBook book;
+    Book book;
     
     // Add one order
-    book.addOrder(1001, 100.50, 1000, 'B');
+    book.addOrder(1001, priceFromDouble(100.50), 1000, 'B');
     
     // Test initial snapshot
     MbpSnapshot snapshot1 = book.generateSnapshot();
-    assert(snapshot1.bid_px_00 == 100.50);
-    assert(snapshot1.bid_sz_00 == 1000);
-    assert(snapshot1.bid_ct_00 == 1);
+    assert(snapshot1.px[BID][0] == priceFromDouble(100.50));
+    assert(snapshot1.sz[BID][0] == 1000);
+    assert(snapshot1.ct[BID][0] == 1);
     
     // Partially cancel the order (cancel 300 out of 1000)
-    MboEvent partialCancel1{std::chrono::nanoseconds(0), 'C', 'B', 100.50, 300, 1001};
+    MboEvent partialCancel1{std::chrono::nanoseconds(0), 'C', 'B', priceFromDouble(100.50), 300, 1001};
     assert(book.processEvent(partialCancel1));
     
     assert(book.getBidLevelCount() == 1); // Level still exists
@@ -164,21 +194,21 @@ void testPartialCancellation() {
     
     // Test snapshot after partial cancellation
     MbpSnapshot snapshot2 = book.generateSnapshot();
-    assert(snapshot2.bid_px_00 == 100.50);
-    assert(snapshot2.bid_sz_00 == 700); // 1000 - 300
-    assert(snapshot2.bid_ct_00 == 1); // Order still exists
+    assert(snapshot2.px[BID][0] == priceFromDouble(100.50));
+    assert(snapshot2.sz[BID][0] == 700); // 1000 - 300
+    assert(snapshot2.ct[BID][0] == 1); // Order still exists
     
     // Another partial cancellation (cancel 200 more)
-    MboEvent partialCancel2{std::chrono::nanoseconds(0), 'C', 'B', 100.50, 200, 1001};
+    MboEvent partialCancel2{std::chrono::nanoseconds(0), 'C', 'B', priceFromDouble(100.50), 200, 1001};
     assert(book.processEvent(partialCancel2));
     
     MbpSnapshot snapshot3 = book.generateSnapshot();
-    assert(snapshot3.bid_px_00 == 100.50);
-    assert(snapshot3.bid_sz_00 == 500); // 700 - 200
-    assert(snapshot3.bid_ct_00 == 1);
+    assert(snapshot3.px[BID][0] == priceFromDouble(100.50));
+    assert(snapshot3.sz[BID][0] == 500); // 700 - 200
+    assert(snapshot3.ct[BID][0] == 1);
     
     // Cancel remaining quantity (full cancellation)
-    MboEvent fullCancel{std::chrono::nanoseconds(0), 'C', 'B', 100.50, 500, 1001};
+    MboEvent fullCancel{std::chrono::nanoseconds(0), 'C', 'B', priceFromDouble(100.50), 500, 1001};
     assert(book.processEvent(fullCancel));
     
     assert(book.getBidLevelCount() == 0); // Level removed
@@ -187,23 +217,24 @@ void testPartialCancellation() {
     // Test final snapshot
     MbpSnapshot snapshot4 = book.generateSnapshot();
     for (int i = 0; i < 10; i++) {
-        assert((&snapshot4.bid_px_00)[i] == 0.0);
-        assert((&snapshot4.bid_sz_00)[i] == 0);
-        assert((&snapshot4.bid_ct_00)[i] == 0);
+        assert(snapshot4.px[BID][i] == 0);
+        assert(snapshot4.sz[BID][i] == 0);
+        assert(snapshot4.ct[BID][i] == 0);
     }
     
     std::cout << "✓ Partial cancellation handling passed" << std::endl;
 }
 
+template <typename Book>
 void testOverCancellation() {
     std::cout << "Testing Over-cancellation Protection..." << std::endl;
-    OrderBook book;
+    Book book;
     
     // Add order
-    book.addOrder(1001, 100.50, 500, 'B');
+    book.addOrder(1001, priceFromDouble(100.50), 500, 'B');
     
     // Try to cancel more than available (over-cancellation)
-    MboEvent overCancel{std::chrono::nanoseconds(0), 'C', 'B', 100.50, 1000, 1001}; // Cancel 1000 but only 500 available
+    MboEvent overCancel{std::chrono::nanoseconds(0), 'C', 'B', priceFromDouble(100.50), 1000, 1001}; // Cancel 1000 but only 500 available
     assert(book.processEvent(overCancel)); // Should still succeed
     
     // Order should be fully removed
@@ -213,282 +244,334 @@ void testOverCancellation() {
     std::cout << "✓ Over-cancellation protection passed" << std::endl;
 }
 
+template <typename Book>
 void testCancellationAcrossLevels() {
     std::cout << "Testing Cancellation Across Different Price Levels..." << std::endl;
-    OrderBook book;
+    Book book;
     
     // Add orders at different price levels
-    book.addOrder(1001, 100.75, 1000, 'B'); // Higher bid
-    book.addOrder(1002, 100.50, 800, 'B');  // Lower bid
-    book.addOrder(2001, 101.00, 600, 'A');  // Lower ask
-    book.addOrder(2002, 101.50, 400, 'A');  // Higher ask
+    book.addOrder(1001, priceFromDouble(100.75), 1000, 'B'); // Higher bid
+    book.addOrder(1002, priceFromDouble(100.50), 800, 'B');  // Lower bid
+    book.addOrder(2001, priceFromDouble(101.00), 600, 'A');  // Lower ask
+    book.addOrder(2002, priceFromDouble(101.50), 400, 'A');  // Higher ask
     
     // Test initial snapshot
     MbpSnapshot snapshot1 = book.generateSnapshot();
-    assert(snapshot1.bid_ct_00 == 1); // 2 bid levels
-    assert(snapshot1.ask_ct_00 == 1); // 2 ask levels
-    assert(snapshot1.bid_px_00 == 100.75); // Highest bid first
-    assert(snapshot1.bid_sz_00 == 1000);
-    assert(snapshot1.ask_px_00 == 101.00); // Lowest ask first
-    assert(snapshot1.ask_sz_00 == 600);
+    assert(snapshot1.ct[BID][0] == 1); // 2 bid levels
+    assert(snapshot1.ct[ASK][0] == 1); // 2 ask levels
+    assert(snapshot1.px[BID][0] == priceFromDouble(100.75)); // Highest bid first
+    assert(snapshot1.sz[BID][0] == 1000);
+    assert(snapshot1.px[ASK][0] == priceFromDouble(101.00)); // Lowest ask first
+    assert(snapshot1.sz[ASK][0] == 600);
     
     // Cancel from higher bid level (partial)
-    MboEvent cancel1{std::chrono::nanoseconds(0), 'C', 'B', 100.75, 300, 1001};
+    MboEvent cancel1{std::chrono::nanoseconds(0), 'C', 'B', priceFromDouble(100.75), 300, 1001};
     assert(book.processEvent(cancel1));
     
     MbpSnapshot snapshot2 = book.generateSnapshot();
-    assert(snapshot2.bid_px_00 == 100.75);
-    assert(snapshot2.bid_sz_00 == 700); // Reduced from 1000
-    assert(snapshot2.bid_px_01 == 100.50);
-    assert(snapshot2.bid_sz_01 == 800); // Unchanged
-    assert(snapshot2.ask_px_00 == 101.00);
-    assert(snapshot2.ask_sz_00 == 600); // Unchanged
-    assert(snapshot2.ask_px_01 == 101.50);
-    assert(snapshot2.ask_sz_01 == 400); // Unchanged
+    assert(snapshot2.px[BID][0] == priceFromDouble(100.75));
+    assert(snapshot2.sz[BID][0] == 700); // Reduced from 1000
+    assert(snapshot2.px[BID][1] == priceFromDouble(100.50));
+    assert(snapshot2.sz[BID][1] == 800); // Unchanged
+    assert(snapshot2.px[ASK][0] == priceFromDouble(101.00));
+    assert(snapshot2.sz[ASK][0] == 600); // Unchanged
+    assert(snapshot2.px[ASK][1] == priceFromDouble(101.50));
+    assert(snapshot2.sz[ASK][1] == 400); // Unchanged
     
     // Cancel entire higher ask level
-    MboEvent cancel2{std::chrono::nanoseconds(0), 'C', 'A', 101.50, 400, 2002};
+    MboEvent cancel2{std::chrono::nanoseconds(0), 'C', 'A', priceFromDouble(101.50), 400, 2002};
     assert(book.processEvent(cancel2));
     
     assert(book.getBidLevelCount() == 2); // Still two bid levels
     assert(book.getAskLevelCount() == 1); // Only one ask level remains
     
     MbpSnapshot snapshot3 = book.generateSnapshot();
-    assert(snapshot3.ask_px_00 == 101.00);
-    assert(snapshot3.ask_sz_00 == 600);
+    assert(snapshot3.px[ASK][0] == priceFromDouble(101.00));
+    assert(snapshot3.sz[ASK][0] == 600);
     // Second ask level should be empty
-    assert(snapshot3.ask_px_01 == 0.0);
-    assert(snapshot3.ask_sz_01 == 0);
-    assert(snapshot3.ask_ct_01 == 0);
+    assert(snapshot3.px[ASK][1] == 0);
+    assert(snapshot3.sz[ASK][1] == 0);
+    assert(snapshot3.ct[ASK][1] == 0);
     
     std::cout << "✓ Cross-level cancellation isolation passed" << std::endl;
 }
 
+template <typename Book>
 void testMultiOrderLevelCancellation() {
     std::cout << "Testing Multi-Order Level Cancellation..." << std::endl;
-    OrderBook book;
+    Book book;
     
     // Add multiple orders at the same price level
-    book.addOrder(1001, 100.50, 1000, 'B');
-    book.addOrder(1002, 100.50, 750, 'B');
-    book.addOrder(1003, 100.50, 500, 'B');
+    book.addOrder(1001, priceFromDouble(100.50), 1000, 'B');
+    book.addOrder(1002, priceFromDouble(100.50), 750, 'B');
+    book.addOrder(1003, priceFromDouble(100.50), 500, 'B');
     
     // Test initial snapshot
     MbpSnapshot snapshot1 = book.generateSnapshot();
-    assert(snapshot1.bid_px_00 == 100.50);
-    assert(snapshot1.bid_sz_00 == 2250); // 1000 + 750 + 500
-    assert(snapshot1.bid_ct_00 == 3);
+    assert(snapshot1.px[BID][0] == priceFromDouble(100.50));
+    assert(snapshot1.sz[BID][0] == 2250); // 1000 + 750 + 500
+    assert(snapshot1.ct[BID][0] == 3);
     
     // Partially cancel first order
-    MboEvent cancel1{std::chrono::nanoseconds(0), 'C', 'B', 100.50, 250, 1001};
+    MboEvent cancel1{std::chrono::nanoseconds(0), 'C', 'B', priceFromDouble(100.50), 250, 1001};
     assert(book.processEvent(cancel1));
     
     MbpSnapshot snapshot2 = book.generateSnapshot();
-    assert(snapshot2.bid_px_00 == 100.50);
-    assert(snapshot2.bid_sz_00 == 2000); // 2250 - 250
-    assert(snapshot2.bid_ct_00 == 3);
+    assert(snapshot2.px[BID][0] == priceFromDouble(100.50));
+    assert(snapshot2.sz[BID][0] == 2000); // 2250 - 250
+    assert(snapshot2.ct[BID][0] == 3);
     
     // Fully cancel second order
-    MboEvent cancel2{std::chrono::nanoseconds(0), 'C', 'B', 100.50, 750, 1002};
+    MboEvent cancel2{std::chrono::nanoseconds(0), 'C', 'B', priceFromDouble(100.50), 750, 1002};
     assert(book.processEvent(cancel2));
     
     MbpSnapshot snapshot3 = book.generateSnapshot();
-    assert(snapshot3.bid_px_00 == 100.50);
-    assert(snapshot3.bid_sz_00 == 1250); // 750 (from 1001 after partial cancel) + 500 (from 1003)
-    assert(snapshot3.bid_ct_00 == 2);
+    assert(snapshot3.px[BID][0] == priceFromDouble(100.50));
+    assert(snapshot3.sz[BID][0] == 1250); // 750 (from 1001 after partial cancel) + 500 (from 1003)
+    assert(snapshot3.ct[BID][0] == 2);
     
     // Partially cancel first order again
-    MboEvent cancel3{std::chrono::nanoseconds(0), 'C', 'B', 100.50, 250, 1001};
+    MboEvent cancel3{std::chrono::nanoseconds(0), 'C', 'B', priceFromDouble(100.50), 250, 1001};
     assert(book.processEvent(cancel3));
     
     MbpSnapshot snapshot4 = book.generateSnapshot();
-    assert(snapshot4.bid_px_00 == 100.50);
-    assert(snapshot4.bid_sz_00 == 1000); // 500 (remaining from 1001) + 500 (from 1003)
-    assert(snapshot4.bid_ct_00 == 2);
+    assert(snapshot4.px[BID][0] == priceFromDouble(100.50));
+    assert(snapshot4.sz[BID][0] == 1000); // 500 (remaining from 1001) + 500 (from 1003)
+    assert(snapshot4.ct[BID][0] == 2);
     
     std::cout << "✓ Multi-order level cancellation passed" << std::endl;
 }
 
+template <typename Book>
 void testTradeEventHandling() {
     std::cout << "Testing Trade Event Handling (T-F-C sequence)..." << std::endl;
-    OrderBook book;
+    Book book;
     
     // Add orders
-    book.addOrder(1001, 100.50, 100, 'B');
-    book.addOrder(1002, 100.50, 50, 'B');
-    book.addOrder(2001, 100.75, 75, 'A');
-    book.addOrder(2002, 100.75, 25, 'A');
+    book.addOrder(1001, priceFromDouble(100.50), 100, 'B');
+    book.addOrder(1002, priceFromDouble(100.50), 50, 'B');
+    book.addOrder(2001, priceFromDouble(100.75), 75, 'A');
+    book.addOrder(2002, priceFromDouble(100.75), 25, 'A');
     
     // Test initial state
     MbpSnapshot initial_snapshot = book.generateSnapshot();
-    assert(initial_snapshot.bid_px_00 == 100.50);
-    assert(initial_snapshot.bid_sz_00 == 150); // 100 + 50
-    assert(initial_snapshot.bid_ct_00 == 2);
-    assert(initial_snapshot.ask_px_00 == 100.75);
-    assert(initial_snapshot.ask_sz_00 == 100); // 75 + 25
-    assert(initial_snapshot.ask_ct_00 == 2);
+    assert(initial_snapshot.px[BID][0] == priceFromDouble(100.50));
+    assert(initial_snapshot.sz[BID][0] == 150); // 100 + 50
+    assert(initial_snapshot.ct[BID][0] == 2);
+    assert(initial_snapshot.px[ASK][0] == priceFromDouble(100.75));
+    assert(initial_snapshot.sz[ASK][0] == 100); // 75 + 25
+    assert(initial_snapshot.ct[ASK][0] == 2);
     
     // T event should NOT change the order book (per requirements)
-    MboEvent trade{std::chrono::nanoseconds(0), 'T', 'A', 100.50, 30, 0};
+    MboEvent trade{std::chrono::nanoseconds(0), 'T', 'A', priceFromDouble(100.50), 30, 0};
     assert(book.processEvent(trade));
     
     MbpSnapshot snapshot1 = book.generateSnapshot();
-    assert(snapshot1.bid_px_00 == 100.50);
-    assert(snapshot1.bid_sz_00 == 150); // Unchanged - T event doesn't affect book
-    assert(snapshot1.bid_ct_00 == 2);
-    assert(snapshot1.ask_px_00 == 100.75);
-    assert(snapshot1.ask_sz_00 == 100); // Unchanged - T event doesn't affect book
-    assert(snapshot1.ask_ct_00 == 2);
+    assert(snapshot1.px[BID][0] == priceFromDouble(100.50));
+    assert(snapshot1.sz[BID][0] == 150); // Unchanged - T event doesn't affect book
+    assert(snapshot1.ct[BID][0] == 2);
+    assert(snapshot1.px[ASK][0] == priceFromDouble(100.75));
+    assert(snapshot1.sz[ASK][0] == 100); // Unchanged - T event doesn't affect book
+    assert(snapshot1.ct[ASK][0] == 2);
     
     // F event should also NOT change the order book (per requirements)
-    MboEvent fill{std::chrono::nanoseconds(0), 'F', 'A', 100.75, 30, 2001};
+    MboEvent fill{std::chrono::nanoseconds(0), 'F', 'A', priceFromDouble(100.75), 30, 2001};
     assert(book.processEvent(fill));
     
     MbpSnapshot snapshot2 = book.generateSnapshot();
-    assert(snapshot2.bid_px_00 == 100.50);
-    assert(snapshot2.bid_sz_00 == 150); // Still unchanged - F event doesn't affect book
-    assert(snapshot2.ask_px_00 == 100.75);
-    assert(snapshot2.ask_sz_00 == 100); // Still unchanged - F event doesn't affect book
-    assert(snapshot2.ask_ct_00 == 2);
+    assert(snapshot2.px[BID][0] == priceFromDouble(100.50));
+    assert(snapshot2.sz[BID][0] == 150); // Still unchanged - F event doesn't affect book
+    assert(snapshot2.px[ASK][0] == priceFromDouble(100.75));
+    assert(snapshot2.sz[ASK][0] == 100); // Still unchanged - F event doesn't affect book
+    assert(snapshot2.ct[ASK][0] == 2);
     
     // C event should complete the T-F-C sequence and apply the trade
     // The trade was T 'A' 100.50 30, so it should affect the BID side (opposite)
-    MboEvent cancel{std::chrono::nanoseconds(0), 'C', 'A', 100.75, 30, 2001};
+    MboEvent cancel{std::chrono::nanoseconds(0), 'C', 'A', priceFromDouble(100.75), 30, 2001};
     assert(book.processEvent(cancel));
     
     MbpSnapshot snapshot3 = book.generateSnapshot();
-    assert(snapshot3.bid_px_00 == 100.50);
-    assert(snapshot3.bid_sz_00 == 120); // 150 - 30 = 120 (trade applied to bid side)
-    assert(snapshot3.ask_px_00 == 100.75);
-    assert(snapshot3.ask_sz_00 == 100); // Ask side unchanged by the trade
+    assert(snapshot3.px[BID][0] == priceFromDouble(100.50));
+    assert(snapshot3.sz[BID][0] == 120); // 150 - 30 = 120 (trade applied to bid side)
+    assert(snapshot3.px[ASK][0] == priceFromDouble(100.75));
+    assert(snapshot3.sz[ASK][0] == 100); // Ask side unchanged by the trade
     
     std::cout << "✓ Basic trade event handling passed" << std::endl;
 }
 
+template <typename Book>
 void testTradeEventFIFO() {
     std::cout << "Testing Trade Event FIFO Policy..." << std::endl;
-    OrderBook book;
+    Book book;
     
     // Add multiple orders at same price level (FIFO order)
-    book.addOrder(2001, 100.75, 20, 'A'); // First in queue
-    book.addOrder(2002, 100.75, 30, 'A'); // Second in queue
-    book.addOrder(2003, 100.75, 40, 'A'); // Third in queue
+    book.addOrder(2001, priceFromDouble(100.75), 20, 'A'); // First in queue
+    book.addOrder(2002, priceFromDouble(100.75), 30, 'A'); // Second in queue
+    book.addOrder(2003, priceFromDouble(100.75), 40, 'A'); // Third in queue
     
     MbpSnapshot snapshot1 = book.generateSnapshot();
-    assert(snapshot1.ask_px_00 == 100.75);
-    assert(snapshot1.ask_sz_00 == 90); // 20 + 30 + 40
+    assert(snapshot1.px[ASK][0] == priceFromDouble(100.75));
+    assert(snapshot1.sz[ASK][0] == 90); // 20 + 30 + 40
     
     // Complete T-F-C sequence that should affect multiple orders in FIFO order
     // Trade from bid side (B) should affect ask side orders
-    MboEvent trade{std::chrono::nanoseconds(0), 'T', 'B', 100.75, 35, 0}; // Trade from bid side
+    MboEvent trade{std::chrono::nanoseconds(0), 'T', 'B', priceFromDouble(100.75), 35, 0}; // Trade from bid side
     assert(book.processEvent(trade));
     
     // F event should not change the order book yet
-    MboEvent fill{std::chrono::nanoseconds(0), 'F', 'A', 100.75, 35, 2001}; // Fill ask side
+    MboEvent fill{std::chrono::nanoseconds(0), 'F', 'A', priceFromDouble(100.75), 35, 2001}; // Fill ask side
     assert(book.processEvent(fill));
     
     // Order book should still be unchanged after T-F
     MbpSnapshot snapshot_tf = book.generateSnapshot();
-    assert(snapshot_tf.ask_px_00 == 100.75);
-    assert(snapshot_tf.ask_sz_00 == 90); // Still unchanged after T-F
+    assert(snapshot_tf.px[ASK][0] == priceFromDouble(100.75));
+    assert(snapshot_tf.sz[ASK][0] == 90); // Still unchanged after T-F
     
     // C event completes the sequence and applies the trade
-    MboEvent cancel{std::chrono::nanoseconds(0), 'C', 'A', 100.75, 35, 2001}; // Cancel to complete sequence
+    MboEvent cancel{std::chrono::nanoseconds(0), 'C', 'A', priceFromDouble(100.75), 35, 2001}; // Cancel to complete sequence
     assert(book.processEvent(cancel));
     
     // Should fill first order completely (20) and second order partially (15)
     MbpSnapshot snapshot2 = book.generateSnapshot();
-    assert(snapshot2.ask_px_00 == 100.75);
-    assert(snapshot2.ask_sz_00 == 55); // 90 - 35 = 55
-    assert(snapshot2.ask_ct_00 == 2); // One order removed (20 size order), one partially filled
+    assert(snapshot2.px[ASK][0] == priceFromDouble(100.75));
+    assert(snapshot2.sz[ASK][0] == 55); // 90 - 35 = 55
+    assert(snapshot2.ct[ASK][0] == 2); // One order removed (20 size order), one partially filled
     
     std::cout << "✓ Trade FIFO policy passed" << std::endl;
 }
 
+template <typename Book>
+void testCancelPreservesQueuePriority() {
+    std::cout << "Testing Cancel Preserves Queue Priority..." << std::endl;
+    Book book;
+    
+    book.addOrder(2001, priceFromDouble(100.75), 20, 'A'); // First in queue
+    book.addOrder(2002, priceFromDouble(100.75), 30, 'A'); // Second in queue
+    book.addOrder(2003, priceFromDouble(100.75), 40, 'A'); // Third in queue
+    book.addOrder(2004, priceFromDouble(100.75), 50, 'A'); // Fourth in queue
+    
+    // Remove the second order outright and shrink the first one
+    MboEvent cancel_middle{std::chrono::nanoseconds(0), 'C', 'A', priceFromDouble(100.75), 30, 2002};
+    assert(book.processEvent(cancel_middle));
+    MboEvent shrink_front{std::chrono::nanoseconds(0), 'C', 'A', priceFromDouble(100.75), 10, 2001};
+    assert(book.processEvent(shrink_front));
+    // Remove the tail order
+    MboEvent cancel_tail{std::chrono::nanoseconds(0), 'C', 'A', priceFromDouble(100.75), 50, 2004};
+    assert(book.processEvent(cancel_tail));
+    
+    MbpSnapshot snapshot1 = book.generateSnapshot();
+    assert(snapshot1.sz[ASK][0] == 50); // 10 + 40
+    assert(snapshot1.ct[ASK][0] == 2);
+    
+    // Fill of 25 should consume the shrunken front order (10) and then 15 of order 2003
+    book.fillOrdersAtPrice(priceFromDouble(100.75), 25, 'A');
+    
+    assert(!book.orderExists(2001));
+    assert(book.orderExists(2003));
+    MbpSnapshot snapshot2 = book.generateSnapshot();
+    assert(snapshot2.sz[ASK][0] == 25);
+    assert(snapshot2.ct[ASK][0] == 1);
+    
+    // New orders join behind the survivor
+    book.addOrder(2005, priceFromDouble(100.75), 60, 'A');
+    book.fillOrdersAtPrice(priceFromDouble(100.75), 30, 'A');
+    
+    assert(!book.orderExists(2003));
+    assert(book.orderExists(2005));
+    MbpSnapshot snapshot3 = book.generateSnapshot();
+    assert(snapshot3.sz[ASK][0] == 55);
+    assert(snapshot3.ct[ASK][0] == 1);
+    
+    std::cout << "✓ Cancel queue priority passed" << std::endl;
+}
+
+template <typename Book>
 void testTradeEventIgnoreSideN() {
     std::cout << "Testing Trade Event Side 'N' Ignored..." << std::endl;
-    OrderBook book;
+    Book book;
     
     // Add orders
-    book.addOrder(1001, 100.50, 100, 'B');
-    book.addOrder(2001, 100.75, 100, 'A');
+    book.addOrder(1001, priceFromDouble(100.50), 100, 'B');
+    book.addOrder(2001, priceFromDouble(100.75), 100, 'A');
     
     MbpSnapshot snapshot1 = book.generateSnapshot();
-    uint64_t initial_bid_size = snapshot1.bid_sz_00;
-    uint64_t initial_ask_size = snapshot1.ask_sz_00;
+    uint64_t initial_bid_size = snapshot1.sz[BID][0];
+    uint64_t initial_ask_size = snapshot1.sz[ASK][0];
     
     // Trade with side 'N' should be ignored
-    MboEvent trade{std::chrono::nanoseconds(0), 'T', 'N', 100.62, 50, 0};
+    MboEvent trade{std::chrono::nanoseconds(0), 'T', 'N', priceFromDouble(100.62), 50, 0};
     assert(book.processEvent(trade)); // Should return true but do nothing
     
     MbpSnapshot snapshot2 = book.generateSnapshot();
-    assert(snapshot2.bid_sz_00 == initial_bid_size);
-    assert(snapshot2.ask_sz_00 == initial_ask_size);
+    assert(snapshot2.sz[BID][0] == initial_bid_size);
+    assert(snapshot2.sz[ASK][0] == initial_ask_size);
     
     std::cout << "✓ Trade side 'N' ignored correctly" << std::endl;
 }
 
+template <typename Book>
 void testTradeEventOppositeSideLogic() {
     std::cout << "Testing Trade Event Opposite Side Logic..." << std::endl;
-    OrderBook book;
+    Book book;
     
     // Add orders
-    book.addOrder(1001, 100.50, 100, 'B');
-    book.addOrder(2001, 100.75, 100, 'A');
+    book.addOrder(1001, priceFromDouble(100.50), 100, 'B');
+    book.addOrder(2001, priceFromDouble(100.75), 100, 'A');
     
     // Complete T-F-C sequence: Trade from ask side (A) should affect bid side orders
-    MboEvent trade1{std::chrono::nanoseconds(0), 'T', 'A', 100.50, 25, 0};
+    MboEvent trade1{std::chrono::nanoseconds(0), 'T', 'A', priceFromDouble(100.50), 25, 0};
     assert(book.processEvent(trade1));
     
-    MboEvent fill1{std::chrono::nanoseconds(0), 'F', 'A', 100.75, 25, 2001};
+    MboEvent fill1{std::chrono::nanoseconds(0), 'F', 'A', priceFromDouble(100.75), 25, 2001};
     assert(book.processEvent(fill1));
     
     // Complete the T-F-C sequence
-    MboEvent cancel1{std::chrono::nanoseconds(0), 'C', 'A', 100.75, 25, 2001};
+    MboEvent cancel1{std::chrono::nanoseconds(0), 'C', 'A', priceFromDouble(100.75), 25, 2001};
     assert(book.processEvent(cancel1));
     
     MbpSnapshot snapshot1 = book.generateSnapshot();
-    assert(snapshot1.bid_px_00 == 100.50);
-    assert(snapshot1.bid_sz_00 == 75); // Bid reduced by 25 (opposite side logic)
-    assert(snapshot1.ask_px_00 == 100.75);
-    assert(snapshot1.ask_sz_00 == 100);  // Ask unchanged (trade affects opposite side)
+    assert(snapshot1.px[BID][0] == priceFromDouble(100.50));
+    assert(snapshot1.sz[BID][0] == 75); // Bid reduced by 25 (opposite side logic)
+    assert(snapshot1.px[ASK][0] == priceFromDouble(100.75));
+    assert(snapshot1.sz[ASK][0] == 100);  // Ask unchanged (trade affects opposite side)
     
     // Complete T-F-C sequence: Trade from bid side (B) should affect ask side orders  
-    MboEvent trade2{std::chrono::nanoseconds(0), 'T', 'B', 100.75, 30, 0};
+    MboEvent trade2{std::chrono::nanoseconds(0), 'T', 'B', priceFromDouble(100.75), 30, 0};
     assert(book.processEvent(trade2));
     
-    MboEvent fill2{std::chrono::nanoseconds(0), 'F', 'B', 100.50, 30, 1001};
+    MboEvent fill2{std::chrono::nanoseconds(0), 'F', 'B', priceFromDouble(100.50), 30, 1001};
     assert(book.processEvent(fill2));
     
     // Complete the T-F-C sequence
-    MboEvent cancel2{std::chrono::nanoseconds(0), 'C', 'B', 100.50, 30, 1001};
+    MboEvent cancel2{std::chrono::nanoseconds(0), 'C', 'B', priceFromDouble(100.50), 30, 1001};
     assert(book.processEvent(cancel2));
     
     MbpSnapshot snapshot2 = book.generateSnapshot();
-    assert(snapshot2.bid_px_00 == 100.50);
-    assert(snapshot2.bid_sz_00 == 75);  // Bid unchanged from previous (trade affects opposite side)
-    assert(snapshot2.ask_px_00 == 100.75);
-    assert(snapshot2.ask_sz_00 == 70);  // Ask reduced by 30 (opposite side logic)
+    assert(snapshot2.px[BID][0] == priceFromDouble(100.50));
+    assert(snapshot2.sz[BID][0] == 75);  // Bid unchanged from previous (trade affects opposite side)
+    assert(snapshot2.px[ASK][0] == priceFromDouble(100.75));
+    assert(snapshot2.sz[ASK][0] == 70);  // Ask reduced by 30 (opposite side logic)
     
     std::cout << "✓ Opposite side logic passed" << std::endl;
 }
 
+template <typename Book>
 void testResetEvent() {
     std::cout << "Testing Reset Event..." << std::endl;
-    OrderBook book;
+    Book book;
     
     // Add multiple orders
-    book.addOrder(1001, 100.50, 1000, 'B');
-    book.addOrder(1002, 100.25, 500, 'B');
-    book.addOrder(2001, 100.75, 750, 'A');
-    book.addOrder(2002, 101.00, 600, 'A');
+    book.addOrder(1001, priceFromDouble(100.50), 1000, 'B');
+    book.addOrder(1002, priceFromDouble(100.25), 500, 'B');
+    book.addOrder(2001, priceFromDouble(100.75), 750, 'A');
+    book.addOrder(2002, priceFromDouble(101.00), 600, 'A');
     
     assert(book.getBidLevelCount() == 2);
     assert(book.getAskLevelCount() == 2);
     assert(book.getOrderCount() == 4);
     
     // Process reset event
-    MboEvent reset{std::chrono::nanoseconds(0), 'R', 'N', 0.0, 0, 0};
+    MboEvent reset{std::chrono::nanoseconds(0), 'R', 'N', priceFromDouble(0.0), 0, 0};
     assert(book.processEvent(reset));
     
     // Book should be completely empty
@@ -500,47 +583,48 @@ void testResetEvent() {
     
     // All price, size, and count fields should be 0
     for (int i = 0; i < 10; i++) {
-        assert((&snapshot.bid_px_00)[i] == 0.0);
-        assert((&snapshot.ask_px_00)[i] == 0.0);
-        assert((&snapshot.bid_sz_00)[i] == 0);
-        assert((&snapshot.ask_sz_00)[i] == 0);
-        assert((&snapshot.bid_ct_00)[i] == 0);
-        assert((&snapshot.ask_ct_00)[i] == 0);
+        assert(snapshot.px[BID][i] == 0);
+        assert(snapshot.px[ASK][i] == 0);
+        assert(snapshot.sz[BID][i] == 0);
+        assert(snapshot.sz[ASK][i] == 0);
+        assert(snapshot.ct[BID][i] == 0);
+        assert(snapshot.ct[ASK][i] == 0);
     }
     
     std::cout << "✓ Reset event handling passed" << std::endl;
 }
 
+template <typename Book>
 void testMbpSnapshotGeneration() {
     std::cout << "Testing MBP-10 Snapshot Generation..." << std::endl;
-    OrderBook book;
+    Book book;
     
     // Test with exactly 10 levels on each side
     for (int i = 0; i < 10; i++) {
         // Add bid levels from 100.10 down to 100.01
-        book.addOrder(1000 + i, 100.10 - i * 0.01, 100 + i * 10, 'B');
+        book.addOrder(1000 + i, priceFromDouble(100.10 - i * 0.01), 100 + i * 10, 'B');
         // Add ask levels from 100.20 up to 100.29
-        book.addOrder(2000 + i, 100.20 + i * 0.01, 200 + i * 10, 'A');
+        book.addOrder(2000 + i, priceFromDouble(100.20 + i * 0.01), 200 + i * 10, 'A');
     }
     
     MbpSnapshot snapshot = book.generateSnapshot();
     
     // Verify all 10 bid levels (sorted highest to lowest)
     for (int i = 0; i < 10; i++) {
-        double expected_price = 100.10 - i * 0.01;
+        Price expected_price = priceFromDouble(100.10 - i * 0.01);
         uint64_t expected_size = 100 + i * 10;
-        assert(std::abs((&snapshot.bid_px_00)[i] - expected_price) < 0.001);
-        assert((&snapshot.bid_sz_00)[i] == expected_size);
-        assert((&snapshot.bid_ct_00)[i] == 1);
+        assert(snapshot.px[BID][i] == expected_price);
+        assert(snapshot.sz[BID][i] == expected_size);
+        assert(snapshot.ct[BID][i] == 1);
     }
     
     // Verify all 10 ask levels (sorted lowest to highest)
     for (int i = 0; i < 10; i++) {
-        double expected_price = 100.20 + i * 0.01;
+        Price expected_price = priceFromDouble(100.20 + i * 0.01);
         uint64_t expected_size = 200 + i * 10;
-        assert(std::abs((&snapshot.ask_px_00)[i] - expected_price) < 0.001);
-        assert((&snapshot.ask_sz_00)[i] == expected_size);
-        assert((&snapshot.ask_ct_00)[i] == 1);
+        assert(snapshot.px[ASK][i] == expected_price);
+        assert(snapshot.sz[ASK][i] == expected_size);
+        assert(snapshot.ct[ASK][i] == 1);
     }
     
     std::cout << "✓ 10-level snapshot generation passed" << std::endl;
@@ -548,84 +632,607 @@ void testMbpSnapshotGeneration() {
     // Test with more than 10 levels (should only show top 10)
     book.clear();
     for (int i = 0; i < 15; i++) {
-        book.addOrder(3000 + i, 95.00 + i * 0.50, 50, 'B');
-        book.addOrder(4000 + i, 105.00 + i * 0.25, 75, 'A');
+        book.addOrder(3000 + i, priceFromDouble(95.00 + i * 0.50), 50, 'B');
+        book.addOrder(4000 + i, priceFromDouble(105.00 + i * 0.25), 75, 'A');
     }
     
     snapshot = book.generateSnapshot();
     
     // Should show top 10 bids (highest prices)
     for (int i = 0; i < 10; i++) {
-        double expected_price = 102.00 - i * 0.50; // Top 10 from 102.00 down
-        assert(std::abs((&snapshot.bid_px_00)[i] - expected_price) < 0.001);
-        assert((&snapshot.bid_sz_00)[i] == 50);
-        assert((&snapshot.bid_ct_00)[i] == 1);
+        Price expected_price = priceFromDouble(102.00 - i * 0.50); // Top 10 from 102.00 down
+        assert(snapshot.px[BID][i] == expected_price);
+        assert(snapshot.sz[BID][i] == 50);
+        assert(snapshot.ct[BID][i] == 1);
     }
     
     // Should show top 10 asks (lowest prices)
     for (int i = 0; i < 10; i++) {
-        double expected_price = 105.00 + i * 0.25; // Bottom 10 from 105.00 up
-        assert(std::abs((&snapshot.ask_px_00)[i] - expected_price) < 0.001);
-        assert((&snapshot.ask_sz_00)[i] == 75);
-        assert((&snapshot.ask_ct_00)[i] == 1);
+        Price expected_price = priceFromDouble(105.00 + i * 0.25); // Bottom 10 from 105.00 up
+        assert(snapshot.px[ASK][i] == expected_price);
+        assert(snapshot.sz[ASK][i] == 75);
+        assert(snapshot.ct[ASK][i] == 1);
     }
     
     std::cout << "✓ >10 level truncation passed" << std::endl;
     
     // Test with fewer than 10 levels
     book.clear();
-    book.addOrder(5001, 99.50, 300, 'B');
-    book.addOrder(5002, 99.25, 400, 'B');
-    book.addOrder(5003, 100.75, 200, 'A');
+    book.addOrder(5001, priceFromDouble(99.50), 300, 'B');
+    book.addOrder(5002, priceFromDouble(99.25), 400, 'B');
+    book.addOrder(5003, priceFromDouble(100.75), 200, 'A');
     
     snapshot = book.generateSnapshot();
     
     // First 2 bid levels should have data
-    assert(snapshot.bid_px_00 == 99.50);
-    assert(snapshot.bid_sz_00 == 300);
-    assert(snapshot.bid_ct_00 == 1);
+    assert(snapshot.px[BID][0] == priceFromDouble(99.50));
+    assert(snapshot.sz[BID][0] == 300);
+    assert(snapshot.ct[BID][0] == 1);
     
-    assert(snapshot.bid_px_01 == 99.25);
-    assert(snapshot.bid_sz_01 == 400);
-    assert(snapshot.bid_ct_01 == 1);
+    assert(snapshot.px[BID][1] == priceFromDouble(99.25));
+    assert(snapshot.sz[BID][1] == 400);
+    assert(snapshot.ct[BID][1] == 1);
     
     // Remaining bid levels should be 0
     for (int i = 2; i < 10; i++) {
-        assert((&snapshot.bid_px_00)[i] == 0.0);
-        assert((&snapshot.bid_sz_00)[i] == 0);
-        assert((&snapshot.bid_ct_00)[i] == 0);
+        assert(snapshot.px[BID][i] == 0);
+        assert(snapshot.sz[BID][i] == 0);
+        assert(snapshot.ct[BID][i] == 0);
     }
     
     // First ask level should have data
-    assert(snapshot.ask_px_00 == 100.75);
-    assert(snapshot.ask_sz_00 == 200);
-    assert(snapshot.ask_ct_00 == 1);
+    assert(snapshot.px[ASK][0] == priceFromDouble(100.75));
+    assert(snapshot.sz[ASK][0] == 200);
+    assert(snapshot.ct[ASK][0] == 1);
     
     // Remaining ask levels should be 0
     for (int i = 1; i < 10; i++) {
-        assert((&snapshot.ask_px_00)[i] == 0.0);
-        assert((&snapshot.ask_sz_00)[i] == 0);
-        assert((&snapshot.ask_ct_00)[i] == 0);
+        assert(snapshot.px[ASK][i] == 0);
+        assert(snapshot.sz[ASK][i] == 0);
+        assert(snapshot.ct[ASK][i] == 0);
     }
     
     std::cout << "✓ <10 level padding passed" << std::endl;
     std::cout << "✓ MBP-10 snapshot generation tests passed" << std::endl;
 }
 
+void testLadderRecentring() {
+    std::cout << "Testing Ladder Re-centring and Overflow..." << std::endl;
+    LadderOrderBook book;
+    
+    // A far-away ask lands in overflow, beyond the 4096-tick window
+    book.addOrder(2001, priceFromDouble(21.33), 100, 'A');
+    book.addOrder(2002, priceFromDouble(95.00), 100, 'A');
+    // Better asks arrive well outside the window and force a re-centre
+    book.addOrder(2003, priceFromDouble(5.90), 100, 'A');
+    book.addOrder(2004, priceFromDouble(5.91), 200, 'A');
+    
+    assert(book.getAskLevelCount() == 4);
+    
+    MbpSnapshot snapshot = book.generateSnapshot();
+    assert(snapshot.px[ASK][0] == priceFromDouble(5.90));
+    assert(snapshot.px[ASK][1] == priceFromDouble(5.91));
+    assert(snapshot.sz[ASK][1] == 200);
+    assert(snapshot.px[ASK][2] == priceFromDouble(21.33));
+    assert(snapshot.px[ASK][3] == priceFromDouble(95.00));
+    
+    // Emptying the window pulls overflow levels back in best-first
+    MboEvent cancel1{std::chrono::nanoseconds(0), 'C', 'A', priceFromDouble(5.90), 100, 2003};
+    MboEvent cancel2{std::chrono::nanoseconds(0), 'C', 'A', priceFromDouble(5.91), 200, 2004};
+    MboEvent cancel3{std::chrono::nanoseconds(0), 'C', 'A', priceFromDouble(21.33), 100, 2001};
+    book.processEvent(cancel1);
+    book.processEvent(cancel2);
+    book.processEvent(cancel3);
+    
+    assert(book.getAskLevelCount() == 1);
+    assert(book.getBestAskPrice() == priceFromDouble(95.00));
+    assert(book.hasOrdersAtPrice(priceFromDouble(95.00), 'A'));
+    assert(!book.hasOrdersAtPrice(priceFromDouble(21.33), 'A'));
+    
+    // Same for bids, where better means higher
+    book.addOrder(1001, priceFromDouble(5.51), 100, 'B');
+    book.addOrder(1002, priceFromDouble(80.00), 300, 'B');
+    book.addOrder(1003, priceFromDouble(0.50), 400, 'B');
+    
+    snapshot = book.generateSnapshot();
+    assert(snapshot.px[BID][0] == priceFromDouble(80.00));
+    assert(snapshot.sz[BID][0] == 300);
+    assert(snapshot.px[BID][1] == priceFromDouble(5.51));
+    assert(snapshot.px[BID][2] == priceFromDouble(0.50));
+    assert(book.getBestBidAsk().first == priceFromDouble(80.00));
+    
+    std::cout << "✓ Ladder re-centring passed" << std::endl;
+}
+
+void testLadderOffGridPrices() {
+    std::cout << "Testing Ladder Off-grid Prices..." << std::endl;
+    LadderOrderBook book;
+    
+    book.addOrder(1001, priceFromDouble(13.57), 100, 'B');
+    book.addOrder(1002, priceFromDouble(13.56), 100, 'B');
+    // Half-cent price is off the default 0.01 grid and forces a re-grid
+    book.addOrder(1003, priceFromDouble(13.565), 50, 'B');
+    book.addOrder(1004, priceFromDouble(13.575), 25, 'B');
+    
+    assert(book.getBidLevelCount() == 4);
+    
+    MbpSnapshot snapshot = book.generateSnapshot();
+    assert(snapshot.px[BID][0] == priceFromDouble(13.575));
+    assert(snapshot.px[BID][1] == priceFromDouble(13.57));
+    assert(snapshot.px[BID][2] == priceFromDouble(13.565));
+    assert(snapshot.sz[BID][2] == 50);
+    assert(snapshot.px[BID][3] == priceFromDouble(13.56));
+    
+    std::cout << "✓ Ladder off-grid prices passed" << std::endl;
+}
+
+void testLadderOffGridTick() {
+    std::cout << "Testing Ladder Off-grid Tick Handling..." << std::endl;
+    using AskLadder = LadderPriceLevels<std::less<Price>>;
+    const Price tick = AskLadder::DEFAULT_TICK_SIZE;
+    const Price half_tick = tick / 2;
+    AskLadder levels;
+    
+    for (int i = 0; i < 100; ++i) {
+        levels.insert(priceFromDouble(20.00) + i * tick);
+    }
+    
+    // A lone off-grid print is held aside and leaves the tick alone, while
+    // still ranking and iterating in price order
+    const Price stray = priceFromDouble(20.00) + 10 * tick + half_tick;
+    levels.insert(stray);
+    assert(levels.getTickSize() == tick);
+    assert(levels.size() == 101);
+    assert(levels.find(stray) && levels.find(stray)->price == stray);
+    assert(levels.rank(stray, 50) == 11);
+    assert(levels.rank(priceFromDouble(20.00) + 11 * tick, 50) == 12);
+    std::vector<Price> seen;
+    levels.forEachLevel(13, [&](const LevelData& level) { seen.push_back(level.price); });
+    assert(seen.size() == 13 && seen[10] == priceFromDouble(20.00) + 10 * tick && seen[11] == stray);
+    
+    // A better off-grid price becomes the best level
+    const Price better = priceFromDouble(20.00) - half_tick;
+    levels.insert(better);
+    assert(levels.best()->price == better);
+    assert(levels.rank(priceFromDouble(20.00), 50) == 1);
+    levels.erase(better);
+    levels.erase(stray);
+    assert(!levels.find(stray) && levels.size() == 100);
+    assert(levels.best()->price == priceFromDouble(20.00));
+    
+    // Past OFF_GRID_LEVELS live off-grid prices the ladder re-grids to the
+    // half tick, keeping every level
+    for (size_t i = 0; i <= AskLadder::OFF_GRID_LEVELS; ++i) {
+        levels.insert(priceFromDouble(20.00) + static_cast<Price>(i) * tick + half_tick);
+    }
+    assert(levels.getTickSize() == half_tick);
+    assert(levels.size() == 100 + AskLadder::OFF_GRID_LEVELS + 1);
+    Price previous = 0;
+    size_t count = 0;
+    levels.forEachLevel(SIZE_MAX, [&](const LevelData& level) {
+        assert(count == 0 || level.price > previous);
+        assert(levels.find(level.price) == &level);
+        previous = level.price;
+        ++count;
+    });
+    assert(count == levels.size());
+    
+    // Clearing restores the configured tick, as does draining every level
+    levels.clear();
+    assert(levels.getTickSize() == tick && levels.empty());
+    levels.insert(priceFromDouble(30.00));
+    for (size_t i = 0; i <= AskLadder::OFF_GRID_LEVELS; ++i) {
+        levels.insert(priceFromDouble(30.00) + static_cast<Price>(i) * tick + half_tick);
+    }
+    assert(levels.getTickSize() == half_tick);
+    levels.erase(priceFromDouble(30.00));
+    for (size_t i = 0; i <= AskLadder::OFF_GRID_LEVELS; ++i) {
+        levels.erase(priceFromDouble(30.00) + static_cast<Price>(i) * tick + half_tick);
+    }
+    assert(levels.empty());
+    levels.insert(priceFromDouble(31.00));
+    assert(levels.getTickSize() == tick);
+    
+    std::cout << "✓ Ladder off-grid tick handling passed" << std::endl;
+}
+
+void testLadderPoolCounted() {
+    std::cout << "Testing Ladder Pool Allocation Counting..." << std::endl;
+    NodeArena arena;
+    AllocationStats empty = arena.getStats();
+    {
+        LadderPriceLevels<std::less<Price>> levels(&arena);
+        AllocationStats constructed = arena.getStats();
+        assert(constructed.large_allocations > empty.large_allocations);
+        
+        // Filling the window grows the level pool, which the arena counts
+        for (int tick = 0; tick < 2000; ++tick) {
+            levels.insert(priceFromDouble(10.00) + tick * LadderPriceLevels<std::less<Price>>::DEFAULT_TICK_SIZE);
+        }
+        AllocationStats filled = arena.getStats();
+        assert(filled.large_allocations > constructed.large_allocations);
+        
+        // The pool is kept across clear() and an arena reset and refilled
+        // without further allocations
+        levels.clear();
+        arena.reset();
+        for (int tick = 0; tick < 2000; ++tick) {
+            levels.insert(priceFromDouble(10.00) + tick * LadderPriceLevels<std::less<Price>>::DEFAULT_TICK_SIZE);
+        }
+        assert(arena.getStats().heapAllocations() == filled.heapAllocations());
+    }
+    
+    std::cout << "✅ Ladder Pool Allocation Counting test passed!" << std::endl;
+}
+
+// Drives both level stores with the same random add/cancel flow spread wider
+// than the ladder window and checks they agree after every event
+void testLadderMatchesMapBook() {
+    std::cout << "Testing Ladder Against Map Book..." << std::endl;
+    OrderBook map_book;
+    LadderOrderBook ladder_book;
+    
+    std::vector<MboEvent> live_orders;
+    uint64_t next_order_id = 1;
+    uint64_t rng = 12345;
+    auto next_random = [&rng]() {
+        rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+        return rng >> 33;
+    };
+    
+    for (int i = 0; i < 20000; ++i) {
+        MboEvent event;
+        bool add = live_orders.empty() || next_random() % 100 < 55;
+        
+        if (add) {
+            event.action = 'A';
+            event.side = (next_random() % 2) ? 'B' : 'A';
+            // Mostly near the touch, occasionally far away
+            int64_t cents = (next_random() % 10 == 0) ? 100 + next_random() % 20000 : 1000 + next_random() % 200;
+            if (event.side == 'A') {
+                cents += 150;
+            }
+            event.price = cents * (PRICE_SCALE / 100);
+            // Now and then a sub-penny price, off the ladder's tick grid
+            if (next_random() % 40 == 0) {
+                event.price += static_cast<Price>(1 + next_random() % 9) * (PRICE_SCALE / 1000);
+            }
+            event.size = 1 + next_random() % 500;
+            event.order_id = next_order_id++;
+            live_orders.push_back(event);
+        } else {
+            size_t victim = next_random() % live_orders.size();
+            event = live_orders[victim];
+            event.action = 'C';
+            if (next_random() % 4 == 0 && event.size > 1) {
+                event.size = 1 + next_random() % (event.size - 1);
+                live_orders[victim].size -= event.size;
+            } else {
+                live_orders[victim] = live_orders.back();
+                live_orders.pop_back();
+            }
+        }
+        
+        map_book.processEvent(event);
+        ladder_book.processEvent(event);
+        
+        assert(map_book.captureTop10State() == ladder_book.captureTop10State());
+        assert(map_book.getBidLevelCount() == ladder_book.getBidLevelCount());
+        assert(map_book.getAskLevelCount() == ladder_book.getAskLevelCount());
+    }
+    
+    std::cout << "✓ Ladder matches map book passed" << std::endl;
+}
+
+template <typename Book>
+void testDepthSnapshots() {
+    std::cout << "Testing MBP-1/MBP-50 Depth Snapshots..." << std::endl;
+    Book book;
+    
+    // 60 bid levels, 30 ask levels
+    for (int i = 0; i < 60; ++i) {
+        book.addOrder(1000 + i, (500 - i) * PRICE_SCALE, 10 + i, 'B');
+    }
+    for (int i = 0; i < 30; ++i) {
+        book.addOrder(2000 + i, (600 + i) * PRICE_SCALE, 20 + i, 'A');
+    }
+    
+    MboEvent event{std::chrono::nanoseconds(7), 'A', 'B', 440 * PRICE_SCALE, 69, 1059};
+    Mbp1Snapshot top = book.template generateDepthSnapshot<1>(event);
+    MbpSnapshot mbp10 = book.generateSnapshot(event);
+    Mbp50Snapshot mbp50 = book.template generateDepthSnapshot<50>(event);
+    
+    assert(top.timestamp == mbp10.timestamp && top.event_order_id == 1059);
+    assert(top.px[BID][0] == 500 * PRICE_SCALE && top.sz[BID][0] == 10);
+    assert(top.px[ASK][0] == 600 * PRICE_SCALE && top.sz[ASK][0] == 20);
+    
+    // Each depth is a prefix of the deeper one
+    for (size_t i = 0; i < MbpSnapshot::DEPTH; ++i) {
+        assert(mbp10.px[BID][i] == mbp50.px[BID][i] && mbp10.sz[ASK][i] == mbp50.sz[ASK][i]);
+    }
+    assert(mbp50.px[BID][49] == 451 * PRICE_SCALE && mbp50.ct[BID][49] == 1);
+    assert(mbp50.px[ASK][29] == 629 * PRICE_SCALE);
+    assert(mbp50.px[ASK][30] == 0 && mbp50.sz[ASK][30] == 0 && mbp50.ct[ASK][30] == 0);
+    
+    // Top10State is the level block of an MBP-10 snapshot
+    assert(book.captureTop10State() == mbp10.levels());
+    Top10State changed = mbp10.levels();
+    changed.sz[ASK][9] += 1;
+    assert(changed != mbp10.levels());
+    assert(changed.hasMarketRelevantChange(mbp10.levels()));
+    
+    std::cout << "✓ Depth snapshots passed" << std::endl;
+}
+
+// Queries and fills are dispatched on the side once; a side that is
+// neither B nor A touches no levels
+template <typename Book>
+void testSideDispatch() {
+    std::cout << "Testing side dispatch..." << std::endl;
+    Book book;
+    book.addOrder(1, 100 * PRICE_SCALE, 10, 'B');
+    book.addOrder(2, 99 * PRICE_SCALE, 20, 'B');
+    book.addOrder(3, 100 * PRICE_SCALE, 30, 'A');
+    
+    assert(book.hasOrdersAtPrice(100 * PRICE_SCALE, 'B') && book.hasOrdersAtPrice(100 * PRICE_SCALE, 'A'));
+    assert(!book.hasOrdersAtPrice(99 * PRICE_SCALE, 'A'));
+    assert(!book.hasOrdersAtPrice(100 * PRICE_SCALE, 'N'));
+    assert(book.getLevelDepth(99 * PRICE_SCALE, 'B') == 1);
+    assert(book.getLevelDepth(100 * PRICE_SCALE, 'A') == 0);
+    assert(book.getLevelDepth(99 * PRICE_SCALE, 'N') == 0);
+    
+    book.fillOrdersAtPrice(100 * PRICE_SCALE, 10, 'N');
+    assert(book.getOrderCount() == 3);
+    
+    // Filling the whole best bid removes its level and promotes the next
+    book.fillOrdersAtPrice(100 * PRICE_SCALE, 10, 'B');
+    assert(book.getBidLevelCount() == 1 && book.getBestBidPrice() == 99 * PRICE_SCALE);
+    assert(book.getLevelDepth(99 * PRICE_SCALE, 'B') == 0);
+    assert(book.getBestAskPrice() == 100 * PRICE_SCALE && book.orderExists(3));
+    
+    std::cout << "✓ Side dispatch passed" << std::endl;
+}
+
+// The MBP-10 levels come from the book's kept window, MBP-50 from a fresh
+// walk, so after every update the one must be a prefix of the other
+template <typename Book>
+void testTopLevelCache() {
+    std::cout << "Testing top level cache..." << std::endl;
+    Book book;
+    
+    uint64_t state = 99;
+    auto next = [&state]() {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return state >> 33;
+    };
+    
+    std::vector<uint64_t> live_orders;
+    uint64_t next_order_id = 1;
+    MboEvent probe{std::chrono::nanoseconds(0), 'A', 'B', 0, 0, 0};
+    for (int i = 0; i < 20000; ++i) {
+        int choice = static_cast<int>(next() % 10);
+        if (choice < 5 || live_orders.empty()) {
+            // About 15 levels per side, so levels keep crossing the window edge
+            char side = next() % 2 ? 'B' : 'A';
+            Price ticks = static_cast<Price>(next() % 15);
+            Price price = side == 'B' ? (100 - ticks) * PRICE_SCALE : (101 + ticks) * PRICE_SCALE;
+            book.addOrder(next_order_id, price, 1 + next() % 100, side);
+            live_orders.push_back(next_order_id++);
+        } else if (choice < 9) {
+            size_t pick = next() % live_orders.size();
+            uint64_t cancel_size = next() % 3 == 0 ? 1 : 0;
+            MboEvent cancel{std::chrono::nanoseconds(0), 'C', 'N', 0, cancel_size, live_orders[pick]};
+            book.processEvent(cancel);
+            if (!book.orderExists(live_orders[pick])) {
+                live_orders[pick] = live_orders.back();
+                live_orders.pop_back();
+            }
+        } else {
+            char side = next() % 2 ? 'B' : 'A';
+            Price best = side == 'B' ? book.getBestBidPrice() : book.getBestAskPrice();
+            book.fillOrdersAtPrice(best, 1 + next() % 150, side);
+        }
+        
+        if (i % 7 == 0 || i > 19900) {
+            MbpSnapshot mbp10 = book.generateSnapshot(probe);
+            Mbp50Snapshot mbp50 = book.template generateDepthSnapshot<50>(probe);
+            for (size_t s = 0; s < 2; ++s) {
+                for (size_t level = 0; level < MbpSnapshot::DEPTH; ++level) {
+                    assert(mbp10.px[s][level] == mbp50.px[s][level]);
+                    assert(mbp10.sz[s][level] == mbp50.sz[s][level]);
+                    assert(mbp10.ct[s][level] == mbp50.ct[s][level]);
+                }
+            }
+        }
+    }
+    
+    MboEvent reset{std::chrono::nanoseconds(0), 'R', 'N', 0, 0, 0};
+    book.processEvent(reset);
+    assert(book.captureTop10State() == Top10State());
+    book.addOrder(next_order_id, 100 * PRICE_SCALE, 5, 'B');
+    assert(book.captureTop10State().px[BID][0] == 100 * PRICE_SCALE);
+    
+    std::cout << "✓ Top level cache passed" << std::endl;
+}
+
+template <typename Book>
+void testIncrementalTopChange() {
+    std::cout << "Testing Incremental Top-10 Change Detection..." << std::endl;
+    Book book;
+    
+    std::vector<MboEvent> live_orders;
+    uint64_t next_order_id = 1;
+    uint64_t rng = 98765;
+    auto next_random = [&rng]() {
+        rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+        return rng >> 33;
+    };
+    
+    // First differing rank between two states on one side, or 10 if none
+    auto firstDifference = [](const Top10State& a, const Top10State& b, char side) {
+        for (int i = 0; i < 10; ++i) {
+            bool same = (side == 'B')
+                ? a.px[BID][i] == b.px[BID][i] && a.sz[BID][i] == b.sz[BID][i] && a.ct[BID][i] == b.ct[BID][i]
+                : a.px[ASK][i] == b.px[ASK][i] && a.sz[ASK][i] == b.sz[ASK][i] && a.ct[ASK][i] == b.ct[ASK][i];
+            if (!same) {
+                return i;
+            }
+        }
+        return 10;
+    };
+    
+    for (int i = 0; i < 10000; ++i) {
+        MboEvent event;
+        bool add = live_orders.empty() || next_random() % 100 < 55;
+        
+        if (add) {
+            event.action = 'A';
+            event.side = (next_random() % 2) ? 'B' : 'A';
+            // Spread over ~40 levels so many updates land below the top 10
+            int64_t cents = 1000 + next_random() % 40;
+            if (event.side == 'A') {
+                cents += 45;
+            }
+            event.price = cents * (PRICE_SCALE / 100);
+            event.size = 1 + next_random() % 500;
+            event.order_id = next_order_id++;
+            live_orders.push_back(event);
+        } else {
+            size_t victim = next_random() % live_orders.size();
+            event = live_orders[victim];
+            event.action = 'C';
+            if (next_random() % 4 == 0 && event.size > 1) {
+                event.size = 1 + next_random() % (event.size - 1);
+                live_orders[victim].size -= event.size;
+            } else {
+                live_orders[victim] = live_orders.back();
+                live_orders.pop_back();
+            }
+        }
+        
+        Top10State before = book.captureTop10State();
+        ProcessResult result = book.processEvent(event);
+        Top10State after = book.captureTop10State();
+        
+        assert(result.top_changed == (before != after));
+        if (result.top_changed) {
+            assert(result.depth == firstDifference(before, after, event.side));
+        }
+    }
+    
+    // An update outside the snapshot depth reports its capped rank
+    book.clear();
+    for (int i = 0; i < 12; ++i) {
+        book.addOrder(100 + i, (100 - i) * PRICE_SCALE, 10, 'B');
+    }
+    MboEvent deep_add{std::chrono::nanoseconds(1), 'A', 'B', 85 * PRICE_SCALE, 10, 500};
+    ProcessResult deep = book.processEvent(deep_add);
+    assert(!deep.top_changed);
+    assert(deep.depth == 10);
+    assert(book.getLevelDepth(97 * PRICE_SCALE, 'B') == 3);
+    
+    std::cout << "✓ Incremental top-10 change detection passed" << std::endl;
+}
+
+template <typename Book>
+void testSteadyStateAllocations() {
+    std::cout << "Testing Steady-State Allocations..." << std::endl;
+    Book book;
+    
+    // Adds over a wide spread, so the ladder overflows too, and cancels of
+    // random live orders
+    std::vector<MboEvent> events;
+    std::vector<uint64_t> live_orders;
+    uint64_t rng = 4242;
+    auto next_random = [&rng]() {
+        rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+        return rng >> 33;
+    };
+    for (uint64_t i = 0; i < 20000; ++i) {
+        MboEvent event;
+        if (live_orders.empty() || next_random() % 100 < 60) {
+            event.action = 'A';
+            event.side = (next_random() % 2) ? 'B' : 'A';
+            int64_t cents = 100000 + static_cast<int64_t>(next_random() % 8000) * (event.side == 'A' ? 1 : -1);
+            event.price = cents * (PRICE_SCALE / 100);
+            event.size = 1 + next_random() % 100;
+            event.order_id = i + 1;
+            live_orders.push_back(event.order_id);
+        } else {
+            size_t pick = next_random() % live_orders.size();
+            event.action = 'C';
+            event.order_id = live_orders[pick];
+            live_orders[pick] = live_orders.back();
+            live_orders.pop_back();
+        }
+        events.push_back(event);
+    }
+    
+    MboEvent reset;
+    reset.action = 'R';
+    reset.side = 'N';
+    
+    auto replay = [&]() {
+        for (const MboEvent& event : events) {
+            book.processEvent(event);
+        }
+    };
+    
+    replay();
+    size_t orders = book.getOrderCount();
+    book.processEvent(reset);
+    AllocationStats warm = book.getAllocationStats();
+    assert(warm.heapAllocations() > 0);
+    
+    // The same work after a reset is served entirely from recycled memory
+    for (int pass = 0; pass < 2; ++pass) {
+        replay();
+        assert(book.getOrderCount() == orders);
+        book.processEvent(reset);
+        
+        AllocationStats steady = book.getAllocationStats();
+        assert(steady.heapAllocations() == warm.heapAllocations());
+        assert(steady.node_allocations > warm.node_allocations);
+        warm = steady;
+    }
+    
+    std::cout << "✅ Steady-State Allocations test passed!" << std::endl;
+}
+
+template <typename Book>
+void runBookTests(const char* name) {
+    std::cout << "\n=== " << name << " ===" << std::endl;
+    testOrderBookBasics<Book>();
+    testOrderBookLevels<Book>();
+    testOrderCancellation<Book>();
+    testDuplicateAddOrder<Book>();
+    testPartialCancellation<Book>();
+    testOverCancellation<Book>();
+    testCancellationAcrossLevels<Book>();
+    testMultiOrderLevelCancellation<Book>();
+    testTradeEventHandling<Book>();
+    testTradeEventFIFO<Book>();
+    testCancelPreservesQueuePriority<Book>();
+    testTradeEventIgnoreSideN<Book>();
+    testTradeEventOppositeSideLogic<Book>();
+    testResetEvent<Book>();
+    testMbpSnapshotGeneration<Book>();
+    testDepthSnapshots<Book>();
+    testSideDispatch<Book>();
+    testTopLevelCache<Book>();
+    testIncrementalTopChange<Book>();
+    testSteadyStateAllocations<Book>();
+}
+
 int main() {
-    testOrderBookBasics();
-    testOrderBookLevels();
-    testOrderCancellation();
-    testPartialCancellation();
-    testOverCancellation();
-    testCancellationAcrossLevels();
-    testMultiOrderLevelCancellation();
-    testTradeEventHandling();
-    testTradeEventFIFO();
-    testTradeEventIgnoreSideN();
-    testTradeEventOppositeSideLogic();
-    testResetEvent();
-    testMbpSnapshotGeneration();
+    runBookTests<OrderBook>("std::map price levels");
+    runBookTests<LadderOrderBook>("Array-indexed price ladder");
+    
+    testLadderRecentring();
+    testLadderOffGridPrices();
+    testLadderOffGridTick();
+    testLadderMatchesMapBook();
+    testLadderPoolCounted();
     
     std::cout << "\n✅ All Order Book tests passed!" << std::endl;
     return 0;
@@ -0,0 +1,143 @@
+#include <iostream>
+#include <cassert>
+#include <unordered_map>
+#include <vector>
+#include "order_id_map.h"
+
+struct TestValue {
+    uint64_t size;
+    char side;
+    
+    TestValue() : size(0), side('\0') {}
+};
+
+void testBasicOperations() {
+    std::cout << "Testing OrderIdMap basics..." << std::endl;
+    OrderIdMap<TestValue> orders;
+    
+    assert(orders.empty());
+    assert(orders.find(1) == nullptr);
+    assert(!orders.erase(1));
+    
+    bool inserted;
+    TestValue& first = orders.insert(817593, inserted);
+    assert(inserted);
+    assert(first.size == 0);
+    first.size = 100;
+    first.side = 'B';
+    
+    TestValue& again = orders.insert(817593, inserted);
+    assert(!inserted);
+    assert(again.size == 100 && again.side == 'B');
+    
+    assert(orders.size() == 1);
+    assert(orders.contains(817593));
+    assert(!orders.contains(817594));
+    
+    // Id zero is a valid key, not an empty marker
+    orders.insert(0, inserted).size = 7;
+    assert(inserted);
+    assert(orders.find(0)->size == 7);
+    
+    orders.eraseFound(orders.find(817593));
+    assert(!orders.contains(817593));
+    assert(orders.size() == 1);
+    
+    size_t capacity = orders.capacity();
+    orders.clear();
+    assert(orders.empty());
+    assert(orders.capacity() == capacity);
+    assert(orders.find(0) == nullptr);
+    
+    std::cout << "✓ OrderIdMap basics passed" << std::endl;
+}
+
+void testMatchesUnorderedMap() {
+    std::cout << "Testing OrderIdMap against std::unordered_map..." << std::endl;
+    OrderIdMap<TestValue> orders;
+    std::unordered_map<uint64_t, uint64_t> reference;
+    std::vector<uint64_t> live;
+    
+    uint64_t rng = 777;
+    auto next_random = [&rng]() {
+        rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+        return rng >> 33;
+    };
+    
+    // Ids increase like exchange-assigned ones, with gaps, while random
+    // live orders are cancelled, so deletions constantly shift probe runs
+    uint64_t next_id = 1000000;
+    bool inserted;
+    for (int i = 0; i < 200000; ++i) {
+        if (live.empty() || next_random() % 100 < 55) {
+            next_id += 1 + next_random() % 4;
+            orders.insert(next_id, inserted).size = next_id * 3;
+            assert(inserted);
+            reference[next_id] = next_id * 3;
+            live.push_back(next_id);
+        } else {
+            size_t pick = next_random() % live.size();
+            uint64_t id = live[pick];
+            if (next_random() % 2) {
+                assert(orders.erase(id));
+            } else {
+                TestValue* value = orders.find(id);
+                assert(value && value->size == id * 3);
+                orders.eraseFound(value);
+            }
+            reference.erase(id);
+            live[pick] = live.back();
+            live.pop_back();
+        }
+        
+        if (i % 1000 == 0) {
+            assert(orders.size() == reference.size());
+            for (uint64_t id : live) {
+                const TestValue* value = orders.find(id);
+                assert(value && value->size == reference[id]);
+                
+                // Inserting a live id finds it in the same probe
+                assert(orders.insert(id, inserted).size == reference[id] && !inserted);
+            }
+            assert(orders.size() == reference.size());
+            assert(!orders.contains(next_id + 1));
+        }
+    }
+    
+    std::cout << "✓ OrderIdMap differential check passed" << std::endl;
+}
+
+void testReserve() {
+    std::cout << "Testing OrderIdMap capacity..." << std::endl;
+    OrderIdMap<TestValue> orders(100000);
+    size_t capacity = orders.capacity();
+    size_t allocations = orders.getAllocationCount();
+    assert(capacity >= 100000);
+    
+    bool inserted;
+    for (uint64_t id = 1; id <= 100000; ++id) {
+        orders.insert(id, inserted);
+    }
+    assert(orders.size() == 100000);
+    assert(orders.capacity() == capacity);
+    assert(orders.getAllocationCount() == allocations);
+    
+    // Growing past the reservation keeps every entry
+    orders.insert(100001, inserted);
+    for (uint64_t id = 100002; id <= 200000; ++id) {
+        orders.insert(id, inserted);
+    }
+    assert(orders.capacity() > capacity);
+    for (uint64_t id = 1; id <= 200000; id += 997) {
+        assert(orders.contains(id));
+    }
+    
+    std::cout << "✓ OrderIdMap capacity passed" << std::endl;
+}
+
+int main() {
+    testBasicOperations();
+    testMatchesUnorderedMap();
+    testReserve();
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include <iostream>
+#include <cassert>
+#include <vector>
+#include "packed_event.h"
+
+static MboEvent makeEvent(int64_t ts, char action, uint64_t order_id, uint64_t sequence) {
+    MboEvent event(std::chrono::nanoseconds(ts), action, 'B', 5510000000LL + static_cast<Price>(order_id), 100 + order_id,
+                   order_id);
+    event.ts_recv = std::chrono::nanoseconds(ts + 165000);
+    event.instrument_id = 1108;
+    event.publisher_id = 2;
+    event.channel_id = 3;
+    event.flags = 130;
+    event.ts_in_delta = -42;
+    event.sequence = sequence;
+    return event;
+}
+
+static bool sameEvent(const MboEvent& a, const MboEvent& b) {
+    return a.ts_event == b.ts_event && a.action == b.action && a.side == b.side && a.price == b.price && a.size == b.size &&
+           a.order_id == b.order_id && a.flags == b.flags && a.ts_in_delta == b.ts_in_delta && a.sequence == b.sequence &&
+           a.instrument_id == b.instrument_id && a.publisher_id == b.publisher_id && a.ts_recv == b.ts_recv &&
+           a.channel_id == b.channel_id;
+}
+
+void testRoundTrip() {
+    std::cout << "Testing packed event round trip..." << std::endl;
+    static_assert(sizeof(PackedMboEvent) == 32, "hot event is 32 bytes");
+    
+    const int64_t base = 1752739509035627674LL;
+    std::vector<MboEvent> originals;
+    for (uint64_t i = 0; i < 1000; ++i) {
+        originals.push_back(makeEvent(base + static_cast<int64_t>(i) * 1000 - 500000, i % 2 ? 'A' : 'C', i, 851012 + i));
+    }
+    originals.push_back(makeEvent(base, 'R', 0, 0));
+    originals.back().size = UINT32_MAX;
+    
+    PackedEventBatch batch;
+    for (const MboEvent& event : originals) {
+        batch.push(event);
+    }
+    assert(batch.size() == originals.size());
+    assert(batch.getSegmentCount() == 1);
+    for (size_t i = 0; i < originals.size(); ++i) {
+        assert(sameEvent(batch.get(i), originals[i]));
+    }
+    assert(batch.hot(3).order_id == 3 && batch.hot(3).action == 'A');
+    assert(batch.cold(3).sequence == 851015);
+    
+    batch.clear();
+    assert(batch.empty() && batch.getSegmentCount() == 0);
+    std::cout << "✓ Packed event round trip passed" << std::endl;
+}
+
+// Offsets are 32-bit, so events far from the base open new segments in
+// either direction
+void testSegments() {
+    std::cout << "Testing timestamp segments..." << std::endl;
+    const int64_t SECOND = 1000000000LL;
+    const int64_t base = 1752739509035627674LL;
+    const int64_t offsets[] = {0, SECOND, 2 * SECOND, 3 * SECOND, 3 * SECOND + 1, -SECOND, 10 * 3600 * SECOND, 5};
+    
+    PackedEventBatch batch;
+    std::vector<MboEvent> originals;
+    for (size_t i = 0; i < sizeof(offsets) / sizeof(offsets[0]); ++i) {
+        originals.push_back(makeEvent(base + offsets[i], 'A', i, i));
+        batch.push(originals.back());
+    }
+    assert(batch.getSegmentCount() == 5);
+    for (size_t i = 0; i < originals.size(); ++i) {
+        assert(batch.get(i).ts_event == originals[i].ts_event);
+    }
+    
+    batch.truncate(4);
+    assert(batch.size() == 4 && batch.getSegmentCount() == 2);
+    assert(batch.get(3).ts_event == originals[3].ts_event);
+    batch.push(originals[4]);
+    assert(batch.getSegmentCount() == 2 && batch.get(4).ts_event == originals[4].ts_event);
+    std::cout << "✓ Timestamp segments passed" << std::endl;
+}
+
+void testCompaction() {
+    std::cout << "Testing in-place compaction..." << std::endl;
+    const int64_t base = 1752739509035627674LL;
+    PackedEventBatch batch;
+    for (uint64_t i = 0; i < 10; ++i) {
+        batch.push(makeEvent(base + static_cast<int64_t>(i) * 100, 'A', i, i));
+    }
+    
+    // Keep the odd events
+    size_t kept = 0;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (batch.hot(i).order_id % 2) {
+            batch.move(i, kept++);
+        }
+    }
+    batch.truncate(kept);
+    assert(batch.size() == 5);
+    for (size_t i = 0; i < batch.size(); ++i) {
+        assert(sameEvent(batch.get(i), makeEvent(base + static_cast<int64_t>(2 * i + 1) * 100, 'A', 2 * i + 1, 2 * i + 1)));
+    }
+    std::cout << "✓ In-place compaction passed" << std::endl;
+}
+
+int main() {
+    testRoundTrip();
+    testSegments();
+    testCompaction();
+    
+    std::cout << "\n✅ All packed event tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include <iostream>
+#include <cassert>
+#include <memory>
+#include <vector>
+#include "process_usage.h"
+
+struct alignas(64) CacheLineBlock {
+    char bytes[64];
+};
+
+// Pointers stored here escape, so the compiler cannot elide the allocations
+static void* volatile sink;
+
+void testAllocationsCounted() {
+    std::cout << "Testing allocation counting..." << std::endl;
+    
+    const ProcessUsage before = currentProcessUsage();
+    std::unique_ptr<int> single(new int(7));
+    std::unique_ptr<char[]> array(new char[1000]);
+    std::unique_ptr<CacheLineBlock> aligned(new CacheLineBlock());
+    sink = single.get();
+    sink = array.get();
+    sink = aligned.get();
+    const ProcessUsage after = currentProcessUsage();
+    
+    // Builds without ORDERBOOK_COUNT_ALLOCS leave operator new alone
+    if (!ALLOCATION_COUNTING_ENABLED) {
+        assert(after.allocations == 0 && after.allocated_bytes == 0);
+        std::cout << "✓ Allocation counting compiled out" << std::endl;
+        return;
+    }
+    assert(after.allocations - before.allocations == 3);
+    assert(after.allocated_bytes - before.allocated_bytes == sizeof(int) + 1000 + sizeof(CacheLineBlock));
+    assert(reinterpret_cast<uintptr_t>(aligned.get()) % 64 == 0);
+    
+    // Freeing does not take anything off the counts
+    single.reset();
+    array.reset();
+    aligned.reset();
+    assert(currentProcessUsage().allocations == after.allocations);
+    std::cout << "✓ Allocation counting passed" << std::endl;
+}
+
+void testPeakRss() {
+    std::cout << "Testing peak RSS..." << std::endl;
+    
+    const ProcessUsage before = currentProcessUsage();
+#ifndef _WIN32
+    assert(before.peak_rss_kb > 0);
+#endif
+    
+    // Touching 64 MB raises the high-water mark, and it stays up once freed
+    {
+        std::vector<char> touched(64 * 1024 * 1024, 1);
+        sink = touched.data();
+    }
+    const ProcessUsage after = currentProcessUsage();
+    assert(after.peak_rss_kb >= before.peak_rss_kb + 32 * 1024);
+    std::cout << "✓ Peak RSS passed" << std::endl;
+}
+
+int main() {
+    testAllocationsCounted();
+    testPeakRss();
+    
+    std::cout << "\n✅ All process usage tests passed!" << std::endl;
+    return 0;
+}
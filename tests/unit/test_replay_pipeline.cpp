@@ -0,0 +1,205 @@
+#include <iostream>
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <vector>
+#include "replay_engine.h"
+#include "replay_pipeline.h"
+#include "mbo_file_reader.h"
+#include "symbology.h"
+
+static const char* INPUT_FILE = "test_pipeline_input.csv";
+
+// Random adds and cancels around a mid price, with a T->F->C sequence every
+// so often, preceded by the initial clear
+static void writeInput(size_t event_count) {
+    std::ofstream file(INPUT_FILE);
+    file << "ts_recv,ts_event,rtype,publisher_id,instrument_id,action,side,price,size,channel_id,order_id,flags,ts_in_delta,sequence,symbol\n";
+    file << "2025-07-17T07:05:09.035793433Z,2025-07-17T07:05:09.035627674Z,160,2,1108,R,N,,0,0,0,8,0,0,ARL\n";
+    
+    uint64_t state = 12345;
+    auto next = [&state]() {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return state >> 33;
+    };
+    
+    std::vector<uint64_t> live_orders;
+    std::vector<char> live_sides;
+    uint64_t next_order_id = 1;
+    
+    for (size_t i = 0; i < event_count; ++i) {
+        std::ostringstream ts;
+        ts << "2025-07-17T08:05:" << (10 + (i / 1000) % 50) << "." << (100000000 + i) << "Z";
+        const std::string stamp = ts.str();
+        uint64_t sequence = i + 1;
+        int choice = static_cast<int>(next() % 10);
+        
+        if (choice < 6 || live_orders.size() < 5) {
+            char side = next() % 2 ? 'B' : 'A';
+            int ticks = static_cast<int>(next() % 20);
+            double price = side == 'B' ? 5.50 - ticks * 0.01 : 5.60 + ticks * 0.01;
+            file << stamp << "," << stamp << ",160,2,1108,A," << side << "," << price << "," << (1 + next() % 500)
+                 << ",0," << next_order_id << ",130,0," << sequence << ",ARL\n";
+            live_orders.push_back(next_order_id++);
+            live_sides.push_back(side);
+        } else if (choice < 9) {
+            size_t pick = next() % live_orders.size();
+            file << stamp << "," << stamp << ",160,2,1108,C," << live_sides[pick] << ",0,0,0," << live_orders[pick]
+                 << ",130,0," << sequence << ",ARL\n";
+            live_orders[pick] = live_orders.back();
+            live_orders.pop_back();
+            live_sides[pick] = live_sides.back();
+            live_sides.pop_back();
+        } else {
+            size_t pick = next() % live_orders.size();
+            char trade_side = live_sides[pick] == 'B' ? 'A' : 'B';
+            file << stamp << "," << stamp << ",160,2,1108,T," << trade_side << ",5.5,10,0,0,130,0," << sequence << ",ARL\n";
+            file << stamp << "," << stamp << ",160,2,1108,F," << live_sides[pick] << ",5.5,10,0," << live_orders[pick]
+                 << ",130,0," << sequence << ",ARL\n";
+            file << stamp << "," << stamp << ",160,2,1108,C," << live_sides[pick] << ",5.5,10,0," << live_orders[pick]
+                 << ",130,0," << sequence << ",ARL\n";
+            live_orders[pick] = live_orders.back();
+            live_orders.pop_back();
+            live_sides[pick] = live_sides.back();
+            live_sides.pop_back();
+        }
+    }
+}
+
+static std::string readFile(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+template <typename Book>
+void testPipelineMatchesSequential() {
+    std::cout << "Testing pipelined replay against the sequential engine..." << std::endl;
+    
+    ReplayStats sequential_stats;
+    {
+        SymbologyTable symbology;
+        MboFileReader reader(INPUT_FILE);
+        reader.setSymbology(&symbology);
+        assert(reader.open());
+        
+        MbpCsvWriter writer("test_pipeline_sequential.csv");
+        writer.setSymbology(&symbology);
+        assert(writer.initialize());
+        
+        ReplayEngine<Book, MbpCsvWriter> engine(writer);
+        reader.forEach([&](const MboEvent& event) { engine.push(event); });
+        engine.finish();
+        writer.close();
+        sequential_stats = engine.getStats();
+    }
+    
+    {
+        SymbologyTable symbology;
+        MboFileReader reader(INPUT_FILE);
+        reader.setSymbology(&symbology);
+        assert(reader.open());
+        
+        MbpCsvWriter writer("test_pipeline_pipelined.csv");
+        writer.setSymbology(&symbology);
+        writer.setAsyncIo(true);
+        assert(writer.initialize());
+        
+        ReplayPipeline<Book, MbpCsvWriter> pipeline(writer);
+        MboEvent first;
+        assert(reader.next(first));
+        pipeline.run(reader, first);
+        writer.close();
+        
+        const ReplayStats& stats = pipeline.getStats();
+        assert(stats.processed_events == sequential_stats.processed_events);
+        assert(stats.snapshots_written == sequential_stats.snapshots_written);
+        assert(stats.tfc_sequences_detected == sequential_stats.tfc_sequences_detected);
+        assert(stats.tfc_sequences_detected > 0);
+        
+        // More snapshots than the ring holds, so the book stage had to wait
+        const size_t ring_capacity = ReplayPipeline<Book, MbpCsvWriter>::SNAPSHOT_RING_CAPACITY;
+        assert(stats.snapshots_written > ring_capacity);
+        assert(writer.getSnapshotCount() == stats.snapshots_written);
+        assert(pipeline.getBooks().findBook(1108) != nullptr);
+    }
+    
+    assert(readFile("test_pipeline_pipelined.csv") == readFile("test_pipeline_sequential.csv"));
+    
+    std::remove("test_pipeline_sequential.csv");
+    std::remove("test_pipeline_pipelined.csv");
+    
+    std::cout << "✓ Pipelined replay passed" << std::endl;
+}
+
+// Batches of every size from one up, so the carried lookahead is seen
+// holding zero, one and two events, with T->F->C sequences split across
+// batch boundaries
+template <typename Book>
+void testBatchMatchesSingleEvents() {
+    std::cout << "Testing batched engine input against single pushes..." << std::endl;
+    
+    SymbologyTable symbology;
+    std::vector<MboEvent> events;
+    {
+        MboFileReader reader(INPUT_FILE);
+        reader.setSymbology(&symbology);
+        assert(reader.open());
+        reader.forEach([&](const MboEvent& event) { events.push_back(event); });
+    }
+    
+    std::string expected;
+    ReplayStats expected_stats;
+    {
+        MbpCsvWriter writer("test_pipeline_single.csv");
+        writer.setSymbology(&symbology);
+        assert(writer.initialize());
+        ReplayEngine<Book, MbpCsvWriter> engine(writer);
+        for (const MboEvent& event : events) {
+            engine.push(event);
+        }
+        engine.finish();
+        writer.close();
+        expected_stats = engine.getStats();
+        expected = readFile("test_pipeline_single.csv");
+    }
+    
+    const size_t batch_sizes[] = {1, 2, 3, 4, 7, ReplayEngine<Book, MbpCsvWriter>::BATCH_SIZE};
+    for (size_t batch_size : batch_sizes) {
+        MbpCsvWriter writer("test_pipeline_batched.csv");
+        writer.setSymbology(&symbology);
+        assert(writer.initialize());
+        ReplayEngine<Book, MbpCsvWriter> engine(writer);
+        
+        // Uneven batches: batch_size, then one, then batch_size again
+        size_t pushed = 0;
+        for (size_t round = 0; pushed < events.size(); ++round) {
+            size_t count = std::min(round % 2 ? 1 : batch_size, events.size() - pushed);
+            engine.pushBatch(events.data() + pushed, count);
+            pushed += count;
+        }
+        engine.finish();
+        writer.close();
+        
+        assert(engine.getStats().snapshots_written == expected_stats.snapshots_written);
+        assert(engine.getStats().tfc_sequences_detected == expected_stats.tfc_sequences_detected);
+        assert(readFile("test_pipeline_batched.csv") == expected);
+    }
+    
+    std::remove("test_pipeline_single.csv");
+    std::remove("test_pipeline_batched.csv");
+    
+    std::cout << "✓ Batched engine input passed" << std::endl;
+}
+
+int main() {
+    writeInput(50000);
+    testPipelineMatchesSequential<OrderBook>();
+    testPipelineMatchesSequential<LadderOrderBook>();
+    testBatchMatchesSingleEvents<OrderBook>();
+    std::remove(INPUT_FILE);
+    return 0;
+}
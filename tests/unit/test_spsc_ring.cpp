@@ -0,0 +1,100 @@
+#include <iostream>
+#include <cassert>
+#include <thread>
+#include <cstdint>
+#include "spsc_ring.h"
+
+void testSingleThreaded() {
+    std::cout << "Testing SPSC ring basics..." << std::endl;
+    
+    SpscRing<int> ring(5);
+    assert(ring.capacity() == 8);
+    assert(ring.empty());
+    
+    int value = 0;
+    assert(!ring.tryPop(value));
+    
+    // Fill, drain halfway and refill so the indices wrap
+    for (int i = 0; i < 8; ++i) {
+        assert(ring.tryPush(i));
+    }
+    assert(!ring.tryPush(8));
+    
+    for (int i = 0; i < 4; ++i) {
+        assert(ring.tryPop(value) && value == i);
+    }
+    for (int i = 8; i < 12; ++i) {
+        assert(ring.tryPush(i));
+    }
+    assert(!ring.tryPush(12));
+    
+    for (int i = 4; i < 12; ++i) {
+        assert(ring.tryPop(value) && value == i);
+    }
+    assert(ring.empty());
+    
+    std::cout << "✓ SPSC ring basics passed" << std::endl;
+}
+
+void testBatchPop() {
+    std::cout << "Testing SPSC ring batch pops..." << std::endl;
+    
+    SpscRing<int> ring(8);
+    int items[8];
+    assert(ring.tryPopBatch(items, 8) == 0);
+    
+    // A batch is capped by max and by what is queued, across the wrap
+    for (int i = 0; i < 6; ++i) {
+        assert(ring.tryPush(i));
+    }
+    assert(ring.tryPopBatch(items, 4) == 4 && items[0] == 0 && items[3] == 3);
+    for (int i = 6; i < 12; ++i) {
+        assert(ring.tryPush(i));
+    }
+    assert(!ring.tryPush(12));
+    assert(ring.tryPopBatch(items, 8) == 8);
+    for (int i = 0; i < 8; ++i) {
+        assert(items[i] == 4 + i);
+    }
+    assert(ring.empty() && ring.tryPopBatch(items, 8) == 0);
+    
+    std::cout << "✓ SPSC ring batch pops passed" << std::endl;
+}
+
+void testProducerConsumer() {
+    std::cout << "Testing SPSC ring across threads..." << std::endl;
+    
+    const uint64_t count = 1000000;
+    SpscRing<uint64_t> ring(1024);
+    
+    std::thread consumer([&]() {
+        uint64_t expected = 0;
+        uint64_t value;
+        while (expected < count) {
+            if (ring.tryPop(value)) {
+                assert(value == expected);
+                ++expected;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    
+    for (uint64_t i = 0; i < count; ++i) {
+        while (!ring.tryPush(i)) {
+            std::this_thread::yield();
+        }
+    }
+    
+    consumer.join();
+    assert(ring.empty());
+    
+    std::cout << "✓ SPSC ring across threads passed" << std::endl;
+}
+
+int main() {
+    testSingleThreaded();
+    testBatchPop();
+    testProducerConsumer();
+    return 0;
+}